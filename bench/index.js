@@ -0,0 +1,287 @@
+/**
+ * Throughput, latency, allocation & GC benchmark of the JavaScript API,
+ * replaying the uplinks of bench/corpus.txt
+ *
+ * Usage: npm run bench -- [--duration ms] [--filter name] [--output file.json]
+ *                         [--baseline file.json] [--threshold percent]
+ */
+
+/**
+ * Module dependencies
+ */
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { performance, PerformanceObserver } = require('perf_hooks');
+const sensitPayload = require('../');
+
+const LATENCY_SAMPLES = 20000;
+const WARMUP_MS = 300;
+
+/**
+ * Command line options
+ *
+ * @param {Array} argv
+ *
+ * @return {Object}
+ */
+
+function parseOptions(argv) {
+  const options = {
+    duration: 2000,
+    filter: null,
+    output: null,
+    baseline: null,
+    threshold: 10
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const name = argv[i].replace(/^--/, '');
+    if (!(name in options) || i + 1 >= argv.length) {
+      throw new Error(`Unknown option ${argv[i]}`);
+    }
+    const value = argv[++i];
+    options[name] = typeof options[name] === 'number' ? Number(value) : value;
+  }
+  return options;
+}
+
+/**
+ * Uplinks of the corpus, one hexadecimal payload per line
+ *
+ * @return {Array}
+ */
+
+function loadCorpus() {
+  return fs.readFileSync(path.join(__dirname, 'corpus.txt'), 'utf8')
+    .split('\n')
+    .filter(line => line !== '' && line[0] !== '#');
+}
+
+/**
+ * Functions measured, each called once per input in a loop
+ *
+ * @param {Array} corpus
+ *
+ * @return {Array}
+ */
+
+function createSuites(corpus) {
+  const datas = corpus.map(payload => payload.slice(0, 8));
+  const configs = corpus
+    .filter(payload => payload.length === 24)
+    .map(payload => ({ payload: payload.slice(8), type: sensitPayload.parseData(payload.slice(0, 8)).type }));
+  const parsedConfigs = configs.map(({ payload, type }) => ({ config: sensitPayload.parseConfig(payload, type), type }));
+  const words = datas.map(payload => parseInt(payload, 16));
+  const target = sensitPayload.createData();
+  const batches = [];
+  for (let i = 0; i + 256 <= datas.length; i += 256) {
+    batches.push(Buffer.from(datas.slice(i, i + 256).join(''), 'hex'));
+  }
+
+  return [
+    { name: 'parse', inputs: corpus, fn: payload => sensitPayload.parse(payload) },
+    { name: 'parseData', inputs: datas, fn: payload => sensitPayload.parseData(payload) },
+    { name: 'parseInto', inputs: datas, fn: payload => sensitPayload.parseInto(payload, target) },
+    { name: 'parseIntoWord', inputs: words, fn: word => sensitPayload.parseInto(word, target) },
+    { name: 'parseConfig', inputs: configs, fn: ({ payload, type }) => sensitPayload.parseConfig(payload, type) },
+    { name: 'serializeConfig', inputs: parsedConfigs, fn: ({ config, type }) => sensitPayload.serializeConfig(config, type) },
+    { name: 'parseDataBatch', inputs: batches, fn: batch => sensitPayload.parseDataBatch(batch), items: 256, chunk: 16 }
+  ];
+}
+
+/**
+ * Call fn over the inputs, round robin, for the given time
+ *
+ * @return {Number} number of calls
+ */
+
+function runFor(suite, duration) {
+  const { inputs, fn } = suite;
+  const end = performance.now() + duration;
+  let calls = 0;
+  let index = 0;
+  do {
+    for (let i = 0; i < 256; i++) {
+      fn(inputs[index]);
+      index = index + 1 === inputs.length ? 0 : index + 1;
+    }
+    calls += 256;
+  } while (performance.now() < end);
+  return calls;
+}
+
+/**
+ * Latency of single calls, in nanoseconds
+ *
+ * @return {Object} p50 & p99
+ */
+
+function measureLatency(suite) {
+  const { inputs, fn } = suite;
+  const samples = new Float64Array(LATENCY_SAMPLES);
+  for (let i = 0; i < samples.length; i++) {
+    const input = inputs[i % inputs.length];
+    const start = process.hrtime();
+    fn(input);
+    const [seconds, nanoseconds] = process.hrtime(start);
+    samples[i] = (seconds * 1e9) + nanoseconds;
+  }
+  samples.sort();
+  return {
+    p50: samples[Math.floor(samples.length * 0.5)],
+    p99: samples[Math.floor(samples.length * 0.99)]
+  };
+}
+
+/**
+ * Bytes allocated on the heap per call: the heap growth over chunks of
+ * calls small enough not to trigger a scavenge, after a full GC.
+ * Needs --expose-gc
+ *
+ * @return {Number|null}
+ */
+
+function measureAllocation(suite) {
+  if (typeof global.gc !== 'function') {
+    return null;
+  }
+  const { inputs, fn } = suite;
+  const chunk = suite.chunk || 1000;
+  let bytes = 0;
+  let calls = 0;
+  for (let start = 0; calls < Math.max(inputs.length, 10 * chunk); start += chunk) {
+    global.gc();
+    const before = process.memoryUsage().heapUsed;
+    for (let i = start; i < start + chunk; i++) {
+      fn(inputs[i % inputs.length]);
+    }
+    bytes += Math.max(process.memoryUsage().heapUsed - before, 0);
+    calls += chunk;
+  }
+  return Math.round(bytes / calls);
+}
+
+/**
+ * Let the queued performance entries reach their observer, GC entries
+ * are queued from the GC callback and delivered on later loop turns
+ */
+
+function flushEntries() {
+  return new Promise(resolve => setTimeout(resolve, 50));
+}
+
+/**
+ * Measure a suite
+ *
+ * @return {Promise<Object>}
+ */
+
+async function runSuite(suite, duration) {
+  runFor(suite, WARMUP_MS);
+
+  let gcCount = 0;
+  let gcPause = 0;
+  const observer = new PerformanceObserver((list) => {
+    list.getEntries().forEach((entry) => {
+      gcCount++;
+      gcPause += entry.duration;
+    });
+  });
+  observer.observe({ entryTypes: ['gc'] });
+  const start = performance.now();
+  const calls = runFor(suite, duration);
+  const elapsed = performance.now() - start;
+  await flushEntries();
+  observer.disconnect();
+
+  const latency = measureLatency(suite);
+  const result = {
+    opsPerSec: Math.round(calls / (elapsed / 1000)),
+    p50Ns: Math.round(latency.p50),
+    p99Ns: Math.round(latency.p99),
+    bytesPerOp: measureAllocation(suite),
+    gcCount,
+    gcPauseMs: Math.round(gcPause * 100) / 100,
+    gcPausePercent: Math.round((gcPause / elapsed) * 10000) / 100
+  };
+  if (suite.items) {
+    result.itemsPerSec = result.opsPerSec * suite.items;
+  }
+  return result;
+}
+
+/**
+ * Relative changes of the results against a baseline. Throughput and
+ * allocation worse past the threshold are regressions, latencies are
+ * too noisy for a single run and only printed
+ *
+ * @return {Array} regressions
+ */
+
+function compare(results, baseline, threshold) {
+  const regressions = [];
+  // Metric, true when higher is better, true when it can fail the run
+  const metrics = [['opsPerSec', true, true], ['p50Ns', false, false], ['p99Ns', false, false], ['bytesPerOp', false, true]];
+  Object.keys(results).forEach((name) => {
+    const previous = baseline.results[name];
+    if (!previous) {
+      return;
+    }
+    metrics.forEach(([metric, higherIsBetter, gated]) => {
+      if (typeof results[name][metric] !== 'number' || typeof previous[metric] !== 'number' || previous[metric] === 0) {
+        return;
+      }
+      const change = ((results[name][metric] - previous[metric]) / previous[metric]) * 100;
+      const regressed = gated && (higherIsBetter ? -change : change) > threshold;
+      const line = `${name}.${metric}: ${previous[metric]} -> ${results[name][metric]} (${change > 0 ? '+' : ''}${change.toFixed(1)}%)`;
+      if (regressed) {
+        regressions.push(line);
+      }
+      console.log(`${regressed ? 'REGRESSION ' : ''}${line}`);
+    });
+  });
+  return regressions;
+}
+
+async function main() {
+  const options = parseOptions(process.argv.slice(2));
+  const corpus = loadCorpus();
+  const suites = createSuites(corpus)
+    .filter(suite => !options.filter || suite.name.indexOf(options.filter) >= 0);
+
+  if (typeof global.gc !== 'function') {
+    console.error('bytesPerOp needs node --expose-gc, use npm run bench');
+  }
+
+  const results = {};
+  for (const suite of suites) {
+    results[suite.name] = await runSuite(suite, options.duration);
+    const result = results[suite.name];
+    console.log(`${suite.name}: ${result.opsPerSec} ops/s, p50 ${result.p50Ns} ns, p99 ${result.p99Ns} ns, ` +
+      `${result.bytesPerOp} B/op, GC ${result.gcCount} pauses ${result.gcPauseMs} ms (${result.gcPausePercent}%)`);
+  }
+
+  const report = {
+    date: new Date().toISOString(),
+    node: process.version,
+    v8: process.versions.v8,
+    platform: `${os.platform()} ${os.arch()}`,
+    cpu: os.cpus()[0].model,
+    corpus: corpus.length,
+    duration: options.duration,
+    results
+  };
+  if (options.output) {
+    fs.writeFileSync(options.output, `${JSON.stringify(report, null, 2)}\n`);
+  }
+  if (options.baseline) {
+    const regressions = compare(results, JSON.parse(fs.readFileSync(options.baseline, 'utf8')), options.threshold);
+    process.exitCode = regressions.length > 0 ? 1 : 0;
+  }
+}
+
+main().catch((err) => {
+  console.error(err);
+  process.exitCode = 2;
+});
@@ -3,7 +3,47 @@
     {
       "target_name": "sensit_payload_lib",
       'defines': [ 'V8_DEPRECATION_WARNINGS=1' ],
-      "sources": [ "src/sensit_payload_node.cc", "src/sensit_payload.cc", "src/sensit_payload_v3.cc", "src/sensit_payload_v2.cc" ]
+      "sources": [ "src/sensit_payload_node.cc", "src/sensit_payload.cc", "src/sensit_payload_v3.cc", "src/sensit_payload_v2.cc",
+                   "src/sensit_dedup.cc", "src/sensit_dedup_node.cc",
+                   "src/sensit_arrow.cc", "src/sensit_arrow_node.cc",
+                   "src/sensit_text.cc", "src/sensit_text_node.cc",
+                   "src/sensit_series.cc", "src/sensit_series_node.cc", "src/sensit_downsample.cc",
+                   "src/sensit_devices.cc",
+                   "src/sensit_battery.cc", "src/sensit_battery_node.cc",
+                   "src/sensit_rules.cc", "src/sensit_rules_node.cc",
+                   "src/sensit_timeline.cc", "src/sensit_timeline_node.cc",
+                   "src/sensit_downlink.cc", "src/sensit_downlink_node.cc",
+                   "src/sensit_watchdog.cc", "src/sensit_watchdog_node.cc",
+                   "src/sensit_sketch.cc", "src/sensit_sketch_node.cc",
+                   "src/sensit_decoder_node.cc",
+                   "src/sensit_reorder.cc", "src/sensit_reorder_node.cc",
+                   "src/sensit_bitmap.cc", "src/sensit_index.cc", "src/sensit_index_node.cc" ],
+      "conditions": [
+        [ 'OS=="linux"', {
+          "sources": [ "src/sensit_ring.cc", "src/sensit_ring_node.cc" ],
+          "libraries": [ "-ldl" ]
+        } ]
+      ]
     }
+  ],
+  "conditions": [
+    [ 'OS=="linux"', {
+      "targets": [
+        {
+          "target_name": "sensitd",
+          "type": "executable",
+          "sources": [ "src/sensitd.cc", "src/sensit_protocol.cc", "src/sensit_text.cc",
+                       "src/sensit_payload.cc", "src/sensit_payload_v3.cc", "src/sensit_payload_v2.cc" ]
+        },
+        {
+          "target_name": "sensit_sweep",
+          "type": "executable",
+          "sources": [ "src/sensit_sweep.cc",
+                       "src/sensit_payload.cc", "src/sensit_payload_v3.cc", "src/sensit_payload_v2.cc" ],
+          "cflags": [ "-pthread" ],
+          "ldflags": [ "-pthread" ]
+        }
+      ]
+    } ]
   ]
 }
@@ -4,6 +4,7 @@
 
 const bindings = require('bindings');
 const Buffer = require('buffer').Buffer;
+const path = require('path');
 
 const lib = bindings('sensit_payload_lib');
 
@@ -351,6 +352,287 @@ sensitPayload.parseData = (payload) => {
   return formatData(data);
 };
 
+/**
+ * Parse Sensit payload "data" part made of 4 bytes of a v3 device,
+ * skipping the version detection. A payload of another version
+ * is returned with the PARSE_ERR_TYPE error
+ *
+ * @param {String} payload
+ *
+ * @return {Object} data
+ */
+
+sensitPayload.parseDataV3 = (payload) => {
+  if (payload.length !== 8) {
+    throw new Error('Sensit payload "data" part is made of 8 hexadecimal characters');
+  }
+  return formatData(lib.parseDataV3(Buffer.from(payload, 'hex')));
+};
+
+/**
+ * Parse Sensit payload "data" part made of 4 bytes of a v2 device,
+ * skipping the version detection. A payload of another version
+ * is returned with the PARSE_ERR_TYPE error
+ *
+ * @param {String} payload
+ *
+ * @return {Object} data
+ */
+
+sensitPayload.parseDataV2 = (payload) => {
+  if (payload.length !== 8) {
+    throw new Error('Sensit payload "data" part is made of 8 hexadecimal characters');
+  }
+  return formatData(lib.parseDataV2(Buffer.from(payload, 'hex')));
+};
+
+/**
+ * Parse a batch of Sensit payload "data" parts in a single native call.
+ * When `payloadType` is given, every payload is parsed as that version
+ *
+ * @param {Array|Buffer} payloads - hexadecimal strings or concatenated 4 bytes payloads
+ * @param {Number} payloadType - optional, PAYLOAD_TYPE_V2 or PAYLOAD_TYPE_V3
+ *
+ * @return {Array} data
+ */
+
+sensitPayload.parseDataBatch = (payloads, payloadType = 0) => {
+  if (payloadType !== 0 && payloadType !== sensitPayload.PAYLOAD_TYPE_V2 && payloadType !== sensitPayload.PAYLOAD_TYPE_V3) {
+    throw new Error('payload type not defined or not supported');
+  }
+  return lib.parseDataBatch(toPayloadBuffer(payloads, 4), payloadType).map(formatData);
+};
+
+sensitPayload.parseDataBatchV3 = payloads => sensitPayload.parseDataBatch(payloads, sensitPayload.PAYLOAD_TYPE_V3);
+sensitPayload.parseDataBatchV2 = payloads => sensitPayload.parseDataBatch(payloads, sensitPayload.PAYLOAD_TYPE_V2);
+
+const BATCHER_INITIAL_SIZE = 16;
+const BATCHER_GROWTH = 1.25;
+const BATCHER_SHRINK = 0.75;
+const BATCHER_SMOOTHING = 0.2;
+
+/**
+ * Monotonic clock
+ *
+ * @return {Number} microseconds
+ */
+
+function nowUs() {
+  const [seconds, nanoseconds] = process.hrtime();
+  return (seconds * 1e6) + (nanoseconds / 1e3);
+}
+
+/**
+ * Settle a request of the batcher, an exception of its callback is
+ * rethrown apart so that the other requests of the batch settle
+ *
+ * @param {Object} request
+ * @param {Error} err
+ * @param {Object} data
+ */
+
+function settleRequest(request, err, data) {
+  if (!request.callback) {
+    if (err) {
+      request.reject(err);
+    } else {
+      request.resolve(data);
+    }
+    return;
+  }
+  try {
+    request.callback(err, data);
+  } catch (callbackErr) {
+    process.nextTick(() => { throw callbackErr; });
+  }
+}
+
+/**
+ * Coalesce single parse() calls into native batch decodes: requests
+ * are queued until the batch size or the delay of the oldest one is
+ * reached. The batch size is tuned toward the latency target, growing
+ * while batches fill up under load and shrinking when the latency of
+ * the oldest request of a batch goes over the target
+ */
+
+class Batcher {
+  /**
+   * @param {Object} options
+   * @param {Number} options.maxDelayUs - longest wait of a request before its batch is decoded, default to 1000.
+   *                                      Below 1000 the batch is decoded once the current I/O callbacks are done.
+   * @param {Number} options.maxBatch - largest batch, default to 256
+   * @param {Number} options.targetLatencyUs - latency of the oldest request of a batch, default to maxDelayUs
+   */
+
+  constructor({ maxDelayUs = 1000, maxBatch = 256, targetLatencyUs = maxDelayUs } = {}) {
+    if (!(maxDelayUs >= 0) || !(targetLatencyUs > 0) || !Number.isInteger(maxBatch) || maxBatch < 1) {
+      throw new Error('maxDelayUs, targetLatencyUs and maxBatch must be positive');
+    }
+    this.maxDelayUs = maxDelayUs;
+    this.maxBatch = maxBatch;
+    this.targetLatencyUs = targetLatencyUs;
+    this.batchSize = Math.min(BATCHER_INITIAL_SIZE, maxBatch);
+    this.pending = [];
+    this.firstUs = 0;
+    this.timer = null;
+    this.payloads = Buffer.allocUnsafe(maxBatch * 4);
+    this.counters = {
+      requests: 0,
+      batches: 0,
+      flushedBySize: 0,
+      flushedByDelay: 0,
+      latencyUs: 0
+    };
+  }
+
+  /**
+   * Queue a payload, parsed as parse() does
+   *
+   * @param {String} payload - 8 or 24 hexadecimal characters
+   * @param {Function} callback - optional, (err, data)
+   *
+   * @return {Promise|undefined} data, when no callback is given
+   */
+
+  parse(payload, callback) {
+    if (!callback) {
+      return new Promise((resolve, reject) => this.enqueue(payload, { resolve, reject }));
+    }
+    this.enqueue(payload, { callback });
+    return undefined;
+  }
+
+  /**
+   * @param {String} payload
+   * @param {Object} request - resolve & reject, or callback
+   */
+
+  enqueue(payload, request) {
+    // A partly invalid payload would leave bytes of an earlier batch in the buffer
+    if (typeof payload !== 'string' || (payload.length !== 8 && payload.length !== 24) || !/^[0-9a-fA-F]+$/.test(payload)) {
+      const err = new Error('Sensit payload is made of either 8 or 24 hexadecimal characters');
+      process.nextTick(() => settleRequest(request, err));
+      return;
+    }
+    request.payload = payload;
+    if (this.pending.length === 0) {
+      this.firstUs = nowUs();
+      this.timer = this.maxDelayUs < 1000 ?
+        setImmediate(() => this.decode(false)) :
+        setTimeout(() => this.decode(false), Math.floor(this.maxDelayUs / 1000));
+    }
+    this.pending.push(request);
+    if (this.pending.length >= this.batchSize) {
+      this.decode(true);
+    }
+  }
+
+  /**
+   * Decode the queued requests now
+   */
+
+  flush() {
+    if (this.pending.length !== 0) {
+      this.decode(false);
+    }
+  }
+
+  /**
+   * Decode the queued requests in a single native call, then settle them
+   *
+   * @param {Boolean} full - the batch size has been reached
+   */
+
+  decode(full) {
+    if (this.maxDelayUs < 1000) {
+      clearImmediate(this.timer);
+    } else {
+      clearTimeout(this.timer);
+    }
+    this.timer = null;
+    const requests = this.pending;
+    this.pending = [];
+    if (requests.length === 0) {
+      return;
+    }
+
+    requests.forEach((request, i) => this.payloads.write(request.payload, i * 4, 4, 'hex'));
+    const decoded = lib.parseDataBatch(this.payloads.slice(0, requests.length * 4), 0);
+    const results = requests.map((request, i) => {
+      const data = formatData(decoded[i]);
+      data.config = null;
+      if (request.payload.length === 24) {
+        try {
+          data.config = sensitPayload.parseConfig(request.payload.slice(8, 24), data.type);
+        } catch (err) {
+          return err;
+        }
+      }
+      return data;
+    });
+    this.adapt(nowUs() - this.firstUs, full, requests.length);
+
+    // A batch filled by parse() is decoded within it, callbacks are never called synchronously
+    process.nextTick(() => requests.forEach((request, i) => {
+      if (results[i] instanceof Error) {
+        settleRequest(request, results[i]);
+      } else {
+        settleRequest(request, null, results[i]);
+      }
+    }));
+  }
+
+  /**
+   * Tune the batch size from the latency of the oldest request of a batch
+   *
+   * @param {Number} latencyUs
+   * @param {Boolean} full - the batch size has been reached
+   * @param {Number} count - requests of the batch
+   */
+
+  adapt(latencyUs, full, count) {
+    const { counters } = this;
+    counters.requests += count;
+    counters.batches++;
+    if (full) {
+      counters.flushedBySize++;
+    } else {
+      counters.flushedByDelay++;
+    }
+    counters.latencyUs = counters.batches === 1 ?
+      latencyUs :
+      counters.latencyUs + (BATCHER_SMOOTHING * (latencyUs - counters.latencyUs));
+
+    if (counters.latencyUs > this.targetLatencyUs) {
+      this.batchSize = Math.max(Math.floor(this.batchSize * BATCHER_SHRINK), 1);
+    } else if (full) {
+      // Only a load filling the batches makes larger batches useful
+      this.batchSize = Math.min(Math.ceil(this.batchSize * BATCHER_GROWTH), this.maxBatch);
+    }
+  }
+
+  /**
+   * @return {Object} requests, batches, flushedBySize, flushedByDelay,
+   *                  batchSize (current limit), meanBatchSize, latencyUs
+   *                  (smoothed latency of the oldest request of a batch),
+   *                  pending and efficiency (share of the native calls
+   *                  saved compared to one call per request)
+   */
+
+  stats() {
+    const { requests, batches } = this.counters;
+    return Object.assign({}, this.counters, {
+      batchSize: this.batchSize,
+      meanBatchSize: batches ? requests / batches : 0,
+      pending: this.pending.length,
+      efficiency: requests ? 1 - (batches / requests) : 0
+    });
+  }
+}
+
+sensitPayload.Batcher = Batcher;
+sensitPayload.createBatcher = options => new Batcher(options);
+
 /**
  * Parse Sensit payload "config" part made of 8 bytes
  *
@@ -368,6 +650,515 @@ sensitPayload.parseConfig = (payload, type) => {
   return formatConfig(config, type);
 };
 
+/*
+ * Scratch memory of parseInto() & parseConfigInto(), the native side writes
+ * the decoded fields in the order of the DATA_INTO_* & CONFIG_INTO_* indexes
+ */
+
+const DATA_INTO_ERROR = 0;
+const DATA_INTO_TYPE = 1;
+const DATA_INTO_BATTERY_LEVEL = 2;
+const DATA_INTO_MODE = 3;
+const DATA_INTO_BUTTON = 4;
+const DATA_INTO_TEMPERATURE = 5;
+const DATA_INTO_HUMIDITY = 6;
+const DATA_INTO_BRIGHTNESS = 7;
+const DATA_INTO_DOOR = 8;
+const DATA_INTO_VIBRATION = 9;
+const DATA_INTO_MAGNET = 10;
+const DATA_INTO_EVENT_COUNTER = 11;
+const DATA_INTO_VERSION_MAJOR = 12;
+const DATA_INTO_VERSION_MINOR = 13;
+const DATA_INTO_VERSION_PATCH = 14;
+const DATA_INTO_LAST = 15;
+
+const CONFIG_INTO_LIMITED = 0;
+const CONFIG_INTO_STANDBY_PERIODIC = 1;
+const CONFIG_INTO_TEMPERATURE_PERIODIC = 2;
+const CONFIG_INTO_LIGHT_PERIODIC = 3;
+const CONFIG_INTO_DOOR_PERIODIC = 4;
+const CONFIG_INTO_VIBRATION_PERIODIC = 5;
+const CONFIG_INTO_MAGNET_PERIODIC = 6;
+const CONFIG_INTO_TEMPERATURE_LOW = 7;
+const CONFIG_INTO_TEMPERATURE_HIGH = 8;
+const CONFIG_INTO_HUMIDITY_LOW = 9;
+const CONFIG_INTO_HUMIDITY_HIGH = 10;
+const CONFIG_INTO_BRIGHTNESS = 11;
+const CONFIG_INTO_BRIGHTNESS_LOW = 12;
+const CONFIG_INTO_BRIGHTNESS_HIGH = 13;
+const CONFIG_INTO_DELAY = 14;
+const CONFIG_INTO_VIBRATION = 15;
+const CONFIG_INTO_DOOR = 16;
+const CONFIG_INTO_PERIOD = 17;
+const CONFIG_INTO_LAST = 18;
+
+const intoPayload = Buffer.alloc(8);
+const intoData = new Int32Array(DATA_INTO_LAST);
+const intoConfig = new Int32Array(CONFIG_INTO_LAST);
+const versions = new Map();
+
+/**
+ * Version string of a standby payload, cached as only a few firmwares exist
+ *
+ * @return {String}
+ */
+
+function getVersion(major, minor, patch) {
+  const key = (major << 16) | (minor << 8) | patch;
+  let version = versions.get(key);
+  if (version === undefined) {
+    version = `${major}.${minor}.${patch}`;
+    versions.set(key, version);
+  }
+  return version;
+}
+
+/**
+ * Create an object with every property parseInto() may set, so that
+ * it keeps the same shape whatever the mode of the parsed payloads
+ *
+ * @return {Object}
+ */
+
+sensitPayload.createData = () => ({
+  error: 0,
+  type: 0,
+  temperature: undefined,
+  humidity: undefined,
+  light: undefined,
+  version: undefined,
+  door: undefined,
+  eventCounter: undefined,
+  magnet: undefined,
+  vibration: undefined,
+  button: false,
+  battery: 0,
+  batteryIndicator: 0,
+  batteryLevel: 0,
+  modeCode: 0,
+  mode: undefined
+});
+
+/**
+ * Parse Sensit payload "data" part made of 4 bytes into `target`, the
+ * properties not relevant to the mode are set to undefined. Same values
+ * as parseData() without allocating, use createData() to create `target`
+ *
+ * @param {String|Number} payload - 8 hexadecimal characters, or the 4 bytes as a big endian integer
+ * @param {Object} target
+ *
+ * @return {Object} target
+ */
+
+sensitPayload.parseInto = (payload, target) => {
+  if (typeof payload === 'number') {
+    lib.parseDataWord(payload, intoData);
+    return formatInto(target);
+  }
+  if (payload.length !== 8) {
+    throw new Error('Sensit payload "data" part is made of 8 hexadecimal characters');
+  }
+  // A partly invalid payload would leave bytes of the previous call in the scratch buffer
+  if (!/^[0-9a-fA-F]+$/.test(payload)) {
+    throw new TypeError('Sensit payload "data" part is made of 8 hexadecimal characters');
+  }
+  intoPayload.write(payload, 0, 4, 'hex');
+  lib.parseDataInto(intoPayload, intoData);
+  return formatInto(target);
+};
+
+/**
+ * Index of each raw field in the Int32Array of parseDataWord()
+ */
+
+sensitPayload.DATA_WORD_FIELDS = {
+  error: DATA_INTO_ERROR,
+  type: DATA_INTO_TYPE,
+  batteryLevel: DATA_INTO_BATTERY_LEVEL,
+  mode: DATA_INTO_MODE,
+  button: DATA_INTO_BUTTON,
+  temperature: DATA_INTO_TEMPERATURE,
+  humidity: DATA_INTO_HUMIDITY,
+  brightness: DATA_INTO_BRIGHTNESS,
+  door: DATA_INTO_DOOR,
+  vibration: DATA_INTO_VIBRATION,
+  magnet: DATA_INTO_MAGNET,
+  eventCounter: DATA_INTO_EVENT_COUNTER,
+  versionMajor: DATA_INTO_VERSION_MAJOR,
+  versionMinor: DATA_INTO_VERSION_MINOR,
+  versionPatch: DATA_INTO_VERSION_PATCH
+};
+
+sensitPayload.DATA_WORD_LENGTH = DATA_INTO_LAST;
+
+/**
+ * Decode the 4 bytes "data" part given as a big endian integer (e.g.
+ * buffer.readUInt32BE(offset)) into the raw values of the native
+ * decoder, without any allocation nor formatting
+ *
+ * @param {Number} word
+ * @param {Int32Array} values - of DATA_WORD_LENGTH, indexed by DATA_WORD_FIELDS
+ *
+ * @return {Int32Array} values
+ */
+
+sensitPayload.parseDataWord = (word, values = new Int32Array(DATA_INTO_LAST)) => {
+  lib.parseDataWord(word, values);
+  return values;
+};
+
+/**
+ * Format the values of intoData into `target`
+ *
+ * @param {Object} target
+ *
+ * @return {Object} target
+ */
+
+function formatInto(target) {
+  const type = intoData[DATA_INTO_TYPE];
+  const mode = intoData[DATA_INTO_MODE];
+  const button = intoData[DATA_INTO_BUTTON];
+  const batteryLevel = intoData[DATA_INTO_BATTERY_LEVEL];
+  const isV2ButtonPressed = type === sensitPayload.PAYLOAD_TYPE_V2 && button === sensitPayload.BUTTON_PRESSED;
+  const isModeSent = !isV2ButtonPressed;
+
+  target.error = intoData[DATA_INTO_ERROR];
+  target.type = type;
+  target.temperature = mode === sensitPayload.MODE_TEMPERATURE ?
+    round(intoData[DATA_INTO_TEMPERATURE] / 8, 2) : undefined;
+  target.humidity = mode === sensitPayload.MODE_TEMPERATURE && isModeSent ?
+    round(intoData[DATA_INTO_HUMIDITY] / 2, 1) : undefined;
+  target.light = mode === sensitPayload.MODE_LIGHT && isModeSent ?
+    round(intoData[DATA_INTO_BRIGHTNESS] / 96, 2) : undefined;
+  target.version = mode === sensitPayload.MODE_STANDBY ?
+    getVersion(intoData[DATA_INTO_VERSION_MAJOR], intoData[DATA_INTO_VERSION_MINOR], intoData[DATA_INTO_VERSION_PATCH]) : undefined;
+  if (mode === sensitPayload.MODE_DOOR && isModeSent) {
+    const door = intoData[DATA_INTO_DOOR];
+    target.door = door === sensitPayload.DOOR_NONE && type === sensitPayload.PAYLOAD_TYPE_V3 ?
+      sensitPayload.DOOR_NOT_CALIBRATED : door;
+  } else {
+    target.door = undefined;
+  }
+  target.eventCounter = (mode === sensitPayload.MODE_DOOR || mode === sensitPayload.MODE_MAGNET ||
+    mode === sensitPayload.MODE_VIBRATION) && isModeSent ? intoData[DATA_INTO_EVENT_COUNTER] : undefined;
+  target.magnet = mode === sensitPayload.MODE_MAGNET && isModeSent ?
+    intoData[DATA_INTO_MAGNET] === sensitPayload.MAGNET_DETECTED : undefined;
+  target.vibration = mode === sensitPayload.MODE_VIBRATION && isModeSent ?
+    intoData[DATA_INTO_VIBRATION] === sensitPayload.VIBRATION_ONGOING : undefined;
+  target.button = button === sensitPayload.BUTTON_PRESSED;
+  target.battery = getBatteryPercentage(batteryLevel);
+  target.batteryIndicator = getBatteryIndicator(batteryLevel);
+  target.batteryLevel = batteryLevel;
+  target.modeCode = mode;
+  target.mode = sensitPayload.MODES[mode];
+  return target;
+}
+
+/**
+ * Create an object with every property parseConfigInto() may set
+ *
+ * @return {Object}
+ */
+
+sensitPayload.createConfig = () => ({
+  isStandByPeriodic: undefined,
+  isTemperaturePeriodic: undefined,
+  isLightPeriodic: undefined,
+  isDoorPeriodic: undefined,
+  isVibrationPeriodic: undefined,
+  isMagnetPeriodic: undefined,
+  vibrationClearTime: undefined,
+  lightThreshold: undefined,
+  lightUpper: undefined,
+  lightLower: undefined,
+  temperatureLower: 0,
+  temperatureUpper: 0,
+  humidityLower: 0,
+  humidityUpper: 0,
+  vibrationSensitivity: 0,
+  door: 0,
+  period: 0,
+  limited: false
+});
+
+/**
+ * Parse Sensit payload "config" part made of 8 bytes into `target`, the
+ * properties of the other payload type are set to undefined. Same values
+ * as parseConfig() without allocating, use createConfig() to create `target`
+ *
+ * @param {String} payload
+ * @param {Number} type
+ * @param {Object} target
+ *
+ * @return {Object} target
+ */
+
+sensitPayload.parseConfigInto = (payload, type, target) => {
+  if (payload.length !== 16) {
+    throw new Error('Sensit payload "config" part is made of 16 hexadecimal characters');
+  }
+  if (!/^[0-9a-fA-F]+$/.test(payload)) {
+    throw new TypeError('Sensit payload "config" part is made of 16 hexadecimal characters');
+  }
+  intoPayload.write(payload, 0, 8, 'hex');
+  lib.parseConfigInto(intoPayload, type, intoConfig);
+
+  const isV3 = type === sensitPayload.PAYLOAD_TYPE_V3;
+  const isV2 = type === sensitPayload.PAYLOAD_TYPE_V2;
+  target.isStandByPeriodic = isV3 ? !!intoConfig[CONFIG_INTO_STANDBY_PERIODIC] : undefined;
+  target.isTemperaturePeriodic = isV3 ? !!intoConfig[CONFIG_INTO_TEMPERATURE_PERIODIC] : undefined;
+  target.isLightPeriodic = isV3 ? !!intoConfig[CONFIG_INTO_LIGHT_PERIODIC] : undefined;
+  target.isDoorPeriodic = isV3 ? !!intoConfig[CONFIG_INTO_DOOR_PERIODIC] : undefined;
+  target.isVibrationPeriodic = isV3 ? !!intoConfig[CONFIG_INTO_VIBRATION_PERIODIC] : undefined;
+  target.isMagnetPeriodic = isV3 ? !!intoConfig[CONFIG_INTO_MAGNET_PERIODIC] : undefined;
+  target.vibrationClearTime = isV3 ? intoConfig[CONFIG_INTO_DELAY] : undefined;
+  target.lightThreshold = isV3 ? intoConfig[CONFIG_INTO_BRIGHTNESS] : undefined;
+  target.lightUpper = isV2 ? intoConfig[CONFIG_INTO_BRIGHTNESS_HIGH] / 96 : undefined;
+  target.lightLower = isV2 ? intoConfig[CONFIG_INTO_BRIGHTNESS_LOW] / 96 : undefined;
+  target.temperatureLower = intoConfig[CONFIG_INTO_TEMPERATURE_LOW];
+  target.temperatureUpper = intoConfig[CONFIG_INTO_TEMPERATURE_HIGH];
+  target.humidityLower = intoConfig[CONFIG_INTO_HUMIDITY_LOW];
+  target.humidityUpper = intoConfig[CONFIG_INTO_HUMIDITY_HIGH];
+  target.vibrationSensitivity = intoConfig[CONFIG_INTO_VIBRATION];
+  target.door = intoConfig[CONFIG_INTO_DOOR];
+  target.period = intoConfig[CONFIG_INTO_PERIOD];
+  target.limited = !!intoConfig[CONFIG_INTO_LIMITED];
+  return target;
+};
+
+/*
+ * Raw bits layout, see sensit_payload_v2.h & sensit_payload_v3.h
+ */
+
+const PAYLOAD_V3_ID = 0b110;
+const V2_FRAME_TYPE_BUTTON = 0b01;
+const V2_FRAME_TYPE_ALERT = 0b10;
+const BATTERY_OFFSET = 2700;
+const BATTERY_STEP = 50;
+const TEMPERATURE_OFFSET = -200;
+
+/**
+ * View over the 4 bytes "data" part of a payload held in a Buffer, each
+ * property is decoded from the raw bits when read. Properties have the
+ * same names and raw units as the native decoder: fields not relevant
+ * to the mode are 0. The view can be moved along a batch with reset()
+ */
+
+class PayloadView {
+  /**
+   * @param {Buffer} buffer
+   * @param {Number} offset - default to 0
+   */
+
+  constructor(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+  }
+
+  /**
+   * Move the view to another payload
+   *
+   * @param {Buffer} buffer
+   * @param {Number} offset - default to 0
+   *
+   * @return {PayloadView} this
+   */
+
+  reset(buffer, offset = 0) {
+    this.buffer = buffer;
+    this.offset = offset;
+    return this;
+  }
+
+  get type() {
+    const reserved = this.buffer[this.offset] & 0b111;
+    if (reserved === PAYLOAD_V3_ID) {
+      return sensitPayload.PAYLOAD_TYPE_V3;
+    }
+    return reserved < PAYLOAD_V3_ID ? sensitPayload.PAYLOAD_TYPE_V2 : 0;
+  }
+
+  get error() {
+    const type = this.type;
+    if (type === 0) {
+      return sensitPayload.PARSE_ERR_TYPE;
+    }
+    return this.mode > sensitPayload.MODE_MAGNET ? sensitPayload.PARSE_ERR_MODE : sensitPayload.PARSE_ERR_NONE;
+  }
+
+  get mode() {
+    const type = this.type;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return this.buffer[this.offset + 1] >> 3;
+    }
+    return type === sensitPayload.PAYLOAD_TYPE_V2 ? this.buffer[this.offset] & 0b111 : 0;
+  }
+
+  get button() {
+    const type = this.type;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return (this.buffer[this.offset + 1] >> 2) & 1;
+    }
+    return type === sensitPayload.PAYLOAD_TYPE_V2 && this.isV2Button() ? 1 : 0;
+  }
+
+  get batteryLevel() {
+    const type = this.type;
+    let battery;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3) {
+      battery = this.buffer[this.offset] >> 3;
+    } else if (type === sensitPayload.PAYLOAD_TYPE_V2) {
+      battery = ((this.buffer[this.offset] >> 7) << 4) | (this.buffer[this.offset + 1] & 0x0F);
+    } else {
+      return 0;
+    }
+    return (battery * BATTERY_STEP) + BATTERY_OFFSET;
+  }
+
+  get temperature() {
+    const type = this.type;
+    const mode = this.mode;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3 && mode === sensitPayload.MODE_TEMPERATURE) {
+      return (((this.buffer[this.offset + 1] & 0b11) << 8) | this.buffer[this.offset + 2]) + TEMPERATURE_OFFSET;
+    }
+    if (type === sensitPayload.PAYLOAD_TYPE_V2 && (mode === sensitPayload.MODE_TEMPERATURE || this.isV2Button())) {
+      return (((this.buffer[this.offset + 1] >> 4) << 6) | (this.buffer[this.offset + 2] & 0x3F)) + TEMPERATURE_OFFSET;
+    }
+    return 0;
+  }
+
+  get humidity() {
+    return this.isModeValue(sensitPayload.MODE_TEMPERATURE) ? this.buffer[this.offset + 3] : 0;
+  }
+
+  get brightness() {
+    if (!this.isModeValue(sensitPayload.MODE_LIGHT)) {
+      return 0;
+    }
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return (this.buffer[this.offset + 2] << 8) | this.buffer[this.offset + 3];
+    }
+    // v2 light is a 6 bits value with a 2 bits multiplier
+    const light = this.buffer[this.offset + 2];
+    return (light & 0x3F) * [1, 8, 64, 1024][light >> 6];
+  }
+
+  get door() {
+    if (!this.isModeValue(sensitPayload.MODE_DOOR)) {
+      return 0;
+    }
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return this.buffer[this.offset + 1] & 0b11;
+    }
+    return this.isV2Alert() ? sensitPayload.DOOR_MOVEMENT : sensitPayload.DOOR_NONE;
+  }
+
+  get vibration() {
+    if (!this.isModeValue(sensitPayload.MODE_VIBRATION)) {
+      return 0;
+    }
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return (this.buffer[this.offset + 1] & 0b11) ? 1 : 0;
+    }
+    return this.isV2Alert() ? 1 : 0;
+  }
+
+  get magnet() {
+    if (!this.isModeValue(sensitPayload.MODE_MAGNET)) {
+      return 0;
+    }
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return (this.buffer[this.offset + 1] & 0b11) ? 1 : 0;
+    }
+    return (this.buffer[this.offset + 2] >> 6) & 1;
+  }
+
+  get eventCounter() {
+    if (!this.isModeValue(sensitPayload.MODE_DOOR) && !this.isModeValue(sensitPayload.MODE_VIBRATION) &&
+      !this.isModeValue(sensitPayload.MODE_MAGNET)) {
+      return 0;
+    }
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return (this.buffer[this.offset + 2] << 8) | this.buffer[this.offset + 3];
+    }
+    return this.buffer[this.offset + 3];
+  }
+
+  get versionMajor() {
+    const type = this.type;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3 && this.mode === sensitPayload.MODE_STANDBY) {
+      return this.buffer[this.offset + 2] >> 4;
+    }
+    if (type === sensitPayload.PAYLOAD_TYPE_V2 && (this.mode === sensitPayload.MODE_STANDBY || this.isV2Button())) {
+      return this.buffer[this.offset + 3] >> 4;
+    }
+    return 0;
+  }
+
+  get versionMinor() {
+    const type = this.type;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3 && this.mode === sensitPayload.MODE_STANDBY) {
+      return ((this.buffer[this.offset + 2] & 0x0F) << 4) | (this.buffer[this.offset + 3] >> 6);
+    }
+    if (type === sensitPayload.PAYLOAD_TYPE_V2 && (this.mode === sensitPayload.MODE_STANDBY || this.isV2Button())) {
+      return this.buffer[this.offset + 3] & 0x0F;
+    }
+    return 0;
+  }
+
+  get versionPatch() {
+    if (this.type === sensitPayload.PAYLOAD_TYPE_V3 && this.mode === sensitPayload.MODE_STANDBY) {
+      return this.buffer[this.offset + 3] & 0x3F;
+    }
+    return 0;
+  }
+
+  /**
+   * Tell if the payload is a v2 button frame, which only holds the
+   * temperature and the version whatever the mode
+   *
+   * @return {Boolean}
+   */
+
+  isV2Button() {
+    return ((this.buffer[this.offset] >> 5) & 0b11) === V2_FRAME_TYPE_BUTTON;
+  }
+
+  isV2Alert() {
+    return ((this.buffer[this.offset] >> 5) & 0b11) === V2_FRAME_TYPE_ALERT;
+  }
+
+  /**
+   * Tell if the payload holds the value of the given mode
+   *
+   * @param {Number} mode
+   *
+   * @return {Boolean}
+   */
+
+  isModeValue(mode) {
+    const type = this.type;
+    if (type === sensitPayload.PAYLOAD_TYPE_V3) {
+      return this.mode === mode;
+    }
+    return type === sensitPayload.PAYLOAD_TYPE_V2 && this.mode === mode && !this.isV2Button();
+  }
+
+  /**
+   * Decode every field, same result as parseData()
+   *
+   * @return {Object}
+   */
+
+  format() {
+    return formatData(this);
+  }
+}
+
+sensitPayload.PayloadView = PayloadView;
+sensitPayload.createPayloadView = (buffer, offset) => new PayloadView(buffer, offset);
+
 /**
  * Serialize Sens'it config object representation into a hexadecimal string
  *
@@ -406,6 +1197,1437 @@ sensitPayload.serializeV2Config = config => lib.serializeConfig(config, sensitPa
 sensitPayload.serializeV3Config = config => lib.serializeConfig(config, sensitPayload.PAYLOAD_TYPE_V3).toString('hex');
 
 
+/**
+ * Convert a Sigfox device id (hexadecimal string or number) into a number
+ *
+ * @param {String|Number} device
+ *
+ * @return {Number}
+ */
+
+function toDeviceId(device) {
+  return typeof device === 'string' ? parseInt(device, 16) >>> 0 : device >>> 0;
+}
+
+/**
+ * Convert a list of Sigfox device ids into a Uint32Array
+ *
+ * @param {Array|Uint32Array} devices
+ *
+ * @return {Uint32Array}
+ */
+
+function toDeviceIds(devices) {
+  if (devices instanceof Uint32Array) {
+    return devices;
+  }
+  const ids = new Uint32Array(devices.length);
+  for (let i = 0; i < devices.length; i++) {
+    ids[i] = toDeviceId(devices[i]);
+  }
+  return ids;
+}
+
+/**
+ * Concatenate hexadecimal payloads of `size` bytes into a Buffer,
+ * a Buffer is used as is
+ *
+ * @param {Array|Buffer} payloads
+ * @param {Number} size - size of one payload in bytes
+ *
+ * @return {Buffer}
+ */
+
+function toPayloadBuffer(payloads, size) {
+  if (Buffer.isBuffer(payloads)) {
+    if (payloads.length % size !== 0) {
+      throw new Error(`Sensit payloads Buffer length must be a multiple of ${size}`);
+    }
+    return payloads;
+  }
+  const buffer = Buffer.alloc(payloads.length * size);
+  payloads.forEach((payload, index) => {
+    if (payload.length !== size * 2) {
+      throw new Error(`Sensit payload is made of ${size * 2} hexadecimal characters`);
+    }
+    // write() stops at the first character that is not hexadecimal
+    if (buffer.write(payload, index * size, size, 'hex') !== size) {
+      throw new TypeError(`Sensit payload is made of ${size * 2} hexadecimal characters`);
+    }
+  });
+  return buffer;
+}
+
+/**
+ * Convert an optional list of numbers into a Uint32Array
+ *
+ * @param {Array|Uint32Array} values
+ *
+ * @return {Uint32Array|undefined}
+ */
+
+function toUint32Array(values) {
+  if (values === undefined || values instanceof Uint32Array) {
+    return values;
+  }
+  return Uint32Array.from(values);
+}
+
+/**
+ * Drop the copies of an uplink received through several base stations,
+ * keyed by (device id, seqNumber), before parsing them
+ */
+
+class Deduplicator {
+  /**
+   * @param {Object} options
+   * @param {Number} options.capacity - number of devices tracked, default to 2^20
+   */
+
+  constructor({ capacity } = {}) {
+    this.native = new lib.Deduplicator(capacity);
+  }
+
+  /**
+   * Record an uplink and tell if it was already seen
+   *
+   * @param {String|Number} device
+   * @param {Number} seqNumber
+   *
+   * @return {Boolean}
+   */
+
+  isDuplicate(device, seqNumber) {
+    return !this.native.check(toDeviceId(device), seqNumber);
+  }
+
+  /**
+   * Record a batch of uplinks
+   *
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint16Array} seqNumbers
+   *
+   * @return {Uint8Array} 1 for the uplinks to keep, 0 for the duplicates
+   */
+
+  filter(devices, seqNumbers) {
+    if (devices.length !== seqNumbers.length) {
+      throw new Error('devices and seqNumbers must have the same length');
+    }
+    const mask = new Uint8Array(devices.length);
+    this.native.filter(
+      toDeviceIds(devices),
+      seqNumbers instanceof Uint16Array ? seqNumbers : Uint16Array.from(seqNumbers),
+      mask
+    );
+    return mask;
+  }
+
+  /**
+   * @return {Object} lookups, duplicates, outOfWindow, devices, evictions and duplicateRate
+   */
+
+  stats() {
+    const stats = this.native.stats();
+    stats.duplicateRate = stats.lookups ? stats.duplicates / stats.lookups : 0;
+    return stats;
+  }
+
+  reset() {
+    this.native.reset();
+  }
+}
+
+sensitPayload.Deduplicator = Deduplicator;
+sensitPayload.createDeduplicator = options => new Deduplicator(options);
+
+/**
+ * Put the uplinks of each device back in (time, seqNumber) order before
+ * parsing them, releasing them in batches behind a low watermark
+ */
+
+class Reorderer {
+  /**
+   * @param {Object} options
+   * @param {Number} options.lateness - seconds an uplink may arrive after a later one, default to 300
+   * @param {Number} options.depth - uplinks held at most per device, default to 32
+   * @param {Number} options.size - 4 for "data" payloads, 12 for "data" followed by "config", default to 4
+   */
+
+  constructor({ lateness = 300, depth = 32, size = 4 } = {}) {
+    if (size !== 4 && size !== 12) {
+      throw new Error('size must be 4 or 12');
+    }
+    this.size = size;
+    this.native = new lib.Reorderer(lateness, depth, size);
+  }
+
+  /**
+   * Hold a batch of uplinks until the watermark passes their time
+   *
+   * @param {Array|Buffer} payloads - hexadecimal strings or concatenated payloads of `size` bytes
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint16Array} seqNumbers
+   * @param {Array|Uint32Array} times - seconds since epoch
+   *
+   * @return {Uint8Array} 1 for the uplinks too late to be put back in order, not held
+   */
+
+  push(payloads, devices, seqNumbers, times) {
+    const buffer = toPayloadBuffer(payloads, this.size);
+    const count = buffer.length / this.size;
+    if (devices.length !== count || seqNumbers.length !== count || times.length !== count) {
+      throw new Error('payloads, devices, seqNumbers and times must have the same length');
+    }
+    const late = new Uint8Array(count);
+    this.native.push(
+      buffer,
+      toDeviceIds(devices),
+      seqNumbers instanceof Uint16Array ? seqNumbers : Uint16Array.from(seqNumbers),
+      toUint32Array(times),
+      late
+    );
+    return late;
+  }
+
+  /**
+   * Release the uplinks up to the watermark, in time order, and the
+   * oldest uplinks of the devices holding depth uplinks
+   *
+   * @param {Object} options
+   * @param {Number} options.watermark - seconds since epoch, default to the latest time pushed minus the lateness
+   * @param {Number} options.max - uplinks released at most, the next poll returns the others
+   *
+   * @return {Object} `devices`, `seqNumbers`, `times`, `payloads` (concatenated, ready for parseDataBatch()) and `watermark`
+   */
+
+  poll({ watermark, max = 0xFFFFFFFF } = {}) {
+    return this.native.poll(watermark, max);
+  }
+
+  /**
+   * Release every uplink held, e.g. before a shutdown. Uplinks pushed
+   * afterwards are late
+   *
+   * @return {Object} see poll()
+   */
+
+  flush() {
+    return this.native.poll(0xFFFFFFFF, 0xFFFFFFFF);
+  }
+
+  /**
+   * @return {Object} devices, held, pushed, released, late, forced and watermark
+   */
+
+  stats() {
+    return this.native.stats();
+  }
+}
+
+sensitPayload.Reorderer = Reorderer;
+sensitPayload.createReorderer = options => new Reorderer(options);
+
+/**
+ * Fields stored by the series store, values keep the unit of the decoder
+ */
+
+sensitPayload.SERIES_FIELDS = {
+  temperature: 0, // Must be divided by 8 to get in °C
+  humidity: 1, // Must be divided by 2 to get in %
+  brightness: 2, // Must be divided by 96 to get in lux
+  batteryLevel: 3, // mV
+  eventCounter: 4
+};
+
+sensitPayload.DOWNSAMPLE_METHODS = {
+  lttb: 0, // Largest-Triangle-Three-Buckets, up to width points
+  minMax: 1 // lowest & highest sample per pixel, up to 2 * width points
+};
+
+/**
+ * Per device compressed history of the decoded values, kept in memory
+ */
+
+class SeriesStore {
+  constructor() {
+    this.native = new lib.SeriesStore();
+  }
+
+  /**
+   * Decode and append a batch of payloads, times of a device must not decrease
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} times - seconds since epoch
+   *
+   * @return {Number} number of payloads rejected because older than the last one of their device
+   */
+
+  append(payloads, devices, times) {
+    const buffer = toPayloadBuffer(payloads, 4);
+    if (devices.length !== buffer.length / 4 || times.length !== buffer.length / 4) {
+      throw new Error('payloads, devices and times must have the same length');
+    }
+    return this.native.append(buffer, toDeviceIds(devices), toUint32Array(times));
+  }
+
+  /**
+   * Read the samples of a field of a device with from <= time <= to
+   *
+   * @param {String|Number} device
+   * @param {String} field - key of sensitPayload.SERIES_FIELDS
+   * @param {Number} from - seconds since epoch, default to 0
+   * @param {Number} to - seconds since epoch, default to the end
+   *
+   * @return {Object} { times: Uint32Array, values: Int32Array }
+   */
+
+  read(device, field, from = 0, to = 0xFFFFFFFF) {
+    if (!(field in sensitPayload.SERIES_FIELDS)) {
+      throw new Error(`Unknown series field ${field}`);
+    }
+    return this.native.read(toDeviceId(device), sensitPayload.SERIES_FIELDS[field], from, to);
+  }
+
+  /**
+   * Downsample the samples of a field of a device with from <= time <= to
+   * to draw them on a chart of width pixels. The cost depends on width,
+   * not on the number of samples of the range.
+   *
+   * @param {String|Number} device
+   * @param {String} field - key of sensitPayload.SERIES_FIELDS
+   * @param {Object} options
+   * @param {Number} options.width - number of pixels (buckets), up to 65536
+   * @param {String} options.method - key of sensitPayload.DOWNSAMPLE_METHODS, default to 'lttb'
+   * @param {Number} options.from - seconds since epoch, default to 0
+   * @param {Number} options.to - seconds since epoch, default to the end
+   *
+   * @return {Object} { times: Uint32Array, values: Int32Array }
+   */
+
+  downsample(device, field, { width, method = 'lttb', from = 0, to = 0xFFFFFFFF } = {}) {
+    if (!(field in sensitPayload.SERIES_FIELDS)) {
+      throw new Error(`Unknown series field ${field}`);
+    }
+    if (!(method in sensitPayload.DOWNSAMPLE_METHODS)) {
+      throw new Error(`Unknown downsampling method ${method}`);
+    }
+    return this.native.downsample(toDeviceId(device), sensitPayload.SERIES_FIELDS[field], from, to, width,
+      sensitPayload.DOWNSAMPLE_METHODS[method]);
+  }
+
+  /**
+   * Encode the samples waiting for a full block
+   */
+
+  flush() {
+    this.native.flush();
+  }
+
+  /**
+   * @return {Object} devices, samples, encodedSamples, encodedBytes and bitsPerSample
+   */
+
+  stats() {
+    const stats = this.native.stats();
+    stats.bitsPerSample = stats.encodedSamples ? (stats.encodedBytes * 8) / stats.encodedSamples : 0;
+    return stats;
+  }
+}
+
+sensitPayload.SeriesStore = SeriesStore;
+sensitPayload.createSeriesStore = () => new SeriesStore();
+
+/**
+ * Forecast the battery depletion of every device from the battery
+ * level of its uplinks, with an online linear regression per device
+ */
+
+class BatteryForecaster {
+  /**
+   * @param {Object} options
+   * @param {Number} options.halfLife - age in days at which a sample weights half, default to 30
+   */
+
+  constructor({ halfLife } = {}) {
+    this.native = new lib.BatteryForecaster(halfLife);
+  }
+
+  /**
+   * Decode a batch of payloads and add their battery level, times of a
+   * device must not decrease
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} times - seconds since epoch
+   *
+   * @return {Number} number of payloads rejected, not parsable or older than the last one of their device
+   */
+
+  update(payloads, devices, times) {
+    const buffer = toPayloadBuffer(payloads, 4);
+    if (devices.length !== buffer.length / 4 || times.length !== buffer.length / 4) {
+      throw new Error('payloads, devices and times must have the same length');
+    }
+    return this.native.update(buffer, toDeviceIds(devices), toUint32Array(times));
+  }
+
+  /**
+   * Fitted battery of a device
+   *
+   * @param {String|Number} device
+   *
+   * @return {Object|undefined} level (mV), slope (mV per day, 0 until reliable), time and samples
+   */
+
+  get(device) {
+    return this.native.get(toDeviceId(device));
+  }
+
+  /**
+   * Devices predicted to be below `below` mV within `withinDays` days,
+   * sorted by the time they are predicted to cross it
+   *
+   * @param {Object} options
+   * @param {Number} options.below - battery level in mV
+   * @param {Number} options.withinDays
+   * @param {Number} options.now - seconds since epoch, default to now
+   *
+   * @return {Object} { devices: Uint32Array, times: Uint32Array }
+   */
+
+  query({ below, withinDays, now = Math.floor(Date.now() / 1000) }) {
+    return this.native.query(below, Math.round(withinDays * 86400), now);
+  }
+
+  /**
+   * @return {Number} number of devices
+   */
+
+  size() {
+    return this.native.size();
+  }
+}
+
+sensitPayload.BatteryForecaster = BatteryForecaster;
+sensitPayload.createBatteryForecaster = options => new BatteryForecaster(options);
+
+/**
+ * Fields watched by a rule with the factor from their unit
+ * (°C, %, lux, mV) to the raw unit of the decoder
+ */
+
+sensitPayload.RULE_FIELDS = {
+  temperature: { code: 0, factor: 8 },
+  humidity: { code: 1, factor: 2 },
+  light: { code: 2, factor: 96 },
+  batteryLevel: { code: 3, factor: 1 }
+};
+sensitPayload.RULE_STATES = ['low', 'normal', 'high'];
+
+const RULE_SOURCES = { fleet: 0, config: 1 };
+const INT32_MIN = -2147483648;
+const INT32_MAX = 2147483647;
+
+/**
+ * Raise threshold alerts on batches of payloads, only the state
+ * transitions ('low', 'normal', 'high') of each device are reported
+ */
+
+class RuleEngine {
+  constructor() {
+    this.native = new lib.RuleEngine();
+  }
+
+  /**
+   * Add a rule, at most 16
+   *
+   * @param {Object} rule
+   * @param {String} rule.field - key of sensitPayload.RULE_FIELDS
+   * @param {String} rule.source - 'fleet' (default) to use low & high, 'config' to use the thresholds of the device config
+   * @param {Number} rule.low - 'fleet' only, in the unit of the field
+   * @param {Number} rule.high - 'fleet' only, in the unit of the field
+   * @param {Number} rule.hysteresis - distance to go back inside a limit to return to 'normal', default to 0
+   * @param {Number} rule.debounce - consecutive payloads required to change state, default to 1
+   *
+   * @return {Number} index of the rule
+   */
+
+  addRule({ field, source = 'fleet', low, high, hysteresis = 0, debounce = 1 }) {
+    const ruleField = sensitPayload.RULE_FIELDS[field];
+    if (!ruleField) {
+      throw new Error(`Unknown rule field ${field}`);
+    }
+    if (!(source in RULE_SOURCES)) {
+      throw new Error(`Unknown rule source ${source}`);
+    }
+    return this.native.addRule(
+      ruleField.code,
+      RULE_SOURCES[source],
+      low === undefined ? INT32_MIN : Math.round(low * ruleField.factor),
+      high === undefined ? INT32_MAX : Math.round(high * ruleField.factor),
+      Math.round(hysteresis * ruleField.factor),
+      debounce
+    );
+  }
+
+  /**
+   * Set the config of a device, used by the 'config' rules
+   *
+   * @param {String|Number} device
+   * @param {String} config - 16 hexadecimal characters
+   * @param {Number} payloadType
+   */
+
+  setConfig(device, config, payloadType) {
+    if (config.length !== 16) {
+      throw new Error('Sensit payload "config" part is made of 16 hexadecimal characters');
+    }
+    this.native.setConfig(toDeviceId(device), Buffer.from(config, 'hex'), payloadType);
+  }
+
+  /**
+   * Evaluate every rule on a batch of payloads
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   * @param {Array|Uint32Array} devices
+   *
+   * @return {Array} transitions { row, device, rule, from, to } in the order of the batch
+   */
+
+  evaluate(payloads, devices) {
+    const buffer = toPayloadBuffer(payloads, 4);
+    const ids = toDeviceIds(devices);
+    if (ids.length !== buffer.length / 4) {
+      throw new Error('payloads and devices must have the same length');
+    }
+    const events = this.native.evaluate(buffer, ids);
+    const transitions = new Array(events.rows.length);
+    for (let i = 0; i < events.rows.length; i++) {
+      transitions[i] = {
+        row: events.rows[i],
+        device: ids[events.rows[i]],
+        rule: events.rules[i],
+        from: sensitPayload.RULE_STATES[events.from[i]],
+        to: sensitPayload.RULE_STATES[events.to[i]]
+      };
+    }
+    return transitions;
+  }
+}
+
+sensitPayload.RuleEngine = RuleEngine;
+sensitPayload.createRuleEngine = () => new RuleEngine();
+
+sensitPayload.TIMELINE_KINDS = [undefined, 'open', 'closed', 'vibration', 'movement'];
+sensitPayload.TIMELINE_END_REASONS = ['event', 'gap', 'mode', 'expired'];
+
+/**
+ * Convert the words written by the native timeline into interval objects
+ *
+ * @param {Uint32Array} words - 6 words per interval
+ *
+ * @return {Array}
+ */
+
+function toIntervals(words) {
+  const intervals = new Array(words.length / 6);
+  for (let i = 0; i < intervals.length; i++) {
+    const offset = i * 6;
+    intervals[i] = {
+      device: words[offset],
+      kind: sensitPayload.TIMELINE_KINDS[words[offset + 5] & 0xFF],
+      start: words[offset + 1],
+      end: words[offset + 2],
+      duration: words[offset + 2] - words[offset + 1],
+      events: words[offset + 3],
+      missed: words[offset + 4],
+      endReason: sensitPayload.TIMELINE_END_REASONS[words[offset + 5] >> 8]
+    };
+  }
+  return intervals;
+}
+
+/**
+ * Rebuild door open/closed intervals and vibration or movement sessions
+ * from the uplinks of the DOOR & VIBRATION modes
+ */
+
+class Timeline {
+  /**
+   * @param {Object} options
+   * @param {Number} options.sessionGap - seconds without alert closing a v2 session, default to 60
+   */
+
+  constructor({ sessionGap } = {}) {
+    this.native = new lib.Timeline(sessionGap);
+  }
+
+  /**
+   * Decode a batch of payloads, times of a device must not decrease
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} times - seconds since epoch
+   *
+   * @return {Array} intervals closed by the batch
+   */
+
+  process(payloads, devices, times) {
+    const buffer = toPayloadBuffer(payloads, 4);
+    if (devices.length !== buffer.length / 4 || times.length !== buffer.length / 4) {
+      throw new Error('payloads, devices and times must have the same length');
+    }
+    return toIntervals(this.native.process(buffer, toDeviceIds(devices), toUint32Array(times)));
+  }
+
+  /**
+   * Close the intervals of the devices silent for more than `idle` seconds
+   * and forget them, as well as the v2 sessions older than the session gap
+   *
+   * @param {Number} now - seconds since epoch
+   * @param {Number} idle - seconds, default to 1 day
+   *
+   * @return {Array} intervals closed
+   */
+
+  expire(now, idle = 86400) {
+    return toIntervals(this.native.expire(now, idle));
+  }
+
+  /**
+   * @return {Number} number of devices tracked
+   */
+
+  size() {
+    return this.native.size();
+  }
+}
+
+sensitPayload.Timeline = Timeline;
+sensitPayload.createTimeline = options => new Timeline(options);
+
+/**
+ * Desired config of each device, serialized once, answering downlink
+ * requests only when the device has not reported it yet
+ */
+
+class DownlinkStore {
+  constructor() {
+    this.native = new lib.DownlinkStore();
+    this.downlink = Buffer.alloc(8);
+  }
+
+  /**
+   * Set the desired configs of devices, a config older than the version
+   * already set for its device is ignored
+   *
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Buffer} configs - 16 hexadecimal strings, e.g. from serializeConfig(), or concatenated 8 bytes configs
+   * @param {Array|Uint32Array|Number} versions - one per device, or the same for all, default to 0
+   *
+   * @return {Number} number of configs ignored as older
+   */
+
+  set(devices, configs, versions = 0) {
+    const buffer = toPayloadBuffer(configs, 8);
+    if (devices.length !== buffer.length / 8) {
+      throw new Error('devices and configs must have the same length');
+    }
+    const versionArray = typeof versions === 'number'
+      ? new Uint32Array(devices.length).fill(versions)
+      : toUint32Array(versions);
+    if (versionArray.length !== devices.length) {
+      throw new Error('devices and versions must have the same length');
+    }
+    return this.native.set(buffer, toDeviceIds(devices), versionArray);
+  }
+
+  /**
+   * Forget the desired configs of devices
+   *
+   * @param {Array|Uint32Array} devices
+   */
+
+  clear(devices) {
+    this.native.clear(toDeviceIds(devices));
+  }
+
+  /**
+   * Record the configs reported by devices
+   *
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Buffer} payloads - 24 hexadecimal strings or concatenated 12 bytes payloads
+   */
+
+  report(devices, payloads) {
+    const buffer = toPayloadBuffer(payloads, 12);
+    if (devices.length !== buffer.length / 12) {
+      throw new Error('devices and payloads must have the same length');
+    }
+    this.native.report(buffer, toDeviceIds(devices));
+  }
+
+  /**
+   * Downlink to answer to a device
+   *
+   * @param {String|Number} device
+   * @param {String|Buffer} payload - optional 24 hexadecimal payload of the request, recorded first
+   *
+   * @return {Object|null} `{ config, version }` with the 16 hexadecimal config, null if there is nothing to send
+   */
+
+  answer(device, payload) {
+    let uplink;
+    if (payload !== undefined) {
+      uplink = Buffer.isBuffer(payload) ? payload : Buffer.from(payload, 'hex');
+      if (uplink.length !== 12) {
+        throw new Error('Sensit payload is made of 24 hexadecimal characters');
+      }
+    }
+    const version = this.native.answer(toDeviceId(device), uplink, this.downlink);
+    return version < 0 ? null : { config: this.downlink.toString('hex'), version };
+  }
+
+  /**
+   * @param {String|Number} device
+   *
+   * @return {Object|undefined} `desired` and `reported` 16 hexadecimal configs and `version`, when known
+   */
+
+  get(device) {
+    const configs = this.native.get(toDeviceId(device));
+    if (configs === undefined) {
+      return undefined;
+    }
+    const res = {};
+    if (configs.desired) {
+      res.desired = configs.desired.toString('hex');
+      res.version = configs.version;
+    }
+    if (configs.reported) {
+      res.reported = configs.reported.toString('hex');
+    }
+    return res;
+  }
+
+  /**
+   * @return {Object} `devices` known and `pending`, devices with a desired config not reported yet
+   */
+
+  stats() {
+    return this.native.stats();
+  }
+}
+
+sensitPayload.DownlinkStore = DownlinkStore;
+sensitPayload.createDownlinkStore = () => new DownlinkStore();
+
+/**
+ * Devices gone silent: every uplink re-arms the deadline of its device
+ * from its uplink period, a device expires when it misses it
+ */
+
+class Watchdog {
+  /**
+   * @param {Object} options
+   * @param {Number} options.missed - periods without uplink before a device expires, default to 1
+   * @param {Number} options.grace - seconds added to the deadline, default to 300
+   * @param {Number} options.defaultPeriod - seconds, period of a v3 until it reports its config, default to 3600
+   */
+
+  constructor({ missed = 1, grace = 300, defaultPeriod = 3600 } = {}) {
+    this.native = new lib.Watchdog(missed, grace, defaultPeriod);
+  }
+
+  /**
+   * Re-arm the devices of a batch of uplinks. A v3 in a mode that is not
+   * periodic in its last config only sends on events and is not watched
+   *
+   * @param {Array|Buffer} payloads - hexadecimal strings or concatenated payloads of `size` bytes
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} times - seconds since epoch
+   * @param {Number} size - 4 for "data" payloads, 12 for "data" followed by "config", default to the length of the strings or 4
+   *
+   * @return {Number} number of payloads that could not be decoded
+   */
+
+  uplink(payloads, devices, times, size) {
+    const payloadSize = size || (!Buffer.isBuffer(payloads) && payloads.length > 0 ? payloads[0].length / 2 : 4);
+    const buffer = toPayloadBuffer(payloads, payloadSize);
+    if (devices.length !== buffer.length / payloadSize || times.length !== buffer.length / payloadSize) {
+      throw new Error('payloads, devices and times must have the same length');
+    }
+    return this.native.uplink(buffer, payloadSize, toDeviceIds(devices), toUint32Array(times));
+  }
+
+  /**
+   * Set the deadlines of devices, e.g. to restore them after a restart
+   *
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} lastTimes - last uplink of each device, seconds since epoch
+   * @param {Array|Uint32Array} deadlines - seconds since epoch, 0 to stop watching the device
+   */
+
+  arm(devices, lastTimes, deadlines) {
+    if (lastTimes.length !== devices.length || deadlines.length !== devices.length) {
+      throw new Error('devices, lastTimes and deadlines must have the same length');
+    }
+    this.native.arm(toDeviceIds(devices), toUint32Array(lastTimes), toUint32Array(deadlines));
+  }
+
+  /**
+   * Forget devices
+   *
+   * @param {Array|Uint32Array} devices
+   */
+
+  remove(devices) {
+    this.native.remove(toDeviceIds(devices));
+  }
+
+  /**
+   * Devices whose deadline is passed. They are reported once, until
+   * their next uplink re-arms them
+   *
+   * @param {Number} now - seconds since epoch
+   * @param {Number} max - devices returned at most, the next poll returns the others
+   *
+   * @return {Object} `devices` and their `lastTimes`, as Uint32Arrays
+   */
+
+  poll(now, max = 0xFFFFFFFF) {
+    return this.native.poll(now, max);
+  }
+
+  /**
+   * @return {Object} `devices` known and `armed`, devices watched
+   */
+
+  stats() {
+    return this.native.stats();
+  }
+}
+
+sensitPayload.Watchdog = Watchdog;
+sensitPayload.createWatchdog = options => new Watchdog(options);
+
+/**
+ * Fields of the sketch histograms, and the divisor of the raw value of
+ * the decoder to get their unit
+ */
+
+sensitPayload.SKETCH_FIELDS = {
+  temperature: 0, // °C
+  humidity: 1, // %
+  brightness: 2, // lux
+  batteryLevel: 3 // mV
+};
+
+const SKETCH_DIVISORS = [8, 2, 96, 1];
+
+/**
+ * Summary of a window of uplinks, of a size independent of the number
+ * of uplinks: a histogram per field for quantiles and a HyperLogLog of
+ * the distinct devices. Sketches of different processes merge through
+ * their serialized form
+ */
+
+class Sketch {
+  /**
+   * @param {Buffer} serialized - optional, start from a serialized sketch
+   */
+
+  constructor(serialized) {
+    this.native = new lib.Sketch();
+    if (serialized) {
+      this.merge(serialized);
+    }
+  }
+
+  /**
+   * Decode a batch of payloads and add the values valid for their mode
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   * @param {Array|Uint32Array} devices - optional, counted in the distinct devices
+   *
+   * @return {Number} number of payloads without parsing error
+   */
+
+  update(payloads, devices) {
+    const buffer = toPayloadBuffer(payloads, 4);
+    if (devices && devices.length !== buffer.length / 4) {
+      throw new Error('payloads and devices must have the same length');
+    }
+    if (devices) {
+      this.addDevices(devices);
+    }
+    return this.native.update(buffer);
+  }
+
+  /**
+   * @param {Array|Uint32Array} devices
+   */
+
+  addDevices(devices) {
+    this.native.addDevices(toDeviceIds(devices));
+  }
+
+  /**
+   * Nearest rank quantiles of a field: exact for temperature, humidity
+   * and batteryLevel, within 1.6% for brightness
+   *
+   * @param {String} field - key of sensitPayload.SKETCH_FIELDS
+   * @param {Array} qs - between 0 (minimum) and 1 (maximum), default to p50, p95 & p99
+   *
+   * @return {Array} values in °C, %, lux or mV, NaN when no value was added
+   */
+
+  quantiles(field, qs = [0.5, 0.95, 0.99]) {
+    if (!(field in sensitPayload.SKETCH_FIELDS)) {
+      throw new Error(`Unknown sketch field ${field}`);
+    }
+    const index = sensitPayload.SKETCH_FIELDS[field];
+    const values = this.native.quantiles(index, Float64Array.from(qs));
+    return Array.from(values, value => value / SKETCH_DIVISORS[index]);
+  }
+
+  /**
+   * @param {String} field - key of sensitPayload.SKETCH_FIELDS
+   * @param {Number} q - between 0 and 1
+   *
+   * @return {Number}
+   */
+
+  quantile(field, q) {
+    return this.quantiles(field, [q])[0];
+  }
+
+  /**
+   * @param {String} field - key of sensitPayload.SKETCH_FIELDS
+   *
+   * @return {Number} number of values added to the field
+   */
+
+  count(field) {
+    if (!(field in sensitPayload.SKETCH_FIELDS)) {
+      throw new Error(`Unknown sketch field ${field}`);
+    }
+    return this.native.count(sensitPayload.SKETCH_FIELDS[field]);
+  }
+
+  /**
+   * @return {Number} estimated number of distinct devices, within ~0.8%
+   */
+
+  distinct() {
+    return Math.round(this.native.distinct());
+  }
+
+  /**
+   * Add the uplinks of another sketch
+   *
+   * @param {Sketch|Buffer} other - sketch or serialized sketch
+   *
+   * @return {Sketch} this
+   */
+
+  merge(other) {
+    this.native.merge(other instanceof Sketch ? other.serialize() : other);
+    return this;
+  }
+
+  /**
+   * @return {Buffer} compact form, a few bytes per non-empty bucket
+   */
+
+  serialize() {
+    return this.native.serialize();
+  }
+
+  /**
+   * Empty the sketch, to reuse it for the next window
+   */
+
+  reset() {
+    this.native.reset();
+  }
+}
+
+sensitPayload.Sketch = Sketch;
+sensitPayload.createSketch = serialized => new Sketch(serialized);
+
+/**
+ * Fields of the payload index, every value of a field has its bitmap
+ */
+
+sensitPayload.INDEX_FIELDS = {
+  mode: 0, // MODE_*, payloads without parsing error
+  button: 1, // true or false, payloads without parsing error
+  type: 2, // PAYLOAD_TYPE_*
+  door: 3, // DOOR_*, payloads of mode DOOR, as parseData()
+  error: 4, // PARSE_ERR_*
+  batteryLevel: 5 // mV, or { min, max } in mV, payloads without parsing error
+};
+
+const INDEX_OP_LEAF = 0;
+const INDEX_OP_AND = 1;
+const INDEX_OP_OR = 2;
+const INDEX_OP_ANDNOT = 3;
+const INDEX_BATTERY_BUCKETS = 32;
+
+/**
+ * Bitmap values of a field of a query leaf
+ *
+ * @param {String} field - key of sensitPayload.INDEX_FIELDS
+ * @param {*} value - value, array of values or battery level range
+ *
+ * @return {Array} values of the bitmaps to OR
+ */
+
+function toIndexValues(field, value) {
+  if (field === 'batteryLevel' && typeof value === 'object' && !Array.isArray(value)) {
+    const { min = BATTERY_OFFSET, max = BATTERY_OFFSET + ((INDEX_BATTERY_BUCKETS - 1) * BATTERY_STEP) } = value;
+    const first = Math.max(Math.ceil((min - BATTERY_OFFSET) / BATTERY_STEP), 0);
+    const last = Math.min(Math.floor((max - BATTERY_OFFSET) / BATTERY_STEP), INDEX_BATTERY_BUCKETS - 1);
+    if (first > last) {
+      throw new Error(`Empty battery level range ${min} - ${max}`);
+    }
+    return Array.from({ length: (last - first) + 1 }, (bucket, i) => first + i);
+  }
+  const values = Array.isArray(value) ? value : [value];
+  if (values.length === 0) {
+    throw new Error(`No value for the index field ${field}`);
+  }
+  return values.map((item) => {
+    let converted = item;
+    if (field === 'button') {
+      converted = item ? 1 : 0;
+    } else if (field === 'batteryLevel') {
+      converted = Math.round((item - BATTERY_OFFSET) / BATTERY_STEP);
+    }
+    if (!Number.isInteger(converted) || converted < 0 || converted > 0xFF) {
+      throw new Error(`Invalid value ${item} of the index field ${field}`);
+    }
+    return converted;
+  });
+}
+
+/**
+ * Compile a query into the postfix program of the native index
+ *
+ * @param {Object} query - { and: [] }, { or: [] }, { andNot: [] } or { field: value, ... }
+ * @param {Array} program - instructions appended
+ *
+ * @return {Array} program
+ */
+
+function compileIndexQuery(query, program = []) {
+  const fold = (operands, op) => {
+    if (!Array.isArray(operands) || operands.length === 0) {
+      throw new Error('Index query operators take a non-empty array');
+    }
+    operands.forEach((operand, i) => {
+      compileIndexQuery(operand, program);
+      if (i > 0) {
+        program.push(op << 16);
+      }
+    });
+    return program;
+  };
+  if (query === null || typeof query !== 'object') {
+    throw new Error('Index query must be an object');
+  }
+  if ('and' in query) {
+    return fold(query.and, INDEX_OP_AND);
+  }
+  if ('or' in query) {
+    return fold(query.or, INDEX_OP_OR);
+  }
+  if ('andNot' in query) {
+    return fold(query.andNot, INDEX_OP_ANDNOT);
+  }
+  const fields = Object.keys(query);
+  if (fields.length === 0) {
+    throw new Error('Index query without field');
+  }
+  fields.forEach((field, i) => {
+    if (!(field in sensitPayload.INDEX_FIELDS)) {
+      throw new Error(`Unknown index field ${field}`);
+    }
+    toIndexValues(field, query[field]).forEach((value, j) => {
+      program.push((INDEX_OP_LEAF << 16) | (sensitPayload.INDEX_FIELDS[field] << 8) | value);
+      if (j > 0) {
+        program.push(INDEX_OP_OR << 16);
+      }
+    });
+    if (i > 0) {
+      program.push(INDEX_OP_AND << 16);
+    }
+  });
+  return program;
+}
+
+/**
+ * Secondary indexes of stored payloads: a compressed bitmap of row ids
+ * (positions of the payloads in the store) per value of the mode,
+ * button, type, door state, parsing error and battery level. Queries
+ * return the rows to decode instead of decoding every stored payload
+ */
+
+class PayloadIndex {
+  /**
+   * @param {Buffer} serialized - optional, start from a serialized index
+   */
+
+  constructor(serialized) {
+    this.native = new lib.PayloadIndex();
+    if (serialized) {
+      this.native.load(serialized);
+    }
+  }
+
+  /**
+   * Decode a batch of payloads and index them as the next rows
+   *
+   * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+   *
+   * @return {Number} row id of the first payload
+   */
+
+  add(payloads) {
+    return this.native.add(toPayloadBuffer(payloads, 4));
+  }
+
+  /**
+   * Rows matching a query. A leaf { field: value } selects the rows with
+   * that value, an array of values any of them, several fields all of
+   * them; leaves combine with { and: [] }, { or: [] } and
+   * { andNot: [first, ...others] } (rows of first but of no other)
+   *
+   * @param {Object} query - e.g. { and: [{ door: sensitPayload.DOOR_OPEN }, { button: true }] }
+   *
+   * @return {Uint32Array} row ids, increasing
+   */
+
+  query(query) {
+    return this.native.query(Uint32Array.from(compileIndexQuery(query)));
+  }
+
+  /**
+   * @param {Object} query - as query()
+   *
+   * @return {Number} number of rows matching the query
+   */
+
+  count(query) {
+    return this.native.count(Uint32Array.from(compileIndexQuery(query)));
+  }
+
+  /**
+   * @return {Buffer} compact form, to be written to disk next to the payloads
+   */
+
+  serialize() {
+    return this.native.serialize();
+  }
+
+  /**
+   * Remove every row
+   */
+
+  reset() {
+    this.native.reset();
+  }
+
+  /**
+   * @return {Object} rows, bitmaps, containers and bytes
+   */
+
+  stats() {
+    return this.native.stats();
+  }
+}
+
+sensitPayload.PayloadIndex = PayloadIndex;
+sensitPayload.createPayloadIndex = serialized => new PayloadIndex(serialized);
+
+/**
+ * Gather the payloads of some rows, e.g. of PayloadIndex.query(), to
+ * decode them with parseDataBatch()
+ *
+ * @param {Buffer} payloads - concatenated payloads of size bytes
+ * @param {Uint32Array|Array} rows - row ids
+ * @param {Number} size - size of one payload in bytes, default to 4
+ *
+ * @return {Buffer}
+ */
+
+sensitPayload.selectRows = (payloads, rows, size = 4) => {
+  const buffer = toPayloadBuffer(payloads, size);
+  const selected = Buffer.allocUnsafe(rows.length * size);
+  for (let i = 0; i < rows.length; i++) {
+    if (!(rows[i] < buffer.length / size)) {
+      throw new Error(`Row ${rows[i]} out of the payloads`);
+    }
+    buffer.copy(selected, i * size, rows[i] * size, (rows[i] + 1) * size);
+  }
+  return selected;
+};
+
+/**
+ * Load a shared library of decoders for other payload formats (see
+ * payload_decoder_s in src/sensit_payload.h). Its payloads then decode
+ * through every "data" parsing function, batch and columnar ones
+ * included. Decoders cannot be unregistered.
+ *
+ * @param {String} file path of the shared library
+ *
+ * @return {Number} number of decoders registered
+ */
+
+sensitPayload.registerDecoders = file => lib.registerDecoders(path.resolve(file));
+
+/**
+ * Decoders registered, in the order of registration
+ *
+ * @return {Array} of { name, type, keyMask, keyValue }
+ */
+
+sensitPayload.decoders = () => lib.decoders();
+
+/**
+ * Lock-free ring of raw uplinks in shared memory, to pass them from a
+ * receiver process to decoder processes without serializing them.
+ * Any number of processes push, a single one drains. Linux only.
+ */
+
+class Ring {
+  /**
+   * @param {Object} options
+   * @param {String} options.path - shared memory file, e.g. '/dev/shm/sensit', default to an anonymous memfd
+   * @param {Number} options.capacity - number of records, rounded up to a power of 2, default to 65536
+   * @param {Boolean} options.open - map an existing ring instead of creating it
+   */
+
+  constructor({ path, capacity = 65536, open = false } = {}) {
+    this.native = new lib.Ring(path, capacity, open);
+    this.path = path || `/proc/${process.pid}/fd/${this.native.stats().fd}`;
+  }
+
+  /**
+   * Publish an uplink, dropped and counted in the overflow if the ring is full
+   *
+   * @param {String|Number} device
+   * @param {Number} time - seconds since epoch
+   * @param {Number} seqNumber
+   * @param {String|Buffer} payload - 4 bytes "data" payload
+   * @param {String|Buffer} config - optional 8 bytes "config" payload
+   *
+   * @return {Boolean} false if the ring was full
+   */
+
+  push(device, time, seqNumber, payload, config) {
+    let buffer = Buffer.isBuffer(payload) ? payload : Buffer.from(payload, 'hex');
+    if (config !== undefined) {
+      buffer = Buffer.concat([buffer, Buffer.isBuffer(config) ? config : Buffer.from(config, 'hex')]);
+    }
+    return this.native.push(toDeviceId(device), time, seqNumber, buffer);
+  }
+
+  /**
+   * Publish a batch of uplinks
+   *
+   * @param {Array|Buffer} payloads - hexadecimal strings or concatenated payloads of `size` bytes
+   * @param {Array|Uint32Array} devices
+   * @param {Array|Uint32Array} times - seconds since epoch
+   * @param {Array|Uint16Array} seqNumbers
+   * @param {Number} size - 4 for "data" payloads (default), 12 for "data" followed by "config"
+   *
+   * @return {Number} number of uplinks pushed, the others are counted in the overflow
+   */
+
+  pushBatch(payloads, devices, times, seqNumbers, size = 4) {
+    const buffer = toPayloadBuffer(payloads, size);
+    const count = buffer.length / size;
+    if (devices.length !== count || times.length !== count || seqNumbers.length !== count) {
+      throw new Error('payloads, devices, times and seqNumbers must have the same length');
+    }
+    return this.native.pushBatch(
+      buffer,
+      size,
+      toDeviceIds(devices),
+      toUint32Array(times),
+      seqNumbers instanceof Uint16Array ? seqNumbers : Uint16Array.from(seqNumbers)
+    );
+  }
+
+  /**
+   * Take the published uplinks in order, single consumer only
+   *
+   * @param {Number} max - default to 4096
+   *
+   * @return {Object} columns `devices`, `times`, `seqNumbers`, `sizes`,
+   *                  `payloads` (concatenated 4 bytes) and `configs`
+   *                  (concatenated 8 bytes, zeros when not pushed)
+   */
+
+  drain(max = 4096) {
+    return this.native.drain(max);
+  }
+
+  /**
+   * Sleep until an uplink is published. Blocks the event loop, meant for
+   * a process dedicated to decoding.
+   *
+   * @param {Number} timeout - milliseconds, default to wait forever
+   *
+   * @return {Boolean} true if the ring is not empty
+   */
+
+  wait(timeout = -1) {
+    return this.native.wait(timeout);
+  }
+
+  /**
+   * @return {Object} `capacity`, `size` (records not drained) and `overflow` (records dropped)
+   */
+
+  stats() {
+    const { capacity, size, overflow } = this.native.stats();
+    return { capacity, size, overflow };
+  }
+
+  /**
+   * Unmap the ring
+   */
+
+  close() {
+    this.native.close();
+  }
+}
+
+sensitPayload.Ring = Ring;
+sensitPayload.createRing = options => new Ring(options);
+sensitPayload.openRing = path => new Ring({ path, open: true });
+
+/**
+ * Decode a batch of "data" payloads into an Apache Arrow IPC stream or file.
+ * Each field of the decoded data is a typed column (raw units, e.g.
+ * temperature must be divided by 8), fields that do not belong to the
+ * mode of a payload are null.
+ *
+ * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+ * @param {Object} options
+ * @param {String} options.format - 'stream' (default) or 'file'
+ * @param {Array|Uint32Array} options.devices - optional "device" column
+ * @param {Array|Uint32Array} options.times - optional "time" column, in seconds since epoch
+ *
+ * @return {Buffer}
+ */
+
+sensitPayload.toArrow = (payloads, { format = 'stream', devices, times } = {}) => {
+  const buffer = toPayloadBuffer(payloads, 4);
+  return lib.toArrowData(
+    buffer,
+    devices && toDeviceIds(devices),
+    toUint32Array(times),
+    format === 'file' ? 1 : 0
+  );
+};
+
+/**
+ * Decode a batch of "config" payloads of the same payload type into an
+ * Apache Arrow IPC stream or file
+ *
+ * @param {Array|Buffer} payloads - 16 hexadecimal strings or concatenated 8 bytes configs
+ * @param {Number} payloadType
+ * @param {Object} options - see sensitPayload.toArrow()
+ *
+ * @return {Buffer}
+ */
+
+sensitPayload.configToArrow = (payloads, payloadType, { format = 'stream', devices, times } = {}) => {
+  if (payloadType !== sensitPayload.PAYLOAD_TYPE_V2 && payloadType !== sensitPayload.PAYLOAD_TYPE_V3) {
+    throw new Error('payload type not defined or not supported');
+  }
+  const buffer = toPayloadBuffer(payloads, 8);
+  return lib.toArrowConfig(
+    buffer,
+    payloadType,
+    devices && toDeviceIds(devices),
+    toUint32Array(times),
+    format === 'file' ? 1 : 0
+  );
+};
+
+/**
+ * Columns of toNdjson() & toCsv(), in the order of the parsed data keys
+ */
+
+sensitPayload.TEXT_COLUMNS = [
+  'error', 'type', 'temperature', 'humidity', 'light', 'version', 'door', 'magnet', 'vibration',
+  'eventCounter', 'button', 'battery', 'batteryIndicator', 'batteryLevel', 'modeCode', 'mode'
+];
+
+/**
+ * Bitmask of the native writers from a list of column names
+ *
+ * @param {Array} columns - default to every column
+ *
+ * @return {Number}
+ */
+
+function toTextColumns(columns) {
+  if (columns === undefined) {
+    return (1 << sensitPayload.TEXT_COLUMNS.length) - 1;
+  }
+  return columns.reduce((mask, column) => {
+    const index = sensitPayload.TEXT_COLUMNS.indexOf(column);
+    if (index < 0) {
+      throw new Error(`Unknown column ${column}`);
+    }
+    return mask | (1 << index);
+  }, 0);
+}
+
+/**
+ * Decode a batch of "data" payloads into NDJSON: each line is the
+ * JSON.stringify() of the data parsed by parseData(), without building
+ * any object. Fields that do not belong to the mode of a payload are omitted.
+ *
+ * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+ * @param {Object} options
+ * @param {Array} options.columns - names of sensitPayload.TEXT_COLUMNS, default to all
+ * @param {Array|Uint32Array} options.devices - optional "device" first key, written in hexadecimal
+ * @param {Array|Uint32Array} options.times - optional "time" key, in seconds since epoch
+ *
+ * @return {Buffer}
+ */
+
+sensitPayload.toNdjson = (payloads, { columns, devices, times } = {}) => {
+  const buffer = toPayloadBuffer(payloads, 4);
+  return lib.toText(buffer, devices && toDeviceIds(devices), toUint32Array(times), 0, toTextColumns(columns), false);
+};
+
+/**
+ * Decode a batch of "data" payloads into CSV, with the values of
+ * toNdjson(). Fields that do not belong to the mode of a payload are empty.
+ *
+ * @param {Array|Buffer} payloads - 8 hexadecimal strings or concatenated 4 bytes payloads
+ * @param {Object} options - see sensitPayload.toNdjson()
+ * @param {Boolean} options.header - start with the line of the column names, default to true
+ *
+ * @return {Buffer}
+ */
+
+sensitPayload.toCsv = (payloads, { columns, devices, times, header = true } = {}) => {
+  const buffer = toPayloadBuffer(payloads, 4);
+  return lib.toText(buffer, devices && toDeviceIds(devices), toUint32Array(times), 1, toTextColumns(columns), header);
+};
+
+
 /**
  * Expose native lib
  */
@@ -0,0 +1,781 @@
+/*!******************************************************************
+ * \file sensit_arrow.c
+ * \brief Functions to write decoded payloads as Apache Arrow IPC
+ * \author Sens'it Team
+ *
+ * Arrow metadata are flatbuffers (Schema.fbs, Message.fbs, File.fbs of
+ * the Arrow format, metadata version V5). They are small and have a
+ * fixed layout, so a minimal back to front flatbuffer builder is used
+ * instead of a dependency on the Arrow library.
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_arrow.h"
+
+/******* DEFINE ****************************************************/
+#define FB_SIZE_MAX 16384
+#define FB_SLOTS_MAX 8
+
+#define ARROW_METADATA_V5 4
+#define ARROW_CONTINUATION 0xFFFFFFFF
+#define ARROW_MAGIC "ARROW1"
+#define ARROW_MAGIC_SIZE 6
+#define ARROW_ALIGNMENT 8
+#define ARROW_COLUMNS_MAX 24
+
+/* MessageHeader union */
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_RECORD_BATCH 3
+
+/* Type union */
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_BOOL 6
+#define ARROW_TYPE_TIMESTAMP 10
+
+#define ARROW_TIME_UNIT_SECOND 0
+
+#define ARROW_PAD(size) (((size) + (ARROW_ALIGNMENT - 1)) & ~((size_t)ARROW_ALIGNMENT - 1))
+#define ARROW_BITMAP_SIZE(count) (((count) + 7) / 8)
+
+/*!******************************************************************
+ * \struct fb_builder_s
+ * \brief Flatbuffer built from the end of buf
+ *******************************************************************/
+typedef struct
+{
+    u8 buf[FB_SIZE_MAX];
+    u32 head;
+    u32 minalign;
+    u32 slots[FB_SLOTS_MAX]; /* Field positions from the end of buf, 0 if absent */
+    u32 slot_count;
+    u32 table_start;
+    bool overflow;
+} fb_builder_s;
+
+/*!******************************************************************
+ * \struct arrow_column_s
+ * \brief Column of a record batch
+ *******************************************************************/
+typedef struct
+{
+    const char *name;
+    u8 type;          /*!< ARROW_TYPE_* */
+    u8 bit_width;     /*!< 1 for ARROW_TYPE_BOOL */
+    bool is_signed;
+    bool nullable;
+    size_t validity_offset;
+    size_t validity_size;
+    size_t values_offset;
+    size_t values_size;
+    u8 *validity;
+    u8 *values;
+    u32 null_count;
+} arrow_column_s;
+
+/*!******************************************************************
+ * \struct arrow_batch_s
+ * \brief Columns & layout of the output
+ *******************************************************************/
+typedef struct
+{
+    arrow_column_s columns[ARROW_COLUMNS_MAX];
+    u32 column_count;
+    u32 length;
+    size_t body_size;
+} arrow_batch_s;
+
+/******* FLATBUFFER BUILDER ****************************************/
+
+static void FB_init(fb_builder_s *fb)
+{
+    fb->head = FB_SIZE_MAX;
+    fb->minalign = 1;
+    fb->slot_count = 0;
+    fb->overflow = FALSE;
+}
+
+static inline u32 FB_size(const fb_builder_s *fb)
+{
+    return FB_SIZE_MAX - fb->head;
+}
+
+static void FB_push(fb_builder_s *fb, const void *bytes, u32 size)
+{
+    if (fb->head < size)
+    {
+        fb->overflow = TRUE;
+        return;
+    }
+    fb->head -= size;
+    memcpy(&(fb->buf[fb->head]), bytes, size);
+}
+
+static void FB_prep(fb_builder_s *fb, u32 size, u32 additional)
+{
+    static const u8 zeros[8] = {0};
+    u32 pad = (~(FB_size(fb) + additional) + 1) & (size - 1);
+
+    if (size > fb->minalign)
+    {
+        fb->minalign = size;
+    }
+    FB_push(fb, zeros, pad);
+}
+
+/* Scalars are written little endian, as on every target of this module */
+static void FB_push_u8(fb_builder_s *fb, u8 value)
+{
+    FB_prep(fb, 1, 0);
+    FB_push(fb, &value, 1);
+}
+
+static void FB_push_s16(fb_builder_s *fb, s16 value)
+{
+    FB_prep(fb, 2, 0);
+    FB_push(fb, &value, 2);
+}
+
+static void FB_push_u16(fb_builder_s *fb, u16 value)
+{
+    FB_prep(fb, 2, 0);
+    FB_push(fb, &value, 2);
+}
+
+static void FB_push_u32(fb_builder_s *fb, u32 value)
+{
+    FB_prep(fb, 4, 0);
+    FB_push(fb, &value, 4);
+}
+
+static void FB_push_s64(fb_builder_s *fb, s64 value)
+{
+    FB_prep(fb, 8, 0);
+    FB_push(fb, &value, 8);
+}
+
+static void FB_push_offset(fb_builder_s *fb, u32 offset)
+{
+    FB_prep(fb, 4, 0);
+    FB_push_u32(fb, FB_size(fb) - offset + 4);
+}
+
+static u32 FB_string(fb_builder_s *fb, const char *str)
+{
+    u32 length = (u32)strlen(str);
+
+    FB_prep(fb, 4, length + 1);
+    FB_push_u8(fb, 0);
+    FB_push(fb, str, length);
+    FB_push_u32(fb, length);
+    return FB_size(fb);
+}
+
+static void FB_start_vector(fb_builder_s *fb, u32 element_size, u32 count, u32 alignment)
+{
+    FB_prep(fb, 4, element_size * count);
+    FB_prep(fb, alignment, element_size * count);
+}
+
+static u32 FB_end_vector(fb_builder_s *fb, u32 count)
+{
+    FB_push_u32(fb, count);
+    return FB_size(fb);
+}
+
+static void FB_start_table(fb_builder_s *fb, u32 slot_count)
+{
+    memset(fb->slots, 0, sizeof(fb->slots));
+    fb->slot_count = slot_count;
+    fb->table_start = FB_size(fb);
+}
+
+static void FB_add_u8(fb_builder_s *fb, u32 slot, u8 value)
+{
+    FB_push_u8(fb, value);
+    fb->slots[slot] = FB_size(fb);
+}
+
+static void FB_add_s16(fb_builder_s *fb, u32 slot, s16 value)
+{
+    FB_push_s16(fb, value);
+    fb->slots[slot] = FB_size(fb);
+}
+
+static void FB_add_u32(fb_builder_s *fb, u32 slot, u32 value)
+{
+    FB_push_u32(fb, value);
+    fb->slots[slot] = FB_size(fb);
+}
+
+static void FB_add_s64(fb_builder_s *fb, u32 slot, s64 value)
+{
+    FB_push_s64(fb, value);
+    fb->slots[slot] = FB_size(fb);
+}
+
+static void FB_add_offset(fb_builder_s *fb, u32 slot, u32 offset)
+{
+    FB_push_offset(fb, offset);
+    fb->slots[slot] = FB_size(fb);
+}
+
+static u32 FB_end_table(fb_builder_s *fb)
+{
+    u32 object;
+    u32 vtable;
+    s32 vtable_offset;
+    u32 count = fb->slot_count;
+    s32 i;
+
+    FB_push_u32(fb, 0);
+    object = FB_size(fb);
+
+    while (count > 0 && fb->slots[count - 1] == 0)
+    {
+        count--;
+    }
+    for (i = (s32)count - 1; i >= 0; i--)
+    {
+        FB_push_u16(fb, (u16)(fb->slots[i] ? object - fb->slots[i] : 0));
+    }
+    FB_push_u16(fb, (u16)(object - fb->table_start));
+    FB_push_u16(fb, (u16)((count + 2) * 2));
+    vtable = FB_size(fb);
+
+    if (!fb->overflow)
+    {
+        vtable_offset = (s32)(vtable - object);
+        memcpy(&(fb->buf[FB_SIZE_MAX - object]), &vtable_offset, 4);
+    }
+    return object;
+}
+
+static void FB_finish(fb_builder_s *fb, u32 root)
+{
+    FB_prep(fb, fb->minalign, 4);
+    FB_push_offset(fb, root);
+}
+
+/******* ARROW METADATA ********************************************/
+
+static u32 ARROW_build_schema(fb_builder_s *fb, const arrow_batch_s *batch)
+{
+    u32 fields[ARROW_COLUMNS_MAX];
+    u32 name;
+    u32 type;
+    u32 children;
+    u32 vector;
+    u32 i;
+    const arrow_column_s *column;
+
+    for (i = 0; i < batch->column_count; i++)
+    {
+        column = &(batch->columns[i]);
+
+        if (column->type == ARROW_TYPE_INT)
+        {
+            FB_start_table(fb, 2);
+            FB_add_u32(fb, 0, column->bit_width);
+            FB_add_u8(fb, 1, column->is_signed);
+        }
+        else if (column->type == ARROW_TYPE_TIMESTAMP)
+        {
+            FB_start_table(fb, 2);
+            FB_add_s16(fb, 0, ARROW_TIME_UNIT_SECOND);
+        }
+        else
+        {
+            FB_start_table(fb, 0);
+        }
+        type = FB_end_table(fb);
+
+        name = FB_string(fb, column->name);
+
+        FB_start_vector(fb, 4, 0, 4);
+        children = FB_end_vector(fb, 0);
+
+        FB_start_table(fb, 6);
+        FB_add_offset(fb, 0, name);
+        FB_add_offset(fb, 3, type);
+        FB_add_offset(fb, 5, children);
+        FB_add_u8(fb, 1, column->nullable);
+        FB_add_u8(fb, 2, column->type);
+        fields[i] = FB_end_table(fb);
+    }
+
+    FB_start_vector(fb, 4, batch->column_count, 4);
+    for (i = batch->column_count; i > 0; i--)
+    {
+        FB_push_offset(fb, fields[i - 1]);
+    }
+    vector = FB_end_vector(fb, batch->column_count);
+
+    FB_start_table(fb, 2);
+    FB_add_offset(fb, 1, vector);
+    return FB_end_table(fb);
+}
+
+static u32 ARROW_build_record_batch(fb_builder_s *fb, const arrow_batch_s *batch)
+{
+    u32 nodes;
+    u32 buffers;
+    u32 i;
+    const arrow_column_s *column;
+
+    /* struct FieldNode { length: long; null_count: long; } */
+    FB_start_vector(fb, 16, batch->column_count, 8);
+    for (i = batch->column_count; i > 0; i--)
+    {
+        FB_push_s64(fb, batch->columns[i - 1].null_count);
+        FB_push_s64(fb, batch->length);
+    }
+    nodes = FB_end_vector(fb, batch->column_count);
+
+    /* struct Buffer { offset: long; length: long; }, validity then values */
+    FB_start_vector(fb, 16, batch->column_count * 2, 8);
+    for (i = batch->column_count; i > 0; i--)
+    {
+        column = &(batch->columns[i - 1]);
+        FB_push_s64(fb, (s64)column->values_size);
+        FB_push_s64(fb, (s64)column->values_offset);
+        FB_push_s64(fb, (s64)column->validity_size);
+        FB_push_s64(fb, (s64)column->validity_offset);
+    }
+    buffers = FB_end_vector(fb, batch->column_count * 2);
+
+    FB_start_table(fb, 3);
+    FB_add_s64(fb, 0, batch->length);
+    FB_add_offset(fb, 1, nodes);
+    FB_add_offset(fb, 2, buffers);
+    return FB_end_table(fb);
+}
+
+static void ARROW_build_message(fb_builder_s *fb, const arrow_batch_s *batch, u8 header_type)
+{
+    u32 header;
+    u32 message;
+
+    FB_init(fb);
+    if (header_type == ARROW_HEADER_SCHEMA)
+    {
+        header = ARROW_build_schema(fb, batch);
+    }
+    else
+    {
+        header = ARROW_build_record_batch(fb, batch);
+    }
+
+    FB_start_table(fb, 4);
+    FB_add_s64(fb, 3, (header_type == ARROW_HEADER_SCHEMA) ? 0 : (s64)batch->body_size);
+    FB_add_offset(fb, 2, header);
+    FB_add_s16(fb, 0, ARROW_METADATA_V5);
+    FB_add_u8(fb, 1, header_type);
+    message = FB_end_table(fb);
+    FB_finish(fb, message);
+}
+
+static void ARROW_build_footer(fb_builder_s *fb, const arrow_batch_s *batch, size_t block_offset, u32 block_metadata_size)
+{
+    u32 schema;
+    u32 dictionaries;
+    u32 record_batches;
+    u32 footer;
+
+    FB_init(fb);
+    schema = ARROW_build_schema(fb, batch);
+
+    FB_start_vector(fb, 24, 0, 8);
+    dictionaries = FB_end_vector(fb, 0);
+
+    /* struct Block { offset: long; metaDataLength: int; bodyLength: long; } */
+    FB_start_vector(fb, 24, 1, 8);
+    FB_push_s64(fb, (s64)batch->body_size);
+    FB_push_u32(fb, 0);
+    FB_push_u32(fb, block_metadata_size);
+    FB_push_s64(fb, (s64)block_offset);
+    record_batches = FB_end_vector(fb, 1);
+
+    FB_start_table(fb, 4);
+    FB_add_offset(fb, 1, schema);
+    FB_add_offset(fb, 2, dictionaries);
+    FB_add_offset(fb, 3, record_batches);
+    FB_add_s16(fb, 0, ARROW_METADATA_V5);
+    footer = FB_end_table(fb);
+    FB_finish(fb, footer);
+}
+
+/* Encapsulated message: continuation, metadata size, padded flatbuffer */
+static size_t ARROW_message_size(const fb_builder_s *fb)
+{
+    return 8 + ARROW_PAD(FB_size(fb));
+}
+
+static u8 *ARROW_write_message(u8 *out, const fb_builder_s *fb)
+{
+    u32 continuation = ARROW_CONTINUATION;
+    u32 metadata_size = (u32)ARROW_PAD(FB_size(fb));
+
+    memcpy(out, &continuation, 4);
+    memcpy(out + 4, &metadata_size, 4);
+    memcpy(out + 8, &(fb->buf[fb->head]), FB_size(fb));
+    return out + 8 + metadata_size;
+}
+
+/******* COLUMNS ***************************************************/
+
+static void ARROW_add_column(arrow_batch_s *batch, const char *name, u8 type, u8 bit_width, bool is_signed, bool nullable)
+{
+    arrow_column_s *column = &(batch->columns[batch->column_count++]);
+
+    column->name = name;
+    column->type = type;
+    column->bit_width = bit_width;
+    column->is_signed = is_signed;
+    column->nullable = nullable;
+    column->null_count = 0;
+}
+
+static void ARROW_layout(arrow_batch_s *batch)
+{
+    arrow_column_s *column;
+    size_t offset = 0;
+    u32 i;
+
+    for (i = 0; i < batch->column_count; i++)
+    {
+        column = &(batch->columns[i]);
+
+        column->validity_offset = offset;
+        column->validity_size = column->nullable ? ARROW_BITMAP_SIZE(batch->length) : 0;
+        offset += ARROW_PAD(column->validity_size);
+
+        column->values_offset = offset;
+        column->values_size = (column->type == ARROW_TYPE_BOOL) ? ARROW_BITMAP_SIZE(batch->length) : (size_t)batch->length * (column->bit_width / 8);
+        offset += ARROW_PAD(column->values_size);
+    }
+    batch->body_size = offset;
+}
+
+static inline void ARROW_set(arrow_column_s *column, u32 row, s64 value, bool valid)
+{
+    if (!valid)
+    {
+        column->null_count++;
+        return;
+    }
+    if (column->nullable)
+    {
+        column->validity[row >> 3] |= (u8)(1 << (row & 7));
+    }
+
+    switch (column->bit_width)
+    {
+    case 1:
+        if (value)
+        {
+            column->values[row >> 3] |= (u8)(1 << (row & 7));
+        }
+        break;
+    case 8:
+        column->values[row] = (u8)value;
+        break;
+    case 16:
+        ((u16 *)column->values)[row] = (u16)value;
+        break;
+    case 32:
+        ((u32 *)column->values)[row] = (u32)value;
+        break;
+    default:
+        ((s64 *)column->values)[row] = value;
+        break;
+    }
+}
+
+/*******************************************************************/
+
+static u8 ARROW_write(arrow_batch_s *batch, u8 *input, u8 input_size, payload_type_e type,
+                      const u32 *device_ids, const u32 *times, arrow_format_e format, u8 **arrow_out, u32 *arrow_size);
+
+static void ARROW_fill_data(arrow_batch_s *batch, u8 *data_in, u32 column)
+{
+    arrow_column_s *c = &(batch->columns[column]);
+    data_s data;
+    bool known;
+    bool valid;
+    bool v2_button;
+    u32 row;
+
+    for (row = 0; row < batch->length; row++)
+    {
+        memset(&data, 0, sizeof(data_s));
+        PAYLOAD_parse_data(data_in + (row * PAYLOAD_DATA_SIZE), &data);
+
+        known = (data.error != PARSE_ERR_TYPE);
+        valid = (data.error == PARSE_ERR_NONE);
+        /* Sens'it v2 only sends the temperature with a double click message */
+        v2_button = (data.type == PAYLOAD_V2) && data.button;
+
+        ARROW_set(&c[0], row, data.error, TRUE);
+        ARROW_set(&c[1], row, data.type, known);
+        ARROW_set(&c[2], row, data.battery_level, known);
+        ARROW_set(&c[3], row, data.mode, known);
+        ARROW_set(&c[4], row, data.button, known);
+        ARROW_set(&c[5], row, data.temperature, valid && data.mode == MODE_TEMPERATURE);
+        ARROW_set(&c[6], row, data.humidity, valid && data.mode == MODE_TEMPERATURE && !v2_button);
+        ARROW_set(&c[7], row, data.brightness, valid && data.mode == MODE_LIGHT && !v2_button);
+        ARROW_set(&c[8], row, data.door, valid && data.mode == MODE_DOOR && !v2_button);
+        ARROW_set(&c[9], row, data.vibration, valid && data.mode == MODE_VIBRATION && !v2_button);
+        ARROW_set(&c[10], row, data.magnet, valid && data.mode == MODE_MAGNET && !v2_button);
+        ARROW_set(&c[11], row, data.event_counter,
+                  valid && !v2_button && (data.mode == MODE_DOOR || data.mode == MODE_VIBRATION || data.mode == MODE_MAGNET));
+        ARROW_set(&c[12], row, data.version_major, valid && data.mode == MODE_STANDBY);
+        ARROW_set(&c[13], row, data.version_minor, valid && data.mode == MODE_STANDBY);
+        ARROW_set(&c[14], row, data.version_patch, valid && data.mode == MODE_STANDBY);
+    }
+}
+
+static void ARROW_fill_config(arrow_batch_s *batch, u8 *config_in, payload_type_e type, u32 column)
+{
+    arrow_column_s *c = &(batch->columns[column]);
+    config_s config;
+    u32 row;
+
+    for (row = 0; row < batch->length; row++)
+    {
+        memset(&config, 0, sizeof(config_s));
+        PAYLOAD_parse_config(config_in + (row * PAYLOAD_CONFIG_SIZE), type, &config);
+
+        ARROW_set(&c[0], row, config.limited, TRUE);
+        ARROW_set(&c[1], row, config.period, TRUE);
+        ARROW_set(&c[2], row, config.temperature_low_threshold, TRUE);
+        ARROW_set(&c[3], row, config.temperature_high_threshold, TRUE);
+        ARROW_set(&c[4], row, config.vibration_config, TRUE);
+        ARROW_set(&c[5], row, config.door_config, TRUE);
+
+        if (type == PAYLOAD_V3)
+        {
+            ARROW_set(&c[6], row, config.humidity_low_threshold, TRUE);
+            ARROW_set(&c[7], row, config.humidity_high_threshold, TRUE);
+            ARROW_set(&c[8], row, config.brightness_threshold, TRUE);
+            ARROW_set(&c[9], row, config.delay, TRUE);
+            ARROW_set(&c[10], row, config.is_standby_periodic, TRUE);
+            ARROW_set(&c[11], row, config.is_temperature_periodic, TRUE);
+            ARROW_set(&c[12], row, config.is_light_periodic, TRUE);
+            ARROW_set(&c[13], row, config.is_door_periodic, TRUE);
+            ARROW_set(&c[14], row, config.is_vibration_periodic, TRUE);
+            ARROW_set(&c[15], row, config.is_magnet_periodic, TRUE);
+        }
+        else
+        {
+            ARROW_set(&c[6], row, config.brightness_low_threshold, TRUE);
+            ARROW_set(&c[7], row, config.brightness_high_threshold, TRUE);
+        }
+    }
+}
+
+static u32 ARROW_add_key_columns(arrow_batch_s *batch, const u32 *device_ids, const u32 *times)
+{
+    batch->column_count = 0;
+    if (device_ids != NULL)
+    {
+        ARROW_add_column(batch, "device", ARROW_TYPE_INT, 32, FALSE, FALSE);
+    }
+    if (times != NULL)
+    {
+        ARROW_add_column(batch, "time", ARROW_TYPE_TIMESTAMP, 64, TRUE, FALSE);
+    }
+    return batch->column_count;
+}
+
+/*******************************************************************/
+
+u8 ARROW_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times,
+                    arrow_format_e format, u8 **arrow_out, u32 *arrow_size)
+{
+    arrow_batch_s batch;
+
+    batch.length = count;
+    ARROW_add_key_columns(&batch, device_ids, times);
+
+    ARROW_add_column(&batch, "error", ARROW_TYPE_INT, 8, FALSE, FALSE);
+    ARROW_add_column(&batch, "type", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "battery_level", ARROW_TYPE_INT, 16, FALSE, TRUE);
+    ARROW_add_column(&batch, "mode", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "button", ARROW_TYPE_BOOL, 1, FALSE, TRUE);
+    ARROW_add_column(&batch, "temperature", ARROW_TYPE_INT, 16, TRUE, TRUE);
+    ARROW_add_column(&batch, "humidity", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "brightness", ARROW_TYPE_INT, 16, FALSE, TRUE);
+    ARROW_add_column(&batch, "door", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "vibration", ARROW_TYPE_BOOL, 1, FALSE, TRUE);
+    ARROW_add_column(&batch, "magnet", ARROW_TYPE_BOOL, 1, FALSE, TRUE);
+    ARROW_add_column(&batch, "event_counter", ARROW_TYPE_INT, 16, FALSE, TRUE);
+    ARROW_add_column(&batch, "version_major", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "version_minor", ARROW_TYPE_INT, 8, FALSE, TRUE);
+    ARROW_add_column(&batch, "version_patch", ARROW_TYPE_INT, 8, FALSE, TRUE);
+
+    return ARROW_write(&batch, data_in, PAYLOAD_DATA_SIZE, PAYLOAD_LAST, device_ids, times, format, arrow_out, arrow_size);
+}
+
+/*******************************************************************/
+
+u8 ARROW_write_config(u8 *config_in, u32 count, payload_type_e type, const u32 *device_ids, const u32 *times,
+                      arrow_format_e format, u8 **arrow_out, u32 *arrow_size)
+{
+    arrow_batch_s batch;
+
+    if (type != PAYLOAD_V2 && type != PAYLOAD_V3)
+    {
+        return ARROW_ERR_TYPE;
+    }
+
+    batch.length = count;
+    ARROW_add_key_columns(&batch, device_ids, times);
+
+    ARROW_add_column(&batch, "limited", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+    ARROW_add_column(&batch, "period", ARROW_TYPE_INT, 8, FALSE, FALSE);
+    ARROW_add_column(&batch, "temperature_low_threshold", ARROW_TYPE_INT, 8, TRUE, FALSE);
+    ARROW_add_column(&batch, "temperature_high_threshold", ARROW_TYPE_INT, 8, TRUE, FALSE);
+    ARROW_add_column(&batch, "vibration_config", ARROW_TYPE_INT, 8, FALSE, FALSE);
+    ARROW_add_column(&batch, "door_config", ARROW_TYPE_INT, 8, FALSE, FALSE);
+
+    if (type == PAYLOAD_V3)
+    {
+        ARROW_add_column(&batch, "humidity_low_threshold", ARROW_TYPE_INT, 8, FALSE, FALSE);
+        ARROW_add_column(&batch, "humidity_high_threshold", ARROW_TYPE_INT, 8, FALSE, FALSE);
+        ARROW_add_column(&batch, "brightness_threshold", ARROW_TYPE_INT, 16, FALSE, FALSE);
+        ARROW_add_column(&batch, "delay", ARROW_TYPE_INT, 8, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_standby_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_temperature_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_light_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_door_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_vibration_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+        ARROW_add_column(&batch, "is_magnet_periodic", ARROW_TYPE_BOOL, 1, FALSE, FALSE);
+    }
+    else
+    {
+        ARROW_add_column(&batch, "brightness_low_threshold", ARROW_TYPE_INT, 16, FALSE, FALSE);
+        ARROW_add_column(&batch, "brightness_high_threshold", ARROW_TYPE_INT, 16, FALSE, FALSE);
+    }
+
+    return ARROW_write(&batch, config_in, PAYLOAD_CONFIG_SIZE, type, device_ids, times, format, arrow_out, arrow_size);
+}
+
+/*******************************************************************/
+
+static u8 ARROW_write(arrow_batch_s *batch, u8 *input, u8 input_size, payload_type_e type,
+                      const u32 *device_ids, const u32 *times, arrow_format_e format, u8 **arrow_out, u32 *arrow_size)
+{
+    fb_builder_s *schema = (fb_builder_s *)malloc(sizeof(fb_builder_s));
+    fb_builder_s *record_batch = (fb_builder_s *)malloc(sizeof(fb_builder_s));
+    fb_builder_s *footer = (fb_builder_s *)malloc(sizeof(fb_builder_s));
+    u32 footer_size = 0;
+    u32 eos[2] = {ARROW_CONTINUATION, 0};
+    u32 key_columns = 0;
+    size_t header_size = (format == ARROW_FORMAT_FILE) ? ARROW_PAD(ARROW_MAGIC_SIZE) : 0;
+    size_t block_offset;
+    size_t record_batch_size;
+    size_t total;
+    u8 *out = NULL;
+    u8 *cursor;
+    u32 i;
+    u8 err = ARROW_ERR_NONE;
+
+    if (schema == NULL || record_batch == NULL || footer == NULL)
+    {
+        err = ARROW_ERR_ALLOC;
+        goto end;
+    }
+
+    /* Only a file has a footer, an empty one is not an overflow */
+    FB_init(footer);
+    ARROW_layout(batch);
+
+    /* Metadata sizes do not depend on the null counts, compute them first */
+    ARROW_build_message(schema, batch, ARROW_HEADER_SCHEMA);
+    ARROW_build_message(record_batch, batch, ARROW_HEADER_RECORD_BATCH);
+    block_offset = header_size + ARROW_message_size(schema);
+    record_batch_size = ARROW_message_size(record_batch);
+
+    total = block_offset + record_batch_size + batch->body_size + sizeof(eos);
+    if (format == ARROW_FORMAT_FILE)
+    {
+        ARROW_build_footer(footer, batch, block_offset, (u32)record_batch_size);
+        footer_size = FB_size(footer);
+        total += footer_size + 4 + ARROW_MAGIC_SIZE;
+    }
+
+    if (schema->overflow || record_batch->overflow || footer->overflow || total > 0xFFFFFFFF)
+    {
+        err = ARROW_ERR_ALLOC;
+        goto end;
+    }
+
+    out = (u8 *)calloc(1, total);
+    if (out == NULL)
+    {
+        err = ARROW_ERR_ALLOC;
+        goto end;
+    }
+
+    /* Decode straight into the record batch body */
+    cursor = out + block_offset + record_batch_size;
+    for (i = 0; i < batch->column_count; i++)
+    {
+        batch->columns[i].validity = cursor + batch->columns[i].validity_offset;
+        batch->columns[i].values = cursor + batch->columns[i].values_offset;
+    }
+    if (device_ids != NULL)
+    {
+        memcpy(batch->columns[key_columns++].values, device_ids, (size_t)batch->length * sizeof(u32));
+    }
+    if (times != NULL)
+    {
+        for (i = 0; i < batch->length; i++)
+        {
+            ((s64 *)batch->columns[key_columns].values)[i] = times[i];
+        }
+        key_columns++;
+    }
+    if (input_size == PAYLOAD_DATA_SIZE)
+    {
+        ARROW_fill_data(batch, input, key_columns);
+    }
+    else
+    {
+        ARROW_fill_config(batch, input, type, key_columns);
+    }
+    ARROW_build_message(record_batch, batch, ARROW_HEADER_RECORD_BATCH);
+
+    cursor = out;
+    if (format == ARROW_FORMAT_FILE)
+    {
+        memcpy(cursor, ARROW_MAGIC, ARROW_MAGIC_SIZE);
+        cursor += header_size;
+    }
+    cursor = ARROW_write_message(cursor, schema);
+    cursor = ARROW_write_message(cursor, record_batch);
+    cursor += batch->body_size;
+    memcpy(cursor, eos, sizeof(eos));
+    cursor += sizeof(eos);
+
+    if (format == ARROW_FORMAT_FILE)
+    {
+        memcpy(cursor, &(footer->buf[footer->head]), footer_size);
+        cursor += footer_size;
+        memcpy(cursor, &footer_size, 4);
+        memcpy(cursor + 4, ARROW_MAGIC, ARROW_MAGIC_SIZE);
+    }
+
+    *arrow_out = out;
+    *arrow_size = (u32)total;
+
+end:
+    free(schema);
+    free(record_batch);
+    free(footer);
+    return err;
+}
+
+/*******************************************************************/
@@ -0,0 +1,52 @@
+/*!******************************************************************
+ * \file sensit_arrow.h
+ * \brief Functions to write decoded payloads as Apache Arrow IPC
+ * \author Sens'it Team
+ *
+ * A batch of raw payloads is decoded straight into the body of a
+ * single Arrow record batch: one typed column per field of data_s or
+ * config_s, mode dependent fields carry a validity bitmap. The
+ * output buffer is allocated once with malloc and owned by the caller.
+ *******************************************************************/
+
+#define ARROW_ERR_NONE 0x00
+#define ARROW_ERR_ALLOC 0x01
+#define ARROW_ERR_TYPE 0x02
+
+/*!******************************************************************
+ * \enum arrow_format_e
+ * \brief Arrow IPC flavours
+ *******************************************************************/
+typedef enum {
+    ARROW_FORMAT_STREAM = 0, /*!< Schema, record batch & end-of-stream messages */
+    ARROW_FORMAT_FILE = 1,   /*!< Stream wrapped with the ARROW1 magic and a footer */
+    ARROW_FORMAT_LAST
+} arrow_format_e;
+
+/*!************************************************************************
+ * \fn u8 ARROW_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times, arrow_format_e format, u8 **arrow_out, u32 *arrow_size)
+ * \brief Decode a batch of payloads into an Arrow record batch.
+ *
+ * \param[in] data_in               count payloads of PAYLOAD_DATA_SIZE length
+ * \param[in] count                 Number of payloads
+ * \param[in] device_ids            Optional "device" column, may be NULL
+ * \param[in] times                 Optional "time" column in seconds since epoch, may be NULL
+ * \param[in] format                Stream or file
+ * \param[out] arrow_out            Buffer allocated with malloc
+ * \param[out] arrow_size           Length of arrow_out
+ * \retval                          ARROW_ERR_NONE or ARROW_ERR_ALLOC
+ **************************************************************************/
+u8 ARROW_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times,
+                    arrow_format_e format, u8 **arrow_out, u32 *arrow_size);
+
+/*!************************************************************************
+ * \fn u8 ARROW_write_config(u8 *config_in, u32 count, payload_type_e type, const u32 *device_ids, const u32 *times, arrow_format_e format, u8 **arrow_out, u32 *arrow_size)
+ * \brief Decode a batch of configs into an Arrow record batch. Only the
+ *        columns meaningful for the given payload type are written.
+ *
+ * \param[in] config_in             count configs of PAYLOAD_CONFIG_SIZE length
+ * \param[in] type                  PAYLOAD_V2 or PAYLOAD_V3
+ * \retval                          ARROW_ERR_NONE, ARROW_ERR_ALLOC or ARROW_ERR_TYPE
+ **************************************************************************/
+u8 ARROW_write_config(u8 *config_in, u32 count, payload_type_e type, const u32 *device_ids, const u32 *times,
+                      arrow_format_e format, u8 **arrow_out, u32 *arrow_size);
@@ -0,0 +1,88 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_arrow.h"
+#include "sensit_payload_node.h"
+
+bool OptionalColumn(v8::Isolate *isolate, v8::Local<v8::Value> arg, u32 count, const u32 **column)
+{
+  *column = NULL;
+  if (!arg->IsUint32Array())
+  {
+    return TRUE;
+  }
+  // A column of another length would be left out of the output, or read past its end
+  if (node::Buffer::Length(arg) != count * sizeof(u32))
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "devices and times must have one value per payload")));
+    return FALSE;
+  }
+  *column = (const u32 *)node::Buffer::Data(arg);
+  return TRUE;
+}
+
+static void ReturnArrow(const v8::FunctionCallbackInfo<v8::Value> &args, u8 err, u8 *arrow, u32 arrow_size)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  if (err != ARROW_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to write the Arrow batch")));
+    return;
+  }
+
+  // The Buffer takes ownership of the malloc'ed batch, no copy
+  v8::MaybeLocal<v8::Object> buffer = node::Buffer::New(isolate, (char *)arrow, arrow_size);
+  v8::Local<v8::Object> out;
+  if (buffer.ToLocal(&out))
+  {
+    args.GetReturnValue().Set(out);
+  }
+}
+
+void ToArrowData(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  // args: Buffer payloads, Uint32Array|undefined devices, Uint32Array|undefined times, format
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  u32 count = (u32)(node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE);
+  arrow_format_e format = (args[3]->Uint32Value() == ARROW_FORMAT_FILE) ? ARROW_FORMAT_FILE : ARROW_FORMAT_STREAM;
+  const u32 *device_ids;
+  const u32 *times;
+  u8 *arrow = NULL;
+  u32 arrow_size = 0;
+
+  if (!OptionalColumn(args.GetIsolate(), args[1], count, &device_ids) || !OptionalColumn(args.GetIsolate(), args[2], count, &times))
+  {
+    return;
+  }
+  u8 err = ARROW_write_data(payloads, count, device_ids, times, format, &arrow, &arrow_size);
+  ReturnArrow(args, err, arrow, arrow_size);
+}
+
+void ToArrowConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  // args: Buffer configs, type, Uint32Array|undefined devices, Uint32Array|undefined times, format
+  u8 *configs = (u8 *)node::Buffer::Data(args[0]);
+  u32 count = (u32)(node::Buffer::Length(args[0]) / PAYLOAD_CONFIG_SIZE);
+  double type = args[1]->NumberValue();
+  arrow_format_e format = (args[4]->Uint32Value() == ARROW_FORMAT_FILE) ? ARROW_FORMAT_FILE : ARROW_FORMAT_STREAM;
+  const u32 *device_ids;
+  const u32 *times;
+  u8 *arrow = NULL;
+  u32 arrow_size = 0;
+
+  if (!OptionalColumn(args.GetIsolate(), args[2], count, &device_ids) || !OptionalColumn(args.GetIsolate(), args[3], count, &times))
+  {
+    return;
+  }
+  u8 err = ARROW_write_config(configs, count, (type == 3) ? PAYLOAD_V3 : PAYLOAD_V2, device_ids, times,
+                              format, &arrow, &arrow_size);
+  ReturnArrow(args, err, arrow, arrow_size);
+}
+
+void ARROW_node_init(v8::Local<v8::Object> exports)
+{
+  NODE_SET_METHOD(exports, "toArrowData", ToArrowData);
+  NODE_SET_METHOD(exports, "toArrowConfig", ToArrowConfig);
+}
@@ -0,0 +1,278 @@
+/*!******************************************************************
+ * \file sensit_battery.c
+ * \brief Functions to forecast the battery depletion of a fleet
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_battery.h"
+
+/******* DEFINE ****************************************************/
+#define BATTERY_MIN_DEVICES 64
+#define BATTERY_SECONDS_PER_DAY 86400.0
+/* A rise above the 50 mV quantization & temperature jitter means a new battery */
+#define BATTERY_RESET_RISE 150
+
+/*******************************************************************/
+
+static bool BATTERY_grow_states(battery_forecast_s *forecast)
+{
+    u32 capacity = (forecast->capacity == 0) ? BATTERY_MIN_DEVICES : forecast->capacity * 2;
+    void *states = realloc(forecast->states, (size_t)capacity * sizeof(battery_state_s));
+    void *levels;
+    void *slopes;
+    void *times;
+
+    if (states == NULL)
+    {
+        return FALSE;
+    }
+    forecast->states = (battery_state_s *)states;
+    levels = realloc(forecast->levels, (size_t)capacity * sizeof(float));
+    if (levels == NULL)
+    {
+        return FALSE;
+    }
+    forecast->levels = (float *)levels;
+    slopes = realloc(forecast->slopes, (size_t)capacity * sizeof(float));
+    if (slopes == NULL)
+    {
+        return FALSE;
+    }
+    forecast->slopes = (float *)slopes;
+    times = realloc(forecast->times, (size_t)capacity * sizeof(u32));
+    if (times == NULL)
+    {
+        return FALSE;
+    }
+    forecast->times = (u32 *)times;
+    forecast->capacity = capacity;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static void BATTERY_restart(battery_state_s *state, u32 time, u8 mode, u8 period)
+{
+    state->origin = time;
+    state->last_time = time;
+    state->mode = mode;
+    state->period = period;
+    state->count = 0;
+    state->sw = 0;
+    state->st = 0;
+    state->sv = 0;
+    state->stt = 0;
+    state->stv = 0;
+}
+
+/*******************************************************************/
+
+battery_forecast_s *BATTERY_create(double half_life)
+{
+    battery_forecast_s *forecast = (battery_forecast_s *)calloc(1, sizeof(battery_forecast_s));
+
+    if (forecast == NULL)
+    {
+        return NULL;
+    }
+    forecast->decay = (half_life > 0) ? (M_LN2 / half_life) : 0;
+    if (!DEVICES_init(&(forecast->ids)) || !BATTERY_grow_states(forecast))
+    {
+        BATTERY_destroy(forecast);
+        return NULL;
+    }
+    return forecast;
+}
+
+/*******************************************************************/
+
+void BATTERY_destroy(battery_forecast_s *forecast)
+{
+    if (forecast != NULL)
+    {
+        DEVICES_free(&(forecast->ids));
+        free(forecast->states);
+        free(forecast->levels);
+        free(forecast->slopes);
+        free(forecast->times);
+        free(forecast);
+    }
+}
+
+/*******************************************************************/
+
+u8 BATTERY_update(battery_forecast_s *forecast, u32 device_id, u32 time, u16 level, u8 mode, u8 period)
+{
+    u32 index = DEVICES_find(&(forecast->ids), device_id);
+    battery_state_s *state;
+    double t;
+    double factor;
+    double var;
+    double slope;
+
+    if (index == DEVICES_NONE)
+    {
+        if (forecast->device_count == forecast->capacity && !BATTERY_grow_states(forecast))
+        {
+            return BATTERY_ERR_ALLOC;
+        }
+        if (!DEVICES_add(&(forecast->ids), device_id, forecast->device_count))
+        {
+            return BATTERY_ERR_ALLOC;
+        }
+        index = forecast->device_count++;
+        state = &(forecast->states[index]);
+        state->device_id = device_id;
+        BATTERY_restart(state, time, mode, period);
+    }
+    else
+    {
+        state = &(forecast->states[index]);
+        if (time < state->last_time)
+        {
+            return BATTERY_ERR_ORDER;
+        }
+        if (level > state->last_level + BATTERY_RESET_RISE || mode != state->mode ||
+            (period != BATTERY_PERIOD_UNKNOWN && period != state->period))
+        {
+            BATTERY_restart(state, time, mode, period);
+        }
+    }
+
+    if (forecast->decay > 0 && time > state->last_time)
+    {
+        factor = exp(-forecast->decay * ((time - state->last_time) / BATTERY_SECONDS_PER_DAY));
+        state->sw *= factor;
+        state->st *= factor;
+        state->sv *= factor;
+        state->stt *= factor;
+        state->stv *= factor;
+    }
+
+    t = (time - state->origin) / BATTERY_SECONDS_PER_DAY;
+    state->sw += 1;
+    state->st += t;
+    state->sv += level;
+    state->stt += t * t;
+    state->stv += t * level;
+    state->count++;
+    state->last_time = time;
+    state->last_level = level;
+
+    forecast->times[index] = time;
+    forecast->levels[index] = level;
+    forecast->slopes[index] = 0;
+    if (state->count >= BATTERY_MIN_SAMPLES && (time - state->origin) >= BATTERY_MIN_SPAN)
+    {
+        var = (state->stt * state->sw) - (state->st * state->st);
+        if (var > 0)
+        {
+            slope = ((state->stv * state->sw) - (state->st * state->sv)) / var;
+            forecast->slopes[index] = (float)slope;
+            forecast->levels[index] = (float)((state->sv / state->sw) + (slope * (t - (state->st / state->sw))));
+        }
+    }
+    return BATTERY_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 BATTERY_update_data(battery_forecast_s *forecast, u32 device_id, u32 time, u8 *data_in)
+{
+    data_s data = {};
+    u8 period = BATTERY_PERIOD_UNKNOWN;
+
+    PAYLOAD_parse_data(data_in, &data);
+    if (data.error != PARSE_ERR_NONE)
+    {
+        return BATTERY_ERR_DATA;
+    }
+    if (data.type == PAYLOAD_V2)
+    {
+        /* uplinkPeriod bits of payload_v2_s */
+        period = (data_in[0] >> 3) & 0x03;
+    }
+    return BATTERY_update(forecast, device_id, time, data.battery_level, data.mode, period);
+}
+
+/*******************************************************************/
+
+bool BATTERY_get(const battery_forecast_s *forecast, u32 device_id, battery_estimate_s *estimate)
+{
+    u32 index = DEVICES_find(&(forecast->ids), device_id);
+
+    if (index == DEVICES_NONE)
+    {
+        return FALSE;
+    }
+    estimate->level = forecast->levels[index];
+    estimate->slope = forecast->slopes[index];
+    estimate->last_time = forecast->times[index];
+    estimate->count = forecast->states[index].count;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static int BATTERY_compare(const void *a, const void *b)
+{
+    u64 left = *(const u64 *)a;
+    u64 right = *(const u64 *)b;
+    return (left > right) - (left < right);
+}
+
+/*******************************************************************/
+
+u8 BATTERY_query(const battery_forecast_s *forecast, u32 time, u16 threshold, u32 horizon,
+                 u32 *device_ids, u32 *crossing_times, u32 max, u32 *count)
+{
+    double end = (double)time + horizon;
+    double crossing;
+    float days;
+    u64 *matches;
+    u32 matched = 0;
+    u32 i;
+
+    /* Worst case every device matches, the sort key is (crossing time, index) */
+    matches = (u64 *)malloc(((size_t)forecast->device_count + 1) * sizeof(u64));
+    if (matches == NULL)
+    {
+        return BATTERY_ERR_ALLOC;
+    }
+
+    for (i = 0; i < forecast->device_count; i++)
+    {
+        days = (float)((end - forecast->times[i]) / BATTERY_SECONDS_PER_DAY);
+        if (forecast->levels[i] + (forecast->slopes[i] * days) >= threshold)
+        {
+            continue;
+        }
+        if (forecast->levels[i] <= threshold)
+        {
+            crossing = forecast->times[i];
+        }
+        else
+        {
+            crossing = forecast->times[i] + (((threshold - forecast->levels[i]) / forecast->slopes[i]) * BATTERY_SECONDS_PER_DAY);
+        }
+        crossing = (crossing > 0xFFFFFFFF) ? 0xFFFFFFFF : crossing;
+        matches[matched++] = ((u64)(u32)crossing << 32) | i;
+    }
+
+    qsort(matches, matched, sizeof(u64), BATTERY_compare);
+    for (i = 0; i < matched && i < max; i++)
+    {
+        device_ids[i] = forecast->states[(u32)matches[i]].device_id;
+        crossing_times[i] = (u32)(matches[i] >> 32);
+    }
+    free(matches);
+    *count = matched;
+    return BATTERY_ERR_NONE;
+}
+
+/*******************************************************************/
@@ -0,0 +1,127 @@
+/*!******************************************************************
+ * \file sensit_battery.h
+ * \brief Functions & Types to forecast the battery depletion of a fleet
+ * \author Sens'it Team
+ *
+ * Each device keeps the sums of an exponentially weighted linear
+ * regression of its battery level over time, updated in O(1) per
+ * uplink. The regression restarts when the battery level rises (battery
+ * changed or recharged) or when the mode or uplink period changes, as
+ * the consumption depends on both. The fitted level and slope of every
+ * device are kept in flat arrays so that a fleet wide query is a single
+ * linear scan.
+ *******************************************************************/
+
+#define BATTERY_ERR_NONE 0x00
+#define BATTERY_ERR_ALLOC 0x01
+#define BATTERY_ERR_ORDER 0x02
+#define BATTERY_ERR_DATA 0x03
+
+#define BATTERY_PERIOD_UNKNOWN 0xFF
+#define BATTERY_DEFAULT_HALF_LIFE 30.0 /* days */
+#define BATTERY_MIN_SAMPLES 4
+#define BATTERY_MIN_SPAN (24 * 3600) /* seconds */
+
+/*!******************************************************************
+ * \struct battery_state_s
+ * \brief Regression state of a device, times are in days since origin
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 origin;     /*!< Time of the first sample of the regression, seconds */
+    u32 last_time;  /*!< Time of the last sample, seconds */
+    u16 last_level; /*!< Last battery level, mV */
+    u8 mode;        /*!< Mode of the regression */
+    u8 period;      /*!< uplink_period_e of the regression, BATTERY_PERIOD_UNKNOWN for a v3 */
+    u32 count;      /*!< Number of samples of the regression */
+    double sw;      /*!< Sum of the weights */
+    double st;      /*!< Weighted sum of the times */
+    double sv;      /*!< Weighted sum of the levels */
+    double stt;
+    double stv;
+} battery_state_s;
+
+/*!******************************************************************
+ * \struct battery_estimate_s
+ * \brief Fitted battery of a device
+ *******************************************************************/
+typedef struct
+{
+    float level;    /*!< Fitted level at last_time, mV */
+    float slope;    /*!< mV per day, 0 until the regression is reliable */
+    u32 last_time;
+    u32 count;
+} battery_estimate_s;
+
+/*!******************************************************************
+ * \struct battery_forecast_s
+ * \brief Regressions of every device
+ *******************************************************************/
+typedef struct
+{
+    devices_s ids;            /*!< Index in states of each device id */
+    battery_state_s *states;
+    float *levels;            /*!< Fitted level at times[i], mV */
+    float *slopes;            /*!< mV per day, 0 until the regression is reliable */
+    u32 *times;
+    u32 device_count;
+    u32 capacity;
+    double decay;             /*!< ln(2) / half life in days */
+} battery_forecast_s;
+
+/*!************************************************************************
+ * \fn battery_forecast_s *BATTERY_create(double half_life)
+ * \brief Allocate an empty forecast, NULL if the allocation failed.
+ *
+ * \param[in] half_life             Age in days at which a sample weights half, 0 for no decay
+ **************************************************************************/
+battery_forecast_s *BATTERY_create(double half_life);
+
+/*!************************************************************************
+ * \fn void BATTERY_destroy(battery_forecast_s *forecast)
+ **************************************************************************/
+void BATTERY_destroy(battery_forecast_s *forecast);
+
+/*!************************************************************************
+ * \fn u8 BATTERY_update(battery_forecast_s *forecast, u32 device_id, u32 time, u16 level, u8 mode, u8 period)
+ * \brief Add a battery level sample of a device.
+ *
+ * \param[in] time                  Seconds, not lower than the previous one of the device
+ * \param[in] level                 Battery level in mV
+ * \param[in] mode                  mode_e of the device
+ * \param[in] period                uplink_period_e, BATTERY_PERIOD_UNKNOWN if not in the payload
+ * \retval                          BATTERY_ERR_NONE, BATTERY_ERR_ALLOC or BATTERY_ERR_ORDER
+ **************************************************************************/
+u8 BATTERY_update(battery_forecast_s *forecast, u32 device_id, u32 time, u16 level, u8 mode, u8 period);
+
+/*!************************************************************************
+ * \fn u8 BATTERY_update_data(battery_forecast_s *forecast, u32 device_id, u32 time, u8 *data_in)
+ * \brief Decode a payload and add its battery level, the uplink period
+ *        of a v2 payload is read from its raw bits.
+ *
+ * \retval                          BATTERY_ERR_NONE, BATTERY_ERR_ALLOC, BATTERY_ERR_ORDER or BATTERY_ERR_DATA
+ **************************************************************************/
+u8 BATTERY_update_data(battery_forecast_s *forecast, u32 device_id, u32 time, u8 *data_in);
+
+/*!************************************************************************
+ * \fn bool BATTERY_get(const battery_forecast_s *forecast, u32 device_id, battery_estimate_s *estimate)
+ * \brief Fitted battery of a device, FALSE if unknown.
+ **************************************************************************/
+bool BATTERY_get(const battery_forecast_s *forecast, u32 device_id, battery_estimate_s *estimate);
+
+/*!************************************************************************
+ * \fn u8 BATTERY_query(const battery_forecast_s *forecast, u32 time, u16 threshold, u32 horizon, u32 *device_ids, u32 *crossing_times, u32 max, u32 *count)
+ * \brief Devices predicted to be below threshold at time + horizon,
+ *        sorted by the time they cross it.
+ *
+ * \param[in] time                  Seconds, usually now
+ * \param[in] threshold             mV
+ * \param[in] horizon               Seconds
+ * \param[out] device_ids           At most max devices
+ * \param[out] crossing_times       Predicted time the level crosses threshold, seconds
+ * \param[out] count                Number of devices matching, may be greater than max
+ * \retval                          BATTERY_ERR_NONE or BATTERY_ERR_ALLOC
+ **************************************************************************/
+u8 BATTERY_query(const battery_forecast_s *forecast, u32 time, u16 threshold, u32 horizon,
+                 u32 *device_ids, u32 *crossing_times, u32 max, u32 *count);
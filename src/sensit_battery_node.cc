@@ -0,0 +1,153 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_battery.h"
+#include "sensit_payload_node.h"
+
+class BatteryForecaster : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit BatteryForecaster(battery_forecast_s *forecast) : forecast_(forecast) {}
+  ~BatteryForecaster() { BATTERY_destroy(forecast_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Update(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Get(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Query(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Size(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  battery_forecast_s *forecast_;
+};
+
+void BatteryForecaster::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "BatteryForecaster"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "update", Update);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get", Get);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "query", Query);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "size", Size);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "BatteryForecaster"), tpl->GetFunction());
+}
+
+void BatteryForecaster::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: half life in days
+  double half_life = args[0]->IsNumber() ? args[0]->NumberValue() : BATTERY_DEFAULT_HALF_LIFE;
+  battery_forecast_s *forecast = BATTERY_create(half_life);
+  if (forecast == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the battery forecaster")));
+    return;
+  }
+
+  BatteryForecaster *obj = new BatteryForecaster(forecast);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void BatteryForecaster::Update(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  BatteryForecaster *obj = node::ObjectWrap::Unwrap<BatteryForecaster>(args.Holder());
+
+  // args: Buffer payloads, Uint32Array device ids, Uint32Array times
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+
+  u32 rejected = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    u8 err = BATTERY_update_data(obj->forecast_, device_ids[i], times[i], payloads + (i * PAYLOAD_DATA_SIZE));
+    if (err == BATTERY_ERR_ALLOC)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the battery forecaster")));
+      return;
+    }
+    if (err != BATTERY_ERR_NONE)
+    {
+      rejected++;
+    }
+  }
+  // Number of payloads not parsable or older than the last one of their device
+  args.GetReturnValue().Set(rejected);
+}
+
+void BatteryForecaster::Get(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  BatteryForecaster *obj = node::ObjectWrap::Unwrap<BatteryForecaster>(args.Holder());
+  battery_estimate_s estimate;
+
+  if (!BATTERY_get(obj->forecast_, args[0]->Uint32Value(), &estimate))
+  {
+    return;
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "level"), v8::Number::New(isolate, estimate.level));
+  res->Set(v8::String::NewFromUtf8(isolate, "slope"), v8::Number::New(isolate, estimate.slope));
+  res->Set(v8::String::NewFromUtf8(isolate, "time"), v8::Number::New(isolate, estimate.last_time));
+  res->Set(v8::String::NewFromUtf8(isolate, "samples"), v8::Number::New(isolate, estimate.count));
+  args.GetReturnValue().Set(res);
+}
+
+void BatteryForecaster::Query(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  BatteryForecaster *obj = node::ObjectWrap::Unwrap<BatteryForecaster>(args.Holder());
+
+  // args: threshold in mV, horizon in seconds, time in seconds
+  u32 max = obj->forecast_->device_count;
+  u32 count = 0;
+  v8::Local<v8::ArrayBuffer> devices_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(u32));
+  v8::Local<v8::ArrayBuffer> times_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(u32));
+
+  if (BATTERY_query(obj->forecast_, args[2]->Uint32Value(), (u16)args[0]->Uint32Value(), args[1]->Uint32Value(),
+                    (u32 *)devices_buffer->GetContents().Data(), (u32 *)times_buffer->GetContents().Data(),
+                    max, &count) != BATTERY_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Out of memory")));
+    return;
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Uint32Array::New(devices_buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "times"), v8::Uint32Array::New(times_buffer, 0, count));
+  args.GetReturnValue().Set(res);
+}
+
+void BatteryForecaster::Size(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  BatteryForecaster *obj = node::ObjectWrap::Unwrap<BatteryForecaster>(args.Holder());
+  args.GetReturnValue().Set(obj->forecast_->device_count);
+}
+
+void BATTERY_node_init(v8::Local<v8::Object> exports)
+{
+  BatteryForecaster::Init(exports);
+}
@@ -0,0 +1,898 @@
+/*!******************************************************************
+ * \file sensit_bitmap.c
+ * \brief Functions of compressed bitmaps of row ids
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_bitmap.h"
+
+/******* DEFINE ****************************************************/
+#define BITMAP_CONTAINER_HEADER_SIZE 4
+#define BITMAP_MIN_CAPACITY 4
+
+#define BITMAP_KEY(value) ((u16)((value) >> 16))
+#define BITMAP_LOW(value) ((u16)((value) & 0xFFFF))
+#define BITMAP_TEST(words, low) (((words)[(low) >> 6] >> ((low) & 63)) & 1)
+
+/*******************************************************************/
+
+void BITMAP_init(bitmap_s *bitmap)
+{
+    memset(bitmap, 0, sizeof(bitmap_s));
+}
+
+/*******************************************************************/
+
+void BITMAP_clear(bitmap_s *bitmap)
+{
+    u32 i;
+
+    for (i = 0; i < bitmap->count; i++)
+    {
+        free(bitmap->containers[i].values);
+        free(bitmap->containers[i].words);
+    }
+    free(bitmap->containers);
+    BITMAP_init(bitmap);
+}
+
+/*******************************************************************/
+
+static u32 BITMAP_popcount(const u64 *words)
+{
+    u32 cardinality = 0;
+    u32 i;
+
+    for (i = 0; i < BITMAP_WORDS; i++)
+    {
+        cardinality += __builtin_popcountll(words[i]);
+    }
+    return cardinality;
+}
+
+/*******************************************************************/
+
+static s32 BITMAP_find(const bitmap_s *bitmap, u16 key)
+{
+    s32 low = 0;
+    s32 high = (s32)bitmap->count - 1;
+    s32 middle;
+
+    /* Index of the container of key, or -(insertion index) - 1 */
+    while (low <= high)
+    {
+        middle = (low + high) >> 1;
+        if (bitmap->containers[middle].key < key)
+        {
+            low = middle + 1;
+        }
+        else if (bitmap->containers[middle].key > key)
+        {
+            high = middle - 1;
+        }
+        else
+        {
+            return middle;
+        }
+    }
+    return -(low + 1);
+}
+
+/*******************************************************************/
+
+static s32 BITMAP_find_value(const u16 *values, u32 count, u16 value)
+{
+    s32 low = 0;
+    s32 high = (s32)count - 1;
+    s32 middle;
+
+    while (low <= high)
+    {
+        middle = (low + high) >> 1;
+        if (values[middle] < value)
+        {
+            low = middle + 1;
+        }
+        else if (values[middle] > value)
+        {
+            high = middle - 1;
+        }
+        else
+        {
+            return middle;
+        }
+    }
+    return -(low + 1);
+}
+
+/*******************************************************************/
+
+static bitmap_container_s *BITMAP_insert_container(bitmap_s *bitmap, u32 index, u16 key)
+{
+    bitmap_container_s *containers;
+    u32 capacity;
+
+    if (bitmap->count == bitmap->capacity)
+    {
+        capacity = bitmap->capacity ? bitmap->capacity * 2 : BITMAP_MIN_CAPACITY;
+        containers = (bitmap_container_s *)realloc(bitmap->containers, capacity * sizeof(bitmap_container_s));
+        if (containers == NULL)
+        {
+            return NULL;
+        }
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+    memmove(bitmap->containers + index + 1, bitmap->containers + index, (bitmap->count - index) * sizeof(bitmap_container_s));
+    bitmap->count++;
+    memset(bitmap->containers + index, 0, sizeof(bitmap_container_s));
+    bitmap->containers[index].key = key;
+    return bitmap->containers + index;
+}
+
+/*******************************************************************/
+
+static bool BITMAP_array_to_bitset(bitmap_container_s *container)
+{
+    u64 *words = (u64 *)calloc(BITMAP_WORDS, sizeof(u64));
+    u32 i;
+
+    if (words == NULL)
+    {
+        return FALSE;
+    }
+    for (i = 0; i < container->cardinality; i++)
+    {
+        words[container->values[i] >> 6] |= 1ULL << (container->values[i] & 63);
+    }
+    free(container->values);
+    container->values = NULL;
+    container->capacity = 0;
+    container->words = words;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+u8 BITMAP_add(bitmap_s *bitmap, u32 value)
+{
+    bitmap_container_s *container;
+    u16 key = BITMAP_KEY(value);
+    u16 low = BITMAP_LOW(value);
+    u16 *values;
+    u32 capacity;
+    s32 index;
+
+    /* Row ids are mostly appended, try the last container first */
+    if (bitmap->count != 0 && bitmap->containers[bitmap->count - 1].key == key)
+    {
+        container = bitmap->containers + bitmap->count - 1;
+    }
+    else
+    {
+        index = BITMAP_find(bitmap, key);
+        if (index >= 0)
+        {
+            container = bitmap->containers + index;
+        }
+        else
+        {
+            container = BITMAP_insert_container(bitmap, (u32)(-index - 1), key);
+            if (container == NULL)
+            {
+                return BITMAP_ERR_ALLOC;
+            }
+        }
+    }
+
+    if (container->words == NULL)
+    {
+        if (container->cardinality != 0 && container->values[container->cardinality - 1] >= low)
+        {
+            index = BITMAP_find_value(container->values, container->cardinality, low);
+            if (index >= 0)
+            {
+                return BITMAP_ERR_NONE;
+            }
+            index = -index - 1;
+        }
+        else
+        {
+            index = (s32)container->cardinality;
+        }
+
+        if (container->cardinality < BITMAP_ARRAY_MAX)
+        {
+            if (container->cardinality == container->capacity)
+            {
+                capacity = container->capacity ? container->capacity * 2 : BITMAP_MIN_CAPACITY;
+                values = (u16 *)realloc(container->values, capacity * sizeof(u16));
+                if (values == NULL)
+                {
+                    if (container->cardinality == 0)
+                    {
+                        /* Drop the container just inserted, none is empty */
+                        bitmap->count--;
+                        memmove(container, container + 1, (bitmap->containers + bitmap->count - container) * sizeof(bitmap_container_s));
+                    }
+                    return BITMAP_ERR_ALLOC;
+                }
+                container->values = values;
+                container->capacity = capacity;
+            }
+            memmove(container->values + index + 1, container->values + index, (container->cardinality - index) * sizeof(u16));
+            container->values[index] = low;
+            container->cardinality++;
+            return BITMAP_ERR_NONE;
+        }
+        if (!BITMAP_array_to_bitset(container))
+        {
+            return BITMAP_ERR_ALLOC;
+        }
+    }
+
+    if (!BITMAP_TEST(container->words, low))
+    {
+        container->words[low >> 6] |= 1ULL << (low & 63);
+        container->cardinality++;
+    }
+    return BITMAP_ERR_NONE;
+}
+
+/*******************************************************************/
+
+bool BITMAP_contains(const bitmap_s *bitmap, u32 value)
+{
+    const bitmap_container_s *container;
+    s32 index = BITMAP_find(bitmap, BITMAP_KEY(value));
+
+    if (index < 0)
+    {
+        return FALSE;
+    }
+    container = bitmap->containers + index;
+    if (container->words != NULL)
+    {
+        return BITMAP_TEST(container->words, BITMAP_LOW(value));
+    }
+    return BITMAP_find_value(container->values, container->cardinality, BITMAP_LOW(value)) >= 0;
+}
+
+/*******************************************************************/
+
+u64 BITMAP_cardinality(const bitmap_s *bitmap)
+{
+    u64 cardinality = 0;
+    u32 i;
+
+    for (i = 0; i < bitmap->count; i++)
+    {
+        cardinality += bitmap->containers[i].cardinality;
+    }
+    return cardinality;
+}
+
+/*******************************************************************/
+
+u64 BITMAP_size(const bitmap_s *bitmap)
+{
+    u64 size = (u64)bitmap->capacity * sizeof(bitmap_container_s);
+    u32 i;
+
+    for (i = 0; i < bitmap->count; i++)
+    {
+        if (bitmap->containers[i].words != NULL)
+        {
+            size += BITMAP_WORDS * sizeof(u64);
+        }
+        else
+        {
+            size += bitmap->containers[i].capacity * sizeof(u16);
+        }
+    }
+    return size;
+}
+
+/*******************************************************************/
+
+static bool BITMAP_append_values(bitmap_s *bitmap, u16 key, const u16 *values, u32 count)
+{
+    bitmap_container_s *container;
+    u32 i;
+
+    if (count == 0)
+    {
+        return TRUE;
+    }
+    container = BITMAP_insert_container(bitmap, bitmap->count, key);
+    if (container == NULL)
+    {
+        return FALSE;
+    }
+    if (count <= BITMAP_ARRAY_MAX)
+    {
+        container->values = (u16 *)malloc(count * sizeof(u16));
+        if (container->values == NULL)
+        {
+            bitmap->count--;
+            return FALSE;
+        }
+        memcpy(container->values, values, count * sizeof(u16));
+        container->capacity = count;
+    }
+    else
+    {
+        container->words = (u64 *)calloc(BITMAP_WORDS, sizeof(u64));
+        if (container->words == NULL)
+        {
+            bitmap->count--;
+            return FALSE;
+        }
+        for (i = 0; i < count; i++)
+        {
+            container->words[values[i] >> 6] |= 1ULL << (values[i] & 63);
+        }
+    }
+    container->cardinality = count;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static bool BITMAP_append_words(bitmap_s *bitmap, u16 key, const u64 *words, u32 cardinality)
+{
+    bitmap_container_s *container;
+    u16 values[BITMAP_ARRAY_MAX];
+    u32 count = 0;
+    u64 word;
+    u32 i;
+
+    if (cardinality == 0)
+    {
+        return TRUE;
+    }
+    if (cardinality <= BITMAP_ARRAY_MAX)
+    {
+        for (i = 0; i < BITMAP_WORDS; i++)
+        {
+            for (word = words[i]; word != 0; word &= word - 1)
+            {
+                values[count++] = (u16)((i << 6) | __builtin_ctzll(word));
+            }
+        }
+        return BITMAP_append_values(bitmap, key, values, count);
+    }
+    container = BITMAP_insert_container(bitmap, bitmap->count, key);
+    if (container == NULL)
+    {
+        return FALSE;
+    }
+    container->words = (u64 *)malloc(BITMAP_WORDS * sizeof(u64));
+    if (container->words == NULL)
+    {
+        bitmap->count--;
+        return FALSE;
+    }
+    memcpy(container->words, words, BITMAP_WORDS * sizeof(u64));
+    container->cardinality = cardinality;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static bool BITMAP_append_container(bitmap_s *bitmap, const bitmap_container_s *container)
+{
+    if (container->words != NULL)
+    {
+        return BITMAP_append_words(bitmap, container->key, container->words, container->cardinality);
+    }
+    return BITMAP_append_values(bitmap, container->key, container->values, container->cardinality);
+}
+
+/*******************************************************************/
+
+static void BITMAP_load_words(const bitmap_container_s *container, u64 *words)
+{
+    u32 i;
+
+    if (container->words != NULL)
+    {
+        memcpy(words, container->words, BITMAP_WORDS * sizeof(u64));
+        return;
+    }
+    memset(words, 0, BITMAP_WORDS * sizeof(u64));
+    for (i = 0; i < container->cardinality; i++)
+    {
+        words[container->values[i] >> 6] |= 1ULL << (container->values[i] & 63);
+    }
+}
+
+/*******************************************************************/
+
+static bool BITMAP_and_containers(bitmap_s *bitmap, const bitmap_container_s *a, const bitmap_container_s *b)
+{
+    const bitmap_container_s *swap;
+    u16 values[BITMAP_ARRAY_MAX];
+    u64 words[BITMAP_WORDS];
+    u32 count = 0;
+    u32 i = 0;
+    u32 j = 0;
+
+    if (a->words != NULL && b->words != NULL)
+    {
+        for (i = 0; i < BITMAP_WORDS; i++)
+        {
+            words[i] = a->words[i] & b->words[i];
+        }
+        return BITMAP_append_words(bitmap, a->key, words, BITMAP_popcount(words));
+    }
+    if (a->words != NULL)
+    {
+        swap = a;
+        a = b;
+        b = swap;
+    }
+    /* a is an array, the intersection is a subset of it */
+    if (b->words != NULL)
+    {
+        for (i = 0; i < a->cardinality; i++)
+        {
+            values[count] = a->values[i];
+            count += BITMAP_TEST(b->words, a->values[i]);
+        }
+    }
+    else
+    {
+        while (i < a->cardinality && j < b->cardinality)
+        {
+            if (a->values[i] < b->values[j])
+            {
+                i++;
+            }
+            else if (a->values[i] > b->values[j])
+            {
+                j++;
+            }
+            else
+            {
+                values[count++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+    }
+    return BITMAP_append_values(bitmap, a->key, values, count);
+}
+
+/*******************************************************************/
+
+static bool BITMAP_or_containers(bitmap_s *bitmap, const bitmap_container_s *a, const bitmap_container_s *b)
+{
+    const bitmap_container_s *swap;
+    u16 values[2 * BITMAP_ARRAY_MAX];
+    u64 words[BITMAP_WORDS];
+    u32 count = 0;
+    u32 i = 0;
+    u32 j = 0;
+
+    if (a->words == NULL && b->words == NULL)
+    {
+        while (i < a->cardinality || j < b->cardinality)
+        {
+            if (j == b->cardinality || (i < a->cardinality && a->values[i] < b->values[j]))
+            {
+                values[count++] = a->values[i++];
+            }
+            else if (i == a->cardinality || a->values[i] > b->values[j])
+            {
+                values[count++] = b->values[j++];
+            }
+            else
+            {
+                values[count++] = a->values[i];
+                i++;
+                j++;
+            }
+        }
+        return BITMAP_append_values(bitmap, a->key, values, count);
+    }
+    if (a->words == NULL)
+    {
+        swap = a;
+        a = b;
+        b = swap;
+    }
+    /* a is a bitset, the union is one too */
+    memcpy(words, a->words, BITMAP_WORDS * sizeof(u64));
+    if (b->words != NULL)
+    {
+        for (i = 0; i < BITMAP_WORDS; i++)
+        {
+            words[i] |= b->words[i];
+        }
+    }
+    else
+    {
+        for (i = 0; i < b->cardinality; i++)
+        {
+            words[b->values[i] >> 6] |= 1ULL << (b->values[i] & 63);
+        }
+    }
+    return BITMAP_append_words(bitmap, a->key, words, BITMAP_popcount(words));
+}
+
+/*******************************************************************/
+
+static bool BITMAP_andnot_containers(bitmap_s *bitmap, const bitmap_container_s *a, const bitmap_container_s *b)
+{
+    u16 values[BITMAP_ARRAY_MAX];
+    u64 words[BITMAP_WORDS];
+    u32 count = 0;
+    u32 i = 0;
+    u32 j = 0;
+
+    if (a->words != NULL)
+    {
+        BITMAP_load_words(a, words);
+        if (b->words != NULL)
+        {
+            for (i = 0; i < BITMAP_WORDS; i++)
+            {
+                words[i] &= ~b->words[i];
+            }
+        }
+        else
+        {
+            for (i = 0; i < b->cardinality; i++)
+            {
+                words[b->values[i] >> 6] &= ~(1ULL << (b->values[i] & 63));
+            }
+        }
+        return BITMAP_append_words(bitmap, a->key, words, BITMAP_popcount(words));
+    }
+    /* a is an array, the difference is a subset of it */
+    if (b->words != NULL)
+    {
+        for (i = 0; i < a->cardinality; i++)
+        {
+            values[count] = a->values[i];
+            count += 1 - BITMAP_TEST(b->words, a->values[i]);
+        }
+    }
+    else
+    {
+        while (i < a->cardinality)
+        {
+            if (j == b->cardinality || a->values[i] < b->values[j])
+            {
+                values[count++] = a->values[i++];
+            }
+            else if (a->values[i] > b->values[j])
+            {
+                j++;
+            }
+            else
+            {
+                i++;
+                j++;
+            }
+        }
+    }
+    return BITMAP_append_values(bitmap, a->key, values, count);
+}
+
+/*******************************************************************/
+
+u8 BITMAP_copy(const bitmap_s *bitmap, bitmap_s *bitmap_out)
+{
+    u32 i;
+
+    BITMAP_clear(bitmap_out);
+    for (i = 0; i < bitmap->count; i++)
+    {
+        if (!BITMAP_append_container(bitmap_out, bitmap->containers + i))
+        {
+            BITMAP_clear(bitmap_out);
+            return BITMAP_ERR_ALLOC;
+        }
+    }
+    return BITMAP_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 BITMAP_and(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+{
+    u32 i = 0;
+    u32 j = 0;
+
+    BITMAP_clear(bitmap_out);
+    while (i < a->count && j < b->count)
+    {
+        if (a->containers[i].key < b->containers[j].key)
+        {
+            i++;
+        }
+        else if (a->containers[i].key > b->containers[j].key)
+        {
+            j++;
+        }
+        else
+        {
+            if (!BITMAP_and_containers(bitmap_out, a->containers + i, b->containers + j))
+            {
+                BITMAP_clear(bitmap_out);
+                return BITMAP_ERR_ALLOC;
+            }
+            i++;
+            j++;
+        }
+    }
+    return BITMAP_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 BITMAP_or(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+{
+    u32 i = 0;
+    u32 j = 0;
+    bool done;
+
+    BITMAP_clear(bitmap_out);
+    while (i < a->count || j < b->count)
+    {
+        if (j == b->count || (i < a->count && a->containers[i].key < b->containers[j].key))
+        {
+            done = BITMAP_append_container(bitmap_out, a->containers + i++);
+        }
+        else if (i == a->count || a->containers[i].key > b->containers[j].key)
+        {
+            done = BITMAP_append_container(bitmap_out, b->containers + j++);
+        }
+        else
+        {
+            done = BITMAP_or_containers(bitmap_out, a->containers + i++, b->containers + j++);
+        }
+        if (!done)
+        {
+            BITMAP_clear(bitmap_out);
+            return BITMAP_ERR_ALLOC;
+        }
+    }
+    return BITMAP_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 BITMAP_andnot(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+{
+    u32 i = 0;
+    u32 j = 0;
+    bool done;
+
+    BITMAP_clear(bitmap_out);
+    while (i < a->count)
+    {
+        if (j == b->count || a->containers[i].key < b->containers[j].key)
+        {
+            done = BITMAP_append_container(bitmap_out, a->containers + i++);
+        }
+        else if (a->containers[i].key > b->containers[j].key)
+        {
+            j++;
+            continue;
+        }
+        else
+        {
+            done = BITMAP_andnot_containers(bitmap_out, a->containers + i++, b->containers + j++);
+        }
+        if (!done)
+        {
+            BITMAP_clear(bitmap_out);
+            return BITMAP_ERR_ALLOC;
+        }
+    }
+    return BITMAP_ERR_NONE;
+}
+
+/*******************************************************************/
+
+void BITMAP_to_array(const bitmap_s *bitmap, u32 *values_out)
+{
+    const bitmap_container_s *container;
+    u32 high;
+    u64 word;
+    u32 i;
+    u32 j;
+
+    for (i = 0; i < bitmap->count; i++)
+    {
+        container = bitmap->containers + i;
+        high = (u32)container->key << 16;
+        if (container->words == NULL)
+        {
+            for (j = 0; j < container->cardinality; j++)
+            {
+                *values_out++ = high | container->values[j];
+            }
+            continue;
+        }
+        for (j = 0; j < BITMAP_WORDS; j++)
+        {
+            for (word = container->words[j]; word != 0; word &= word - 1)
+            {
+                *values_out++ = high | (j << 6) | __builtin_ctzll(word);
+            }
+        }
+    }
+}
+
+/*******************************************************************/
+
+u32 BITMAP_serialized_size(const bitmap_s *bitmap)
+{
+    u32 size = sizeof(u32);
+    u32 i;
+
+    for (i = 0; i < bitmap->count; i++)
+    {
+        size += BITMAP_CONTAINER_HEADER_SIZE;
+        if (bitmap->containers[i].words != NULL)
+        {
+            size += BITMAP_WORDS * sizeof(u64);
+        }
+        else
+        {
+            size += bitmap->containers[i].cardinality * sizeof(u16);
+        }
+    }
+    return size;
+}
+
+/*******************************************************************/
+
+static u8 *BITMAP_write_u16(u8 *out, u16 value)
+{
+    out[0] = (u8)value;
+    out[1] = (u8)(value >> 8);
+    return out + 2;
+}
+
+/*******************************************************************/
+
+static u16 BITMAP_read_u16(const u8 *in)
+{
+    return (u16)(in[0] | (in[1] << 8));
+}
+
+/*******************************************************************/
+
+u8 *BITMAP_write(const bitmap_s *bitmap, u8 *out)
+{
+    const bitmap_container_s *container;
+    u64 word;
+    u32 i;
+    u32 j;
+    u32 k;
+
+    out = BITMAP_write_u16(out, (u16)bitmap->count);
+    out = BITMAP_write_u16(out, (u16)(bitmap->count >> 16));
+    for (i = 0; i < bitmap->count; i++)
+    {
+        container = bitmap->containers + i;
+        out = BITMAP_write_u16(out, container->key);
+        out = BITMAP_write_u16(out, (u16)(container->cardinality - 1));
+        if (container->words == NULL)
+        {
+            for (j = 0; j < container->cardinality; j++)
+            {
+                out = BITMAP_write_u16(out, container->values[j]);
+            }
+            continue;
+        }
+        for (j = 0; j < BITMAP_WORDS; j++)
+        {
+            word = container->words[j];
+            for (k = 0; k < 8; k++)
+            {
+                *out++ = (u8)(word >> (k * 8));
+            }
+        }
+    }
+    return out;
+}
+
+/*******************************************************************/
+
+bool BITMAP_read(const u8 **in, const u8 *end, bitmap_s *bitmap_out)
+{
+    const u8 *cursor = *in;
+    u16 values[BITMAP_ARRAY_MAX];
+    u64 words[BITMAP_WORDS];
+    u32 count;
+    u32 cardinality;
+    u16 key;
+    u32 i;
+    u32 j;
+    u32 k;
+
+    BITMAP_clear(bitmap_out);
+    if (end - cursor < (long)sizeof(u32))
+    {
+        return FALSE;
+    }
+    count = BITMAP_read_u16(cursor) | ((u32)BITMAP_read_u16(cursor + 2) << 16);
+    cursor += sizeof(u32);
+    if (count > 0x10000)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (end - cursor < BITMAP_CONTAINER_HEADER_SIZE)
+        {
+            break;
+        }
+        key = BITMAP_read_u16(cursor);
+        cardinality = (u32)BITMAP_read_u16(cursor + 2) + 1;
+        cursor += BITMAP_CONTAINER_HEADER_SIZE;
+        if (bitmap_out->count != 0 && key <= bitmap_out->containers[bitmap_out->count - 1].key)
+        {
+            break;
+        }
+
+        if (cardinality <= BITMAP_ARRAY_MAX)
+        {
+            if ((u32)(end - cursor) < cardinality * sizeof(u16))
+            {
+                break;
+            }
+            for (j = 0; j < cardinality; j++)
+            {
+                values[j] = BITMAP_read_u16(cursor + j * sizeof(u16));
+                if (j != 0 && values[j] <= values[j - 1])
+                {
+                    break;
+                }
+            }
+            cursor += cardinality * sizeof(u16);
+            if (j != cardinality || !BITMAP_append_values(bitmap_out, key, values, cardinality))
+            {
+                break;
+            }
+        }
+        else
+        {
+            if ((u32)(end - cursor) < BITMAP_WORDS * sizeof(u64))
+            {
+                break;
+            }
+            for (j = 0; j < BITMAP_WORDS; j++)
+            {
+                words[j] = 0;
+                for (k = 0; k < 8; k++)
+                {
+                    words[j] |= (u64)cursor[k] << (k * 8);
+                }
+                cursor += sizeof(u64);
+            }
+            if (BITMAP_popcount(words) != cardinality || !BITMAP_append_words(bitmap_out, key, words, cardinality))
+            {
+                break;
+            }
+        }
+    }
+
+    if (i != count)
+    {
+        BITMAP_clear(bitmap_out);
+        return FALSE;
+    }
+    *in = cursor;
+    return TRUE;
+}
@@ -0,0 +1,141 @@
+/*!******************************************************************
+ * \file sensit_bitmap.h
+ * \brief Functions & Types of compressed bitmaps of row ids
+ * \author Sens'it Team
+ *
+ * Roaring bitmap: the 32 bits row ids are split by their high 16 bits
+ * in containers of at most 65536 values, sorted by key. A container
+ * of up to BITMAP_ARRAY_MAX values is a sorted array of their low 16
+ * bits (2 bytes per value), a denser one a bitset of 8 KiB. Operations
+ * go container by container and only visit the keys of their operands,
+ * their cost depends on the number of values, not on the range of the
+ * row ids.
+ *******************************************************************/
+
+#define BITMAP_ERR_NONE 0x00
+#define BITMAP_ERR_ALLOC 0x01
+
+#define BITMAP_ARRAY_MAX 4096 /* Values of an array container, the size of a bitset */
+#define BITMAP_WORDS 1024     /* 64 bits words of a bitset container */
+
+/*!******************************************************************
+ * \struct bitmap_container_s
+ * \brief Values of a bitmap sharing their high 16 bits
+ *******************************************************************/
+typedef struct
+{
+    u16 key;         /*!< High 16 bits of the values */
+    u32 cardinality; /*!< 1 to 65536 */
+    u32 capacity;    /*!< Values allocated of an array container */
+    u16 *values;     /*!< Sorted low 16 bits, when cardinality <= BITMAP_ARRAY_MAX */
+    u64 *words;      /*!< Bitset of the low 16 bits, otherwise */
+} bitmap_container_s;
+
+/*!******************************************************************
+ * \struct bitmap_s
+ * \brief Set of u32, all zero is an empty bitmap
+ *******************************************************************/
+typedef struct
+{
+    bitmap_container_s *containers; /*!< Sorted by key, none is empty */
+    u32 count;
+    u32 capacity;
+} bitmap_s;
+
+/*!************************************************************************
+ * \fn void BITMAP_init(bitmap_s *bitmap)
+ * \brief Empty bitmap, nothing allocated.
+ **************************************************************************/
+void BITMAP_init(bitmap_s *bitmap);
+
+/*!************************************************************************
+ * \fn void BITMAP_clear(bitmap_s *bitmap)
+ * \brief Free the containers, the bitmap is left empty.
+ **************************************************************************/
+void BITMAP_clear(bitmap_s *bitmap);
+
+/*!************************************************************************
+ * \fn u8 BITMAP_add(bitmap_s *bitmap, u32 value)
+ * \brief Add a value, appending values in increasing order is the
+ *        fastest.
+ *
+ * \retval                          BITMAP_ERR_NONE or BITMAP_ERR_ALLOC
+ **************************************************************************/
+u8 BITMAP_add(bitmap_s *bitmap, u32 value);
+
+/*!************************************************************************
+ * \fn bool BITMAP_contains(const bitmap_s *bitmap, u32 value)
+ **************************************************************************/
+bool BITMAP_contains(const bitmap_s *bitmap, u32 value);
+
+/*!************************************************************************
+ * \fn u64 BITMAP_cardinality(const bitmap_s *bitmap)
+ **************************************************************************/
+u64 BITMAP_cardinality(const bitmap_s *bitmap);
+
+/*!************************************************************************
+ * \fn u64 BITMAP_size(const bitmap_s *bitmap)
+ * \brief Bytes allocated by the containers.
+ **************************************************************************/
+u64 BITMAP_size(const bitmap_s *bitmap);
+
+/*!************************************************************************
+ * \fn u8 BITMAP_copy(const bitmap_s *bitmap, bitmap_s *bitmap_out)
+ * \brief bitmap_out is cleared first, then holds the values of bitmap.
+ *
+ * \retval                          BITMAP_ERR_NONE or BITMAP_ERR_ALLOC, bitmap_out is then empty
+ **************************************************************************/
+u8 BITMAP_copy(const bitmap_s *bitmap, bitmap_s *bitmap_out);
+
+/*!************************************************************************
+ * \fn u8 BITMAP_and(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+ * \brief Values of both a and b. bitmap_out is cleared first and must
+ *        be neither a nor b.
+ *
+ * \retval                          BITMAP_ERR_NONE or BITMAP_ERR_ALLOC, bitmap_out is then empty
+ **************************************************************************/
+u8 BITMAP_and(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out);
+
+/*!************************************************************************
+ * \fn u8 BITMAP_or(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+ * \brief Values of a or b, same as BITMAP_and.
+ **************************************************************************/
+u8 BITMAP_or(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out);
+
+/*!************************************************************************
+ * \fn u8 BITMAP_andnot(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out)
+ * \brief Values of a but not of b, same as BITMAP_and.
+ **************************************************************************/
+u8 BITMAP_andnot(const bitmap_s *a, const bitmap_s *b, bitmap_s *bitmap_out);
+
+/*!************************************************************************
+ * \fn void BITMAP_to_array(const bitmap_s *bitmap, u32 *values_out)
+ * \brief Write the values in increasing order.
+ *
+ * \param[out] values_out           BITMAP_cardinality(bitmap) values
+ **************************************************************************/
+void BITMAP_to_array(const bitmap_s *bitmap, u32 *values_out);
+
+/*!************************************************************************
+ * \fn u32 BITMAP_serialized_size(const bitmap_s *bitmap)
+ * \brief Bytes written by BITMAP_write.
+ **************************************************************************/
+u32 BITMAP_serialized_size(const bitmap_s *bitmap);
+
+/*!************************************************************************
+ * \fn u8 *BITMAP_write(const bitmap_s *bitmap, u8 *out)
+ * \brief Encode a bitmap, little endian: the number of containers on 4
+ *        bytes, then per container its key and cardinality - 1 on 2
+ *        bytes each, followed by its array or its bitset as is.
+ *
+ * \retval                          End of the bytes written
+ **************************************************************************/
+u8 *BITMAP_write(const bitmap_s *bitmap, u8 *out);
+
+/*!************************************************************************
+ * \fn bool BITMAP_read(const u8 **in, const u8 *end, bitmap_s *bitmap_out)
+ * \brief Decode a bitmap of BITMAP_write and move *in after it.
+ *        bitmap_out is cleared first, and left empty if the bytes are
+ *        not a valid bitmap or the allocation failed.
+ **************************************************************************/
+bool BITMAP_read(const u8 **in, const u8 *end, bitmap_s *bitmap_out);
@@ -0,0 +1,85 @@
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+#include <node.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_payload_node.h"
+
+static void ThrowError(v8::Isolate *isolate, const char *message)
+{
+  isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, message)));
+}
+
+void RegisterDecoders(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+#ifdef _WIN32
+  ThrowError(isolate, "Decoder plugins are not supported on Windows");
+#else
+  // args: path of the shared library
+  v8::String::Utf8Value path(args[0]);
+
+  // The library is never closed, the registered decoders point into it
+  void *library = dlopen(*path, RTLD_NOW | RTLD_LOCAL);
+  if (library == NULL)
+  {
+    ThrowError(isolate, dlerror());
+    return;
+  }
+  payload_decoders_f decoders_of = (payload_decoders_f)dlsym(library, PAYLOAD_DECODERS_SYMBOL);
+  if (decoders_of == NULL)
+  {
+    ThrowError(isolate, "Missing " PAYLOAD_DECODERS_SYMBOL " in the decoder plugin");
+    return;
+  }
+
+  u32 count = 0;
+  const payload_decoder_s *decoders = decoders_of(&count);
+  for (u32 i = 0; i < count; i++)
+  {
+    switch (PAYLOAD_register_decoder(&(decoders[i])))
+    {
+    case PAYLOAD_REGISTER_ERR_NONE:
+      break;
+    case PAYLOAD_REGISTER_ERR_FULL:
+      ThrowError(isolate, "Too many decoders registered");
+      return;
+    case PAYLOAD_REGISTER_ERR_DECODER:
+      ThrowError(isolate, "Invalid decoder in the decoder plugin");
+      return;
+    default:
+      ThrowError(isolate, "Unable to register the decoder");
+      return;
+    }
+  }
+  args.GetReturnValue().Set(count);
+#endif
+}
+
+void Decoders(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  const payload_decoder_s *decoders[PAYLOAD_MAX_DECODERS];
+  u32 count = PAYLOAD_decoders(decoders, PAYLOAD_MAX_DECODERS);
+
+  v8::Local<v8::Array> list = v8::Array::New(isolate, count);
+  for (u32 i = 0; i < count; i++)
+  {
+    v8::Local<v8::Object> decoder = v8::Object::New(isolate);
+    decoder->Set(v8::String::NewFromUtf8(isolate, "name"), v8::String::NewFromUtf8(isolate, decoders[i]->name != NULL ? decoders[i]->name : ""));
+    decoder->Set(v8::String::NewFromUtf8(isolate, "type"), v8::Integer::NewFromUnsigned(isolate, decoders[i]->type));
+    decoder->Set(v8::String::NewFromUtf8(isolate, "keyMask"), v8::Integer::NewFromUnsigned(isolate, decoders[i]->key_mask));
+    decoder->Set(v8::String::NewFromUtf8(isolate, "keyValue"), v8::Integer::NewFromUnsigned(isolate, decoders[i]->key_value));
+    list->Set(i, decoder);
+  }
+  args.GetReturnValue().Set(list);
+}
+
+void DECODER_node_init(v8::Local<v8::Object> exports)
+{
+  NODE_SET_METHOD(exports, "registerDecoders", RegisterDecoders);
+  NODE_SET_METHOD(exports, "decoders", Decoders);
+}
@@ -0,0 +1,174 @@
+/*!******************************************************************
+ * \file sensit_dedup.c
+ * \brief Functions to drop duplicated Sigfox uplinks
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_dedup.h"
+
+/******* DEFINE ****************************************************/
+#define DEDUP_MIN_BUCKETS 16
+#define DEDUP_CACHE_LINE 64
+#define DEDUP_PREFETCH_DISTANCE 8
+
+/*******************************************************************/
+
+static inline u32 DEDUP_bucket(const dedup_s *dedup, u32 device_id)
+{
+    u32 hash = device_id * 0x9E3779B1;
+    return (hash ^ (hash >> 16)) & dedup->bucket_mask;
+}
+
+/*******************************************************************/
+
+dedup_s *DEDUP_create(u32 capacity)
+{
+    dedup_s *dedup = (dedup_s *)calloc(1, sizeof(dedup_s));
+    void *entries = NULL;
+    u32 bucket_count = DEDUP_MIN_BUCKETS;
+
+    if (dedup == NULL)
+    {
+        return NULL;
+    }
+
+    while ((bucket_count * DEDUP_WAYS) < capacity && bucket_count < 0x80000000 / DEDUP_WAYS)
+    {
+        bucket_count <<= 1;
+    }
+
+    if (posix_memalign(&entries, DEDUP_CACHE_LINE, (size_t)bucket_count * DEDUP_WAYS * sizeof(dedup_entry_s)) != 0)
+    {
+        free(dedup);
+        return NULL;
+    }
+
+    dedup->entries = (dedup_entry_s *)entries;
+    dedup->bucket_count = bucket_count;
+    dedup->bucket_mask = bucket_count - 1;
+    DEDUP_reset(dedup);
+    return dedup;
+}
+
+/*******************************************************************/
+
+void DEDUP_destroy(dedup_s *dedup)
+{
+    if (dedup != NULL)
+    {
+        free(dedup->entries);
+        free(dedup);
+    }
+}
+
+/*******************************************************************/
+
+void DEDUP_reset(dedup_s *dedup)
+{
+    memset(dedup->entries, 0, (size_t)dedup->bucket_count * DEDUP_WAYS * sizeof(dedup_entry_s));
+    memset(&(dedup->stats), 0, sizeof(dedup_stats_s));
+}
+
+/*******************************************************************/
+
+u8 DEDUP_check(dedup_s *dedup, u32 device_id, u16 seq_number)
+{
+    dedup_entry_s *bucket = &(dedup->entries[DEDUP_bucket(dedup, device_id) * DEDUP_WAYS]);
+    dedup_entry_s entry;
+    u8 way;
+    u8 result = DEDUP_KEEP;
+    u16 delta;
+
+    seq_number &= DEDUP_SEQ_MASK;
+    dedup->stats.lookups++;
+
+    for (way = 0; way < DEDUP_WAYS; way++)
+    {
+        if (bucket[way].window == 0 || bucket[way].device_id == device_id)
+        {
+            break;
+        }
+    }
+
+    if (way == DEDUP_WAYS || bucket[way].window == 0)
+    {
+        /* New device: evict the least recently used entry if the bucket is full */
+        if (way == DEDUP_WAYS)
+        {
+            way = DEDUP_WAYS - 1;
+            dedup->stats.evictions++;
+        }
+        dedup->stats.devices++;
+        entry.device_id = device_id;
+        entry.head = seq_number;
+        entry.spare = 0;
+        entry.window = 1;
+    }
+    else
+    {
+        entry = bucket[way];
+        delta = (seq_number - entry.head) & DEDUP_SEQ_MASK;
+
+        if (delta == 0)
+        {
+            result = DEDUP_DROP;
+        }
+        else if (delta < DEDUP_SEQ_HALF)
+        {
+            /* Newer uplink, seqNumber wrap-around is handled by the mask */
+            entry.window = (delta >= DEDUP_WINDOW_SIZE) ? 1 : ((entry.window << delta) | 1);
+            entry.head = seq_number;
+        }
+        else
+        {
+            delta = (entry.head - seq_number) & DEDUP_SEQ_MASK;
+            if (delta >= DEDUP_WINDOW_SIZE)
+            {
+                /* Too old to tell, never drop an uplink that may be unique */
+                dedup->stats.out_of_window++;
+            }
+            else if (entry.window & (1ULL << delta))
+            {
+                result = DEDUP_DROP;
+            }
+            else
+            {
+                entry.window |= (1ULL << delta);
+            }
+        }
+    }
+
+    /* Move the entry in front of the bucket */
+    memmove(&(bucket[1]), &(bucket[0]), way * sizeof(dedup_entry_s));
+    bucket[0] = entry;
+
+    if (result == DEDUP_DROP)
+    {
+        dedup->stats.duplicates++;
+    }
+    return result;
+}
+
+/*******************************************************************/
+
+u32 DEDUP_filter(dedup_s *dedup, const u32 *device_ids, const u16 *seq_numbers, u32 count, u8 *keep_mask)
+{
+    u32 kept = 0;
+    u32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (i + DEDUP_PREFETCH_DISTANCE < count)
+        {
+            __builtin_prefetch(&(dedup->entries[DEDUP_bucket(dedup, device_ids[i + DEDUP_PREFETCH_DISTANCE]) * DEDUP_WAYS]), 1);
+        }
+        keep_mask[i] = DEDUP_check(dedup, device_ids[i], seq_numbers[i]);
+        kept += keep_mask[i];
+    }
+    return kept;
+}
+
+/*******************************************************************/
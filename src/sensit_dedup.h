@@ -0,0 +1,101 @@
+/*!******************************************************************
+ * \file sensit_dedup.h
+ * \brief Functions & Types to drop duplicated Sigfox uplinks
+ * \author Sens'it Team
+ *
+ * The same uplink is delivered by every base station that received it.
+ * Uplinks are identified by (device id, seqNumber), seqNumber being a
+ * 12 bits counter. For each device a sliding window of the last
+ * DEDUP_WINDOW_SIZE sequence numbers is kept in a fixed size, 4-way
+ * set associative table: a bucket fills exactly one cache line.
+ *******************************************************************/
+
+#define DEDUP_SEQ_MASK 0x0FFF
+#define DEDUP_SEQ_HALF 0x0800
+#define DEDUP_WINDOW_SIZE 64
+#define DEDUP_WAYS 4
+
+#define DEDUP_DROP 0
+#define DEDUP_KEEP 1
+
+/*!******************************************************************
+ * \struct dedup_entry_s
+ * \brief Sliding window of a device
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id; /*!< Sigfox device id */
+    u16 head;      /*!< Highest seqNumber seen */
+    u16 spare;
+    u64 window;    /*!< Bit i set if seqNumber (head - i) has been seen. 0 for a free entry */
+} dedup_entry_s;
+
+/*!******************************************************************
+ * \struct dedup_stats_s
+ * \brief Duplicate-rate statistics
+ *******************************************************************/
+typedef struct
+{
+    u64 lookups;       /*!< Number of (device, seqNumber) checked */
+    u64 duplicates;    /*!< Number of uplinks flagged as duplicated */
+    u64 out_of_window; /*!< Uplinks older than the window, kept */
+    u64 devices;       /*!< Number of devices inserted in the table */
+    u64 evictions;     /*!< Number of devices evicted to make room */
+} dedup_stats_s;
+
+/*!******************************************************************
+ * \struct dedup_s
+ * \brief Deduplication table
+ *******************************************************************/
+typedef struct
+{
+    dedup_entry_s *entries; /*!< bucket_count * DEDUP_WAYS entries, most recently used first */
+    u32 bucket_count;       /*!< Power of 2 */
+    u32 bucket_mask;
+    dedup_stats_s stats;
+} dedup_s;
+
+/*!************************************************************************
+ * \fn dedup_s *DEDUP_create(u32 capacity)
+ * \brief Allocate a deduplication table.
+ *
+ * \param[in] capacity              Number of devices tracked, rounded up to
+ *                                  a power of 2. Least recently seen devices
+ *                                  are evicted beyond it.
+ * \retval                          NULL if the allocation failed
+ **************************************************************************/
+dedup_s *DEDUP_create(u32 capacity);
+
+/*!************************************************************************
+ * \fn void DEDUP_destroy(dedup_s *dedup)
+ * \brief Free a deduplication table.
+ **************************************************************************/
+void DEDUP_destroy(dedup_s *dedup);
+
+/*!************************************************************************
+ * \fn void DEDUP_reset(dedup_s *dedup)
+ * \brief Forget every device and clear the statistics.
+ **************************************************************************/
+void DEDUP_reset(dedup_s *dedup);
+
+/*!************************************************************************
+ * \fn u8 DEDUP_check(dedup_s *dedup, u32 device_id, u16 seq_number)
+ * \brief Record an uplink and tell if it must be kept.
+ *
+ * \param[in] device_id             Sigfox device id
+ * \param[in] seq_number            Sigfox seqNumber (12 bits)
+ * \retval                          DEDUP_KEEP or DEDUP_DROP
+ **************************************************************************/
+u8 DEDUP_check(dedup_s *dedup, u32 device_id, u16 seq_number);
+
+/*!************************************************************************
+ * \fn u32 DEDUP_filter(dedup_s *dedup, const u32 *device_ids, const u16 *seq_numbers, u32 count, u8 *keep_mask)
+ * \brief Record a batch of uplinks, to be called before PAYLOAD_parse_data.
+ *
+ * \param[in] device_ids            Sigfox device ids
+ * \param[in] seq_numbers           Sigfox seqNumbers
+ * \param[in] count                 Number of uplinks in the batch
+ * \param[out] keep_mask            DEDUP_KEEP or DEDUP_DROP for each uplink
+ * \retval                          Number of uplinks kept
+ **************************************************************************/
+u32 DEDUP_filter(dedup_s *dedup, const u32 *device_ids, const u16 *seq_numbers, u32 count, u8 *keep_mask);
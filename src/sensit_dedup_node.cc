@@ -0,0 +1,119 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_dedup.h"
+#include "sensit_payload_node.h"
+
+#define DEDUP_DEFAULT_CAPACITY (1 << 20)
+
+class Deduplicator : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Deduplicator(dedup_s *dedup) : dedup_(dedup) {}
+  ~Deduplicator() { DEDUP_destroy(dedup_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Check(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Filter(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Reset(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  dedup_s *dedup_;
+};
+
+void Deduplicator::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Deduplicator"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "check", Check);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "filter", Filter);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "reset", Reset);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Deduplicator"), tpl->GetFunction());
+}
+
+void Deduplicator::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  u32 capacity = args[0]->IsNumber() ? args[0]->Uint32Value() : DEDUP_DEFAULT_CAPACITY;
+  dedup_s *dedup = DEDUP_create(capacity);
+  if (dedup == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the deduplication table")));
+    return;
+  }
+
+  Deduplicator *obj = new Deduplicator(dedup);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void Deduplicator::Check(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Deduplicator *obj = node::ObjectWrap::Unwrap<Deduplicator>(args.Holder());
+
+  u8 keep = DEDUP_check(obj->dedup_, args[0]->Uint32Value(), (u16)args[1]->Uint32Value());
+  args.GetReturnValue().Set(keep == DEDUP_KEEP);
+}
+
+void Deduplicator::Filter(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Deduplicator *obj = node::ObjectWrap::Unwrap<Deduplicator>(args.Holder());
+
+  // args: Uint32Array device ids, Uint16Array seqNumbers, Uint8Array keep mask
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[0]);
+  const u16 *seq_numbers = (const u16 *)node::Buffer::Data(args[1]);
+  u8 *keep_mask = (u8 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / sizeof(u32);
+  if (count > node::Buffer::Length(args[1]) / sizeof(u16))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u16);
+  }
+  if (count > node::Buffer::Length(args[2]))
+  {
+    count = node::Buffer::Length(args[2]);
+  }
+
+  u32 kept = DEDUP_filter(obj->dedup_, device_ids, seq_numbers, (u32)count, keep_mask);
+  args.GetReturnValue().Set(kept);
+}
+
+void Deduplicator::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Deduplicator *obj = node::ObjectWrap::Unwrap<Deduplicator>(args.Holder());
+  const dedup_stats_s *stats = &(obj->dedup_->stats);
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+
+  res->Set(v8::String::NewFromUtf8(isolate, "lookups"), v8::Number::New(isolate, (double)stats->lookups));
+  res->Set(v8::String::NewFromUtf8(isolate, "duplicates"), v8::Number::New(isolate, (double)stats->duplicates));
+  res->Set(v8::String::NewFromUtf8(isolate, "outOfWindow"), v8::Number::New(isolate, (double)stats->out_of_window));
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Number::New(isolate, (double)stats->devices));
+  res->Set(v8::String::NewFromUtf8(isolate, "evictions"), v8::Number::New(isolate, (double)stats->evictions));
+
+  args.GetReturnValue().Set(res);
+}
+
+void Deduplicator::Reset(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Deduplicator *obj = node::ObjectWrap::Unwrap<Deduplicator>(args.Holder());
+  DEDUP_reset(obj->dedup_);
+}
+
+void DEDUP_node_init(v8::Local<v8::Object> exports)
+{
+  Deduplicator::Init(exports);
+}
@@ -0,0 +1,143 @@
+/*!******************************************************************
+ * \file sensit_devices.c
+ * \brief Functions of the device id to index table
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+
+/*******************************************************************/
+
+static u32 DEVICES_home(const devices_s *devices, u32 device_id)
+{
+    u32 hash = device_id * 0x9E3779B1;
+    return (hash ^ (hash >> 16)) & (devices->slot_count - 1);
+}
+
+/*******************************************************************/
+
+static u32 DEVICES_slot(const devices_s *devices, u32 device_id)
+{
+    u32 slot = DEVICES_home(devices, device_id);
+
+    while (devices->slots[slot].index != 0 && devices->slots[slot].device_id != device_id)
+    {
+        slot = (slot + 1) & (devices->slot_count - 1);
+    }
+    return slot;
+}
+
+/*******************************************************************/
+
+static bool DEVICES_grow(devices_s *devices)
+{
+    devices_slot_s *slots = devices->slots;
+    u32 slot_count = devices->slot_count;
+    u32 i;
+
+    devices->slots = (devices_slot_s *)calloc((size_t)slot_count * 2, sizeof(devices_slot_s));
+    if (devices->slots == NULL)
+    {
+        devices->slots = slots;
+        return FALSE;
+    }
+    devices->slot_count = slot_count * 2;
+    for (i = 0; i < slot_count; i++)
+    {
+        if (slots[i].index != 0)
+        {
+            devices->slots[DEVICES_slot(devices, slots[i].device_id)] = slots[i];
+        }
+    }
+    free(slots);
+    return TRUE;
+}
+
+/*******************************************************************/
+
+bool DEVICES_init(devices_s *devices)
+{
+    devices->slots = (devices_slot_s *)calloc(DEVICES_MIN_SLOTS, sizeof(devices_slot_s));
+    devices->slot_count = DEVICES_MIN_SLOTS;
+    devices->count = 0;
+    return devices->slots != NULL;
+}
+
+/*******************************************************************/
+
+void DEVICES_free(devices_s *devices)
+{
+    free(devices->slots);
+    devices->slots = NULL;
+    devices->count = 0;
+}
+
+/*******************************************************************/
+
+u32 DEVICES_find(const devices_s *devices, u32 device_id)
+{
+    u32 slot = DEVICES_slot(devices, device_id);
+
+    return (devices->slots[slot].index == 0) ? DEVICES_NONE : devices->slots[slot].index - 1;
+}
+
+/*******************************************************************/
+
+bool DEVICES_add(devices_s *devices, u32 device_id, u32 index)
+{
+    u32 slot;
+
+    if ((devices->count + 1) * 2 > devices->slot_count && !DEVICES_grow(devices))
+    {
+        return FALSE;
+    }
+    slot = DEVICES_slot(devices, device_id);
+    devices->slots[slot].device_id = device_id;
+    devices->slots[slot].index = index + 1;
+    devices->count++;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+void DEVICES_move(devices_s *devices, u32 device_id, u32 index)
+{
+    devices->slots[DEVICES_slot(devices, device_id)].index = index + 1;
+}
+
+/*******************************************************************/
+
+u32 DEVICES_remove(devices_s *devices, u32 device_id)
+{
+    u32 mask = devices->slot_count - 1;
+    u32 hole = DEVICES_slot(devices, device_id);
+    u32 slot = hole;
+    u32 home;
+    u32 index = devices->slots[hole].index;
+
+    if (index == 0)
+    {
+        return DEVICES_NONE;
+    }
+
+    /* Backward shift deletion keeps the probe sequences without tombstones */
+    for (;;)
+    {
+        slot = (slot + 1) & mask;
+        if (devices->slots[slot].index == 0)
+        {
+            break;
+        }
+        home = DEVICES_home(devices, devices->slots[slot].device_id);
+        if ((slot > hole && (home <= hole || home > slot)) || (slot < hole && (home <= hole && home > slot)))
+        {
+            devices->slots[hole] = devices->slots[slot];
+            hole = slot;
+        }
+    }
+    devices->slots[hole].index = 0;
+    devices->count--;
+    return index - 1;
+}
@@ -0,0 +1,74 @@
+/*!******************************************************************
+ * \file sensit_devices.h
+ * \brief Functions & Types of the device id to index table
+ * \author Sens'it Team
+ *
+ * The per device states of the stores are kept in dense arrays, the
+ * table maps a device id to its index in the array. Open addressing
+ * with linear probing, at most half full, and backward shift deletion
+ * so that removals leave no tombstones. Each slot holds the device id
+ * along with its index, a lookup does not touch the states.
+ *******************************************************************/
+
+#define DEVICES_NONE 0xFFFFFFFF /* Index of an unknown device */
+#define DEVICES_MIN_SLOTS 64
+
+/*!******************************************************************
+ * \struct devices_slot_s
+ * \brief Slot of the table
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 index;      /*!< Index + 1 in the states, 0 is a free slot */
+} devices_slot_s;
+
+/*!******************************************************************
+ * \struct devices_s
+ * \brief Table of the device ids
+ *******************************************************************/
+typedef struct
+{
+    devices_slot_s *slots;
+    u32 slot_count;         /*!< Power of 2 */
+    u32 count;
+} devices_s;
+
+/*!************************************************************************
+ * \fn bool DEVICES_init(devices_s *devices)
+ * \brief Allocate an empty table, FALSE if the allocation failed.
+ **************************************************************************/
+bool DEVICES_init(devices_s *devices);
+
+/*!************************************************************************
+ * \fn void DEVICES_free(devices_s *devices)
+ **************************************************************************/
+void DEVICES_free(devices_s *devices);
+
+/*!************************************************************************
+ * \fn u32 DEVICES_find(const devices_s *devices, u32 device_id)
+ * \brief Index of a device, DEVICES_NONE if unknown.
+ **************************************************************************/
+u32 DEVICES_find(const devices_s *devices, u32 device_id);
+
+/*!************************************************************************
+ * \fn bool DEVICES_add(devices_s *devices, u32 device_id, u32 index)
+ * \brief Add an unknown device, doubling the table when it gets half
+ *        full. FALSE if the allocation failed, the table is unchanged.
+ **************************************************************************/
+bool DEVICES_add(devices_s *devices, u32 device_id, u32 index);
+
+/*!************************************************************************
+ * \fn void DEVICES_move(devices_s *devices, u32 device_id, u32 index)
+ * \brief Change the index of a known device, when its state is moved.
+ **************************************************************************/
+void DEVICES_move(devices_s *devices, u32 device_id, u32 index);
+
+/*!************************************************************************
+ * \fn u32 DEVICES_remove(devices_s *devices, u32 device_id)
+ * \brief Remove a device. To keep the states dense the caller moves
+ *        its last state to the index returned, see DEVICES_move.
+ *
+ * \retval                          Index of the device, DEVICES_NONE if unknown
+ **************************************************************************/
+u32 DEVICES_remove(devices_s *devices, u32 device_id);
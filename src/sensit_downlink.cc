@@ -0,0 +1,173 @@
+/*!******************************************************************
+ * \file sensit_downlink.c
+ * \brief Functions to answer downlink requests
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_downlink.h"
+
+/******* DEFINE ****************************************************/
+#define DOWNLINK_MIN_DEVICES 32
+
+/*******************************************************************/
+
+static downlink_device_s *DOWNLINK_add(downlink_store_s *store, u32 device_id)
+{
+    u32 index = DEVICES_find(&(store->ids), device_id);
+    void *devices;
+
+    if (index != DEVICES_NONE)
+    {
+        return &(store->devices[index]);
+    }
+    if (store->device_count == store->device_capacity)
+    {
+        devices = realloc(store->devices, (size_t)store->device_capacity * 2 * sizeof(downlink_device_s));
+        if (devices == NULL)
+        {
+            return NULL;
+        }
+        store->devices = (downlink_device_s *)devices;
+        store->device_capacity *= 2;
+    }
+
+    if (!DEVICES_add(&(store->ids), device_id, store->device_count))
+    {
+        return NULL;
+    }
+
+    store->device_count++;
+    memset(&(store->devices[store->device_count - 1]), 0, sizeof(downlink_device_s));
+    store->devices[store->device_count - 1].device_id = device_id;
+    return &(store->devices[store->device_count - 1]);
+}
+
+/*******************************************************************/
+
+static bool DOWNLINK_is_pending(const downlink_device_s *device)
+{
+    return (device->flags & DOWNLINK_FLAG_DESIRED) &&
+           (!(device->flags & DOWNLINK_FLAG_REPORTED) || device->desired != device->reported);
+}
+
+/*******************************************************************/
+
+downlink_store_s *DOWNLINK_create(void)
+{
+    downlink_store_s *store = (downlink_store_s *)calloc(1, sizeof(downlink_store_s));
+
+    if (store == NULL)
+    {
+        return NULL;
+    }
+    store->devices = (downlink_device_s *)malloc(DOWNLINK_MIN_DEVICES * sizeof(downlink_device_s));
+    store->device_capacity = DOWNLINK_MIN_DEVICES;
+    if (!DEVICES_init(&(store->ids)) || store->devices == NULL)
+    {
+        DOWNLINK_destroy(store);
+        return NULL;
+    }
+    return store;
+}
+
+/*******************************************************************/
+
+void DOWNLINK_destroy(downlink_store_s *store)
+{
+    if (store != NULL)
+    {
+        DEVICES_free(&(store->ids));
+        free(store->devices);
+        free(store);
+    }
+}
+
+/*******************************************************************/
+
+u8 DOWNLINK_set(downlink_store_s *store, u32 device_id, const u8 *config_in, u32 version)
+{
+    downlink_device_s *device = DOWNLINK_add(store, device_id);
+
+    if (device == NULL)
+    {
+        return DOWNLINK_ERR_ALLOC;
+    }
+    if ((device->flags & DOWNLINK_FLAG_DESIRED) && version < device->version)
+    {
+        return DOWNLINK_ERR_STALE;
+    }
+
+    store->pending -= DOWNLINK_is_pending(device);
+    memcpy(&(device->desired), config_in, PAYLOAD_CONFIG_SIZE);
+    device->version = version;
+    device->flags |= DOWNLINK_FLAG_DESIRED;
+    store->pending += DOWNLINK_is_pending(device);
+    return DOWNLINK_ERR_NONE;
+}
+
+/*******************************************************************/
+
+void DOWNLINK_clear(downlink_store_s *store, u32 device_id)
+{
+    u32 index = DEVICES_find(&(store->ids), device_id);
+    downlink_device_s *device;
+
+    if (index != DEVICES_NONE)
+    {
+        device = &(store->devices[index]);
+        store->pending -= DOWNLINK_is_pending(device);
+        device->flags &= ~DOWNLINK_FLAG_DESIRED;
+    }
+}
+
+/*******************************************************************/
+
+u8 DOWNLINK_report(downlink_store_s *store, u32 device_id, const u8 *uplink_in)
+{
+    downlink_device_s *device = DOWNLINK_add(store, device_id);
+
+    if (device == NULL)
+    {
+        return DOWNLINK_ERR_ALLOC;
+    }
+
+    store->pending -= DOWNLINK_is_pending(device);
+    memcpy(&(device->reported), uplink_in + PAYLOAD_DATA_SIZE, PAYLOAD_CONFIG_SIZE);
+    device->flags |= DOWNLINK_FLAG_REPORTED;
+    store->pending += DOWNLINK_is_pending(device);
+    return DOWNLINK_ERR_NONE;
+}
+
+/*******************************************************************/
+
+bool DOWNLINK_answer(const downlink_store_s *store, u32 device_id, u8 *config_out, u32 *version)
+{
+    u32 index = DEVICES_find(&(store->ids), device_id);
+    const downlink_device_s *device;
+
+    if (index == DEVICES_NONE)
+    {
+        return FALSE;
+    }
+    device = &(store->devices[index]);
+    if (!DOWNLINK_is_pending(device))
+    {
+        return FALSE;
+    }
+    memcpy(config_out, &(device->desired), PAYLOAD_CONFIG_SIZE);
+    *version = device->version;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+const downlink_device_s *DOWNLINK_get(const downlink_store_s *store, u32 device_id)
+{
+    u32 index = DEVICES_find(&(store->ids), device_id);
+
+    return (index == DEVICES_NONE) ? NULL : &(store->devices[index]);
+}
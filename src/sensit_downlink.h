@@ -0,0 +1,97 @@
+/*!******************************************************************
+ * \file sensit_downlink.h
+ * \brief Functions & Types to answer downlink requests
+ * \author Sens'it Team
+ *
+ * A Sigfox downlink answer is 8 bytes, the layout of a serialized
+ * config. The store keeps per device the desired config, serialized
+ * once when it is set, and the last config reported by the device in
+ * the 12 bytes uplinks. A downlink request is answered with a single
+ * hash lookup: the desired config when it differs from the reported
+ * one, nothing otherwise.
+ *******************************************************************/
+
+#define DOWNLINK_ERR_NONE 0x00
+#define DOWNLINK_ERR_ALLOC 0x01
+#define DOWNLINK_ERR_STALE 0x02
+
+#define DOWNLINK_FLAG_DESIRED 0x01
+#define DOWNLINK_FLAG_REPORTED 0x02
+
+/*!******************************************************************
+ * \struct downlink_device_s
+ * \brief Configs of a device, as raw PAYLOAD_CONFIG_SIZE bytes
+ *******************************************************************/
+typedef struct
+{
+    u64 desired;
+    u64 reported;
+    u32 device_id;
+    u32 version;   /*!< Version of desired */
+    u32 flags;     /*!< DOWNLINK_FLAG_* */
+    u32 spare;
+} downlink_device_s;
+
+/*!******************************************************************
+ * \struct downlink_store_s
+ * \brief Configs of every device
+ *******************************************************************/
+typedef struct
+{
+    devices_s ids;              /*!< Index in devices of each device id */
+    downlink_device_s *devices;
+    u32 device_count;
+    u32 device_capacity;
+    u32 pending;                /*!< Devices with a desired config different from the reported one */
+} downlink_store_s;
+
+/*!************************************************************************
+ * \fn downlink_store_s *DOWNLINK_create(void)
+ * \brief Allocate an empty store, NULL if the allocation failed.
+ **************************************************************************/
+downlink_store_s *DOWNLINK_create(void);
+
+/*!************************************************************************
+ * \fn void DOWNLINK_destroy(downlink_store_s *store)
+ **************************************************************************/
+void DOWNLINK_destroy(downlink_store_s *store);
+
+/*!************************************************************************
+ * \fn u8 DOWNLINK_set(downlink_store_s *store, u32 device_id, const u8 *config_in, u32 version)
+ * \brief Set the desired config of a device, ignored if older than the
+ *        version already set.
+ *
+ * \param[in] config_in             Serialized config of PAYLOAD_CONFIG_SIZE bytes
+ * \retval                          DOWNLINK_ERR_NONE, DOWNLINK_ERR_ALLOC or DOWNLINK_ERR_STALE
+ **************************************************************************/
+u8 DOWNLINK_set(downlink_store_s *store, u32 device_id, const u8 *config_in, u32 version);
+
+/*!************************************************************************
+ * \fn void DOWNLINK_clear(downlink_store_s *store, u32 device_id)
+ * \brief Forget the desired config of a device, the reported one is kept.
+ **************************************************************************/
+void DOWNLINK_clear(downlink_store_s *store, u32 device_id);
+
+/*!************************************************************************
+ * \fn u8 DOWNLINK_report(downlink_store_s *store, u32 device_id, const u8 *uplink_in)
+ * \brief Record the config of a 12 bytes uplink.
+ *
+ * \param[in] uplink_in             "data" then "config" payloads, PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE bytes
+ * \retval                          DOWNLINK_ERR_NONE or DOWNLINK_ERR_ALLOC
+ **************************************************************************/
+u8 DOWNLINK_report(downlink_store_s *store, u32 device_id, const u8 *uplink_in);
+
+/*!************************************************************************
+ * \fn bool DOWNLINK_answer(const downlink_store_s *store, u32 device_id, u8 *config_out, u32 *version)
+ * \brief Downlink to send to a device: TRUE with its desired config if
+ *        it has not reported it, FALSE if there is nothing to send.
+ *
+ * \param[out] config_out           PAYLOAD_CONFIG_SIZE bytes
+ **************************************************************************/
+bool DOWNLINK_answer(const downlink_store_s *store, u32 device_id, u8 *config_out, u32 *version);
+
+/*!************************************************************************
+ * \fn const downlink_device_s *DOWNLINK_get(const downlink_store_s *store, u32 device_id)
+ * \brief Configs of a device, NULL if unknown.
+ **************************************************************************/
+const downlink_device_s *DOWNLINK_get(const downlink_store_s *store, u32 device_id);
@@ -0,0 +1,203 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_downlink.h"
+#include "sensit_payload_node.h"
+
+class DownlinkStore : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit DownlinkStore(downlink_store_s *store) : store_(store) {}
+  ~DownlinkStore() { DOWNLINK_destroy(store_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Set(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Clear(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Report(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Answer(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Get(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  downlink_store_s *store_;
+};
+
+void DownlinkStore::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "DownlinkStore"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "set", Set);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "clear", Clear);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "report", Report);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "answer", Answer);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get", Get);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "DownlinkStore"), tpl->GetFunction());
+}
+
+void DownlinkStore::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  downlink_store_s *store = DOWNLINK_create();
+  if (store == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the downlink store")));
+    return;
+  }
+
+  DownlinkStore *obj = new DownlinkStore(store);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void DownlinkStore::Set(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  // args: Buffer configs, Uint32Array device ids, Uint32Array versions
+  const u8 *configs = (const u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+  const u32 *versions = (const u32 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_CONFIG_SIZE;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+
+  u32 stale = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    u8 err = DOWNLINK_set(obj->store_, device_ids[i], configs + (i * PAYLOAD_CONFIG_SIZE), versions[i]);
+    if (err == DOWNLINK_ERR_ALLOC)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the downlink store")));
+      return;
+    }
+    stale += (err == DOWNLINK_ERR_STALE);
+  }
+  args.GetReturnValue().Set(stale);
+}
+
+void DownlinkStore::Clear(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  // args: Uint32Array device ids
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[0]);
+  size_t count = node::Buffer::Length(args[0]) / sizeof(u32);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    DOWNLINK_clear(obj->store_, device_ids[i]);
+  }
+}
+
+void DownlinkStore::Report(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  // args: Buffer 12 bytes uplinks, Uint32Array device ids
+  const u8 *uplinks = (const u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+
+  size_t count = node::Buffer::Length(args[0]) / (PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE);
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (DOWNLINK_report(obj->store_, device_ids[i], uplinks + (i * (PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE))) != DOWNLINK_ERR_NONE)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the downlink store")));
+      return;
+    }
+  }
+}
+
+void DownlinkStore::Answer(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  // args: device id, Buffer 12 bytes uplink of the request or undefined, Buffer of 8 bytes written with the downlink
+  u32 device_id = args[0]->Uint32Value();
+  if (node::Buffer::HasInstance(args[1]) &&
+      DOWNLINK_report(obj->store_, device_id, (const u8 *)node::Buffer::Data(args[1])) != DOWNLINK_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the downlink store")));
+    return;
+  }
+
+  // Version of the downlink written, -1 if there is nothing to send
+  u32 version;
+  if (DOWNLINK_answer(obj->store_, device_id, (u8 *)node::Buffer::Data(args[2]), &version))
+  {
+    args.GetReturnValue().Set(v8::Number::New(isolate, version));
+  }
+  else
+  {
+    args.GetReturnValue().Set(-1);
+  }
+}
+
+void DownlinkStore::Get(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  const downlink_device_s *device = DOWNLINK_get(obj->store_, args[0]->Uint32Value());
+  if (device == NULL)
+  {
+    return;
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  if (device->flags & DOWNLINK_FLAG_DESIRED)
+  {
+    res->Set(v8::String::NewFromUtf8(isolate, "desired"),
+             node::Buffer::Copy(isolate, (const char *)&(device->desired), PAYLOAD_CONFIG_SIZE).ToLocalChecked());
+    res->Set(v8::String::NewFromUtf8(isolate, "version"), v8::Number::New(isolate, device->version));
+  }
+  if (device->flags & DOWNLINK_FLAG_REPORTED)
+  {
+    res->Set(v8::String::NewFromUtf8(isolate, "reported"),
+             node::Buffer::Copy(isolate, (const char *)&(device->reported), PAYLOAD_CONFIG_SIZE).ToLocalChecked());
+  }
+  args.GetReturnValue().Set(res);
+}
+
+void DownlinkStore::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  DownlinkStore *obj = node::ObjectWrap::Unwrap<DownlinkStore>(args.Holder());
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Number::New(isolate, obj->store_->device_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "pending"), v8::Number::New(isolate, obj->store_->pending));
+  args.GetReturnValue().Set(res);
+}
+
+void DOWNLINK_node_init(v8::Local<v8::Object> exports)
+{
+  DownlinkStore::Init(exports);
+}
@@ -0,0 +1,316 @@
+/*!******************************************************************
+ * \file sensit_downsample.c
+ * \brief Functions to downsample series for charts
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_series.h"
+#include "sensit_downsample.h"
+
+/******* DEFINE ****************************************************/
+#define DOWNSAMPLE_BUCKET(state, time) ((u32)((((u64)((time) - (state)->from)) * (state)->buckets) / (state)->span))
+
+/*!******************************************************************
+ * \struct downsample_state_s
+ * \brief Bucket being folded & points written so far
+ *******************************************************************/
+typedef struct
+{
+    u32 from;
+    u32 to;
+    u64 span;      /*!< to - from + 1 */
+    u32 buckets;
+    u32 index;     /*!< Bucket being folded */
+    u32 samples;   /*!< Samples folded in the bucket, 0 if empty */
+    s32 min;
+    s32 max;
+    u32 min_time;
+    u32 max_time;
+    u32 *times_out;
+    s32 *values_out;
+    u32 count;
+} downsample_state_s;
+
+/*******************************************************************/
+
+static bool DOWNSAMPLE_range(const series_s *series, u32 *from, u32 *to)
+{
+    u32 first_time;
+    u32 last_time;
+
+    if (series->sample_count == 0)
+    {
+        return FALSE;
+    }
+    first_time = (series->block_count > 0) ? series->blocks[0].first_time : series->pending_times[0];
+    last_time = (series->pending_count > 0) ? series->pending_times[series->pending_count - 1]
+                                            : series->blocks[series->block_count - 1].last_time;
+    *from = (*from > first_time) ? *from : first_time;
+    *to = (*to < last_time) ? *to : last_time;
+    return *from <= *to;
+}
+
+/*******************************************************************/
+
+static void DOWNSAMPLE_emit(downsample_state_s *state)
+{
+    if (state->samples == 0)
+    {
+        return;
+    }
+    if (state->min_time == state->max_time)
+    {
+        state->times_out[state->count] = state->min_time;
+        state->values_out[state->count++] = state->min;
+    }
+    else if (state->min_time < state->max_time)
+    {
+        state->times_out[state->count] = state->min_time;
+        state->values_out[state->count++] = state->min;
+        state->times_out[state->count] = state->max_time;
+        state->values_out[state->count++] = state->max;
+    }
+    else
+    {
+        state->times_out[state->count] = state->max_time;
+        state->values_out[state->count++] = state->max;
+        state->times_out[state->count] = state->min_time;
+        state->values_out[state->count++] = state->min;
+    }
+    state->samples = 0;
+}
+
+/*******************************************************************/
+
+static void DOWNSAMPLE_merge(downsample_state_s *state, u32 index, s32 min, u32 min_time, s32 max, u32 max_time, u32 samples)
+{
+    if (index != state->index)
+    {
+        DOWNSAMPLE_emit(state);
+        state->index = index;
+    }
+    /* Samples come in time order, the first of equal extrema is kept */
+    if (state->samples == 0 || min < state->min)
+    {
+        state->min = min;
+        state->min_time = min_time;
+    }
+    if (state->samples == 0 || max > state->max)
+    {
+        state->max = max;
+        state->max_time = max_time;
+    }
+    state->samples += samples;
+}
+
+/*******************************************************************/
+
+static void DOWNSAMPLE_fold(downsample_state_s *state, const u32 *times, const s32 *values, u32 count)
+{
+    u32 min_index;
+    u32 max_index;
+    u32 index;
+    u32 i = 0;
+    u32 j;
+    u32 k;
+
+    while (i < count && times[i] < state->from)
+    {
+        i++;
+    }
+    while (i < count && times[i] <= state->to)
+    {
+        index = DOWNSAMPLE_BUCKET(state, times[i]);
+        for (j = i + 1; j < count && times[j] <= state->to && DOWNSAMPLE_BUCKET(state, times[j]) == index; j++)
+        {
+        }
+
+        /* Strict comparisons keep the first sample of the lowest & highest values of the run */
+        min_index = i;
+        max_index = i;
+        for (k = i + 1; k < j; k++)
+        {
+            min_index = (values[k] < values[min_index]) ? k : min_index;
+            max_index = (values[k] > values[max_index]) ? k : max_index;
+        }
+        DOWNSAMPLE_merge(state, index, values[min_index], times[min_index], values[max_index], times[max_index], j - i);
+        i = j;
+    }
+}
+
+/*******************************************************************/
+
+u32 DOWNSAMPLE_min_max(const series_s *series, u32 from, u32 to, u32 buckets, u32 *times_out, s32 *values_out)
+{
+    u32 block_times[SERIES_BLOCK_SIZE];
+    s32 block_values[SERIES_BLOCK_SIZE];
+    const series_block_s *summary;
+    downsample_state_s state;
+    u32 index;
+    u32 block;
+    u32 count;
+
+    if (buckets == 0 || !DOWNSAMPLE_range(series, &from, &to))
+    {
+        return 0;
+    }
+    memset(&state, 0, sizeof(downsample_state_s));
+    state.from = from;
+    state.to = to;
+    state.span = (u64)to - from + 1;
+    state.buckets = buckets;
+    state.times_out = times_out;
+    state.values_out = values_out;
+
+    for (block = SERIES_seek(series, from); block < series->block_count && series->blocks[block].first_time <= to; block++)
+    {
+        summary = &(series->blocks[block]);
+        index = DOWNSAMPLE_BUCKET(&state, summary->first_time);
+        if (summary->first_time >= from && summary->last_time <= to &&
+            DOWNSAMPLE_BUCKET(&state, summary->last_time) == index)
+        {
+            DOWNSAMPLE_merge(&state, index, summary->min, summary->min_time, summary->max, summary->max_time, summary->count);
+        }
+        else
+        {
+            count = SERIES_decode_block(series, block, block_times, block_values);
+            DOWNSAMPLE_fold(&state, block_times, block_values, count);
+        }
+    }
+    DOWNSAMPLE_fold(&state, series->pending_times, series->pending_values, series->pending_count);
+    DOWNSAMPLE_emit(&state);
+    return state.count;
+}
+
+/*******************************************************************/
+
+u32 DOWNSAMPLE_lttb(const u32 *times, const s32 *values, u32 count, u32 threshold, u32 *times_out, s32 *values_out)
+{
+    double every;
+    double average_time;
+    double average_value;
+    double area;
+    double max_area;
+    u32 selected = 0;
+    u32 next = 0;
+    u32 start;
+    u32 end;
+    u32 i;
+    u32 j;
+
+    if (count <= threshold)
+    {
+        memcpy(times_out, times, count * sizeof(u32));
+        memcpy(values_out, values, count * sizeof(s32));
+        return count;
+    }
+    if (threshold < 3)
+    {
+        for (i = 0; i < threshold; i++)
+        {
+            times_out[i] = times[i == 0 ? 0 : count - 1];
+            values_out[i] = values[i == 0 ? 0 : count - 1];
+        }
+        return threshold;
+    }
+
+    /* First & last samples are kept, the others split in threshold - 2 buckets */
+    every = (double)(count - 2) / (threshold - 2);
+    times_out[0] = times[0];
+    values_out[0] = values[0];
+    for (i = 0; i < threshold - 2; i++)
+    {
+        /* Average of the next bucket, the last sample for the last bucket */
+        start = (u32)floor((i + 1) * every) + 1;
+        end = (u32)floor((i + 2) * every) + 1;
+        end = (end < count) ? end : count;
+        average_time = 0;
+        average_value = 0;
+        for (j = start; j < end; j++)
+        {
+            average_time += (double)(times[j] - times[0]);
+            average_value += values[j];
+        }
+        average_time /= (end - start);
+        average_value /= (end - start);
+
+        /* Sample of the bucket with the largest triangle with the previous point & that average */
+        start = (u32)floor(i * every) + 1;
+        end = (u32)floor((i + 1) * every) + 1;
+        max_area = -1;
+        for (j = start; j < end; j++)
+        {
+            area = fabs((((double)(times[selected] - times[0]) - average_time) * ((double)values[j] - values[selected])) -
+                        (((double)(times[selected] - times[0]) - (double)(times[j] - times[0])) * (average_value - values[selected])));
+            if (area > max_area)
+            {
+                max_area = area;
+                next = j;
+            }
+        }
+        selected = next;
+        times_out[i + 1] = times[selected];
+        values_out[i + 1] = values[selected];
+    }
+    times_out[threshold - 1] = times[count - 1];
+    values_out[threshold - 1] = values[count - 1];
+    return threshold;
+}
+
+/*******************************************************************/
+
+u8 DOWNSAMPLE_series_lttb(const series_s *series, u32 from, u32 to, u32 threshold, u32 *times_out, s32 *values_out, u32 *count_out)
+{
+    u32 *times;
+    s32 *values;
+    u64 samples;
+    u32 block;
+    u32 count;
+
+    *count_out = 0;
+    if (threshold == 0 || !DOWNSAMPLE_range(series, &from, &to))
+    {
+        return DOWNSAMPLE_ERR_NONE;
+    }
+
+    /* Upper bound of the samples of the range from the block index */
+    samples = series->pending_count;
+    for (block = SERIES_seek(series, from); block < series->block_count && series->blocks[block].first_time <= to; block++)
+    {
+        samples += series->blocks[block].count;
+    }
+    if (samples == 0)
+    {
+        return DOWNSAMPLE_ERR_NONE;
+    }
+    if (samples > (u64)threshold * DOWNSAMPLE_LTTB_PRESELECT)
+    {
+        samples = (u64)threshold * DOWNSAMPLE_LTTB_PRESELECT;
+    }
+
+    times = (u32 *)malloc(samples * sizeof(u32));
+    values = (s32 *)malloc(samples * sizeof(s32));
+    if (times == NULL || values == NULL)
+    {
+        free(times);
+        free(values);
+        return DOWNSAMPLE_ERR_ALLOC;
+    }
+    if (samples < (u64)threshold * DOWNSAMPLE_LTTB_PRESELECT)
+    {
+        count = SERIES_read(series, from, to, times, values, (u32)samples);
+    }
+    else
+    {
+        count = DOWNSAMPLE_min_max(series, from, to, (threshold * DOWNSAMPLE_LTTB_PRESELECT) / 2, times, values);
+    }
+    *count_out = DOWNSAMPLE_lttb(times, values, count, threshold, times_out, values_out);
+
+    free(times);
+    free(values);
+    return DOWNSAMPLE_ERR_NONE;
+}
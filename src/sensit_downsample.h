@@ -0,0 +1,58 @@
+/*!******************************************************************
+ * \file sensit_downsample.h
+ * \brief Functions to downsample series for charts
+ * \author Sens'it Team
+ *
+ * Reduce a time range of a series to about the number of points a chart
+ * can draw:
+ *  - min/max: the lowest & highest sample of each time bucket, the
+ *    extrema are never lost. Blocks within a single bucket are merged
+ *    from their summary in the block index, only the blocks across a
+ *    bucket boundary are decoded, so the cost depends on the number of
+ *    buckets, not on the number of samples of the range.
+ *  - Largest-Triangle-Three-Buckets: the sample of each bucket forming
+ *    the largest triangle with its neighbours, the visual shape is kept.
+ *    Long ranges first preselect DOWNSAMPLE_LTTB_PRESELECT points per
+ *    bucket with min/max (MinMaxLTTB), short ones are read as is.
+ * Values keep the stored unit of the series.
+ *******************************************************************/
+
+#define DOWNSAMPLE_ERR_NONE 0x00
+#define DOWNSAMPLE_ERR_ALLOC 0x01
+
+#define DOWNSAMPLE_LTTB_PRESELECT 4
+
+/*!************************************************************************
+ * \fn u32 DOWNSAMPLE_min_max(const series_s *series, u32 from, u32 to, u32 buckets, u32 *times_out, s32 *values_out)
+ * \brief Lowest & highest sample of each of buckets equal time buckets
+ *        between from and to (clamped to the samples of the series), in
+ *        time order. A bucket gives one point if both are the same sample.
+ *
+ * \param[out] times_out            At least 2 * buckets entries
+ * \param[out] values_out           At least 2 * buckets entries
+ * \retval                          Number of points
+ **************************************************************************/
+u32 DOWNSAMPLE_min_max(const series_s *series, u32 from, u32 to, u32 buckets, u32 *times_out, s32 *values_out);
+
+/*!************************************************************************
+ * \fn u32 DOWNSAMPLE_lttb(const u32 *times, const s32 *values, u32 count, u32 threshold, u32 *times_out, s32 *values_out)
+ * \brief Largest-Triangle-Three-Buckets of time sorted samples, the first
+ *        & last samples are kept. Samples are copied as is if there are
+ *        no more than threshold.
+ *
+ * \param[out] times_out            At least threshold entries
+ * \param[out] values_out           At least threshold entries
+ * \retval                          Number of points, min(count, threshold)
+ **************************************************************************/
+u32 DOWNSAMPLE_lttb(const u32 *times, const s32 *values, u32 count, u32 threshold, u32 *times_out, s32 *values_out);
+
+/*!************************************************************************
+ * \fn u8 DOWNSAMPLE_series_lttb(const series_s *series, u32 from, u32 to, u32 threshold, u32 *times_out, s32 *values_out, u32 *count_out)
+ * \brief Largest-Triangle-Three-Buckets of the samples with
+ *        from <= time <= to.
+ *
+ * \param[out] times_out            At least threshold entries
+ * \param[out] values_out           At least threshold entries
+ * \retval                          DOWNSAMPLE_ERR_NONE or DOWNSAMPLE_ERR_ALLOC
+ **************************************************************************/
+u8 DOWNSAMPLE_series_lttb(const series_s *series, u32 from, u32 to, u32 threshold, u32 *times_out, s32 *values_out, u32 *count_out);
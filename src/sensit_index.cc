@@ -0,0 +1,348 @@
+/*!******************************************************************
+ * \file sensit_index.c
+ * \brief Functions of the secondary indexes of stored payloads
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_bitmap.h"
+#include "sensit_index.h"
+
+/******* DEFINE ****************************************************/
+#define INDEX_MAGIC_0 0x53 /* "SX" */
+#define INDEX_MAGIC_1 0x58
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 4
+#define INDEX_BITMAP_HEADER_SIZE 2
+
+#define BATTERY_OFFSET 2700
+#define BATTERY_STEP 50
+
+/*******************************************************************/
+
+/*!******************************************************************
+ * \struct index_operand_s
+ * \brief Bitmap of the query stack, an indexed bitmap or a result
+ *******************************************************************/
+typedef struct
+{
+    const bitmap_s *bitmap; /*!< &owned for a result */
+    bitmap_s owned;
+} index_operand_s;
+
+/*******************************************************************/
+
+index_s *INDEX_create(void)
+{
+    /* All zero bitmaps are empty */
+    return (index_s *)calloc(1, sizeof(index_s));
+}
+
+/*******************************************************************/
+
+void INDEX_reset(index_s *index)
+{
+    u32 field;
+    u32 value;
+
+    for (field = 0; field < INDEX_FIELD_LAST; field++)
+    {
+        for (value = 0; value < INDEX_VALUES; value++)
+        {
+            BITMAP_clear(&(index->bitmaps[field][value]));
+        }
+    }
+    index->rows = 0;
+}
+
+/*******************************************************************/
+
+void INDEX_destroy(index_s *index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+    INDEX_reset(index);
+    free(index);
+}
+
+/*******************************************************************/
+
+static u8 INDEX_add(index_s *index, index_field_e field, u32 value, u32 row)
+{
+    if (value >= INDEX_VALUES)
+    {
+        return INDEX_ERR_NONE;
+    }
+    return BITMAP_add(&(index->bitmaps[field][value]), row) == BITMAP_ERR_NONE ? INDEX_ERR_NONE : INDEX_ERR_ALLOC;
+}
+
+/*******************************************************************/
+
+u8 INDEX_add_data(index_s *index, u32 row, const data_s *data)
+{
+    bool v2_button = (data->type == PAYLOAD_V2) && data->button;
+    u32 door = data->door;
+    u8 err = INDEX_ERR_NONE;
+
+    err |= INDEX_add(index, INDEX_FIELD_TYPE, data->type, row);
+    err |= INDEX_add(index, INDEX_FIELD_ERROR, data->error, row);
+    if (data->error == PARSE_ERR_NONE)
+    {
+        err |= INDEX_add(index, INDEX_FIELD_MODE, data->mode, row);
+        err |= INDEX_add(index, INDEX_FIELD_BUTTON, data->button ? 1 : 0, row);
+        err |= INDEX_add(index, INDEX_FIELD_BATTERY_LEVEL, (u32)(data->battery_level - BATTERY_OFFSET) / BATTERY_STEP, row);
+        /* Same door state as formatData() */
+        if (data->mode == MODE_DOOR && !v2_button)
+        {
+            if (door == DOOR_NONE && data->type == PAYLOAD_V3)
+            {
+                door = INDEX_DOOR_NOT_CALIBRATED;
+            }
+            err |= INDEX_add(index, INDEX_FIELD_DOOR, door, row);
+        }
+    }
+    if (row >= index->rows)
+    {
+        index->rows = row + 1;
+    }
+    return err;
+}
+
+/*******************************************************************/
+
+static void INDEX_release(index_operand_s *operand)
+{
+    BITMAP_clear(&(operand->owned));
+    operand->bitmap = NULL;
+}
+
+/*******************************************************************/
+
+u8 INDEX_query(const index_s *index, const u32 *program, u32 length, bitmap_s *rows_out)
+{
+    index_operand_s stack[INDEX_MAX_DEPTH];
+    index_operand_s *a;
+    index_operand_s *b;
+    bitmap_s result;
+    u32 depth = 0;
+    u32 op;
+    u32 field;
+    u32 i;
+    u8 err = INDEX_ERR_NONE;
+
+    BITMAP_clear(rows_out);
+    BITMAP_init(&result);
+    for (i = 0; i < length && err == INDEX_ERR_NONE; i++)
+    {
+        op = program[i] >> 16;
+        field = (program[i] >> 8) & 0xFF;
+        if (op == INDEX_OP_LEAF)
+        {
+            if (field >= INDEX_FIELD_LAST || depth == INDEX_MAX_DEPTH)
+            {
+                err = INDEX_ERR_QUERY;
+                break;
+            }
+            BITMAP_init(&(stack[depth].owned));
+            stack[depth++].bitmap = &(index->bitmaps[field][program[i] & 0xFF]);
+            continue;
+        }
+        if (op > INDEX_OP_ANDNOT || depth < 2)
+        {
+            err = INDEX_ERR_QUERY;
+            break;
+        }
+
+        a = stack + depth - 2;
+        b = stack + depth - 1;
+        if (op == INDEX_OP_AND)
+        {
+            err = BITMAP_and(a->bitmap, b->bitmap, &result);
+        }
+        else if (op == INDEX_OP_OR)
+        {
+            err = BITMAP_or(a->bitmap, b->bitmap, &result);
+        }
+        else
+        {
+            err = BITMAP_andnot(a->bitmap, b->bitmap, &result);
+        }
+        err = (err == BITMAP_ERR_NONE) ? INDEX_ERR_NONE : INDEX_ERR_ALLOC;
+
+        /* The result takes the place of a */
+        INDEX_release(a);
+        INDEX_release(b);
+        depth--;
+        a->owned = result;
+        a->bitmap = &(a->owned);
+        BITMAP_init(&result);
+    }
+
+    if (err == INDEX_ERR_NONE && depth != 1)
+    {
+        err = INDEX_ERR_QUERY;
+    }
+    if (err == INDEX_ERR_NONE)
+    {
+        if (stack[0].bitmap == &(stack[0].owned))
+        {
+            *rows_out = stack[0].owned;
+            BITMAP_init(&(stack[0].owned));
+        }
+        else if (BITMAP_copy(stack[0].bitmap, rows_out) != BITMAP_ERR_NONE)
+        {
+            err = INDEX_ERR_ALLOC;
+        }
+    }
+    for (i = 0; i < depth; i++)
+    {
+        INDEX_release(stack + i);
+    }
+    return err;
+}
+
+/*******************************************************************/
+
+static u32 INDEX_read_u32(const u8 *in)
+{
+    return (u32)in[0] | ((u32)in[1] << 8) | ((u32)in[2] << 16) | ((u32)in[3] << 24);
+}
+
+/*******************************************************************/
+
+static u32 INDEX_max_row(const bitmap_s *bitmap)
+{
+    const bitmap_container_s *container = bitmap->containers + bitmap->count - 1;
+    u32 high = (u32)container->key << 16;
+    s32 i;
+
+    if (container->words == NULL)
+    {
+        return high | container->values[container->cardinality - 1];
+    }
+    for (i = BITMAP_WORDS - 1; container->words[i] == 0; i--)
+    {
+    }
+    return high | ((u32)i << 6) | (63 - __builtin_clzll(container->words[i]));
+}
+
+/*******************************************************************/
+
+u8 INDEX_serialize(const index_s *index, u8 **buffer_out, u32 *size_out)
+{
+    const bitmap_s *bitmap;
+    u64 size = INDEX_HEADER_SIZE + 2 * sizeof(u32);
+    u32 bitmaps = 0;
+    u32 field;
+    u32 value;
+    u8 *buffer;
+    u8 *out;
+    u32 i;
+
+    for (field = 0; field < INDEX_FIELD_LAST; field++)
+    {
+        for (value = 0; value < INDEX_VALUES; value++)
+        {
+            bitmap = &(index->bitmaps[field][value]);
+            if (bitmap->count != 0)
+            {
+                size += INDEX_BITMAP_HEADER_SIZE + BITMAP_serialized_size(bitmap);
+                bitmaps++;
+            }
+        }
+    }
+    if (size > 0xFFFFFFFF)
+    {
+        return INDEX_ERR_ALLOC;
+    }
+    buffer = (u8 *)malloc((size_t)size);
+    if (buffer == NULL)
+    {
+        return INDEX_ERR_ALLOC;
+    }
+
+    out = buffer;
+    *out++ = INDEX_MAGIC_0;
+    *out++ = INDEX_MAGIC_1;
+    *out++ = INDEX_VERSION;
+    *out++ = 0;
+    for (i = 0; i < 4; i++)
+    {
+        *out++ = (u8)(index->rows >> (i * 8));
+    }
+    for (i = 0; i < 4; i++)
+    {
+        *out++ = (u8)(bitmaps >> (i * 8));
+    }
+    for (field = 0; field < INDEX_FIELD_LAST; field++)
+    {
+        for (value = 0; value < INDEX_VALUES; value++)
+        {
+            bitmap = &(index->bitmaps[field][value]);
+            if (bitmap->count != 0)
+            {
+                *out++ = (u8)field;
+                *out++ = (u8)value;
+                out = BITMAP_write(bitmap, out);
+            }
+        }
+    }
+
+    *buffer_out = buffer;
+    *size_out = (u32)size;
+    return INDEX_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 INDEX_deserialize(const u8 *buffer_in, u32 size, index_s *index_out)
+{
+    const u8 *in = buffer_in;
+    const u8 *end = buffer_in + size;
+    bitmap_s *bitmap;
+    u32 bitmaps;
+    u32 previous = 0;
+    u32 key;
+    u32 i;
+
+    INDEX_reset(index_out);
+    if (size < INDEX_HEADER_SIZE + 2 * sizeof(u32) || in[0] != INDEX_MAGIC_0 || in[1] != INDEX_MAGIC_1 || in[2] != INDEX_VERSION)
+    {
+        return INDEX_ERR_FORMAT;
+    }
+    index_out->rows = INDEX_read_u32(in + INDEX_HEADER_SIZE);
+    bitmaps = INDEX_read_u32(in + INDEX_HEADER_SIZE + sizeof(u32));
+    in += INDEX_HEADER_SIZE + 2 * sizeof(u32);
+
+    for (i = 0; i < bitmaps; i++)
+    {
+        if (end - in < INDEX_BITMAP_HEADER_SIZE || in[0] >= INDEX_FIELD_LAST)
+        {
+            break;
+        }
+        /* Bitmaps are sorted by (field, value), each one at most once */
+        key = ((u32)in[0] << 8) | in[1];
+        if (i != 0 && key <= previous)
+        {
+            break;
+        }
+        previous = key;
+        bitmap = &(index_out->bitmaps[in[0]][in[1]]);
+        in += INDEX_BITMAP_HEADER_SIZE;
+        if (!BITMAP_read(&in, end, bitmap) || bitmap->count == 0 || INDEX_max_row(bitmap) >= index_out->rows)
+        {
+            break;
+        }
+    }
+
+    if (i != bitmaps || in != end)
+    {
+        INDEX_reset(index_out);
+        return INDEX_ERR_FORMAT;
+    }
+    return INDEX_ERR_NONE;
+}
@@ -0,0 +1,112 @@
+/*!******************************************************************
+ * \file sensit_index.h
+ * \brief Functions & Types of the secondary indexes of stored payloads
+ * \author Sens'it Team
+ *
+ * Payloads stored one after the other are identified by their row id,
+ * their position in the store. While a batch is decoded, each row id
+ * is added to a bitmap per value of the mode, button, payload type,
+ * door state, parsing error and battery level of its payload. A query
+ * combines these bitmaps with AND, OR & ANDNOT into the row ids to
+ * decode, e.g. the button presses of the DOOR_OPEN payloads, instead
+ * of decoding every stored payload.
+ *******************************************************************/
+
+#define INDEX_ERR_NONE 0x00
+#define INDEX_ERR_ALLOC 0x01
+#define INDEX_ERR_FORMAT 0x02
+#define INDEX_ERR_QUERY 0x03
+
+#define INDEX_VALUES 256    /* Bitmaps per field, one per value of a byte */
+#define INDEX_MAX_DEPTH 64  /* Operands pending in a query */
+
+#define INDEX_DOOR_NOT_CALIBRATED 0x04 /* DOOR_NONE of a v3 payload, as formatData() */
+
+#define INDEX_OP_LEAF 0x00   /* Push the bitmap of (field, value) */
+#define INDEX_OP_AND 0x01    /* Pop b then a, push a AND b */
+#define INDEX_OP_OR 0x02
+#define INDEX_OP_ANDNOT 0x03
+#define INDEX_INSTRUCTION(op, field, value) (((u32)(op) << 16) | ((u32)(field) << 8) | (u32)(value))
+
+/*!******************************************************************
+ * \enum index_field_e
+ * \brief Fields of data_s indexed. Every payload is indexed by type &
+ *        error, the ones without parsing error by mode, button and
+ *        battery level too, the ones of mode DOOR by door state.
+ *******************************************************************/
+typedef enum {
+    INDEX_FIELD_MODE,
+    INDEX_FIELD_BUTTON,
+    INDEX_FIELD_TYPE,
+    INDEX_FIELD_DOOR,          /*!< door_e, or INDEX_DOOR_NOT_CALIBRATED */
+    INDEX_FIELD_ERROR,
+    INDEX_FIELD_BATTERY_LEVEL, /*!< 50 mV steps from 2700 mV, the raw value of the payload */
+    INDEX_FIELD_LAST
+} index_field_e;
+
+/*!******************************************************************
+ * \struct index_s
+ * \brief Bitmaps of row ids of every value of every field
+ *******************************************************************/
+typedef struct
+{
+    bitmap_s bitmaps[INDEX_FIELD_LAST][INDEX_VALUES];
+    u32 rows; /*!< Next row id, rows below have been added */
+} index_s;
+
+/*!************************************************************************
+ * \fn index_s *INDEX_create(void)
+ * \brief Allocate an empty index, NULL if the allocation failed.
+ **************************************************************************/
+index_s *INDEX_create(void);
+
+/*!************************************************************************
+ * \fn void INDEX_destroy(index_s *index)
+ **************************************************************************/
+void INDEX_destroy(index_s *index);
+
+/*!************************************************************************
+ * \fn void INDEX_reset(index_s *index)
+ * \brief Remove every row.
+ **************************************************************************/
+void INDEX_reset(index_s *index);
+
+/*!************************************************************************
+ * \fn u8 INDEX_add_data(index_s *index, u32 row, const data_s *data)
+ * \brief Add the row id of a decoded payload to the bitmaps of its
+ *        values. Adding row ids in increasing order is the fastest.
+ *
+ * \retval                          INDEX_ERR_NONE or INDEX_ERR_ALLOC
+ **************************************************************************/
+u8 INDEX_add_data(index_s *index, u32 row, const data_s *data);
+
+/*!************************************************************************
+ * \fn u8 INDEX_query(const index_s *index, const u32 *program, u32 length, bitmap_s *rows_out)
+ * \brief Evaluate a query in postfix order, e.g. door open and button
+ *        pressed is LEAF(DOOR, DOOR_OPEN), LEAF(BUTTON, 1), AND.
+ *
+ * \param[in] program               length INDEX_INSTRUCTION()
+ * \param[out] rows_out             Cleared first, row ids selected
+ * \retval                          INDEX_ERR_NONE, INDEX_ERR_ALLOC or INDEX_ERR_QUERY if
+ *                                  the program does not leave a single bitmap
+ **************************************************************************/
+u8 INDEX_query(const index_s *index, const u32 *program, u32 length, bitmap_s *rows_out);
+
+/*!************************************************************************
+ * \fn u8 INDEX_serialize(const index_s *index, u8 **buffer_out, u32 *size_out)
+ * \brief Encode an index: a 4 bytes header, the number of rows, then
+ *        the field, value and BITMAP_write() of each non-empty bitmap.
+ *
+ * \param[out] buffer_out           Buffer allocated with malloc
+ * \retval                          INDEX_ERR_NONE or INDEX_ERR_ALLOC
+ **************************************************************************/
+u8 INDEX_serialize(const index_s *index, u8 **buffer_out, u32 *size_out);
+
+/*!************************************************************************
+ * \fn u8 INDEX_deserialize(const u8 *buffer_in, u32 size, index_s *index_out)
+ * \brief Decode a buffer of INDEX_serialize into an index, which is
+ *        reset first and left empty if the buffer is not valid.
+ *
+ * \retval                          INDEX_ERR_NONE or INDEX_ERR_FORMAT
+ **************************************************************************/
+u8 INDEX_deserialize(const u8 *buffer_in, u32 size, index_s *index_out);
@@ -0,0 +1,237 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_bitmap.h"
+#include "sensit_index.h"
+#include "sensit_payload_node.h"
+
+class PayloadIndex : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit PayloadIndex(index_s *index) : index_(index) {}
+  ~PayloadIndex() { INDEX_destroy(index_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Add(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Query(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Count(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Serialize(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Load(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Reset(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  static bool Evaluate(v8::Isolate *isolate, const index_s *index, v8::Local<v8::Value> program, bitmap_s *rows_out);
+
+  index_s *index_;
+};
+
+void PayloadIndex::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "PayloadIndex"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "add", Add);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "query", Query);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "count", Count);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "serialize", Serialize);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "load", Load);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "reset", Reset);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "PayloadIndex"), tpl->GetFunction());
+}
+
+void PayloadIndex::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  index_s *index = INDEX_create();
+  if (index == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the index")));
+    return;
+  }
+
+  PayloadIndex *obj = new PayloadIndex(index);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void PayloadIndex::Add(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  // args: Buffer payloads, indexed as the next rows
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+  u32 first = obj->index_->rows;
+  if (count > 0xFFFFFFFF - first)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Too many rows in the index")));
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    data_s decoded_payload = {};
+    PAYLOAD_parse_data(payloads + (i * PAYLOAD_DATA_SIZE), &decoded_payload);
+    if (INDEX_add_data(obj->index_, first + (u32)i, &decoded_payload) != INDEX_ERR_NONE)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the index")));
+      return;
+    }
+  }
+  // Row id of the first payload
+  args.GetReturnValue().Set(first);
+}
+
+bool PayloadIndex::Evaluate(v8::Isolate *isolate, const index_s *index, v8::Local<v8::Value> program, bitmap_s *rows_out)
+{
+  // Uint32Array of INDEX_INSTRUCTION()
+  const u32 *instructions = (const u32 *)node::Buffer::Data(program);
+  u32 length = (u32)(node::Buffer::Length(program) / sizeof(u32));
+
+  u8 err = INDEX_query(index, instructions, length, rows_out);
+  if (err == INDEX_ERR_QUERY)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Invalid index query")));
+    return false;
+  }
+  if (err != INDEX_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Out of memory")));
+    return false;
+  }
+  return true;
+}
+
+void PayloadIndex::Query(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  // args: Uint32Array program
+  bitmap_s rows;
+  BITMAP_init(&rows);
+  if (!Evaluate(isolate, obj->index_, args[0], &rows))
+  {
+    return;
+  }
+
+  size_t count = (size_t)BITMAP_cardinality(&rows);
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, count * sizeof(u32));
+  BITMAP_to_array(&rows, (u32 *)buffer->GetContents().Data());
+  BITMAP_clear(&rows);
+  args.GetReturnValue().Set(v8::Uint32Array::New(buffer, 0, count));
+}
+
+void PayloadIndex::Count(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  // args: Uint32Array program
+  bitmap_s rows;
+  BITMAP_init(&rows);
+  if (!Evaluate(isolate, obj->index_, args[0], &rows))
+  {
+    return;
+  }
+  args.GetReturnValue().Set(v8::Number::New(isolate, (double)BITMAP_cardinality(&rows)));
+  BITMAP_clear(&rows);
+}
+
+void PayloadIndex::Serialize(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  u8 *serialized = NULL;
+  u32 size = 0;
+  if (INDEX_serialize(obj->index_, &serialized, &size) != INDEX_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to serialize the index")));
+    return;
+  }
+
+  // The Buffer takes ownership of the malloc'ed index, no copy
+  v8::MaybeLocal<v8::Object> buffer = node::Buffer::New(isolate, (char *)serialized, size);
+  v8::Local<v8::Object> out;
+  if (buffer.ToLocal(&out))
+  {
+    args.GetReturnValue().Set(out);
+  }
+}
+
+void PayloadIndex::Load(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  // args: Buffer of a serialized index, replaces the rows of this one
+  index_s *loaded = INDEX_create();
+  if (loaded == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the index")));
+    return;
+  }
+  if (INDEX_deserialize((const u8 *)node::Buffer::Data(args[0]), node::Buffer::Length(args[0]), loaded) != INDEX_ERR_NONE)
+  {
+    INDEX_destroy(loaded);
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Invalid serialized index")));
+    return;
+  }
+  INDEX_destroy(obj->index_);
+  obj->index_ = loaded;
+}
+
+void PayloadIndex::Reset(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  INDEX_reset(obj->index_);
+}
+
+void PayloadIndex::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  PayloadIndex *obj = node::ObjectWrap::Unwrap<PayloadIndex>(args.Holder());
+
+  u32 bitmaps = 0;
+  u32 containers = 0;
+  double bytes = 0;
+  for (u32 field = 0; field < INDEX_FIELD_LAST; field++)
+  {
+    for (u32 value = 0; value < INDEX_VALUES; value++)
+    {
+      const bitmap_s *bitmap = &(obj->index_->bitmaps[field][value]);
+      if (bitmap->count != 0)
+      {
+        bitmaps++;
+        containers += bitmap->count;
+        bytes += (double)BITMAP_size(bitmap);
+      }
+    }
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "rows"), v8::Number::New(isolate, obj->index_->rows));
+  res->Set(v8::String::NewFromUtf8(isolate, "bitmaps"), v8::Number::New(isolate, bitmaps));
+  res->Set(v8::String::NewFromUtf8(isolate, "containers"), v8::Number::New(isolate, containers));
+  res->Set(v8::String::NewFromUtf8(isolate, "bytes"), v8::Number::New(isolate, bytes));
+  args.GetReturnValue().Set(res);
+}
+
+void INDEX_node_init(v8::Local<v8::Object> exports)
+{
+  PayloadIndex::Init(exports);
+}
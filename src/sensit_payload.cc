@@ -5,41 +5,236 @@
  *******************************************************************/
 /******* INCLUDES **************************************************/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "sensit_payload.h"
 #include "sensit_payload_v3.h"
 #include "sensit_payload_v2.h"
+#include "sensit_trace.h"
 
 /******* DEFINE ****************************************************/
 #define PAYLOAD_V3_ID 0b110
 #define V3_ID 3
 #define V2_ID 2
 
+/*!******************************************************************
+ * \struct payload_link_s
+ * \brief Decoder of a key of the jump table, and the next one to try
+ *        when its match rejects the payload
+ *******************************************************************/
+typedef struct payload_link_s
+{
+    const payload_decoder_s *decoder;
+    const struct payload_link_s *next;
+} payload_link_s;
+
 /*******************************************************************/
 
-void PAYLOAD_parse_data(u8 *data_in, data_s *data_out)
+static void PAYLOAD_parse_v3(u8 *data_in, data_s *data_out)
 {
     payload_v3_s payload3;
-    payload_v2_s payload2;
     memcpy(&(payload3.data), data_in, PAYLOAD_DATA_SIZE);
+    PAYLOAD_V3_parse_data(payload3, data_out);
+}
+
+/*******************************************************************/
+
+static void PAYLOAD_parse_v2(u8 *data_in, data_s *data_out)
+{
+    payload_v2_s payload2;
     memcpy(&(payload2.data), data_in, PAYLOAD_DATA_SIZE);
+    PAYLOAD_V2_parse_data(payload2, data_out);
+}
+
+/*******************************************************************/
+
+static void PAYLOAD_parse_unknown(u8 *data_in, data_s *data_out)
+{
+    (void)data_in;
+    data_out->error = PARSE_ERR_TYPE;
+}
+
+/*******************************************************************/
+
+static const payload_decoder_s PAYLOAD_DECODER_V3 = { "v3", PAYLOAD_V3, 0x07, PAYLOAD_V3_ID, NULL, PAYLOAD_parse_v3 };
+static const payload_decoder_s PAYLOAD_DECODER_V2 = { "v2", PAYLOAD_V2, 0x00, 0x00, NULL, PAYLOAD_parse_v2 };
+static const payload_decoder_s PAYLOAD_DECODER_UNKNOWN = { "unknown", (payload_type_e)0, 0x00, 0x00, NULL, PAYLOAD_parse_unknown };
+
+static const payload_link_s PAYLOAD_LINK_V3 = { &PAYLOAD_DECODER_V3, NULL };
+static const payload_link_s PAYLOAD_LINK_V2 = { &PAYLOAD_DECODER_V2, NULL };
+static const payload_link_s PAYLOAD_LINK_UNKNOWN = { &PAYLOAD_DECODER_UNKNOWN, NULL };
+
+/* The 3 low bits of the first byte are the v3 "reserved" field (0b110),
+   a v2 mode below it, the other values are not Sens'it payloads */
+#define PAYLOAD_BUILTIN_8 &PAYLOAD_LINK_V2, &PAYLOAD_LINK_V2, &PAYLOAD_LINK_V2, &PAYLOAD_LINK_V2, \
+                          &PAYLOAD_LINK_V2, &PAYLOAD_LINK_V2, &PAYLOAD_LINK_V3, &PAYLOAD_LINK_UNKNOWN
+#define PAYLOAD_BUILTIN_64 PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8, \
+                           PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8, PAYLOAD_BUILTIN_8
+
+static const payload_link_s *payload_table[PAYLOAD_KEYS] = {
+    PAYLOAD_BUILTIN_64, PAYLOAD_BUILTIN_64, PAYLOAD_BUILTIN_64, PAYLOAD_BUILTIN_64
+};
+
+static payload_decoder_s payload_decoders[PAYLOAD_MAX_DECODERS];
+static u32 payload_decoder_count = 0;
+
+/*******************************************************************/
+
+void PAYLOAD_parse_data(u8 *data_in, data_s *data_out)
+{
+    const payload_link_s *link = payload_table[data_in[0]];
+    SENSIT_TRACE1(parse_data_entry, TRACE_data_word(data_in));
 
+    while (link->decoder->match != NULL && !link->decoder->match(data_in))
+    {
+        link = link->next;
+    }
     data_out->error = PARSE_ERR_NONE;
+    data_out->type = link->decoder->type;
+    link->decoder->parse(data_in, data_out);
+    SENSIT_TRACE4(parse_data_return, TRACE_data_word(data_in), (u8)data_out->type, (u8)data_out->mode, data_out->error);
+}
+
+/*******************************************************************/
 
-    if (payload3.data.reserved == PAYLOAD_V3_ID)
+u8 PAYLOAD_register_decoder(const payload_decoder_s *decoder)
+{
+    payload_link_s *links;
+    u32 count = 0;
+    u32 key;
+
+    if (decoder->parse == NULL || (decoder->key_value & ~decoder->key_mask) != 0)
     {
-        data_out->type = PAYLOAD_V3;
-        PAYLOAD_V3_parse_data(payload3, data_out);
+        return PAYLOAD_REGISTER_ERR_DECODER;
     }
-    else if (payload3.data.reserved < PAYLOAD_V3_ID)
+    if (payload_decoder_count == PAYLOAD_MAX_DECODERS)
     {
-        data_out->type = PAYLOAD_V2;
-        PAYLOAD_V2_parse_data(payload2, data_out);
+        return PAYLOAD_REGISTER_ERR_FULL;
+    }
+    for (key = 0; key < PAYLOAD_KEYS; key++)
+    {
+        count += ((key & decoder->key_mask) == decoder->key_value) ? 1 : 0;
+    }
+    /* Links live as long as the process, like the registration */
+    links = (payload_link_s *)calloc(count, sizeof(payload_link_s));
+    if (links == NULL)
+    {
+        return PAYLOAD_REGISTER_ERR_ALLOC;
+    }
+
+    payload_decoders[payload_decoder_count] = *decoder;
+    for (key = 0; key < PAYLOAD_KEYS; key++)
+    {
+        if ((key & decoder->key_mask) == decoder->key_value)
+        {
+            links->decoder = &(payload_decoders[payload_decoder_count]);
+            links->next = payload_table[key];
+            payload_table[key] = links++;
+        }
+    }
+    payload_decoder_count++;
+    return PAYLOAD_REGISTER_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u32 PAYLOAD_decoders(const payload_decoder_s **decoders_out, u32 max)
+{
+    u32 i;
+
+    for (i = 0; i < payload_decoder_count && i < max; i++)
+    {
+        decoders_out[i] = &(payload_decoders[i]);
+    }
+    return payload_decoder_count;
+}
+
+/*******************************************************************/
+
+template <>
+void PAYLOAD_parse_data_as<PAYLOAD_V3>(u8 *data_in, data_s *data_out)
+{
+    payload_v3_s payload3;
+    memcpy(&(payload3.data), data_in, PAYLOAD_DATA_SIZE);
+    SENSIT_TRACE1(parse_data_entry, TRACE_data_word(data_in));
+
+    data_out->error = PARSE_ERR_NONE;
+    data_out->type = PAYLOAD_V3;
+
+    if (payload3.data.reserved != PAYLOAD_V3_ID)
+    {
+        data_out->error = PARSE_ERR_TYPE;
     }
     else
+    {
+        PAYLOAD_V3_parse_data(payload3, data_out);
+    }
+    SENSIT_TRACE4(parse_data_return, TRACE_data_word(data_in), (u8)data_out->type, (u8)data_out->mode, data_out->error);
+}
+
+/*******************************************************************/
+
+template <>
+void PAYLOAD_parse_data_as<PAYLOAD_V2>(u8 *data_in, data_s *data_out)
+{
+    payload_v2_s payload2;
+    memcpy(&(payload2.data), data_in, PAYLOAD_DATA_SIZE);
+    SENSIT_TRACE1(parse_data_entry, TRACE_data_word(data_in));
+
+    data_out->error = PARSE_ERR_NONE;
+    data_out->type = PAYLOAD_V2;
+
+    /* The 3 bits of the v3 "reserved" field are the v2 mode */
+    if (payload2.data.mode >= PAYLOAD_V3_ID)
     {
         data_out->error = PARSE_ERR_TYPE;
     }
+    else
+    {
+        PAYLOAD_V2_parse_data(payload2, data_out);
+    }
+    SENSIT_TRACE4(parse_data_return, TRACE_data_word(data_in), (u8)data_out->type, (u8)data_out->mode, data_out->error);
+}
+
+/*******************************************************************/
+
+void PAYLOAD_parse_data_batch(u8 *data_in, u32 count, data_s *data_out)
+{
+    u32 i;
+
+    memset(data_out, 0, count * sizeof(data_s));
+    for (i = 0; i < count; i++)
+    {
+        PAYLOAD_parse_data(data_in + (i * PAYLOAD_DATA_SIZE), &(data_out[i]));
+    }
+}
+
+/*******************************************************************/
+
+template <>
+void PAYLOAD_parse_data_batch_as<PAYLOAD_V3>(u8 *data_in, u32 count, data_s *data_out)
+{
+    u32 i;
+
+    memset(data_out, 0, count * sizeof(data_s));
+    for (i = 0; i < count; i++)
+    {
+        PAYLOAD_parse_data_as<PAYLOAD_V3>(data_in + (i * PAYLOAD_DATA_SIZE), &(data_out[i]));
+    }
+}
+
+/*******************************************************************/
+
+template <>
+void PAYLOAD_parse_data_batch_as<PAYLOAD_V2>(u8 *data_in, u32 count, data_s *data_out)
+{
+    u32 i;
+
+    memset(data_out, 0, count * sizeof(data_s));
+    for (i = 0; i < count; i++)
+    {
+        PAYLOAD_parse_data_as<PAYLOAD_V2>(data_in + (i * PAYLOAD_DATA_SIZE), &(data_out[i]));
+    }
 }
 
 /*******************************************************************/
@@ -51,7 +246,9 @@ void PAYLOAD_parse_config(u8 *data_in, payload_type_e type, config_s *config_out
 
     memcpy(&(payload3.config), data_in, PAYLOAD_CONFIG_SIZE);
     memcpy(&(payload2.config), data_in, PAYLOAD_CONFIG_SIZE);
+    SENSIT_TRACE2(parse_config_entry, TRACE_config_word(data_in), (u8)type);
 
+    config_out->error = PARSE_ERR_NONE;
     if (type == V3_ID)
     {
         PAYLOAD_V3_parse_config(payload3, config_out);
@@ -60,10 +257,16 @@ void PAYLOAD_parse_config(u8 *data_in, payload_type_e type, config_s *config_out
     {
         PAYLOAD_V2_parse_config(payload2, config_out);
     }
+    else
+    {
+        config_out->error = PARSE_ERR_TYPE;
+    }
+    SENSIT_TRACE3(parse_config_return, TRACE_config_word(data_in), (u8)type, config_out->error);
 }
 
 void PAYLOAD_serialize_config(config_s config_in, payload_type_e type, u8 *config_out)
 {
+    SENSIT_TRACE1(serialize_config_entry, (u8)type);
     if (type == V3_ID)
     {
         PAYLOAD_V3_serialize_config(config_in, config_out);
@@ -72,4 +275,5 @@ void PAYLOAD_serialize_config(config_s config_in, payload_type_e type, u8 *confi
     {
         PAYLOAD_V2_serialize_config(config_in, config_out);
     }
+    SENSIT_TRACE2(serialize_config_return, TRACE_config_word(config_out), (u8)type);
 }
\ No newline at end of file
@@ -13,16 +13,27 @@
 
 #define BRIGHTNESS_THRESHOLD_FACTOR 96
 
+#define PAYLOAD_REGISTER_ERR_NONE 0x00
+#define PAYLOAD_REGISTER_ERR_ALLOC 0x01
+#define PAYLOAD_REGISTER_ERR_FULL 0x02
+#define PAYLOAD_REGISTER_ERR_DECODER 0x03
+
+#define PAYLOAD_KEYS 256       /* Jump table entries, one per value of the first byte */
+#define PAYLOAD_MAX_DECODERS 32
+#define PAYLOAD_DECODERS_SYMBOL "sensit_payload_decoders"
+
 #define FALSE (bool)0
 #define TRUE (bool)1
 
 typedef unsigned char u8;   /*!< Unsigned 8 bits type  */
 typedef unsigned short u16; /*!< Unsigned 16 bits type */
-typedef unsigned long u32;  /*!< Unsigned 32 bits type */
+typedef unsigned int u32;   /*!< Unsigned 32 bits type */
+typedef unsigned long long u64; /*!< Unsigned 64 bits type */
 
 typedef signed char s8;   /*!< Signed 8 bits type  */
 typedef signed short s16; /*!< Signed 16 bits type */
-typedef signed long s32;  /*!< Signed 32 bits type */
+typedef signed int s32;   /*!< Signed 32 bits type */
+typedef signed long long s64; /*!< Signed 64 bits type */
 
 /*!******************************************************************
  * \enum payload_type_e
@@ -31,7 +42,8 @@ typedef signed long s32;  /*!< Signed 32 bits type */
 typedef enum {
     PAYLOAD_V2 = 2,
     PAYLOAD_V3 = 3,
-    PAYLOAD_LAST
+    PAYLOAD_LAST,
+    PAYLOAD_TYPE_MAX = 0xFF /*!< Registered decoders use types from PAYLOAD_LAST */
 } payload_type_e;
 
 /*!******************************************************************
@@ -158,6 +170,30 @@ typedef enum {
     DOOR_CONFIG_UNKNOW
 } door_config_e;
 
+/*!******************************************************************
+ * \struct payload_decoder_s
+ * \brief Decoder of a payload format, registered in the jump table of
+ *        PAYLOAD_parse_data for every first byte with
+ *        (byte & key_mask) == key_value.
+ *******************************************************************/
+typedef struct
+{
+    const char *name;
+    payload_type_e type;                           /*!< Set in data_s.type before parse is called */
+    u8 key_mask;                                   /*!< Bits of the first byte that select the format */
+    u8 key_value;
+    bool (*match)(const u8 *data_in);              /*!< Optional finer discriminator, NULL to take every payload of its keys */
+    void (*parse)(u8 *data_in, data_s *data_out);  /*!< Called with error PARSE_ERR_NONE and type set */
+} payload_decoder_s;
+
+/*!******************************************************************
+ * \typedef payload_decoders_f
+ * \brief Entry point of a decoder plugin, exported (extern "C") as
+ *        PAYLOAD_DECODERS_SYMBOL: returns an array of count decoders
+ *        that lives as long as the plugin is loaded.
+ *******************************************************************/
+typedef const payload_decoder_s *(*payload_decoders_f)(u32 *count);
+
 /*!************************************************************************
  * \fn void PAYLOAD_parse_data(u8* data_in, data_s* data_out)
  * \brief Function to parse Sens'it Discovery payload.
@@ -167,9 +203,52 @@ typedef enum {
  **************************************************************************/
 void PAYLOAD_parse_data(u8 *data_in, data_s *data_out);
 
+/*!************************************************************************
+ * \fn void PAYLOAD_parse_data_as<payload_type_e TYPE>(u8* data_in, data_s* data_out)
+ * \brief Function to parse a Sens'it Discovery payload of a known version,
+ *        skipping the version detection of PAYLOAD_parse_data.
+ *        A payload of another version is flagged PARSE_ERR_TYPE.
+ *
+ * \param[in] data_in               Payload to parse of PAYLOAD_DATA_SIZE lenght
+ * \param[out] data_out             Parsed data
+ **************************************************************************/
+template <payload_type_e TYPE>
+void PAYLOAD_parse_data_as(u8 *data_in, data_s *data_out);
+
+template <>
+void PAYLOAD_parse_data_as<PAYLOAD_V2>(u8 *data_in, data_s *data_out);
+
+template <>
+void PAYLOAD_parse_data_as<PAYLOAD_V3>(u8 *data_in, data_s *data_out);
+
+/*!************************************************************************
+ * \fn void PAYLOAD_parse_data_batch(u8* data_in, u32 count, data_s* data_out)
+ * \brief Function to parse count consecutive Sens'it Discovery payloads.
+ *        Each output is cleared before parsing.
+ *
+ * \param[in] data_in               count payloads of PAYLOAD_DATA_SIZE lenght
+ * \param[in] count                 Number of payloads
+ * \param[out] data_out             count parsed data
+ **************************************************************************/
+void PAYLOAD_parse_data_batch(u8 *data_in, u32 count, data_s *data_out);
+
+/*!************************************************************************
+ * \fn void PAYLOAD_parse_data_batch_as<payload_type_e TYPE>(u8* data_in, u32 count, data_s* data_out)
+ * \brief Same as PAYLOAD_parse_data_batch for payloads of a known version.
+ **************************************************************************/
+template <payload_type_e TYPE>
+void PAYLOAD_parse_data_batch_as(u8 *data_in, u32 count, data_s *data_out);
+
+template <>
+void PAYLOAD_parse_data_batch_as<PAYLOAD_V2>(u8 *data_in, u32 count, data_s *data_out);
+
+template <>
+void PAYLOAD_parse_data_batch_as<PAYLOAD_V3>(u8 *data_in, u32 count, data_s *data_out);
+
 /*!************************************************************************
  * \fn void PAYLOAD_parse_config(u8* data_in,payload_type_e type,config_s* config_out)
  * \brief Function to parse Sens'it Discovery config.
+ *        A type other than v2 & v3 is flagged PARSE_ERR_TYPE.
  *
  * \param[in] data_in               Payload to parse of PAYLOAD_DATA_SIZE lenght
  * \param[out] config_out             Parsed config
@@ -184,3 +263,25 @@ void PAYLOAD_parse_config(u8 *data_in, payload_type_e type, config_s *config_out
  * \param[out] config_out          Serialized configuration
  **************************************************************************/
 void PAYLOAD_serialize_config(config_s config_in, payload_type_e type, u8 *config_out);
+
+/*!************************************************************************
+ * \fn u8 PAYLOAD_register_decoder(const payload_decoder_s *decoder)
+ * \brief Add a decoder in front of the decoders of its keys: the last
+ *        registered whose match accepts a payload decodes it, the built-in
+ *        v2 & v3 decoders come last. Every function parsing "data"
+ *        payloads, batch & columnar ones included, goes through the jump
+ *        table, but PAYLOAD_parse_data_as that forces a version. Not
+ *        thread safe, register before decoding.
+ *
+ * \param[in] decoder               Copied, its name must outlive the registration
+ * \retval                          PAYLOAD_REGISTER_ERR_*
+ **************************************************************************/
+u8 PAYLOAD_register_decoder(const payload_decoder_s *decoder);
+
+/*!************************************************************************
+ * \fn u32 PAYLOAD_decoders(const payload_decoder_s **decoders_out, u32 max)
+ * \brief Decoders registered, in the order of registration.
+ *
+ * \retval                          Number of decoders registered
+ **************************************************************************/
+u32 PAYLOAD_decoders(const payload_decoder_s **decoders_out, u32 max);
@@ -1,19 +1,29 @@
+#include <stdlib.h>
+#include <string.h>
 #include <node.h>
 #include <node_buffer.h>
 #include <v8.h>
 #include "sensit_payload.h"
+#include "sensit_trace.h"
+#include "sensit_payload_node.h"
 
-void ParseData(const v8::FunctionCallbackInfo<v8::Value> &args)
+// Fire the node_entry & node_return probes around a binding function
+class TraceScope
 {
-  v8::Isolate *isolate = args.GetIsolate();
-
-  unsigned char *payload = (unsigned char *)node::Buffer::Data(args[0]->ToObject());
-
-  // printf("actual: %x%x%x%x \n", payload[0], payload[1], payload[2], payload[3]);
+public:
+  TraceScope(const char *function, u32 count) : function_(function), count_(count)
+  {
+    SENSIT_TRACE2(node_entry, function_, count_);
+  }
+  ~TraceScope() { SENSIT_TRACE2(node_return, function_, count_); }
 
-  data_s decoded_payload = {};
-  PAYLOAD_parse_data(payload, &decoded_payload);
+private:
+  const char *function_;
+  u32 count_;
+};
 
+static v8::Local<v8::Object> DataToObject(v8::Isolate *isolate, const data_s &decoded_payload)
+{
   v8::Local<v8::Object> obj = v8::Object::New(isolate);
 
   v8::Local<v8::Number> type = v8::Number::New(isolate, decoded_payload.type);
@@ -61,7 +71,218 @@ void ParseData(const v8::FunctionCallbackInfo<v8::Value> &args)
   v8::Local<v8::Number> error = v8::Number::New(isolate, decoded_payload.error);
   obj->Set(v8::String::NewFromUtf8(isolate, "error"), error);
 
-  args.GetReturnValue().Set(obj);
+  return obj;
+}
+
+void ParseData(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  unsigned char *payload = (unsigned char *)node::Buffer::Data(args[0]->ToObject());
+  TraceScope trace("parseData", 1);
+
+  // printf("actual: %x%x%x%x \n", payload[0], payload[1], payload[2], payload[3]);
+
+  data_s decoded_payload = {};
+  PAYLOAD_parse_data(payload, &decoded_payload);
+
+  args.GetReturnValue().Set(DataToObject(isolate, decoded_payload));
+}
+
+template <payload_type_e TYPE>
+void ParseDataAs(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  unsigned char *payload = (unsigned char *)node::Buffer::Data(args[0]->ToObject());
+  TraceScope trace((TYPE == PAYLOAD_V3) ? "parseDataV3" : "parseDataV2", 1);
+
+  data_s decoded_payload = {};
+  PAYLOAD_parse_data_as<TYPE>(payload, &decoded_payload);
+
+  args.GetReturnValue().Set(DataToObject(isolate, decoded_payload));
+}
+
+void ParseDataBatch(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  unsigned char *payloads = (unsigned char *)node::Buffer::Data(args[0]->ToObject());
+  u32 count = node::Buffer::Length(args[0]->ToObject()) / PAYLOAD_DATA_SIZE;
+  double type = args[1]->NumberValue();
+  TraceScope trace("parseDataBatch", count);
+
+  data_s *decoded_payloads = (data_s *)malloc((count ? count : 1) * sizeof(data_s));
+  if (decoded_payloads == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Out of memory")));
+    return;
+  }
+
+  if (type == 3)
+  {
+    PAYLOAD_parse_data_batch_as<PAYLOAD_V3>(payloads, count, decoded_payloads);
+  }
+  else if (type == 2)
+  {
+    PAYLOAD_parse_data_batch_as<PAYLOAD_V2>(payloads, count, decoded_payloads);
+  }
+  else
+  {
+    PAYLOAD_parse_data_batch(payloads, count, decoded_payloads);
+  }
+
+  v8::Local<v8::Array> array = v8::Array::New(isolate, count);
+  for (u32 i = 0; i < count; i++)
+  {
+    array->Set(i, DataToObject(isolate, decoded_payloads[i]));
+  }
+  free(decoded_payloads);
+
+  args.GetReturnValue().Set(array);
+}
+
+// Order of the values written by ParseDataInto, mirrored by DATA_INTO_* in index.js
+enum
+{
+  DATA_INTO_ERROR,
+  DATA_INTO_TYPE,
+  DATA_INTO_BATTERY_LEVEL,
+  DATA_INTO_MODE,
+  DATA_INTO_BUTTON,
+  DATA_INTO_TEMPERATURE,
+  DATA_INTO_HUMIDITY,
+  DATA_INTO_BRIGHTNESS,
+  DATA_INTO_DOOR,
+  DATA_INTO_VIBRATION,
+  DATA_INTO_MAGNET,
+  DATA_INTO_EVENT_COUNTER,
+  DATA_INTO_VERSION_MAJOR,
+  DATA_INTO_VERSION_MINOR,
+  DATA_INTO_VERSION_PATCH,
+  DATA_INTO_LAST
+};
+
+// Order of the values written by ParseConfigInto, mirrored by CONFIG_INTO_* in index.js
+enum
+{
+  CONFIG_INTO_LIMITED,
+  CONFIG_INTO_STANDBY_PERIODIC,
+  CONFIG_INTO_TEMPERATURE_PERIODIC,
+  CONFIG_INTO_LIGHT_PERIODIC,
+  CONFIG_INTO_DOOR_PERIODIC,
+  CONFIG_INTO_VIBRATION_PERIODIC,
+  CONFIG_INTO_MAGNET_PERIODIC,
+  CONFIG_INTO_TEMPERATURE_LOW,
+  CONFIG_INTO_TEMPERATURE_HIGH,
+  CONFIG_INTO_HUMIDITY_LOW,
+  CONFIG_INTO_HUMIDITY_HIGH,
+  CONFIG_INTO_BRIGHTNESS,
+  CONFIG_INTO_BRIGHTNESS_LOW,
+  CONFIG_INTO_BRIGHTNESS_HIGH,
+  CONFIG_INTO_DELAY,
+  CONFIG_INTO_VIBRATION,
+  CONFIG_INTO_DOOR,
+  CONFIG_INTO_PERIOD,
+  CONFIG_INTO_LAST
+};
+
+// Write the decoded fields in the order of DATA_INTO_*
+static inline void DataToInt32Array(const data_s &decoded_payload, s32 *values)
+{
+  values[DATA_INTO_ERROR] = decoded_payload.error;
+  values[DATA_INTO_TYPE] = decoded_payload.type;
+  values[DATA_INTO_BATTERY_LEVEL] = decoded_payload.battery_level;
+  values[DATA_INTO_MODE] = decoded_payload.mode;
+  values[DATA_INTO_BUTTON] = decoded_payload.button;
+  values[DATA_INTO_TEMPERATURE] = decoded_payload.temperature;
+  values[DATA_INTO_HUMIDITY] = decoded_payload.humidity;
+  values[DATA_INTO_BRIGHTNESS] = decoded_payload.brightness;
+  values[DATA_INTO_DOOR] = decoded_payload.door;
+  values[DATA_INTO_VIBRATION] = decoded_payload.vibration;
+  values[DATA_INTO_MAGNET] = decoded_payload.magnet;
+  values[DATA_INTO_EVENT_COUNTER] = decoded_payload.event_counter;
+  values[DATA_INTO_VERSION_MAJOR] = decoded_payload.version_major;
+  values[DATA_INTO_VERSION_MINOR] = decoded_payload.version_minor;
+  values[DATA_INTO_VERSION_PATCH] = decoded_payload.version_patch;
+}
+
+// Parse a payload into a caller owned Int32Array, so that no object is allocated
+void ParseDataInto(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  unsigned char *payload = (unsigned char *)node::Buffer::Data(args[0]);
+  s32 *values = (s32 *)node::Buffer::Data(args[1]);
+  TraceScope trace("parseDataInto", 1);
+
+  if (node::Buffer::Length(args[1]) < DATA_INTO_LAST * sizeof(s32))
+  {
+    v8::Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Int32Array too short")));
+    return;
+  }
+
+  data_s decoded_payload = {};
+  PAYLOAD_parse_data(payload, &decoded_payload);
+  DataToInt32Array(decoded_payload, values);
+}
+
+// Same as ParseDataInto with the payload as a big endian 32 bits integer:
+// a Smi or heap number is read without unwrapping a Buffer, and the hot
+// path of a single message avoids the hexadecimal string and its Buffer
+void ParseDataWord(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  u32 word = args[0]->Uint32Value();
+  s32 *values = (s32 *)node::Buffer::Data(args[1]);
+  TraceScope trace("parseDataWord", 1);
+
+  if (node::Buffer::Length(args[1]) < DATA_INTO_LAST * sizeof(s32))
+  {
+    v8::Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Int32Array too short")));
+    return;
+  }
+
+  u8 payload[PAYLOAD_DATA_SIZE] = { (u8)(word >> 24), (u8)(word >> 16), (u8)(word >> 8), (u8)word };
+  data_s decoded_payload = {};
+  PAYLOAD_parse_data(payload, &decoded_payload);
+  DataToInt32Array(decoded_payload, values);
+}
+
+void ParseConfigInto(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  unsigned char *config = (unsigned char *)node::Buffer::Data(args[0]);
+  double type = args[1]->NumberValue();
+  s32 *values = (s32 *)node::Buffer::Data(args[2]);
+  TraceScope trace("parseConfigInto", 1);
+
+  if (node::Buffer::Length(args[2]) < CONFIG_INTO_LAST * sizeof(s32))
+  {
+    v8::Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Int32Array too short")));
+    return;
+  }
+
+  config_s decoded_config = {};
+  PAYLOAD_parse_config(config, (type == 3) ? PAYLOAD_V3 : PAYLOAD_V2, &decoded_config);
+
+  values[CONFIG_INTO_LIMITED] = decoded_config.limited;
+  values[CONFIG_INTO_STANDBY_PERIODIC] = decoded_config.is_standby_periodic;
+  values[CONFIG_INTO_TEMPERATURE_PERIODIC] = decoded_config.is_temperature_periodic;
+  values[CONFIG_INTO_LIGHT_PERIODIC] = decoded_config.is_light_periodic;
+  values[CONFIG_INTO_DOOR_PERIODIC] = decoded_config.is_door_periodic;
+  values[CONFIG_INTO_VIBRATION_PERIODIC] = decoded_config.is_vibration_periodic;
+  values[CONFIG_INTO_MAGNET_PERIODIC] = decoded_config.is_magnet_periodic;
+  values[CONFIG_INTO_TEMPERATURE_LOW] = decoded_config.temperature_low_threshold;
+  values[CONFIG_INTO_TEMPERATURE_HIGH] = decoded_config.temperature_high_threshold;
+  values[CONFIG_INTO_HUMIDITY_LOW] = decoded_config.humidity_low_threshold;
+  values[CONFIG_INTO_HUMIDITY_HIGH] = decoded_config.humidity_high_threshold;
+  values[CONFIG_INTO_BRIGHTNESS] = decoded_config.brightness_threshold;
+  values[CONFIG_INTO_BRIGHTNESS_LOW] = decoded_config.brightness_low_threshold;
+  values[CONFIG_INTO_BRIGHTNESS_HIGH] = decoded_config.brightness_high_threshold;
+  values[CONFIG_INTO_DELAY] = decoded_config.delay;
+  values[CONFIG_INTO_VIBRATION] = decoded_config.vibration_config;
+  values[CONFIG_INTO_DOOR] = decoded_config.door_config;
+  values[CONFIG_INTO_PERIOD] = decoded_config.period;
 }
 
 void ParseConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
@@ -70,6 +291,7 @@ void ParseConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
 
   unsigned char *config = (unsigned char *)node::Buffer::Data(args[0]->ToObject());
   double type = args[1]->NumberValue();
+  TraceScope trace("parseConfig", 1);
   config_s decoded_config = {};
   PAYLOAD_parse_config(config, (type == 3) ? PAYLOAD_V3 : PAYLOAD_V2, &decoded_config);
 
@@ -141,6 +363,7 @@ void ParseConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
 void SerializeConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
 {
   v8::Isolate *isolate = args.GetIsolate();
+  TraceScope trace("serializeConfig", 1);
   config_s config;
   v8::Handle<v8::Object> config_in = v8::Handle<v8::Object>::Cast(args[0]);
   v8::Local<v8::Value> isLightPeriodic =
@@ -215,12 +438,12 @@ void SerializeConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
   config.delay = delay->NumberValue();
 
   double type = args[1]->NumberValue();
-  u8 decoded_config;
+  u8 decoded_config[PAYLOAD_CONFIG_SIZE] = {};
 
-  PAYLOAD_serialize_config(config, (type == 3) ? PAYLOAD_V3 : PAYLOAD_V2, &decoded_config);
+  PAYLOAD_serialize_config(config, (type == 3) ? PAYLOAD_V3 : PAYLOAD_V2, decoded_config);
 
   v8::MaybeLocal<v8::Object>
-      buffer = node::Buffer::Copy(isolate, reinterpret_cast<const char *>(&decoded_config), PAYLOAD_CONFIG_SIZE);
+      buffer = node::Buffer::Copy(isolate, reinterpret_cast<const char *>(decoded_config), PAYLOAD_CONFIG_SIZE);
   v8::Local<v8::Object> out;
   buffer.ToLocal(&out);
   args.GetReturnValue().Set(out);
@@ -229,8 +452,31 @@ void SerializeConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
 void init(v8::Local<v8::Object> exports)
 {
   NODE_SET_METHOD(exports, "parseData", ParseData);
+  NODE_SET_METHOD(exports, "parseDataV2", ParseDataAs<PAYLOAD_V2>);
+  NODE_SET_METHOD(exports, "parseDataV3", ParseDataAs<PAYLOAD_V3>);
+  NODE_SET_METHOD(exports, "parseDataBatch", ParseDataBatch);
+  NODE_SET_METHOD(exports, "parseDataInto", ParseDataInto);
+  NODE_SET_METHOD(exports, "parseDataWord", ParseDataWord);
   NODE_SET_METHOD(exports, "parseConfig", ParseConfig);
+  NODE_SET_METHOD(exports, "parseConfigInto", ParseConfigInto);
   NODE_SET_METHOD(exports, "serializeConfig", SerializeConfig);
+
+  DEDUP_node_init(exports);
+  ARROW_node_init(exports);
+  TEXT_node_init(exports);
+  SERIES_node_init(exports);
+  BATTERY_node_init(exports);
+  RULES_node_init(exports);
+  TIMELINE_node_init(exports);
+  DOWNLINK_node_init(exports);
+  WATCHDOG_node_init(exports);
+  SKETCH_node_init(exports);
+  DECODER_node_init(exports);
+  REORDER_node_init(exports);
+  INDEX_node_init(exports);
+#ifdef __linux__
+  RING_node_init(exports);
+#endif
 }
 
 NODE_MODULE(NODE_GYP_MODULE_NAME, init)
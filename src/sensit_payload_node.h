@@ -0,0 +1,96 @@
+/*!******************************************************************
+ * \file sensit_payload_node.h
+ * \brief Node.js bindings registered next to the payload functions
+ * \author Sens'it Team
+ *******************************************************************/
+
+/*!************************************************************************
+ * \fn bool OptionalColumn(v8::Isolate *isolate, v8::Local<v8::Value> arg, u32 count, const u32 **column)
+ * \brief Optional Uint32Array key column of a batch, NULL when absent.
+ *        FALSE with a RangeError thrown when it is not count long.
+ **************************************************************************/
+bool OptionalColumn(v8::Isolate *isolate, v8::Local<v8::Value> arg, u32 count, const u32 **column);
+
+/*!************************************************************************
+ * \fn void DEDUP_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the uplink deduplication table.
+ **************************************************************************/
+void DEDUP_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void ARROW_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the Apache Arrow IPC writers.
+ **************************************************************************/
+void ARROW_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void TEXT_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the NDJSON & CSV writers.
+ **************************************************************************/
+void TEXT_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void SERIES_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the compressed series store.
+ **************************************************************************/
+void SERIES_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void BATTERY_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the battery depletion forecaster.
+ **************************************************************************/
+void BATTERY_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void RULES_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the threshold rule engine.
+ **************************************************************************/
+void RULES_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void TIMELINE_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the door & vibration timeline.
+ **************************************************************************/
+void TIMELINE_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void DOWNLINK_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the pending downlink config store.
+ **************************************************************************/
+void DOWNLINK_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void WATCHDOG_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the missed uplink watchdog.
+ **************************************************************************/
+void WATCHDOG_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void SKETCH_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the mergeable quantile & distinct device sketches.
+ **************************************************************************/
+void SKETCH_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void DECODER_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the registration of decoder plugins.
+ **************************************************************************/
+void DECODER_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void REORDER_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the per device reorder buffer.
+ **************************************************************************/
+void REORDER_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void INDEX_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the bitmap indexes of stored payloads.
+ **************************************************************************/
+void INDEX_node_init(v8::Local<v8::Object> exports);
+
+/*!************************************************************************
+ * \fn void RING_node_init(v8::Local<v8::Object> exports)
+ * \brief Expose the shared memory uplink ring, Linux only.
+ **************************************************************************/
+void RING_node_init(v8::Local<v8::Object> exports);
@@ -0,0 +1,232 @@
+/*!******************************************************************
+ * \file sensit_protocol.c
+ * \brief Functions of the sensitd batch decoding protocol
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_text.h"
+#include "sensit_protocol.h"
+
+/******* DEFINE ****************************************************/
+#define PROTOCOL_MIN_CAPACITY 4096
+#define PROTOCOL_NDJSON_MAX_LINE (2 * TEXT_JSON_MAX_SIZE)
+
+/*******************************************************************/
+
+u8 *PROTOCOL_reserve(protocol_buffer_s *buffer, u32 size)
+{
+    u32 capacity = (buffer->capacity == 0) ? PROTOCOL_MIN_CAPACITY : buffer->capacity;
+    void *data;
+
+    if (buffer->size + size <= buffer->capacity)
+    {
+        return buffer->data + buffer->size;
+    }
+    while (capacity < buffer->size + size)
+    {
+        capacity *= 2;
+    }
+    data = realloc(buffer->data, capacity);
+    if (data == NULL)
+    {
+        return NULL;
+    }
+    buffer->data = (u8 *)data;
+    buffer->capacity = capacity;
+    return buffer->data + buffer->size;
+}
+
+/*******************************************************************/
+
+void PROTOCOL_free(protocol_buffer_s *buffer)
+{
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
+
+/*******************************************************************/
+
+static void PROTOCOL_write_u16(u8 *out, u16 value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+/*******************************************************************/
+
+static void PROTOCOL_write_u32(u8 *out, u32 value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+}
+
+/*******************************************************************/
+
+static void PROTOCOL_data_record(const data_s *data, u8 *out)
+{
+    out[0] = data->error;
+    out[1] = (u8)data->type;
+    out[2] = (u8)data->mode;
+    out[3] = (u8)(data->button | (data->vibration << 1) | (data->magnet << 2) | (data->door << 3));
+    PROTOCOL_write_u16(out + 4, data->battery_level);
+    PROTOCOL_write_u16(out + 6, (u16)data->temperature);
+    PROTOCOL_write_u16(out + 8, data->brightness);
+    PROTOCOL_write_u16(out + 10, data->event_counter);
+    out[12] = data->humidity;
+    out[13] = data->version_major;
+    out[14] = data->version_minor;
+    out[15] = data->version_patch;
+}
+
+/*******************************************************************/
+
+static void PROTOCOL_config_record(const config_s *config, u8 *out)
+{
+    out[0] = config->error;
+    out[1] = (u8)(config->limited | (config->is_standby_periodic << (1 + MODE_STANDBY)) |
+                  (config->is_temperature_periodic << (1 + MODE_TEMPERATURE)) | (config->is_light_periodic << (1 + MODE_LIGHT)) |
+                  (config->is_door_periodic << (1 + MODE_DOOR)) | (config->is_vibration_periodic << (1 + MODE_VIBRATION)) |
+                  (config->is_magnet_periodic << (1 + MODE_MAGNET)));
+    out[2] = (u8)config->temperature_low_threshold;
+    out[3] = (u8)config->temperature_high_threshold;
+    out[4] = config->humidity_low_threshold;
+    out[5] = config->humidity_high_threshold;
+    PROTOCOL_write_u16(out + 6, config->brightness_threshold);
+    PROTOCOL_write_u16(out + 8, config->brightness_low_threshold);
+    PROTOCOL_write_u16(out + 10, config->brightness_high_threshold);
+    out[12] = config->delay;
+    out[13] = config->vibration_config;
+    out[14] = config->door_config;
+    out[15] = config->period;
+}
+
+/*******************************************************************/
+
+static u8 *PROTOCOL_write_text(u8 *out, const char *text)
+{
+    u32 length = strlen(text);
+
+    memcpy(out, text, length);
+    return out + length;
+}
+
+/*******************************************************************/
+
+static u8 *PROTOCOL_write_json(const data_s *data, const config_s *config, u8 frame_size, u8 *out)
+{
+    /* The object of parse(), parseData() for a data frame */
+    out = TEXT_write_json_data(data, out);
+    if (frame_size != PAYLOAD_DATA_SIZE)
+    {
+        out = PROTOCOL_write_text(out - 1, ",\"config\":");
+        out = (config->error == PARSE_ERR_NONE) ? TEXT_write_json_config(config, (payload_type_e)data->type, out)
+                                                : PROTOCOL_write_text(out, "null");
+        out = PROTOCOL_write_text(out, "}");
+    }
+    return PROTOCOL_write_text(out, "\n");
+}
+
+/*******************************************************************/
+
+static void PROTOCOL_decode(u8 *frame, u8 frame_size, data_s *data, config_s *config)
+{
+    memset(data, 0, sizeof(data_s));
+    PAYLOAD_parse_data(frame, data);
+    if (frame_size == PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+    {
+        /* The config is decoded with the type of its data */
+        memset(config, 0, sizeof(config_s));
+        if (data->type == PAYLOAD_V2 || data->type == PAYLOAD_V3)
+        {
+            PAYLOAD_parse_config(frame + PAYLOAD_DATA_SIZE, data->type, config);
+        }
+        else
+        {
+            config->error = PARSE_ERR_TYPE;
+        }
+    }
+}
+
+/*******************************************************************/
+
+u8 PROTOCOL_handle(u8 *request, u32 length, protocol_buffer_s *reply)
+{
+    u8 format = request[0];
+    u8 frame_size = request[1];
+    u32 count = (length - PROTOCOL_HEADER_SIZE) / ((frame_size == 0) ? 1 : frame_size);
+    u32 start = reply->size;
+    u8 status = PROTOCOL_STATUS_OK;
+    u32 record_size;
+    data_s data;
+    config_s config;
+    u8 *out;
+    u32 i;
+
+    if (format >= PROTOCOL_FORMAT_LAST)
+    {
+        status = PROTOCOL_STATUS_FORMAT;
+    }
+    else if ((frame_size != PAYLOAD_DATA_SIZE && frame_size != PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE) ||
+             (length - PROTOCOL_HEADER_SIZE) % frame_size != 0)
+    {
+        status = PROTOCOL_STATUS_FRAME_SIZE;
+    }
+
+    out = PROTOCOL_reserve(reply, PROTOCOL_LENGTH_SIZE + PROTOCOL_HEADER_SIZE);
+    if (out == NULL)
+    {
+        return PROTOCOL_ERR_ALLOC;
+    }
+    out[4] = status;
+    out[5] = format;
+    out[6] = request[2];
+    out[7] = request[3];
+    reply->size += PROTOCOL_LENGTH_SIZE + PROTOCOL_HEADER_SIZE;
+
+    if (status == PROTOCOL_STATUS_OK && format == PROTOCOL_FORMAT_BINARY)
+    {
+        record_size = PROTOCOL_DATA_RECORD_SIZE + ((frame_size == PAYLOAD_DATA_SIZE) ? 0 : PROTOCOL_CONFIG_RECORD_SIZE);
+        out = PROTOCOL_reserve(reply, count * record_size);
+        if (out == NULL)
+        {
+            reply->size = start;
+            return PROTOCOL_ERR_ALLOC;
+        }
+        for (i = 0; i < count; i++)
+        {
+            PROTOCOL_decode(request + PROTOCOL_HEADER_SIZE + (i * frame_size), frame_size, &data, &config);
+            PROTOCOL_data_record(&data, out);
+            if (frame_size != PAYLOAD_DATA_SIZE)
+            {
+                PROTOCOL_config_record(&config, out + PROTOCOL_DATA_RECORD_SIZE);
+            }
+            out += record_size;
+        }
+        reply->size += count * record_size;
+    }
+    else if (status == PROTOCOL_STATUS_OK)
+    {
+        for (i = 0; i < count; i++)
+        {
+            out = PROTOCOL_reserve(reply, PROTOCOL_NDJSON_MAX_LINE);
+            if (out == NULL)
+            {
+                reply->size = start;
+                return PROTOCOL_ERR_ALLOC;
+            }
+            PROTOCOL_decode(request + PROTOCOL_HEADER_SIZE + (i * frame_size), frame_size, &data, &config);
+            out = PROTOCOL_write_json(&data, &config, frame_size, out);
+            reply->size = out - reply->data;
+        }
+    }
+
+    PROTOCOL_write_u32(reply->data + start, reply->size - start - PROTOCOL_LENGTH_SIZE);
+    return PROTOCOL_ERR_NONE;
+}
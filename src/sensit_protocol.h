@@ -0,0 +1,95 @@
+/*!******************************************************************
+ * \file sensit_protocol.h
+ * \brief Functions & Types of the sensitd batch decoding protocol
+ * \author Sens'it Team
+ *
+ * Every integer is little endian. A request is
+ *   u32 length (of what follows)
+ *   u8 format (protocol_format_e), u8 frame size (4 or 12), u16 id
+ *   frames: 4 bytes "data" payloads, or 12 bytes "data" then "config"
+ * and its reply
+ *   u32 length (of what follows)
+ *   u8 status (protocol_status_e), u8 format, u16 id (of the request)
+ *   body
+ * Replies are sent in the order of the requests.
+ *
+ * PROTOCOL_FORMAT_BINARY body: one record of PROTOCOL_DATA_RECORD_SIZE
+ * bytes per frame, followed for 12 bytes frames by a record of
+ * PROTOCOL_CONFIG_RECORD_SIZE bytes:
+ *   data   0 error, 1 type, 2 mode, 3 button | vibration << 1 | magnet << 2 | door << 3,
+ *          4 u16 battery_level, 6 s16 temperature, 8 u16 brightness,
+ *          10 u16 event_counter, 12 humidity, 13 version major, minor, patch
+ *   config 0 error, 1 limited | is_<mode>_periodic << (1 + mode),
+ *          2 s8 temperature low, 3 s8 temperature high, 4 humidity low,
+ *          5 humidity high, 6 u16 brightness threshold, 8 u16 brightness low,
+ *          10 u16 brightness high, 12 delay, 13 vibration config,
+ *          14 door config, 15 period
+ * PROTOCOL_FORMAT_NDJSON body: one line per frame, the JSON of
+ * parseData() for 4 bytes frames and of parse() for 12 bytes frames,
+ * its "config" null when it does not decode.
+ *******************************************************************/
+
+#define PROTOCOL_ERR_NONE 0x00
+#define PROTOCOL_ERR_ALLOC 0x01
+
+#define PROTOCOL_LENGTH_SIZE 4
+#define PROTOCOL_HEADER_SIZE 4
+#define PROTOCOL_MAX_REQUEST (16 * 1024 * 1024)
+#define PROTOCOL_DATA_RECORD_SIZE 16
+#define PROTOCOL_CONFIG_RECORD_SIZE 16
+
+/*!******************************************************************
+ * \enum protocol_format_e
+ * \brief Format of a reply body
+ *******************************************************************/
+typedef enum {
+    PROTOCOL_FORMAT_BINARY,
+    PROTOCOL_FORMAT_NDJSON,
+    PROTOCOL_FORMAT_LAST
+} protocol_format_e;
+
+/*!******************************************************************
+ * \enum protocol_status_e
+ * \brief Status of a reply, the body is empty on error
+ *******************************************************************/
+typedef enum {
+    PROTOCOL_STATUS_OK,
+    PROTOCOL_STATUS_FORMAT,     /*!< Unknown format */
+    PROTOCOL_STATUS_FRAME_SIZE, /*!< Frame size not 4 nor 12, or length not a multiple of it */
+    PROTOCOL_STATUS_LAST
+} protocol_status_e;
+
+/*!******************************************************************
+ * \struct protocol_buffer_s
+ * \brief Growable output buffer
+ *******************************************************************/
+typedef struct
+{
+    u8 *data;
+    u32 size;
+    u32 capacity;
+} protocol_buffer_s;
+
+/*!************************************************************************
+ * \fn u8 *PROTOCOL_reserve(protocol_buffer_s *buffer, u32 size)
+ * \brief Grow the buffer to append size bytes, NULL if the allocation failed.
+ *
+ * \retval                          Where to write the size bytes, size is not updated
+ **************************************************************************/
+u8 *PROTOCOL_reserve(protocol_buffer_s *buffer, u32 size);
+
+/*!************************************************************************
+ * \fn void PROTOCOL_free(protocol_buffer_s *buffer)
+ **************************************************************************/
+void PROTOCOL_free(protocol_buffer_s *buffer);
+
+/*!************************************************************************
+ * \fn u8 PROTOCOL_handle(u8 *request, u32 length, protocol_buffer_s *reply)
+ * \brief Decode the request following its u32 length and append its
+ *        reply, length included.
+ *
+ * \param[in] request               Request after its length field
+ * \param[in] length                Value of the length field, at least PROTOCOL_HEADER_SIZE
+ * \retval                          PROTOCOL_ERR_NONE or PROTOCOL_ERR_ALLOC
+ **************************************************************************/
+u8 PROTOCOL_handle(u8 *request, u32 length, protocol_buffer_s *reply);
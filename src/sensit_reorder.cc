@@ -0,0 +1,404 @@
+/*!******************************************************************
+ * \file sensit_reorder.c
+ * \brief Functions to put out of order uplinks back in order
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_reorder.h"
+
+/******* DEFINE ****************************************************/
+#define REORDER_MIN_DEVICES 32
+#define REORDER_MIN_FORCED 32
+#define REORDER_MIN_RECORDS 2
+
+/******* DEVICES ***************************************************/
+
+static u32 REORDER_add(reorder_s *reorder, u32 device_id)
+{
+    u32 index = DEVICES_find(&(reorder->ids), device_id);
+    reorder_device_s *device;
+    void *devices;
+    void *heap;
+
+    if (index != DEVICES_NONE)
+    {
+        return index;
+    }
+    if (reorder->device_count == reorder->device_capacity)
+    {
+        devices = realloc(reorder->devices, (size_t)reorder->device_capacity * 2 * sizeof(reorder_device_s));
+        if (devices == NULL)
+        {
+            return REORDER_NIL;
+        }
+        reorder->devices = (reorder_device_s *)devices;
+        heap = realloc(reorder->heap, (size_t)reorder->device_capacity * 2 * sizeof(u32));
+        if (heap == NULL)
+        {
+            return REORDER_NIL;
+        }
+        reorder->heap = (u32 *)heap;
+        reorder->device_capacity *= 2;
+    }
+
+    if (!DEVICES_add(&(reorder->ids), device_id, reorder->device_count))
+    {
+        return REORDER_NIL;
+    }
+
+    reorder->device_count++;
+    device = &(reorder->devices[reorder->device_count - 1]);
+    memset(device, 0, sizeof(reorder_device_s));
+    device->device_id = device_id;
+    device->position = REORDER_NIL;
+    return reorder->device_count - 1;
+}
+
+/******* HEAPS *****************************************************/
+
+static void REORDER_records_up(reorder_record_s *records, u32 position)
+{
+    reorder_record_s record = records[position];
+    u32 parent;
+
+    while (position > 0)
+    {
+        parent = (position - 1) / 2;
+        if (records[parent].key <= record.key)
+        {
+            break;
+        }
+        records[position] = records[parent];
+        position = parent;
+    }
+    records[position] = record;
+}
+
+/*******************************************************************/
+
+static void REORDER_records_down(reorder_record_s *records, u32 count, u32 position)
+{
+    reorder_record_s record = records[position];
+    u32 child;
+
+    while ((child = (position * 2) + 1) < count)
+    {
+        if (child + 1 < count && records[child + 1].key < records[child].key)
+        {
+            child++;
+        }
+        if (record.key <= records[child].key)
+        {
+            break;
+        }
+        records[position] = records[child];
+        position = child;
+    }
+    records[position] = record;
+}
+
+/*******************************************************************/
+
+static u64 REORDER_oldest(const reorder_s *reorder, u32 index)
+{
+    return reorder->devices[index].records[0].key;
+}
+
+/*******************************************************************/
+
+static void REORDER_heap_set(reorder_s *reorder, u32 position, u32 index)
+{
+    reorder->heap[position] = index;
+    reorder->devices[index].position = position;
+}
+
+/*******************************************************************/
+
+static void REORDER_heap_up(reorder_s *reorder, u32 position)
+{
+    u32 index = reorder->heap[position];
+    u64 key = REORDER_oldest(reorder, index);
+    u32 parent;
+
+    while (position > 0)
+    {
+        parent = (position - 1) / 2;
+        if (REORDER_oldest(reorder, reorder->heap[parent]) <= key)
+        {
+            break;
+        }
+        REORDER_heap_set(reorder, position, reorder->heap[parent]);
+        position = parent;
+    }
+    REORDER_heap_set(reorder, position, index);
+}
+
+/*******************************************************************/
+
+static void REORDER_heap_down(reorder_s *reorder, u32 position)
+{
+    u32 index = reorder->heap[position];
+    u64 key = REORDER_oldest(reorder, index);
+    u32 child;
+
+    while ((child = (position * 2) + 1) < reorder->heap_count)
+    {
+        if (child + 1 < reorder->heap_count &&
+            REORDER_oldest(reorder, reorder->heap[child + 1]) < REORDER_oldest(reorder, reorder->heap[child]))
+        {
+            child++;
+        }
+        if (key <= REORDER_oldest(reorder, reorder->heap[child]))
+        {
+            break;
+        }
+        REORDER_heap_set(reorder, position, reorder->heap[child]);
+        position = child;
+    }
+    REORDER_heap_set(reorder, position, index);
+}
+
+/*******************************************************************/
+
+/* Remove the oldest record of a device, keeping both heaps ordered */
+static void REORDER_take(reorder_s *reorder, u32 index, reorder_record_s *record_out)
+{
+    reorder_device_s *device = &(reorder->devices[index]);
+    reorder_record_s *records = device->records;
+    u32 position = device->position;
+    u32 moved;
+
+    *record_out = records[0];
+    device->count--;
+    device->released = TRUE;
+    device->last_key = record_out->key;
+    reorder->stats.held--;
+
+    if (device->count > 0)
+    {
+        records[0] = records[device->count];
+        REORDER_records_down(records, device->count, 0);
+        REORDER_heap_down(reorder, position);
+        return;
+    }
+    device->position = REORDER_NIL;
+    reorder->heap_count--;
+    if (position < reorder->heap_count)
+    {
+        moved = reorder->heap[reorder->heap_count];
+        REORDER_heap_set(reorder, position, moved);
+        REORDER_heap_up(reorder, position);
+        REORDER_heap_down(reorder, reorder->devices[moved].position);
+    }
+}
+
+/*******************************************************************/
+
+/* Next slot of the FIFO of the records released before the watermark */
+static reorder_record_s *REORDER_force(reorder_s *reorder)
+{
+    reorder_record_s *forced;
+    u32 capacity;
+    u32 i;
+
+    if (reorder->forced_count == reorder->forced_capacity)
+    {
+        capacity = reorder->forced_capacity * 2;
+        forced = (reorder_record_s *)malloc((size_t)capacity * sizeof(reorder_record_s));
+        if (forced == NULL)
+        {
+            return NULL;
+        }
+        /* Unwrap the FIFO */
+        for (i = 0; i < reorder->forced_count; i++)
+        {
+            forced[i] = reorder->forced[(reorder->forced_head + i) % reorder->forced_capacity];
+        }
+        free(reorder->forced);
+        reorder->forced = forced;
+        reorder->forced_head = 0;
+        reorder->forced_capacity = capacity;
+    }
+    forced = &(reorder->forced[(reorder->forced_head + reorder->forced_count) % reorder->forced_capacity]);
+    reorder->forced_count++;
+    reorder->stats.forced++;
+    return forced;
+}
+
+/*******************************************************************/
+
+static void REORDER_output(const reorder_s *reorder, const reorder_record_s *record, u32 i, u32 *device_ids, u16 *seq_numbers,
+                           u32 *times, u8 *uplinks)
+{
+    device_ids[i] = record->device_id;
+    seq_numbers[i] = (u16)(record->key & 0x0FFF);
+    times[i] = (u32)(record->key >> 12);
+    memcpy(uplinks + ((size_t)i * reorder->size), record->uplink, reorder->size);
+}
+
+/******* REORDER ***************************************************/
+
+reorder_s *REORDER_create(u32 lateness, u32 depth, u8 size)
+{
+    reorder_s *reorder = (reorder_s *)calloc(1, sizeof(reorder_s));
+
+    if (reorder == NULL)
+    {
+        return NULL;
+    }
+    reorder->depth = (depth == 0) ? REORDER_DEFAULT_DEPTH : depth;
+    reorder->lateness = lateness;
+    reorder->size = (size == REORDER_UPLINK_SIZE) ? REORDER_UPLINK_SIZE : PAYLOAD_DATA_SIZE;
+    reorder->devices = (reorder_device_s *)malloc(REORDER_MIN_DEVICES * sizeof(reorder_device_s));
+    reorder->heap = (u32 *)malloc(REORDER_MIN_DEVICES * sizeof(u32));
+    reorder->device_capacity = REORDER_MIN_DEVICES;
+    reorder->forced = (reorder_record_s *)malloc(REORDER_MIN_FORCED * sizeof(reorder_record_s));
+    reorder->forced_capacity = REORDER_MIN_FORCED;
+    if (!DEVICES_init(&(reorder->ids)) || reorder->devices == NULL || reorder->heap == NULL || reorder->forced == NULL)
+    {
+        REORDER_destroy(reorder);
+        return NULL;
+    }
+    return reorder;
+}
+
+/*******************************************************************/
+
+void REORDER_destroy(reorder_s *reorder)
+{
+    u32 i;
+
+    if (reorder != NULL)
+    {
+        for (i = 0; i < reorder->device_count; i++)
+        {
+            free(reorder->devices[i].records);
+        }
+        DEVICES_free(&(reorder->ids));
+        free(reorder->devices);
+        free(reorder->heap);
+        free(reorder->forced);
+        free(reorder);
+    }
+}
+
+/*******************************************************************/
+
+u8 REORDER_push(reorder_s *reorder, u32 device_id, u16 seq_number, u32 time, const u8 *uplink_in)
+{
+    u64 key = REORDER_KEY(time, seq_number);
+    reorder_device_s *device;
+    reorder_record_s *records;
+    reorder_record_s *forced;
+    u32 capacity;
+    u32 index;
+
+    index = REORDER_add(reorder, device_id);
+    if (index == REORDER_NIL)
+    {
+        return REORDER_ERR_ALLOC;
+    }
+    device = &(reorder->devices[index]);
+    if ((reorder->polled && time <= reorder->watermark) || (device->released && key <= device->last_key))
+    {
+        reorder->stats.late++;
+        return REORDER_LATE;
+    }
+    if (!reorder->started || time > reorder->latest_time)
+    {
+        reorder->latest_time = time;
+        reorder->started = TRUE;
+    }
+
+    if (device->count == reorder->depth)
+    {
+        forced = REORDER_force(reorder);
+        if (forced == NULL)
+        {
+            return REORDER_ERR_ALLOC;
+        }
+        if (key > device->records[0].key)
+        {
+            REORDER_take(reorder, index, forced);
+        }
+        else
+        {
+            /* Older than every uplink held, released first in order */
+            forced->key = key;
+            forced->device_id = device_id;
+            memcpy(forced->uplink, uplink_in, reorder->size);
+            device->released = TRUE;
+            device->last_key = key;
+            reorder->stats.pushed++;
+            return REORDER_ERR_NONE;
+        }
+    }
+
+    if (device->count == device->capacity)
+    {
+        capacity = (device->capacity == 0) ? REORDER_MIN_RECORDS : device->capacity * 2;
+        capacity = (capacity < reorder->depth) ? capacity : reorder->depth;
+        records = (reorder_record_s *)realloc(device->records, (size_t)capacity * sizeof(reorder_record_s));
+        if (records == NULL)
+        {
+            return REORDER_ERR_ALLOC;
+        }
+        device->records = records;
+        device->capacity = capacity;
+    }
+    records = device->records;
+    records[device->count].key = key;
+    records[device->count].device_id = device_id;
+    memcpy(records[device->count].uplink, uplink_in, reorder->size);
+    REORDER_records_up(records, device->count);
+    device->count++;
+
+    if (device->position == REORDER_NIL)
+    {
+        REORDER_heap_set(reorder, reorder->heap_count++, index);
+    }
+    REORDER_heap_up(reorder, device->position);
+    reorder->stats.pushed++;
+    reorder->stats.held++;
+    return REORDER_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u32 REORDER_watermark(const reorder_s *reorder)
+{
+    return (reorder->latest_time > reorder->lateness) ? reorder->latest_time - reorder->lateness : 0;
+}
+
+/*******************************************************************/
+
+u32 REORDER_poll(reorder_s *reorder, u32 watermark, u32 *device_ids, u16 *seq_numbers, u32 *times, u8 *uplinks, u32 max)
+{
+    reorder_record_s record;
+    u32 count = 0;
+
+    if (!reorder->polled || watermark > reorder->watermark)
+    {
+        reorder->watermark = watermark;
+        reorder->polled = TRUE;
+    }
+
+    /* The oldest uplinks of their device, before any of its uplinks still held */
+    while (count < max && reorder->forced_count > 0)
+    {
+        REORDER_output(reorder, &(reorder->forced[reorder->forced_head]), count++, device_ids, seq_numbers, times, uplinks);
+        reorder->forced_head = (reorder->forced_head + 1) % reorder->forced_capacity;
+        reorder->forced_count--;
+    }
+    while (count < max && reorder->heap_count > 0 && (REORDER_oldest(reorder, reorder->heap[0]) >> 12) <= reorder->watermark)
+    {
+        REORDER_take(reorder, reorder->heap[0], &record);
+        REORDER_output(reorder, &record, count++, device_ids, seq_numbers, times, uplinks);
+    }
+    reorder->stats.released += count;
+    return count;
+}
@@ -0,0 +1,140 @@
+/*!******************************************************************
+ * \file sensit_reorder.h
+ * \brief Functions & Types to put out of order uplinks back in order
+ * \author Sens'it Team
+ *
+ * Retries, several base stations and callbacks queued during an outage
+ * deliver the uplinks of a device out of order. Uplinks are held in a
+ * min-heap per device ordered by (time, seqNumber), grown on demand up
+ * to depth records, and the devices holding uplinks in a min-heap
+ * ordered by their oldest one: a push is O(log depth + log devices),
+ * memory is bounded by depth records per device. The low
+ * watermark is the latest time pushed minus the lateness bound, a poll
+ * releases the uplinks up to the watermark in time order, so the
+ * uplinks of each device come out in order. An uplink older than an
+ * uplink already released for its device, or than the watermark of the
+ * last poll, is late: it is not held and the caller handles it apart.
+ * When the heap of a device is full its oldest uplink is released at
+ * the next poll, before the watermark.
+ *******************************************************************/
+
+#define REORDER_ERR_NONE 0x00
+#define REORDER_ERR_ALLOC 0x01
+#define REORDER_LATE 0x02
+
+#define REORDER_UPLINK_SIZE (PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+#define REORDER_NIL 0xFFFFFFFF
+
+#define REORDER_DEFAULT_LATENESS 300 /* seconds */
+#define REORDER_DEFAULT_DEPTH 32
+
+#define REORDER_KEY(time, seq_number) (((u64)(time) << 12) | ((seq_number) & 0x0FFF))
+
+/*!******************************************************************
+ * \struct reorder_record_s
+ * \brief Uplink held
+ *******************************************************************/
+typedef struct
+{
+    u64 key;                         /*!< REORDER_KEY(time, seqNumber) */
+    u32 device_id;
+    u8 uplink[REORDER_UPLINK_SIZE];  /*!< "data" payload, followed by the "config" if size is 12 */
+} reorder_record_s;
+
+/*!******************************************************************
+ * \struct reorder_device_s
+ * \brief Device, with its heap of records
+ *******************************************************************/
+typedef struct
+{
+    reorder_record_s *records; /*!< Min-heap by key, grown up to depth records */
+    u32 capacity;
+    u32 count;                 /*!< Records held */
+    u32 device_id;
+    u32 position;              /*!< Index in reorder_s.heap, REORDER_NIL when no record is held */
+    u64 last_key;              /*!< Key of the last record released */
+    bool released;             /*!< last_key is set */
+} reorder_device_s;
+
+/*!******************************************************************
+ * \struct reorder_stats_s
+ * \brief Counters since the creation
+ *******************************************************************/
+typedef struct
+{
+    u64 pushed;   /*!< Uplinks accepted */
+    u64 released; /*!< Uplinks released by polls */
+    u64 late;     /*!< Uplinks rejected as late */
+    u64 forced;   /*!< Uplinks released before the watermark, device heap full */
+    u64 held;     /*!< Uplinks held now */
+} reorder_stats_s;
+
+/*!******************************************************************
+ * \struct reorder_s
+ * \brief Devices, their heaps & the watermark
+ *******************************************************************/
+typedef struct
+{
+    devices_s ids;              /*!< Index in devices of each device id */
+    reorder_device_s *devices;
+    u32 device_count;
+    u32 device_capacity;
+    u32 *heap;                  /*!< Devices holding records, min-heap by their oldest record */
+    u32 heap_count;
+    reorder_record_s *forced;   /*!< Records pushed out of a full heap, FIFO until the next poll */
+    u32 forced_head;
+    u32 forced_count;
+    u32 forced_capacity;
+    u32 depth;
+    u32 lateness;               /*!< Seconds */
+    u8 size;                    /*!< Bytes of the uplinks, PAYLOAD_DATA_SIZE or REORDER_UPLINK_SIZE */
+    bool started;               /*!< latest_time is set */
+    u32 latest_time;            /*!< Latest time pushed, seconds */
+    bool polled;                /*!< watermark is set */
+    u32 watermark;              /*!< Records up to this time have been released */
+    reorder_stats_s stats;
+} reorder_s;
+
+/*!************************************************************************
+ * \fn reorder_s *REORDER_create(u32 lateness, u32 depth, u8 size)
+ * \brief Allocate an empty reorder buffer, NULL if the allocation failed.
+ *
+ * \param[in] lateness              Seconds an uplink may arrive after a later one
+ * \param[in] depth                 Uplinks held at most per device
+ * \param[in] size                  PAYLOAD_DATA_SIZE or REORDER_UPLINK_SIZE
+ **************************************************************************/
+reorder_s *REORDER_create(u32 lateness, u32 depth, u8 size);
+
+/*!************************************************************************
+ * \fn void REORDER_destroy(reorder_s *reorder)
+ **************************************************************************/
+void REORDER_destroy(reorder_s *reorder);
+
+/*!************************************************************************
+ * \fn u8 REORDER_push(reorder_s *reorder, u32 device_id, u16 seq_number, u32 time, const u8 *uplink_in)
+ * \brief Hold an uplink until the watermark passes its time.
+ *
+ * \param[in] time                  Seconds
+ * \param[in] uplink_in             Uplink of reorder->size bytes
+ * \retval                          REORDER_ERR_NONE, REORDER_ERR_ALLOC or REORDER_LATE
+ **************************************************************************/
+u8 REORDER_push(reorder_s *reorder, u32 device_id, u16 seq_number, u32 time, const u8 *uplink_in);
+
+/*!************************************************************************
+ * \fn u32 REORDER_watermark(const reorder_s *reorder)
+ * \brief Latest time pushed minus the lateness, 0 before the first push.
+ **************************************************************************/
+u32 REORDER_watermark(const reorder_s *reorder);
+
+/*!************************************************************************
+ * \fn u32 REORDER_poll(reorder_s *reorder, u32 watermark, u32 *device_ids, u16 *seq_numbers, u32 *times, u8 *uplinks, u32 max)
+ * \brief Release the uplinks of the full heaps, then the uplinks up to
+ *        watermark included in time order. The watermark never goes
+ *        back. At most max are returned, the next call continues with
+ *        the others.
+ *
+ * \param[in] watermark             Seconds, REORDER_watermark() or later to flush
+ * \param[out] uplinks              max uplinks of reorder->size bytes
+ * \retval                          Number of uplinks released
+ **************************************************************************/
+u32 REORDER_poll(reorder_s *reorder, u32 watermark, u32 *device_ids, u16 *seq_numbers, u32 *times, u8 *uplinks, u32 max);
@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_reorder.h"
+#include "sensit_payload_node.h"
+
+class Reorderer : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Reorderer(reorder_s *reorder) : reorder_(reorder) {}
+  ~Reorderer() { REORDER_destroy(reorder_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Push(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Poll(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  reorder_s *reorder_;
+};
+
+void Reorderer::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Reorderer"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "push", Push);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "poll", Poll);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Reorderer"), tpl->GetFunction());
+}
+
+void Reorderer::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: lateness seconds, depth, uplink size
+  reorder_s *reorder = REORDER_create(args[0]->Uint32Value(), args[1]->Uint32Value(), (u8)args[2]->Uint32Value());
+  if (reorder == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the reorder buffer")));
+    return;
+  }
+
+  Reorderer *obj = new Reorderer(reorder);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void Reorderer::Push(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Reorderer *obj = node::ObjectWrap::Unwrap<Reorderer>(args.Holder());
+
+  // args: Buffer uplinks, Uint32Array device ids, Uint16Array seqNumbers, Uint32Array times, Uint8Array late mask
+  const u8 *uplinks = (const u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+  const u16 *seq_numbers = (const u16 *)node::Buffer::Data(args[2]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[3]);
+  u8 *late_mask = (u8 *)node::Buffer::Data(args[4]);
+
+  size_t count = node::Buffer::Length(args[0]) / obj->reorder_->size;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u16))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u16);
+  }
+  if (count > node::Buffer::Length(args[3]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[3]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[4]))
+  {
+    count = node::Buffer::Length(args[4]);
+  }
+
+  u32 late = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    u8 err = REORDER_push(obj->reorder_, device_ids[i], seq_numbers[i], times[i], uplinks + (i * obj->reorder_->size));
+    if (err == REORDER_ERR_ALLOC)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the reorder buffer")));
+      return;
+    }
+    late_mask[i] = (err == REORDER_LATE) ? 1 : 0;
+    late += late_mask[i];
+  }
+  // Number of uplinks too late to be put back in order
+  args.GetReturnValue().Set(late);
+}
+
+void Reorderer::Poll(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Reorderer *obj = node::ObjectWrap::Unwrap<Reorderer>(args.Holder());
+  reorder_s *reorder = obj->reorder_;
+
+  // args: watermark seconds (undefined for the latest time minus the lateness), max uplinks
+  u32 watermark = args[0]->IsUndefined() ? REORDER_watermark(reorder) : args[0]->Uint32Value();
+  u32 max = args[1]->Uint32Value();
+  if (max > reorder->stats.held + reorder->forced_count)
+  {
+    max = (u32)(reorder->stats.held + reorder->forced_count);
+  }
+
+  // Device ids & times in a single ArrayBuffer
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, (size_t)max * 2 * sizeof(u32));
+  v8::Local<v8::ArrayBuffer> seq_buffer = v8::ArrayBuffer::New(isolate, (size_t)max * sizeof(u16));
+  u32 *columns = (u32 *)buffer->GetContents().Data();
+  u16 *seq_numbers = (u16 *)seq_buffer->GetContents().Data();
+  u8 *uplinks = (u8 *)malloc((size_t)max * reorder->size + 1);
+  if (uplinks == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Out of memory")));
+    return;
+  }
+  u32 count = REORDER_poll(reorder, watermark, columns, seq_numbers, columns + max, uplinks, max);
+
+  v8::MaybeLocal<v8::Object> payloads = node::Buffer::Copy(isolate, (const char *)uplinks, (size_t)count * reorder->size);
+  free(uplinks);
+  v8::Local<v8::Object> payloads_out;
+  if (!payloads.ToLocal(&payloads_out))
+  {
+    return;
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Uint32Array::New(buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "times"), v8::Uint32Array::New(buffer, max * sizeof(u32), count));
+  res->Set(v8::String::NewFromUtf8(isolate, "seqNumbers"), v8::Uint16Array::New(seq_buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "payloads"), payloads_out);
+  res->Set(v8::String::NewFromUtf8(isolate, "watermark"), v8::Number::New(isolate, reorder->watermark));
+  args.GetReturnValue().Set(res);
+}
+
+void Reorderer::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Reorderer *obj = node::ObjectWrap::Unwrap<Reorderer>(args.Holder());
+  const reorder_stats_s *stats = &(obj->reorder_->stats);
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Number::New(isolate, obj->reorder_->device_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "held"), v8::Number::New(isolate, (double)stats->held));
+  res->Set(v8::String::NewFromUtf8(isolate, "pushed"), v8::Number::New(isolate, (double)stats->pushed));
+  res->Set(v8::String::NewFromUtf8(isolate, "released"), v8::Number::New(isolate, (double)stats->released));
+  res->Set(v8::String::NewFromUtf8(isolate, "late"), v8::Number::New(isolate, (double)stats->late));
+  res->Set(v8::String::NewFromUtf8(isolate, "forced"), v8::Number::New(isolate, (double)stats->forced));
+  res->Set(v8::String::NewFromUtf8(isolate, "watermark"), v8::Number::New(isolate, REORDER_watermark(obj->reorder_)));
+  args.GetReturnValue().Set(res);
+}
+
+void REORDER_node_init(v8::Local<v8::Object> exports)
+{
+  Reorderer::Init(exports);
+}
@@ -0,0 +1,321 @@
+/*!******************************************************************
+ * \file sensit_ring.c
+ * \brief Functions to pass raw uplinks between local processes
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "sensit_payload.h"
+#include "sensit_ring.h"
+
+/******* DEFINE ****************************************************/
+#define RING_MIN_CAPACITY 2
+#define RING_MAX_CAPACITY (1U << 26)
+
+/*******************************************************************/
+
+static void RING_futex_wait(u32 *word, u32 value, s32 timeout_ms)
+{
+    struct timespec timeout;
+
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    /* Not FUTEX_PRIVATE_FLAG: the word is shared with other processes */
+    syscall(SYS_futex, word, FUTEX_WAIT, value, (timeout_ms < 0) ? NULL : &timeout, NULL, 0);
+}
+
+/*******************************************************************/
+
+static void RING_futex_wake(u32 *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/*******************************************************************/
+
+static ring_s *RING_map(int fd, size_t size)
+{
+    ring_s *ring = (ring_s *)calloc(1, sizeof(ring_s));
+    void *memory;
+
+    if (ring == NULL)
+    {
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        close(fd);
+        free(ring);
+        return NULL;
+    }
+
+    ring->header = (ring_header_s *)memory;
+    ring->slots = (ring_slot_s *)((u8 *)memory + sizeof(ring_header_s));
+    ring->fd = fd;
+    ring->size = size;
+    return ring;
+}
+
+/*******************************************************************/
+
+ring_s *RING_create(const char *path, u32 capacity)
+{
+    u32 rounded = RING_MIN_CAPACITY;
+    size_t size;
+    ring_s *ring;
+    int fd;
+    u32 i;
+
+    if (capacity > RING_MAX_CAPACITY)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    while (rounded < capacity)
+    {
+        rounded *= 2;
+    }
+    size = sizeof(ring_header_s) + ((size_t)rounded * sizeof(ring_slot_s));
+
+    if (path == NULL)
+    {
+        /* Through syscall, memfd_create is missing from older C libraries */
+        fd = (int)syscall(SYS_memfd_create, "sensit-ring", 0);
+    }
+    else
+    {
+        fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    }
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    ring = RING_map(fd, size);
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+
+    /* Fresh mapping is zeroed, slot i is free for the producer of position i */
+    for (i = 0; i < rounded; i++)
+    {
+        ring->slots[i].sequence = i;
+    }
+    ring->header->capacity = rounded;
+    ring->header->slot_size = sizeof(ring_slot_s);
+    ring->header->version = RING_VERSION;
+    __atomic_store_n(&(ring->header->magic), RING_MAGIC, __ATOMIC_RELEASE);
+    return ring;
+}
+
+/*******************************************************************/
+
+ring_s *RING_open(const char *path)
+{
+    struct stat info;
+    ring_header_s header;
+    ring_s *ring;
+    int fd = open(path, O_RDWR);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ring_header_s) ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != RING_MAGIC || header.version != RING_VERSION || header.slot_size != sizeof(ring_slot_s) ||
+        header.capacity < RING_MIN_CAPACITY || header.capacity > RING_MAX_CAPACITY || (header.capacity & (header.capacity - 1)) != 0 ||
+        (size_t)info.st_size < sizeof(ring_header_s) + ((size_t)header.capacity * sizeof(ring_slot_s)))
+    {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    ring = RING_map(fd, sizeof(ring_header_s) + ((size_t)header.capacity * sizeof(ring_slot_s)));
+    return ring;
+}
+
+/*******************************************************************/
+
+void RING_close(ring_s *ring)
+{
+    if (ring != NULL)
+    {
+        munmap(ring->header, ring->size);
+        close(ring->fd);
+        free(ring);
+    }
+}
+
+/*******************************************************************/
+
+u8 RING_push(ring_s *ring, u32 device_id, u32 time, u16 seq_number, const u8 *payload, u8 size)
+{
+    ring_header_s *header = ring->header;
+    u64 mask = header->capacity - 1;
+    u64 position = __atomic_load_n(&(header->head), __ATOMIC_RELAXED);
+    ring_slot_s *slot;
+    u64 sequence;
+    s64 diff;
+
+    if (size != PAYLOAD_DATA_SIZE && size != RING_PAYLOAD_SIZE)
+    {
+        return RING_ERR_SIZE;
+    }
+
+    for (;;)
+    {
+        slot = &(ring->slots[position & mask]);
+        sequence = __atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE);
+        diff = (s64)(sequence - position);
+        if (diff == 0)
+        {
+            /* Free for this position, reserve it. A failed CAS reloads position */
+            if (__atomic_compare_exchange_n(&(header->head), &position, position + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Slot of the previous lap not drained yet */
+            __atomic_fetch_add(&(header->overflow), 1, __ATOMIC_RELAXED);
+            return RING_ERR_FULL;
+        }
+        else
+        {
+            position = __atomic_load_n(&(header->head), __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->record.device_id = device_id;
+    slot->record.time = time;
+    slot->record.seq_number = seq_number;
+    slot->record.size = size;
+    memcpy(slot->record.payload, payload, size);
+    __atomic_store_n(&(slot->sequence), position + 1, __ATOMIC_RELEASE);
+
+    /* Pairs with the fence of RING_wait: either the consumer sees the
+       record or we see it waiting */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(header->waiting), __ATOMIC_RELAXED) != 0)
+    {
+        __atomic_fetch_add(&(header->signal), 1, __ATOMIC_RELEASE);
+        RING_futex_wake(&(header->signal));
+    }
+    return RING_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u32 RING_drain(ring_s *ring, u32 max, ring_visit_f visit, void *context)
+{
+    ring_header_s *header = ring->header;
+    u64 capacity = header->capacity;
+    u64 position = __atomic_load_n(&(header->tail), __ATOMIC_RELAXED);
+    ring_slot_s *slot;
+    u32 count;
+
+    for (count = 0; count < max; count++)
+    {
+        slot = &(ring->slots[position & (capacity - 1)]);
+        if (__atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE) != position + 1)
+        {
+            break;
+        }
+        visit(&(slot->record), context);
+        /* Hand the slot to the producer of the next lap */
+        __atomic_store_n(&(slot->sequence), position + capacity, __ATOMIC_RELEASE);
+        position++;
+    }
+    __atomic_store_n(&(header->tail), position, __ATOMIC_RELEASE);
+    return count;
+}
+
+/*******************************************************************/
+
+typedef struct
+{
+    u32 *device_ids;
+    u32 *times;
+    data_s *data;
+    u32 count;
+} ring_data_context_s;
+
+static void RING_visit_data(const ring_record_s *record, void *context)
+{
+    ring_data_context_s *columns = (ring_data_context_s *)context;
+
+    columns->device_ids[columns->count] = record->device_id;
+    columns->times[columns->count] = record->time;
+    PAYLOAD_parse_data((u8 *)record->payload, &(columns->data[columns->count]));
+    columns->count++;
+}
+
+u32 RING_drain_data(ring_s *ring, u32 max, u32 *device_ids, u32 *times, data_s *data)
+{
+    ring_data_context_s columns = { device_ids, times, data, 0 };
+
+    memset(data, 0, (size_t)max * sizeof(data_s));
+    return RING_drain(ring, max, RING_visit_data, &columns);
+}
+
+/*******************************************************************/
+
+static bool RING_ready(const ring_s *ring)
+{
+    u64 position = __atomic_load_n(&(ring->header->tail), __ATOMIC_RELAXED);
+    const ring_slot_s *slot = &(ring->slots[position & (ring->header->capacity - 1)]);
+
+    return __atomic_load_n(&(slot->sequence), __ATOMIC_ACQUIRE) == position + 1;
+}
+
+bool RING_wait(ring_s *ring, s32 timeout_ms)
+{
+    ring_header_s *header = ring->header;
+    u32 signal;
+
+    if (RING_ready(ring))
+    {
+        return TRUE;
+    }
+
+    /* A wake between the load of signal and the futex makes it return at once */
+    signal = __atomic_load_n(&(header->signal), __ATOMIC_ACQUIRE);
+    __atomic_store_n(&(header->waiting), 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!RING_ready(ring))
+    {
+        RING_futex_wait(&(header->signal), signal, timeout_ms);
+    }
+    __atomic_store_n(&(header->waiting), 0, __ATOMIC_RELAXED);
+    return RING_ready(ring);
+}
+
+/*******************************************************************/
+
+u32 RING_size(const ring_s *ring)
+{
+    u64 head = __atomic_load_n(&(ring->header->head), __ATOMIC_RELAXED);
+    u64 tail = __atomic_load_n(&(ring->header->tail), __ATOMIC_RELAXED);
+
+    return (head > tail) ? (u32)(head - tail) : 0;
+}
@@ -0,0 +1,152 @@
+/*!******************************************************************
+ * \file sensit_ring.h
+ * \brief Functions & Types to pass raw uplinks between local processes
+ * \author Sens'it Team
+ *
+ * A bounded multi-producer single-consumer ring of fixed size uplink
+ * records lives in a shared memory mapping (a file, e.g. in /dev/shm,
+ * or a memfd inherited by the other processes). Each slot carries a
+ * sequence number: producers reserve a position with a CAS on the head
+ * and publish the slot by bumping its sequence, the consumer reads
+ * published slots in order and hands them back. No lock is taken and
+ * the consumer decodes the payloads in place. A full ring drops the
+ * record and counts it. A sleeping consumer is woken with a futex.
+ * A producer dying between the reservation and the publication of a
+ * slot stalls the consumer at that slot.
+ *
+ * Linux only (memfd, futex).
+ *******************************************************************/
+
+#define RING_ERR_NONE 0x00
+#define RING_ERR_FULL 0x01
+#define RING_ERR_SIZE 0x02
+
+#define RING_MAGIC 0x474E4952 /* "RING" */
+#define RING_VERSION 1
+#define RING_PAYLOAD_SIZE (PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+#define RING_DEFAULT_CAPACITY 65536
+#define RING_CACHE_LINE 64
+
+/*!******************************************************************
+ * \struct ring_record_s
+ * \brief Raw uplink
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 time;                       /*!< Seconds since epoch */
+    u16 seq_number;
+    u8 size;                        /*!< PAYLOAD_DATA_SIZE, or RING_PAYLOAD_SIZE with the config */
+    u8 spare;
+    u8 payload[RING_PAYLOAD_SIZE];
+} ring_record_s;
+
+/*!******************************************************************
+ * \struct ring_slot_s
+ * \brief Record with its sequence number, 32 bytes
+ *******************************************************************/
+typedef struct
+{
+    u64 sequence; /*!< position: free for the producer of position, position + 1: published */
+    ring_record_s record;
+} ring_slot_s;
+
+/*!******************************************************************
+ * \struct ring_header_s
+ * \brief Shared header, producer & consumer fields on their own cache line
+ *******************************************************************/
+typedef struct
+{
+    u32 magic;
+    u32 version;
+    u32 capacity;     /*!< Power of 2 */
+    u32 slot_size;
+    u8 pad0[RING_CACHE_LINE - 16];
+    u64 head;         /*!< Next position reserved by a producer */
+    u64 overflow;     /*!< Records dropped because the ring was full */
+    u8 pad1[RING_CACHE_LINE - 16];
+    u64 tail;         /*!< Next position read by the consumer */
+    u32 waiting;      /*!< Consumer sleeping on signal */
+    u32 signal;       /*!< Futex word bumped by producers */
+    u8 pad2[RING_CACHE_LINE - 16];
+} ring_header_s;
+
+/*!******************************************************************
+ * \struct ring_s
+ * \brief Mapping of a ring in the current process
+ *******************************************************************/
+typedef struct
+{
+    ring_header_s *header;
+    ring_slot_s *slots;
+    int fd;
+    size_t size;
+} ring_s;
+
+/*!******************************************************************
+ * \fn typedef void (*ring_visit_f)(const ring_record_s *record, void *context)
+ * \brief Called on a record still in the ring
+ *******************************************************************/
+typedef void (*ring_visit_f)(const ring_record_s *record, void *context);
+
+/*!************************************************************************
+ * \fn ring_s *RING_create(const char *path, u32 capacity)
+ * \brief Create a ring in a new shared memory file, or in a memfd if
+ *        path is NULL. NULL on failure, errno is set.
+ *
+ * \param[in] capacity              Number of records, rounded up to a power of 2
+ **************************************************************************/
+ring_s *RING_create(const char *path, u32 capacity);
+
+/*!************************************************************************
+ * \fn ring_s *RING_open(const char *path)
+ * \brief Map an existing ring, e.g. /dev/shm/sensit or /proc/<pid>/fd/<fd>
+ *        for a memfd. NULL on failure or if it is not a ring.
+ **************************************************************************/
+ring_s *RING_open(const char *path);
+
+/*!************************************************************************
+ * \fn void RING_close(ring_s *ring)
+ * \brief Unmap the ring, the memory is freed with the last mapping.
+ **************************************************************************/
+void RING_close(ring_s *ring);
+
+/*!************************************************************************
+ * \fn u8 RING_push(ring_s *ring, u32 device_id, u32 time, u16 seq_number, const u8 *payload, u8 size)
+ * \brief Publish a record, safe from several threads or processes.
+ *
+ * \param[in] size                  PAYLOAD_DATA_SIZE or RING_PAYLOAD_SIZE
+ * \retval                          RING_ERR_NONE, RING_ERR_FULL (counted in overflow) or RING_ERR_SIZE
+ **************************************************************************/
+u8 RING_push(ring_s *ring, u32 device_id, u32 time, u16 seq_number, const u8 *payload, u8 size);
+
+/*!************************************************************************
+ * \fn u32 RING_drain(ring_s *ring, u32 max, ring_visit_f visit, void *context)
+ * \brief Visit up to max published records in order and free their slots.
+ *        Single consumer only.
+ *
+ * \retval                          Number of records visited
+ **************************************************************************/
+u32 RING_drain(ring_s *ring, u32 max, ring_visit_f visit, void *context);
+
+/*!************************************************************************
+ * \fn u32 RING_drain_data(ring_s *ring, u32 max, u32 *device_ids, u32 *times, data_s *data)
+ * \brief Drain up to max records decoding their payload straight from the ring.
+ *
+ * \retval                          Number of records drained
+ **************************************************************************/
+u32 RING_drain_data(ring_s *ring, u32 max, u32 *device_ids, u32 *times, data_s *data);
+
+/*!************************************************************************
+ * \fn bool RING_wait(ring_s *ring, s32 timeout_ms)
+ * \brief Sleep until a record is published, TRUE if the ring is not empty.
+ *
+ * \param[in] timeout_ms            Negative to wait forever
+ **************************************************************************/
+bool RING_wait(ring_s *ring, s32 timeout_ms);
+
+/*!************************************************************************
+ * \fn u32 RING_size(const ring_s *ring)
+ * \brief Number of records reserved and not drained yet.
+ **************************************************************************/
+u32 RING_size(const ring_s *ring);
@@ -0,0 +1,275 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include <errno.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_ring.h"
+#include "sensit_payload_node.h"
+
+class Ring : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Ring(ring_s *ring) : ring_(ring) {}
+  ~Ring() { RING_close(ring_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Push(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void PushBatch(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Drain(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Wait(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Close(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static Ring *Opened(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  ring_s *ring_;
+};
+
+// Columns filled by Drain
+struct RingColumns
+{
+  u32 *device_ids;
+  u32 *times;
+  u16 *seq_numbers;
+  u8 *sizes;
+  u8 *payloads;
+  u8 *configs;
+  u32 count;
+};
+
+static void VisitRecord(const ring_record_s *record, void *context)
+{
+  RingColumns *columns = (RingColumns *)context;
+  u32 i = columns->count++;
+
+  columns->device_ids[i] = record->device_id;
+  columns->times[i] = record->time;
+  columns->seq_numbers[i] = record->seq_number;
+  columns->sizes[i] = record->size;
+  memcpy(columns->payloads + (i * PAYLOAD_DATA_SIZE), record->payload, PAYLOAD_DATA_SIZE);
+  if (record->size == RING_PAYLOAD_SIZE)
+  {
+    memcpy(columns->configs + (i * PAYLOAD_CONFIG_SIZE), record->payload + PAYLOAD_DATA_SIZE, PAYLOAD_CONFIG_SIZE);
+  }
+}
+
+void Ring::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Ring"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "push", Push);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "pushBatch", PushBatch);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "drain", Drain);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "wait", Wait);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "close", Close);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Ring"), tpl->GetFunction());
+}
+
+void Ring::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: path or undefined for a memfd, capacity, open an existing ring
+  ring_s *ring;
+  if (args[2]->BooleanValue())
+  {
+    v8::String::Utf8Value path(args[0]);
+    ring = RING_open(*path);
+  }
+  else if (args[0]->IsString())
+  {
+    v8::String::Utf8Value path(args[0]);
+    ring = RING_create(*path, args[1]->Uint32Value());
+  }
+  else
+  {
+    ring = RING_create(NULL, args[1]->Uint32Value());
+  }
+  if (ring == NULL)
+  {
+    isolate->ThrowException(node::ErrnoException(isolate, errno, "mmap", "Unable to map the ring"));
+    return;
+  }
+
+  Ring *obj = new Ring(ring);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+Ring *Ring::Opened(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Ring *obj = node::ObjectWrap::Unwrap<Ring>(args.Holder());
+
+  if (obj->ring_ == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Ring is closed")));
+    return NULL;
+  }
+  return obj;
+}
+
+void Ring::Push(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Ring *obj = Opened(args);
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  // args: device id, time, seqNumber, Buffer of 4 or 12 bytes
+  u8 err = RING_push(obj->ring_, args[0]->Uint32Value(), args[1]->Uint32Value(), (u16)args[2]->Uint32Value(),
+                     (const u8 *)node::Buffer::Data(args[3]), (u8)node::Buffer::Length(args[3]));
+  if (err == RING_ERR_SIZE)
+  {
+    v8::Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Payload must be 4 or 12 bytes long")));
+    return;
+  }
+  args.GetReturnValue().Set(err == RING_ERR_NONE);
+}
+
+void Ring::PushBatch(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Ring *obj = Opened(args);
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  // args: Buffer payloads, size of each payload, Uint32Array device ids, Uint32Array times, Uint16Array seqNumbers
+  const u8 *payloads = (const u8 *)node::Buffer::Data(args[0]);
+  u8 size = (u8)args[1]->Uint32Value();
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[2]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[3]);
+  const u16 *seq_numbers = (const u16 *)node::Buffer::Data(args[4]);
+
+  if (size != PAYLOAD_DATA_SIZE && size != RING_PAYLOAD_SIZE)
+  {
+    v8::Isolate *isolate = args.GetIsolate();
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Payload must be 4 or 12 bytes long")));
+    return;
+  }
+
+  size_t count = node::Buffer::Length(args[0]) / size;
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[3]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[3]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[4]) / sizeof(u16))
+  {
+    count = node::Buffer::Length(args[4]) / sizeof(u16);
+  }
+
+  // Records not pushed are counted in the overflow
+  u32 pushed = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (RING_push(obj->ring_, device_ids[i], times[i], seq_numbers[i], payloads + (i * size), size) == RING_ERR_NONE)
+    {
+      pushed++;
+    }
+  }
+  args.GetReturnValue().Set(pushed);
+}
+
+void Ring::Drain(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Ring *obj = Opened(args);
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  // args: max records. One buffer holds every column, sized for what is published now
+  u32 max = args[0]->Uint32Value();
+  u32 size = RING_size(obj->ring_);
+  if (max > size)
+  {
+    max = size;
+  }
+  size_t record_size = sizeof(u32) + sizeof(u32) + PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE + sizeof(u16) + sizeof(u8);
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, max * record_size);
+  u8 *base = (u8 *)buffer->GetContents().Data();
+  memset(base, 0, max * record_size);
+
+  RingColumns columns;
+  columns.device_ids = (u32 *)base;
+  columns.times = (u32 *)(base + (max * sizeof(u32)));
+  columns.payloads = base + (max * 2 * sizeof(u32));
+  columns.configs = columns.payloads + (max * PAYLOAD_DATA_SIZE);
+  columns.seq_numbers = (u16 *)(columns.configs + (max * PAYLOAD_CONFIG_SIZE));
+  columns.sizes = (u8 *)(columns.seq_numbers + max);
+  columns.count = 0;
+  u32 count = RING_drain(obj->ring_, max, VisitRecord, &columns);
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Uint32Array::New(buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "times"), v8::Uint32Array::New(buffer, max * sizeof(u32), count));
+  // Buffers over an ArrayBuffer slice need Node 12, copy the 2 byte columns
+  res->Set(v8::String::NewFromUtf8(isolate, "payloads"),
+           node::Buffer::Copy(isolate, (const char *)columns.payloads, count * PAYLOAD_DATA_SIZE).ToLocalChecked());
+  res->Set(v8::String::NewFromUtf8(isolate, "configs"),
+           node::Buffer::Copy(isolate, (const char *)columns.configs, count * PAYLOAD_CONFIG_SIZE).ToLocalChecked());
+  res->Set(v8::String::NewFromUtf8(isolate, "seqNumbers"), v8::Uint16Array::New(buffer, (u8 *)columns.seq_numbers - base, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "sizes"), v8::Uint8Array::New(buffer, columns.sizes - base, count));
+  args.GetReturnValue().Set(res);
+}
+
+void Ring::Wait(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Ring *obj = Opened(args);
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  // args: timeout in milliseconds, negative to wait forever. Blocks the thread
+  args.GetReturnValue().Set(RING_wait(obj->ring_, args[0]->Int32Value()));
+}
+
+void Ring::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Ring *obj = Opened(args);
+  if (obj == NULL)
+  {
+    return;
+  }
+
+  const ring_header_s *header = obj->ring_->header;
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "capacity"), v8::Number::New(isolate, header->capacity));
+  res->Set(v8::String::NewFromUtf8(isolate, "size"), v8::Number::New(isolate, RING_size(obj->ring_)));
+  res->Set(v8::String::NewFromUtf8(isolate, "overflow"),
+           v8::Number::New(isolate, (double)__atomic_load_n(&(header->overflow), __ATOMIC_RELAXED)));
+  res->Set(v8::String::NewFromUtf8(isolate, "fd"), v8::Number::New(isolate, obj->ring_->fd));
+  args.GetReturnValue().Set(res);
+}
+
+void Ring::Close(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Ring *obj = node::ObjectWrap::Unwrap<Ring>(args.Holder());
+  RING_close(obj->ring_);
+  obj->ring_ = NULL;
+}
+
+void RING_node_init(v8::Local<v8::Object> exports)
+{
+  Ring::Init(exports);
+}
@@ -0,0 +1,414 @@
+/*!******************************************************************
+ * \file sensit_rules.c
+ * \brief Functions to raise threshold alerts on decoded payloads
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_rules.h"
+
+/******* DEFINE ****************************************************/
+#define RULES_MIN_DEVICES 64
+#define RULES_MIN_ROWS 256
+
+/* Factors from the config thresholds to the unit of data_s */
+#define RULES_TEMPERATURE_FACTOR 8
+#define RULES_HUMIDITY_FACTOR 2
+
+/* Classes of a value, a band is within the hysteresis of a limit */
+#define RULES_CLASS_LOW 0
+#define RULES_CLASS_LOW_BAND 1
+#define RULES_CLASS_NORMAL 2
+#define RULES_CLASS_HIGH_BAND 3
+#define RULES_CLASS_HIGH 4
+
+#define RULES_BOUND_LOW 0
+#define RULES_BOUND_LOW_BAND 1
+#define RULES_BOUND_HIGH_BAND 2
+#define RULES_BOUND_HIGH 3
+
+/*******************************************************************/
+
+static s32 RULES_add_saturate(s32 value, s32 delta)
+{
+    s64 sum = (s64)value + delta;
+    return (sum > INT32_MAX) ? INT32_MAX : ((sum < INT32_MIN) ? INT32_MIN : (s32)sum);
+}
+
+/*******************************************************************/
+
+static void RULES_reset_device(rules_device_s *device, u32 device_id)
+{
+    memset(device, 0, sizeof(rules_device_s));
+    device->device_id = device_id;
+    memset(device->state, RULES_STATE_NORMAL, RULES_MAX);
+    memset(device->pending, RULES_STATE_NORMAL, RULES_MAX);
+}
+
+/*******************************************************************/
+
+static rules_device_s *RULES_get_device(rules_engine_s *engine, u32 device_id, u32 *index)
+{
+    void *devices;
+
+    *index = DEVICES_find(&(engine->ids), device_id);
+    if (*index != DEVICES_NONE)
+    {
+        return &(engine->devices[*index]);
+    }
+
+    if (engine->device_count == engine->device_capacity)
+    {
+        devices = realloc(engine->devices, (size_t)engine->device_capacity * 2 * sizeof(rules_device_s));
+        if (devices == NULL)
+        {
+            return NULL;
+        }
+        engine->devices = (rules_device_s *)devices;
+        engine->device_capacity *= 2;
+    }
+
+    if (!DEVICES_add(&(engine->ids), device_id, engine->device_count))
+    {
+        return NULL;
+    }
+    *index = engine->device_count++;
+    RULES_reset_device(&(engine->devices[*index]), device_id);
+    return &(engine->devices[*index]);
+}
+
+/*******************************************************************/
+
+static bool RULES_grow_rows(rules_engine_s *engine, u32 count)
+{
+    u32 capacity = (engine->row_capacity == 0) ? RULES_MIN_ROWS : engine->row_capacity;
+    bool allocated;
+    u8 i;
+
+    if (count <= engine->row_capacity)
+    {
+        return TRUE;
+    }
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+
+    free(engine->rows_device);
+    free(engine->classes);
+    engine->rows_device = (u32 *)malloc((size_t)capacity * sizeof(u32));
+    engine->classes = (u8 *)malloc(capacity);
+    allocated = (engine->rows_device != NULL) && (engine->classes != NULL);
+    for (i = 0; i < RULES_FIELD_LAST; i++)
+    {
+        free(engine->values[i]);
+        free(engine->valid[i]);
+        engine->values[i] = (s32 *)malloc((size_t)capacity * sizeof(s32));
+        engine->valid[i] = (u8 *)malloc(capacity);
+        allocated = allocated && (engine->values[i] != NULL) && (engine->valid[i] != NULL);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        free(engine->bounds[i]);
+        engine->bounds[i] = (s32 *)malloc((size_t)capacity * sizeof(s32));
+        allocated = allocated && (engine->bounds[i] != NULL);
+    }
+    /* On failure the next batch retries from scratch */
+    engine->row_capacity = allocated ? capacity : 0;
+    return allocated;
+}
+
+/*******************************************************************/
+
+static bool RULES_emit(rules_engine_s *engine, u32 row, u8 rule, u8 from, u8 to)
+{
+    void *events;
+
+    if (engine->event_count == engine->event_capacity)
+    {
+        events = realloc(engine->events, (size_t)(engine->event_capacity ? engine->event_capacity * 2 : RULES_MIN_ROWS) * sizeof(rules_event_s));
+        if (events == NULL)
+        {
+            return FALSE;
+        }
+        engine->events = (rules_event_s *)events;
+        engine->event_capacity = engine->event_capacity ? engine->event_capacity * 2 : RULES_MIN_ROWS;
+    }
+    engine->events[engine->event_count].row = row;
+    engine->events[engine->event_count].rule = rule;
+    engine->events[engine->event_count].from = from;
+    engine->events[engine->event_count].to = to;
+    engine->events[engine->event_count].spare = 0;
+    engine->event_count++;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static int RULES_compare_events(const void *a, const void *b)
+{
+    const rules_event_s *left = (const rules_event_s *)a;
+    const rules_event_s *right = (const rules_event_s *)b;
+
+    if (left->row != right->row)
+    {
+        return (left->row < right->row) ? -1 : 1;
+    }
+    return (int)left->rule - (int)right->rule;
+}
+
+/*******************************************************************/
+
+rules_engine_s *RULES_create(void)
+{
+    rules_engine_s *engine = (rules_engine_s *)calloc(1, sizeof(rules_engine_s));
+
+    if (engine == NULL)
+    {
+        return NULL;
+    }
+    engine->devices = (rules_device_s *)malloc(RULES_MIN_DEVICES * sizeof(rules_device_s));
+    engine->device_capacity = RULES_MIN_DEVICES;
+    if (!DEVICES_init(&(engine->ids)) || engine->devices == NULL)
+    {
+        RULES_destroy(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+/*******************************************************************/
+
+void RULES_destroy(rules_engine_s *engine)
+{
+    u8 i;
+
+    if (engine != NULL)
+    {
+        DEVICES_free(&(engine->ids));
+        free(engine->devices);
+        free(engine->rows_device);
+        free(engine->classes);
+        for (i = 0; i < RULES_FIELD_LAST; i++)
+        {
+            free(engine->values[i]);
+            free(engine->valid[i]);
+        }
+        for (i = 0; i < 4; i++)
+        {
+            free(engine->bounds[i]);
+        }
+        free(engine->events);
+        free(engine);
+    }
+}
+
+/*******************************************************************/
+
+u8 RULES_add(rules_engine_s *engine, const rule_s *rule, u8 *index)
+{
+    if (engine->rule_count == RULES_MAX)
+    {
+        return RULES_ERR_FULL;
+    }
+    if (rule->field >= RULES_FIELD_LAST || rule->source >= RULES_SOURCE_LAST || rule->hysteresis < 0)
+    {
+        return RULES_ERR_RULE;
+    }
+    *index = engine->rule_count;
+    engine->rules[engine->rule_count++] = *rule;
+    return RULES_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 RULES_set_config(rules_engine_s *engine, u32 device_id, const config_s *config, payload_type_e type)
+{
+    u32 index;
+    rules_device_s *device = RULES_get_device(engine, device_id, &index);
+    rules_limits_s *limits;
+
+    if (device == NULL)
+    {
+        return RULES_ERR_ALLOC;
+    }
+    limits = &(device->limits);
+
+    limits->low[RULES_FIELD_TEMPERATURE] = config->temperature_low_threshold * RULES_TEMPERATURE_FACTOR;
+    limits->high[RULES_FIELD_TEMPERATURE] = config->temperature_high_threshold * RULES_TEMPERATURE_FACTOR;
+    limits->low[RULES_FIELD_BATTERY_LEVEL] = INT32_MIN;
+    limits->high[RULES_FIELD_BATTERY_LEVEL] = INT32_MAX;
+    if (type == PAYLOAD_V3)
+    {
+        limits->low[RULES_FIELD_HUMIDITY] = config->humidity_low_threshold * RULES_HUMIDITY_FACTOR;
+        limits->high[RULES_FIELD_HUMIDITY] = config->humidity_high_threshold * RULES_HUMIDITY_FACTOR;
+        /* A Sens'it v3 alerts when the light goes above its threshold in lux */
+        limits->low[RULES_FIELD_BRIGHTNESS] = INT32_MIN;
+        limits->high[RULES_FIELD_BRIGHTNESS] = config->brightness_threshold * BRIGHTNESS_THRESHOLD_FACTOR;
+    }
+    else
+    {
+        /* No humidity alert on a Sens'it v2 */
+        limits->low[RULES_FIELD_HUMIDITY] = INT32_MIN;
+        limits->high[RULES_FIELD_HUMIDITY] = INT32_MAX;
+        limits->low[RULES_FIELD_BRIGHTNESS] = config->brightness_low_threshold;
+        limits->high[RULES_FIELD_BRIGHTNESS] = config->brightness_high_threshold;
+    }
+    limits->valid = TRUE;
+    return RULES_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 RULES_evaluate(rules_engine_s *engine, u8 *data_in, u32 count, const u32 *device_ids)
+{
+    data_s data;
+    rules_device_s *device;
+    const rule_s *rule;
+    const s32 *values;
+    const u8 *valid;
+    const u8 *classes;
+    s32 low;
+    s32 low_band;
+    s32 high_band;
+    s32 high;
+    u8 next;
+    u32 index;
+    u32 i;
+    u8 r;
+    bool v2_button;
+
+    engine->event_count = 0;
+    if (!RULES_grow_rows(engine, count))
+    {
+        return RULES_ERR_ALLOC;
+    }
+
+    /* Decode into columns */
+    for (i = 0; i < count; i++)
+    {
+        memset(&data, 0, sizeof(data_s));
+        PAYLOAD_parse_data(data_in + (i * PAYLOAD_DATA_SIZE), &data);
+        device = RULES_get_device(engine, device_ids[i], &index);
+        if (device == NULL)
+        {
+            return RULES_ERR_ALLOC;
+        }
+        engine->rows_device[i] = index;
+
+        v2_button = (data.type == PAYLOAD_V2) && data.button;
+        engine->values[RULES_FIELD_TEMPERATURE][i] = data.temperature;
+        engine->values[RULES_FIELD_HUMIDITY][i] = data.humidity;
+        engine->values[RULES_FIELD_BRIGHTNESS][i] = data.brightness;
+        engine->values[RULES_FIELD_BATTERY_LEVEL][i] = data.battery_level;
+        if (data.error != PARSE_ERR_NONE)
+        {
+            engine->valid[RULES_FIELD_TEMPERATURE][i] = FALSE;
+            engine->valid[RULES_FIELD_HUMIDITY][i] = FALSE;
+            engine->valid[RULES_FIELD_BRIGHTNESS][i] = FALSE;
+            engine->valid[RULES_FIELD_BATTERY_LEVEL][i] = FALSE;
+            continue;
+        }
+        engine->valid[RULES_FIELD_TEMPERATURE][i] = (data.mode == MODE_TEMPERATURE) || v2_button;
+        engine->valid[RULES_FIELD_HUMIDITY][i] = (data.mode == MODE_TEMPERATURE) && !v2_button;
+        engine->valid[RULES_FIELD_BRIGHTNESS][i] = (data.mode == MODE_LIGHT) && !v2_button;
+        engine->valid[RULES_FIELD_BATTERY_LEVEL][i] = TRUE;
+    }
+
+    for (r = 0; r < engine->rule_count; r++)
+    {
+        rule = &(engine->rules[r]);
+        values = engine->values[rule->field];
+        valid = engine->valid[rule->field];
+        classes = engine->classes;
+
+        /* Classify the whole column, the loops have no branch */
+        if (rule->source == RULES_SOURCE_FLEET)
+        {
+            low = rule->low;
+            low_band = RULES_add_saturate(rule->low, rule->hysteresis);
+            high_band = RULES_add_saturate(rule->high, -rule->hysteresis);
+            high = rule->high;
+            for (i = 0; i < count; i++)
+            {
+                engine->classes[i] = RULES_CLASS_NORMAL + (values[i] > high) + (values[i] >= high_band) - (values[i] < low) - (values[i] <= low_band);
+            }
+        }
+        else
+        {
+            for (i = 0; i < count; i++)
+            {
+                device = &(engine->devices[engine->rows_device[i]]);
+                low = device->limits.valid ? device->limits.low[rule->field] : INT32_MIN;
+                high = device->limits.valid ? device->limits.high[rule->field] : INT32_MAX;
+                engine->bounds[RULES_BOUND_LOW][i] = low;
+                engine->bounds[RULES_BOUND_LOW_BAND][i] = (low == INT32_MIN) ? INT32_MIN : RULES_add_saturate(low, rule->hysteresis);
+                engine->bounds[RULES_BOUND_HIGH_BAND][i] = (high == INT32_MAX) ? INT32_MAX : RULES_add_saturate(high, -rule->hysteresis);
+                engine->bounds[RULES_BOUND_HIGH][i] = high;
+            }
+            for (i = 0; i < count; i++)
+            {
+                engine->classes[i] = RULES_CLASS_NORMAL + (values[i] > engine->bounds[RULES_BOUND_HIGH][i]) + (values[i] >= engine->bounds[RULES_BOUND_HIGH_BAND][i]) - (values[i] < engine->bounds[RULES_BOUND_LOW][i]) - (values[i] <= engine->bounds[RULES_BOUND_LOW_BAND][i]);
+            }
+        }
+
+        /* Hysteresis & debounce, in the order of the batch */
+        for (i = 0; i < count; i++)
+        {
+            if (!valid[i])
+            {
+                continue;
+            }
+            device = &(engine->devices[engine->rows_device[i]]);
+            switch (classes[i])
+            {
+            case RULES_CLASS_LOW:
+                next = RULES_STATE_LOW;
+                break;
+            case RULES_CLASS_LOW_BAND:
+                next = (device->state[r] == RULES_STATE_LOW) ? RULES_STATE_LOW : RULES_STATE_NORMAL;
+                break;
+            case RULES_CLASS_HIGH_BAND:
+                next = (device->state[r] == RULES_STATE_HIGH) ? RULES_STATE_HIGH : RULES_STATE_NORMAL;
+                break;
+            case RULES_CLASS_HIGH:
+                next = RULES_STATE_HIGH;
+                break;
+            default:
+                next = RULES_STATE_NORMAL;
+                break;
+            }
+
+            if (next == device->state[r])
+            {
+                device->count[r] = 0;
+                continue;
+            }
+            if (next != device->pending[r] || device->count[r] == 0)
+            {
+                device->pending[r] = next;
+                device->count[r] = 0;
+            }
+            device->count[r]++;
+            if (device->count[r] >= rule->debounce)
+            {
+                if (!RULES_emit(engine, i, r, device->state[r], next))
+                {
+                    return RULES_ERR_ALLOC;
+                }
+                device->state[r] = next;
+                device->count[r] = 0;
+            }
+        }
+    }
+
+    /* Rules are evaluated one after the other, give the events in the order of the batch */
+    qsort(engine->events, engine->event_count, sizeof(rules_event_s), RULES_compare_events);
+    return RULES_ERR_NONE;
+}
+
+/*******************************************************************/
@@ -0,0 +1,166 @@
+/*!******************************************************************
+ * \file sensit_rules.h
+ * \brief Functions & Types to raise threshold alerts on decoded payloads
+ * \author Sens'it Team
+ *
+ * A rule compares a field of data_s with a low and a high limit, either
+ * fleet wide or taken from the last config of each device (the
+ * thresholds the device itself alerts on). A batch is decoded into
+ * columns, every rule classifies a column in a branch free loop, then a
+ * short per device pass applies hysteresis and debounce and only emits
+ * state transitions.
+ *******************************************************************/
+
+#define RULES_ERR_NONE 0x00
+#define RULES_ERR_ALLOC 0x01
+#define RULES_ERR_FULL 0x02
+#define RULES_ERR_RULE 0x03
+
+#define RULES_MAX 16
+
+/*!******************************************************************
+ * \enum rules_field_e
+ * \brief Fields of data_s a rule can watch, in the unit of data_s
+ *******************************************************************/
+typedef enum {
+    RULES_FIELD_TEMPERATURE,   /*!< Mode TEMPERATURE, 1/8 °C */
+    RULES_FIELD_HUMIDITY,      /*!< Mode TEMPERATURE, 1/2 % */
+    RULES_FIELD_BRIGHTNESS,    /*!< Mode LIGHT, 1/96 lux */
+    RULES_FIELD_BATTERY_LEVEL, /*!< All modes, mV */
+    RULES_FIELD_LAST
+} rules_field_e;
+
+/*!******************************************************************
+ * \enum rules_source_e
+ * \brief Origin of the limits of a rule
+ *******************************************************************/
+typedef enum {
+    RULES_SOURCE_FLEET,  /*!< low & high of the rule */
+    RULES_SOURCE_CONFIG, /*!< Thresholds of the last config of the device */
+    RULES_SOURCE_LAST
+} rules_source_e;
+
+/*!******************************************************************
+ * \enum rules_state_e
+ * \brief State of a rule for a device
+ *******************************************************************/
+typedef enum {
+    RULES_STATE_LOW,
+    RULES_STATE_NORMAL,
+    RULES_STATE_HIGH,
+    RULES_STATE_LAST
+} rules_state_e;
+
+/*!******************************************************************
+ * \struct rule_s
+ * \brief Rule definition, limits are inclusive
+ *******************************************************************/
+typedef struct
+{
+    rules_field_e field;
+    rules_source_e source;
+    s32 low;        /*!< RULES_SOURCE_FLEET: below is LOW, INT32_MIN to disable */
+    s32 high;       /*!< RULES_SOURCE_FLEET: above is HIGH, INT32_MAX to disable */
+    s32 hysteresis; /*!< Distance to go back inside a limit to return to NORMAL */
+    u8 debounce;    /*!< Consecutive samples required to change state, 0 or 1 for none */
+} rule_s;
+
+/*!******************************************************************
+ * \struct rules_limits_s
+ * \brief Limits of a device taken from its config
+ *******************************************************************/
+typedef struct
+{
+    s32 low[RULES_FIELD_LAST];
+    s32 high[RULES_FIELD_LAST];
+    bool valid; /*!< FALSE until a config was set */
+} rules_limits_s;
+
+/*!******************************************************************
+ * \struct rules_device_s
+ * \brief State of every rule for a device
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u8 state[RULES_MAX];   /*!< rules_state_e */
+    u8 pending[RULES_MAX]; /*!< State waiting for debounce */
+    u8 count[RULES_MAX];   /*!< Consecutive samples in pending */
+    rules_limits_s limits;
+} rules_device_s;
+
+/*!******************************************************************
+ * \struct rules_event_s
+ * \brief State transition
+ *******************************************************************/
+typedef struct
+{
+    u32 row;  /*!< Index of the payload in the batch */
+    u8 rule;
+    u8 from;  /*!< rules_state_e */
+    u8 to;    /*!< rules_state_e */
+    u8 spare;
+} rules_event_s;
+
+/*!******************************************************************
+ * \struct rules_engine_s
+ * \brief Rules, device states and scratch columns of a batch
+ *******************************************************************/
+typedef struct
+{
+    rule_s rules[RULES_MAX];
+    u32 rule_count;
+    devices_s ids;            /*!< Index in devices of each device id */
+    rules_device_s *devices;
+    u32 device_count;
+    u32 device_capacity;
+    /* Scratch columns, grown to the largest batch */
+    u32 row_capacity;
+    u32 *rows_device;         /*!< Index in devices of each row */
+    s32 *values[RULES_FIELD_LAST];
+    u8 *valid[RULES_FIELD_LAST];
+    s32 *bounds[4];           /*!< low, low band, high band & high of a config rule */
+    u8 *classes;
+    rules_event_s *events;
+    u32 event_count;
+    u32 event_capacity;
+} rules_engine_s;
+
+/*!************************************************************************
+ * \fn rules_engine_s *RULES_create(void)
+ * \brief Allocate an engine without rules, NULL if the allocation failed.
+ **************************************************************************/
+rules_engine_s *RULES_create(void);
+
+/*!************************************************************************
+ * \fn void RULES_destroy(rules_engine_s *engine)
+ **************************************************************************/
+void RULES_destroy(rules_engine_s *engine);
+
+/*!************************************************************************
+ * \fn u8 RULES_add(rules_engine_s *engine, const rule_s *rule, u8 *index)
+ * \brief Add a rule, devices already known start in RULES_STATE_NORMAL.
+ *
+ * \param[out] index                Index of the rule in the events
+ * \retval                          RULES_ERR_NONE, RULES_ERR_FULL or RULES_ERR_RULE
+ **************************************************************************/
+u8 RULES_add(rules_engine_s *engine, const rule_s *rule, u8 *index);
+
+/*!************************************************************************
+ * \fn u8 RULES_set_config(rules_engine_s *engine, u32 device_id, const config_s *config, payload_type_e type)
+ * \brief Take the limits of the RULES_SOURCE_CONFIG rules of a device from its config.
+ *
+ * \retval                          RULES_ERR_NONE or RULES_ERR_ALLOC
+ **************************************************************************/
+u8 RULES_set_config(rules_engine_s *engine, u32 device_id, const config_s *config, payload_type_e type);
+
+/*!************************************************************************
+ * \fn u8 RULES_evaluate(rules_engine_s *engine, u8 *data_in, u32 count, const u32 *device_ids)
+ * \brief Decode a batch of payloads and evaluate every rule on it, the
+ *        transitions are left in engine->events.
+ *
+ * \param[in] data_in               count payloads of PAYLOAD_DATA_SIZE length
+ * \param[in] device_ids            Device of each payload
+ * \retval                          RULES_ERR_NONE or RULES_ERR_ALLOC
+ **************************************************************************/
+u8 RULES_evaluate(rules_engine_s *engine, u8 *data_in, u32 count, const u32 *device_ids);
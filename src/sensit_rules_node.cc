@@ -0,0 +1,150 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_rules.h"
+#include "sensit_payload_node.h"
+
+class RuleEngine : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit RuleEngine(rules_engine_s *engine) : engine_(engine) {}
+  ~RuleEngine() { RULES_destroy(engine_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void AddRule(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void SetConfig(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Evaluate(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  rules_engine_s *engine_;
+};
+
+void RuleEngine::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "RuleEngine"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "addRule", AddRule);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "setConfig", SetConfig);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "evaluate", Evaluate);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "RuleEngine"), tpl->GetFunction());
+}
+
+void RuleEngine::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  rules_engine_s *engine = RULES_create();
+  if (engine == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the rule engine")));
+    return;
+  }
+
+  RuleEngine *obj = new RuleEngine(engine);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void RuleEngine::AddRule(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  RuleEngine *obj = node::ObjectWrap::Unwrap<RuleEngine>(args.Holder());
+
+  // args: field, source, low, high, hysteresis, debounce. Limits are in the unit of data_s
+  rule_s rule;
+  rule.field = (rules_field_e)args[0]->Uint32Value();
+  rule.source = (rules_source_e)args[1]->Uint32Value();
+  rule.low = args[2]->Int32Value();
+  rule.high = args[3]->Int32Value();
+  rule.hysteresis = args[4]->Int32Value();
+  rule.debounce = (u8)args[5]->Uint32Value();
+
+  u8 index;
+  u8 err = RULES_add(obj->engine_, &rule, &index);
+  if (err == RULES_ERR_FULL)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Too many rules")));
+    return;
+  }
+  if (err != RULES_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Invalid rule")));
+    return;
+  }
+  args.GetReturnValue().Set(index);
+}
+
+void RuleEngine::SetConfig(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  RuleEngine *obj = node::ObjectWrap::Unwrap<RuleEngine>(args.Holder());
+
+  // args: device id, Buffer config, payload type
+  u8 *config_in = (u8 *)node::Buffer::Data(args[1]);
+  payload_type_e type = (args[2]->NumberValue() == 3) ? PAYLOAD_V3 : PAYLOAD_V2;
+  config_s config = {};
+  PAYLOAD_parse_config(config_in, type, &config);
+
+  if (RULES_set_config(obj->engine_, args[0]->Uint32Value(), &config, type) != RULES_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the rule engine")));
+  }
+}
+
+void RuleEngine::Evaluate(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  RuleEngine *obj = node::ObjectWrap::Unwrap<RuleEngine>(args.Holder());
+
+  // args: Buffer payloads, Uint32Array device ids
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+
+  if (RULES_evaluate(obj->engine_, payloads, count, device_ids) != RULES_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the rule engine")));
+    return;
+  }
+
+  // One column per event field
+  u32 event_count = obj->engine_->event_count;
+  v8::Local<v8::ArrayBuffer> rows_buffer = v8::ArrayBuffer::New(isolate, event_count * sizeof(u32));
+  v8::Local<v8::ArrayBuffer> rules_buffer = v8::ArrayBuffer::New(isolate, event_count * 3);
+  u32 *rows = (u32 *)rows_buffer->GetContents().Data();
+  u8 *rules = (u8 *)rules_buffer->GetContents().Data();
+  for (u32 i = 0; i < event_count; i++)
+  {
+    rows[i] = obj->engine_->events[i].row;
+    rules[i] = obj->engine_->events[i].rule;
+    rules[event_count + i] = obj->engine_->events[i].from;
+    rules[(2 * event_count) + i] = obj->engine_->events[i].to;
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "rows"), v8::Uint32Array::New(rows_buffer, 0, event_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "rules"), v8::Uint8Array::New(rules_buffer, 0, event_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "from"), v8::Uint8Array::New(rules_buffer, event_count, event_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "to"), v8::Uint8Array::New(rules_buffer, 2 * event_count, event_count));
+  args.GetReturnValue().Set(res);
+}
+
+void RULES_node_init(v8::Local<v8::Object> exports)
+{
+  RuleEngine::Init(exports);
+}
@@ -0,0 +1,607 @@
+/*!******************************************************************
+ * \file sensit_series.c
+ * \brief Functions to store decoded values as compressed series
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_series.h"
+
+/******* DEFINE ****************************************************/
+#define BATTERY_OFFSET 2700
+#define BATTERY_STEP 50
+
+#define SERIES_WIDTH_MAX 32
+#define SERIES_STORE_MIN_SLOTS 64
+
+#define SERIES_ZIGZAG(value) ((u32)(((u32)(value) << 1) ^ (u32)((s32)(value) >> 31)))
+#define SERIES_UNZIGZAG(value) ((s32)(((value) >> 1) ^ (0U - ((value) & 1))))
+#define SERIES_WORDS(count, width) ((((u64)(count) * (width)) + 63) / 64)
+
+/*!******************************************************************
+ * \struct series_header_s
+ * \brief Encoded block header, followed by the packed time
+ *        delta-of-deltas then the packed value deltas
+ *******************************************************************/
+typedef struct
+{
+    u16 count;
+    u8 time_width;
+    u8 value_width;
+    u32 first_time;
+    s32 first_delta; /*!< Second time minus the first one */
+    s32 first_value;
+} series_header_s;
+
+typedef void (*series_unpack_f)(const u64 *in, u32 count, u32 *out);
+
+/******* BIT PACKING ***********************************************/
+
+static u8 SERIES_width(u32 max)
+{
+    u8 width = 0;
+
+    while (width < SERIES_WIDTH_MAX && (max >> width) != 0)
+    {
+        width++;
+    }
+    return width;
+}
+
+static void SERIES_pack(const u32 *in, u32 count, u8 width, u64 *out)
+{
+    u64 bit = 0;
+    u32 word;
+    u32 shift;
+    u32 i;
+
+    memset(out, 0, SERIES_WORDS(count, width) * sizeof(u64));
+    if (width == 0)
+    {
+        return;
+    }
+    for (i = 0; i < count; i++, bit += width)
+    {
+        word = (u32)(bit >> 6);
+        shift = (u32)(bit & 63);
+        out[word] |= (u64)in[i] << shift;
+        if (shift + width > 64)
+        {
+            out[word + 1] |= (u64)in[i] >> (64 - shift);
+        }
+    }
+}
+
+/* One unpacker per width: shifts & masks are constants the compiler can vectorize */
+template <u8 WIDTH>
+static void SERIES_unpack(const u64 *in, u32 count, u32 *out)
+{
+    const u64 mask = (WIDTH == 0) ? 0 : (~0ULL >> (64 - WIDTH));
+    u64 bit;
+    u64 value;
+    u32 shift;
+    u32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        bit = (u64)i * WIDTH;
+        shift = (u32)(bit & 63);
+        value = in[bit >> 6] >> shift;
+        if (WIDTH > 1 && shift + WIDTH > 64)
+        {
+            value |= in[(bit >> 6) + 1] << (64 - shift);
+        }
+        out[i] = (u32)(value & mask);
+    }
+}
+
+template <>
+void SERIES_unpack<0>(const u64 *in, u32 count, u32 *out)
+{
+    (void)in;
+    memset(out, 0, count * sizeof(u32));
+}
+
+static const series_unpack_f SERIES_UNPACK[SERIES_WIDTH_MAX + 1] = {
+    SERIES_unpack<0>, SERIES_unpack<1>, SERIES_unpack<2>, SERIES_unpack<3>,
+    SERIES_unpack<4>, SERIES_unpack<5>, SERIES_unpack<6>, SERIES_unpack<7>,
+    SERIES_unpack<8>, SERIES_unpack<9>, SERIES_unpack<10>, SERIES_unpack<11>,
+    SERIES_unpack<12>, SERIES_unpack<13>, SERIES_unpack<14>, SERIES_unpack<15>,
+    SERIES_unpack<16>, SERIES_unpack<17>, SERIES_unpack<18>, SERIES_unpack<19>,
+    SERIES_unpack<20>, SERIES_unpack<21>, SERIES_unpack<22>, SERIES_unpack<23>,
+    SERIES_unpack<24>, SERIES_unpack<25>, SERIES_unpack<26>, SERIES_unpack<27>,
+    SERIES_unpack<28>, SERIES_unpack<29>, SERIES_unpack<30>, SERIES_unpack<31>,
+    SERIES_unpack<32>};
+
+/******* SERIES ****************************************************/
+
+void SERIES_init(series_s *series)
+{
+    memset(series, 0, sizeof(series_s));
+}
+
+/*******************************************************************/
+
+void SERIES_free(series_s *series)
+{
+    free(series->data);
+    free(series->blocks);
+    free(series->pending_times);
+    free(series->pending_values);
+    SERIES_init(series);
+}
+
+/*******************************************************************/
+
+static bool SERIES_reserve(series_s *series, u32 size)
+{
+    u8 *data;
+    series_block_s *blocks;
+    u32 capacity;
+
+    if (series->size + size > series->capacity)
+    {
+        capacity = series->capacity ? series->capacity : 256;
+        while (series->size + size > capacity)
+        {
+            capacity *= 2;
+        }
+        data = (u8 *)realloc(series->data, capacity);
+        if (data == NULL)
+        {
+            return FALSE;
+        }
+        series->data = data;
+        series->capacity = capacity;
+    }
+
+    if (series->block_count == series->block_capacity)
+    {
+        capacity = series->block_capacity ? series->block_capacity * 2 : 4;
+        blocks = (series_block_s *)realloc(series->blocks, capacity * sizeof(series_block_s));
+        if (blocks == NULL)
+        {
+            return FALSE;
+        }
+        series->blocks = blocks;
+        series->block_capacity = capacity;
+    }
+    return TRUE;
+}
+
+/*******************************************************************/
+
+u8 SERIES_flush(series_s *series)
+{
+    u32 time_deltas[SERIES_BLOCK_SIZE];
+    u32 value_deltas[SERIES_BLOCK_SIZE];
+    u32 count = series->pending_count;
+    u32 time_max = 0;
+    u32 value_max = 0;
+    u32 size;
+    u32 i;
+    u32 min_index;
+    u32 max_index;
+    series_header_s header;
+    series_block_s *block;
+
+    if (count == 0)
+    {
+        return SERIES_ERR_NONE;
+    }
+
+    for (i = 2; i < count; i++)
+    {
+        time_deltas[i - 2] = SERIES_ZIGZAG((s32)(series->pending_times[i] - series->pending_times[i - 1]) -
+                                           (s32)(series->pending_times[i - 1] - series->pending_times[i - 2]));
+        time_max |= time_deltas[i - 2];
+    }
+    for (i = 1; i < count; i++)
+    {
+        value_deltas[i - 1] = SERIES_ZIGZAG(series->pending_values[i] - series->pending_values[i - 1]);
+        value_max |= value_deltas[i - 1];
+    }
+
+    header.count = (u16)count;
+    header.time_width = SERIES_width(time_max);
+    header.value_width = SERIES_width(value_max);
+    header.first_time = series->pending_times[0];
+    header.first_delta = (count > 1) ? (s32)(series->pending_times[1] - series->pending_times[0]) : 0;
+    header.first_value = series->pending_values[0];
+
+    size = SERIES_BLOCK_HEADER_SIZE;
+    size += (u32)SERIES_WORDS(count > 2 ? count - 2 : 0, header.time_width) * 8;
+    size += (u32)SERIES_WORDS(count - 1, header.value_width) * 8;
+    if (!SERIES_reserve(series, size))
+    {
+        return SERIES_ERR_ALLOC;
+    }
+
+    block = &(series->blocks[series->block_count++]);
+    block->first_time = series->pending_times[0];
+    block->last_time = series->pending_times[count - 1];
+    block->offset = series->size;
+    block->count = count;
+    /* Strict comparisons keep the first sample of the lowest & highest values */
+    min_index = 0;
+    max_index = 0;
+    for (i = 1; i < count; i++)
+    {
+        min_index = (series->pending_values[i] < series->pending_values[min_index]) ? i : min_index;
+        max_index = (series->pending_values[i] > series->pending_values[max_index]) ? i : max_index;
+    }
+    block->min = series->pending_values[min_index];
+    block->max = series->pending_values[max_index];
+    block->min_time = series->pending_times[min_index];
+    block->max_time = series->pending_times[max_index];
+
+    memcpy(series->data + series->size, &header, SERIES_BLOCK_HEADER_SIZE);
+    series->size += SERIES_BLOCK_HEADER_SIZE;
+    SERIES_pack(time_deltas, count > 2 ? count - 2 : 0, header.time_width, (u64 *)(series->data + series->size));
+    series->size += (u32)SERIES_WORDS(count > 2 ? count - 2 : 0, header.time_width) * 8;
+    SERIES_pack(value_deltas, count - 1, header.value_width, (u64 *)(series->data + series->size));
+    series->size += (u32)SERIES_WORDS(count - 1, header.value_width) * 8;
+
+    series->pending_count = 0;
+    return SERIES_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 SERIES_append(series_s *series, u32 time, s32 value)
+{
+    u32 last_time;
+
+    if (series->pending_count > 0)
+    {
+        last_time = series->pending_times[series->pending_count - 1];
+    }
+    else if (series->block_count > 0)
+    {
+        last_time = series->blocks[series->block_count - 1].last_time;
+    }
+    else
+    {
+        last_time = 0;
+    }
+    if (time < last_time)
+    {
+        return SERIES_ERR_ORDER;
+    }
+
+    if (series->pending_times == NULL)
+    {
+        series->pending_times = (u32 *)malloc(SERIES_BLOCK_SIZE * sizeof(u32));
+        series->pending_values = (s32 *)malloc(SERIES_BLOCK_SIZE * sizeof(s32));
+        if (series->pending_times == NULL || series->pending_values == NULL)
+        {
+            return SERIES_ERR_ALLOC;
+        }
+    }
+
+    series->pending_times[series->pending_count] = time;
+    series->pending_values[series->pending_count] = value;
+    series->pending_count++;
+    series->sample_count++;
+
+    if (series->pending_count == SERIES_BLOCK_SIZE)
+    {
+        return SERIES_flush(series);
+    }
+    return SERIES_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u32 SERIES_seek(const series_s *series, u32 time)
+{
+    u32 low = 0;
+    u32 high = series->block_count;
+    u32 middle;
+
+    while (low < high)
+    {
+        middle = low + (high - low) / 2;
+        if (series->blocks[middle].last_time < time)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*******************************************************************/
+
+u32 SERIES_decode_block(const series_s *series, u32 block, u32 *times, s32 *values)
+{
+    series_header_s header;
+    const u8 *cursor = series->data + series->blocks[block].offset;
+    u32 deltas[SERIES_BLOCK_SIZE];
+    s32 delta;
+    u32 i;
+
+    memcpy(&header, cursor, SERIES_BLOCK_HEADER_SIZE);
+    cursor += SERIES_BLOCK_HEADER_SIZE;
+
+    times[0] = header.first_time;
+    if (header.count > 1)
+    {
+        times[1] = header.first_time + header.first_delta;
+    }
+    if (header.count > 2)
+    {
+        SERIES_UNPACK[header.time_width]((const u64 *)cursor, header.count - 2, deltas);
+        cursor += SERIES_WORDS(header.count - 2, header.time_width) * 8;
+        delta = header.first_delta;
+        for (i = 2; i < header.count; i++)
+        {
+            delta += SERIES_UNZIGZAG(deltas[i - 2]);
+            times[i] = times[i - 1] + delta;
+        }
+    }
+
+    values[0] = header.first_value;
+    if (header.count > 1)
+    {
+        SERIES_UNPACK[header.value_width]((const u64 *)cursor, header.count - 1, deltas);
+        for (i = 1; i < header.count; i++)
+        {
+            values[i] = values[i - 1] + SERIES_UNZIGZAG(deltas[i - 1]);
+        }
+    }
+    return header.count;
+}
+
+/*******************************************************************/
+
+u32 SERIES_read(const series_s *series, u32 from, u32 to, u32 *times, s32 *values, u32 max)
+{
+    u32 block_times[SERIES_BLOCK_SIZE];
+    s32 block_values[SERIES_BLOCK_SIZE];
+    u32 block;
+    u32 count;
+    u32 read = 0;
+    u32 i;
+
+    for (block = SERIES_seek(series, from); block < series->block_count && series->blocks[block].first_time <= to; block++)
+    {
+        count = SERIES_decode_block(series, block, block_times, block_values);
+        for (i = 0; i < count && read < max; i++)
+        {
+            if (block_times[i] >= from && block_times[i] <= to)
+            {
+                times[read] = block_times[i];
+                values[read] = block_values[i];
+                read++;
+            }
+        }
+    }
+
+    for (i = 0; i < series->pending_count && read < max; i++)
+    {
+        if (series->pending_times[i] >= from && series->pending_times[i] <= to)
+        {
+            times[read] = series->pending_times[i];
+            values[read] = series->pending_values[i];
+            read++;
+        }
+    }
+    return read;
+}
+
+/******* STORE *****************************************************/
+
+static bool SERIES_STORE_alloc(series_store_s *store, u32 slot_count)
+{
+    store->keys = (u64 *)calloc(slot_count, sizeof(u64));
+    store->series = (series_s *)calloc((size_t)slot_count * SERIES_FIELD_LAST, sizeof(series_s));
+    store->slot_count = slot_count;
+    return store->keys != NULL && store->series != NULL;
+}
+
+static u32 SERIES_STORE_slot(const series_store_s *store, u64 key)
+{
+    u32 hash = (u32)key * 0x9E3779B1;
+    u32 slot = (hash ^ (hash >> 16)) & (store->slot_count - 1);
+
+    while (store->keys[slot] != 0 && store->keys[slot] != key)
+    {
+        slot = (slot + 1) & (store->slot_count - 1);
+    }
+    return slot;
+}
+
+static bool SERIES_STORE_grow(series_store_s *store)
+{
+    series_store_s grown;
+    u32 slot;
+    u32 i;
+
+    if (!SERIES_STORE_alloc(&grown, store->slot_count * 2))
+    {
+        free(grown.keys);
+        free(grown.series);
+        return FALSE;
+    }
+    for (i = 0; i < store->slot_count; i++)
+    {
+        if (store->keys[i] != 0)
+        {
+            slot = SERIES_STORE_slot(&grown, store->keys[i]);
+            grown.keys[slot] = store->keys[i];
+            memcpy(&(grown.series[slot * SERIES_FIELD_LAST]), &(store->series[i * SERIES_FIELD_LAST]), SERIES_FIELD_LAST * sizeof(series_s));
+        }
+    }
+    free(store->keys);
+    free(store->series);
+    store->keys = grown.keys;
+    store->series = grown.series;
+    store->slot_count = grown.slot_count;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+series_store_s *SERIES_STORE_create(void)
+{
+    series_store_s *store = (series_store_s *)calloc(1, sizeof(series_store_s));
+
+    if (store == NULL)
+    {
+        return NULL;
+    }
+    if (!SERIES_STORE_alloc(store, SERIES_STORE_MIN_SLOTS))
+    {
+        SERIES_STORE_destroy(store);
+        return NULL;
+    }
+    return store;
+}
+
+/*******************************************************************/
+
+void SERIES_STORE_destroy(series_store_s *store)
+{
+    u32 i;
+
+    if (store == NULL)
+    {
+        return;
+    }
+    if (store->keys != NULL && store->series != NULL)
+    {
+        for (i = 0; i < store->slot_count * SERIES_FIELD_LAST; i++)
+        {
+            SERIES_free(&(store->series[i]));
+        }
+    }
+    free(store->keys);
+    free(store->series);
+    free(store);
+}
+
+/*******************************************************************/
+
+series_s *SERIES_STORE_get(series_store_s *store, u32 device_id, series_field_e field, bool create)
+{
+    u64 key = SERIES_STORE_KEY(device_id);
+    u32 slot = SERIES_STORE_slot(store, key);
+
+    if (store->keys[slot] == 0)
+    {
+        if (!create)
+        {
+            return NULL;
+        }
+        if ((store->device_count + 1) * 2 > store->slot_count)
+        {
+            if (!SERIES_STORE_grow(store))
+            {
+                return NULL;
+            }
+            slot = SERIES_STORE_slot(store, key);
+        }
+        store->keys[slot] = key;
+        store->device_count++;
+    }
+    return &(store->series[slot * SERIES_FIELD_LAST + field]);
+}
+
+/*******************************************************************/
+
+static u8 SERIES_STORE_append(series_store_s *store, u32 device_id, series_field_e field, u32 time, s32 value)
+{
+    series_s *series = SERIES_STORE_get(store, device_id, field, TRUE);
+
+    if (series == NULL)
+    {
+        return SERIES_ERR_ALLOC;
+    }
+    return SERIES_append(series, time, value);
+}
+
+/*******************************************************************/
+
+u8 SERIES_STORE_append_data(series_store_s *store, u32 device_id, u32 time, const data_s *data)
+{
+    u8 err;
+    bool v2_button = (data->type == PAYLOAD_V2) && data->button;
+
+    if (data->error != PARSE_ERR_NONE)
+    {
+        return SERIES_ERR_NONE;
+    }
+
+    err = SERIES_STORE_append(store, device_id, SERIES_FIELD_BATTERY_LEVEL, time, (data->battery_level - BATTERY_OFFSET) / BATTERY_STEP);
+
+    if (err == SERIES_ERR_NONE && data->mode == MODE_TEMPERATURE)
+    {
+        err = SERIES_STORE_append(store, device_id, SERIES_FIELD_TEMPERATURE, time, data->temperature);
+        if (err == SERIES_ERR_NONE && !v2_button)
+        {
+            err = SERIES_STORE_append(store, device_id, SERIES_FIELD_HUMIDITY, time, data->humidity);
+        }
+    }
+    else if (err == SERIES_ERR_NONE && data->mode == MODE_LIGHT && !v2_button)
+    {
+        err = SERIES_STORE_append(store, device_id, SERIES_FIELD_BRIGHTNESS, time, data->brightness);
+    }
+    else if (err == SERIES_ERR_NONE && !v2_button &&
+             (data->mode == MODE_DOOR || data->mode == MODE_VIBRATION || data->mode == MODE_MAGNET))
+    {
+        err = SERIES_STORE_append(store, device_id, SERIES_FIELD_EVENT_COUNTER, time, data->event_counter);
+    }
+    return err;
+}
+
+/*******************************************************************/
+
+u8 SERIES_STORE_flush(series_store_s *store)
+{
+    u8 err = SERIES_ERR_NONE;
+    u32 i;
+
+    for (i = 0; i < store->slot_count * SERIES_FIELD_LAST && err == SERIES_ERR_NONE; i++)
+    {
+        err = SERIES_flush(&(store->series[i]));
+    }
+    return err;
+}
+
+/*******************************************************************/
+
+void SERIES_STORE_size(const series_store_s *store, u64 *samples, u64 *encoded_size, u64 *encoded_samples)
+{
+    const series_s *series;
+    u32 i;
+
+    *samples = 0;
+    *encoded_size = 0;
+    *encoded_samples = 0;
+    for (i = 0; i < store->slot_count * SERIES_FIELD_LAST; i++)
+    {
+        series = &(store->series[i]);
+        *samples += series->sample_count;
+        *encoded_size += series->size;
+        *encoded_samples += series->sample_count - series->pending_count;
+    }
+}
+
+/*******************************************************************/
+
+s32 SERIES_STORE_to_value(series_field_e field, s32 stored)
+{
+    if (field == SERIES_FIELD_BATTERY_LEVEL)
+    {
+        return (stored * BATTERY_STEP) + BATTERY_OFFSET;
+    }
+    return stored;
+}
+
+/*******************************************************************/
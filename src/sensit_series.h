@@ -0,0 +1,177 @@
+/*!******************************************************************
+ * \file sensit_series.h
+ * \brief Functions & Types to store decoded values as compressed series
+ * \author Sens'it Team
+ *
+ * A series holds (time, value) samples of one field of one device.
+ * Samples are encoded by blocks of SERIES_BLOCK_SIZE:
+ *  - times as delta-of-delta, periodic uplinks give values close to 0
+ *  - values as zig-zag deltas
+ * both bit packed with the smallest width of the block. A block index
+ * (first & last time, lowest & highest value) allows to seek a block
+ * without decoding the previous ones, and to downsample a range without
+ * decoding the blocks that fall within a single bucket.
+ *******************************************************************/
+
+#define SERIES_ERR_NONE 0x00
+#define SERIES_ERR_ALLOC 0x01
+#define SERIES_ERR_ORDER 0x02
+
+#define SERIES_BLOCK_SIZE 64
+#define SERIES_BLOCK_HEADER_SIZE 16
+
+#define SERIES_STORE_KEY(device_id) ((u64)(device_id) | 0x100000000ULL)
+
+/*!******************************************************************
+ * \enum series_field_e
+ * \brief Fields of data_s stored as series
+ *******************************************************************/
+typedef enum {
+    SERIES_FIELD_TEMPERATURE,   /*!< Must be divided by 8 to get in °C */
+    SERIES_FIELD_HUMIDITY,      /*!< Must be divided by 2 to get in % */
+    SERIES_FIELD_BRIGHTNESS,    /*!< Must be divided by 96 to get in lux */
+    SERIES_FIELD_BATTERY_LEVEL, /*!< Value in mV, stored as 5 bits steps */
+    SERIES_FIELD_EVENT_COUNTER,
+    SERIES_FIELD_LAST
+} series_field_e;
+
+/*!******************************************************************
+ * \struct series_block_s
+ * \brief Block index entry
+ *******************************************************************/
+typedef struct
+{
+    u32 first_time;
+    u32 last_time;
+    u32 offset;   /*!< Offset of the block in series_s.data */
+    u32 count;
+    s32 min;      /*!< Lowest value of the block */
+    s32 max;
+    u32 min_time; /*!< Time of the first sample with the lowest value */
+    u32 max_time;
+} series_block_s;
+
+/*!******************************************************************
+ * \struct series_s
+ * \brief Compressed series with its block being encoded
+ *******************************************************************/
+typedef struct
+{
+    u8 *data;               /*!< Encoded blocks, 8 bytes aligned */
+    u32 size;
+    u32 capacity;
+    series_block_s *blocks; /*!< Block index, sorted by time */
+    u32 block_count;
+    u32 block_capacity;
+    u32 *pending_times;     /*!< Samples of the current block, allocated on first append */
+    s32 *pending_values;
+    u32 pending_count;
+    u32 sample_count;
+} series_s;
+
+/*!******************************************************************
+ * \struct series_store_s
+ * \brief Series of every field of every device
+ *******************************************************************/
+typedef struct
+{
+    u64 *keys;          /*!< Open addressing table of SERIES_STORE_KEY(device id), 0 is a free slot */
+    series_s *series;   /*!< SERIES_FIELD_LAST series per slot */
+    u32 slot_count;     /*!< Power of 2 */
+    u32 device_count;
+} series_store_s;
+
+/*!************************************************************************
+ * \fn void SERIES_init(series_s *series)
+ * \brief Initialize an empty series.
+ **************************************************************************/
+void SERIES_init(series_s *series);
+
+/*!************************************************************************
+ * \fn void SERIES_free(series_s *series)
+ * \brief Free the memory held by a series.
+ **************************************************************************/
+void SERIES_free(series_s *series);
+
+/*!************************************************************************
+ * \fn u8 SERIES_append(series_s *series, u32 time, s32 value)
+ * \brief Append a sample, a block is encoded every SERIES_BLOCK_SIZE samples.
+ *
+ * \param[in] time                  Seconds, not lower than the previous one
+ * \param[in] value                 Value in the fixed point unit of the field
+ * \retval                          SERIES_ERR_NONE, SERIES_ERR_ALLOC or SERIES_ERR_ORDER
+ **************************************************************************/
+u8 SERIES_append(series_s *series, u32 time, s32 value);
+
+/*!************************************************************************
+ * \fn u8 SERIES_flush(series_s *series)
+ * \brief Encode the pending samples as a shorter block.
+ **************************************************************************/
+u8 SERIES_flush(series_s *series);
+
+/*!************************************************************************
+ * \fn u32 SERIES_seek(const series_s *series, u32 time)
+ * \brief Find the first block holding samples at or after time.
+ *
+ * \retval                          Block index, block_count if none
+ **************************************************************************/
+u32 SERIES_seek(const series_s *series, u32 time);
+
+/*!************************************************************************
+ * \fn u32 SERIES_decode_block(const series_s *series, u32 block, u32 *times, s32 *values)
+ * \brief Decode one block.
+ *
+ * \param[out] times                At least SERIES_BLOCK_SIZE entries
+ * \param[out] values               At least SERIES_BLOCK_SIZE entries
+ * \retval                          Number of samples decoded
+ **************************************************************************/
+u32 SERIES_decode_block(const series_s *series, u32 block, u32 *times, s32 *values);
+
+/*!************************************************************************
+ * \fn u32 SERIES_read(const series_s *series, u32 from, u32 to, u32 *times, s32 *values, u32 max)
+ * \brief Read the samples with from <= time <= to, pending ones included.
+ *
+ * \retval                          Number of samples read, at most max
+ **************************************************************************/
+u32 SERIES_read(const series_s *series, u32 from, u32 to, u32 *times, s32 *values, u32 max);
+
+/*!************************************************************************
+ * \fn series_store_s *SERIES_STORE_create(void)
+ * \brief Allocate an empty store, NULL if the allocation failed.
+ **************************************************************************/
+series_store_s *SERIES_STORE_create(void);
+
+/*!************************************************************************
+ * \fn void SERIES_STORE_destroy(series_store_s *store)
+ **************************************************************************/
+void SERIES_STORE_destroy(series_store_s *store);
+
+/*!************************************************************************
+ * \fn series_s *SERIES_STORE_get(series_store_s *store, u32 device_id, series_field_e field, bool create)
+ * \brief Series of a field of a device, NULL if unknown (or allocation failed).
+ **************************************************************************/
+series_s *SERIES_STORE_get(series_store_s *store, u32 device_id, series_field_e field, bool create);
+
+/*!************************************************************************
+ * \fn u8 SERIES_STORE_append_data(series_store_s *store, u32 device_id, u32 time, const data_s *data)
+ * \brief Append the fields of a decoded payload that belong to its mode.
+ **************************************************************************/
+u8 SERIES_STORE_append_data(series_store_s *store, u32 device_id, u32 time, const data_s *data);
+
+/*!************************************************************************
+ * \fn u8 SERIES_STORE_flush(series_store_s *store)
+ * \brief Encode the pending samples of every series.
+ **************************************************************************/
+u8 SERIES_STORE_flush(series_store_s *store);
+
+/*!************************************************************************
+ * \fn void SERIES_STORE_size(const series_store_s *store, u64 *samples, u64 *encoded_size, u64 *encoded_samples)
+ * \brief Number of samples, size of the encoded blocks and number of samples they hold.
+ **************************************************************************/
+void SERIES_STORE_size(const series_store_s *store, u64 *samples, u64 *encoded_size, u64 *encoded_samples);
+
+/*!************************************************************************
+ * \fn s32 SERIES_STORE_to_value(series_field_e field, s32 stored)
+ * \brief Convert a stored value back to the unit of data_s.
+ **************************************************************************/
+s32 SERIES_STORE_to_value(series_field_e field, s32 stored);
@@ -0,0 +1,226 @@
+#include <string.h>
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_series.h"
+#include "sensit_downsample.h"
+#include "sensit_payload_node.h"
+
+#define SERIES_DOWNSAMPLE_LTTB 0
+#define SERIES_DOWNSAMPLE_MIN_MAX 1
+#define SERIES_DOWNSAMPLE_MAX_WIDTH 65536
+
+class SeriesStore : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit SeriesStore(series_store_s *store) : store_(store) {}
+  ~SeriesStore() { SERIES_STORE_destroy(store_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Append(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Read(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Downsample(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Flush(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  series_store_s *store_;
+};
+
+void SeriesStore::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "SeriesStore"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "append", Append);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read", Read);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "downsample", Downsample);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "flush", Flush);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "SeriesStore"), tpl->GetFunction());
+}
+
+void SeriesStore::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  series_store_s *store = SERIES_STORE_create();
+  if (store == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the series store")));
+    return;
+  }
+
+  SeriesStore *obj = new SeriesStore(store);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void SeriesStore::Append(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  SeriesStore *obj = node::ObjectWrap::Unwrap<SeriesStore>(args.Holder());
+
+  // args: Buffer payloads, Uint32Array device ids, Uint32Array times
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+
+  u32 rejected = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    data_s decoded_payload = {};
+    PAYLOAD_parse_data(payloads + (i * PAYLOAD_DATA_SIZE), &decoded_payload);
+
+    u8 err = SERIES_STORE_append_data(obj->store_, device_ids[i], times[i], &decoded_payload);
+    if (err == SERIES_ERR_ALLOC)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the series store")));
+      return;
+    }
+    if (err == SERIES_ERR_ORDER)
+    {
+      rejected++;
+    }
+  }
+  // Number of payloads older than the last one stored for their device
+  args.GetReturnValue().Set(rejected);
+}
+
+void SeriesStore::Read(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  SeriesStore *obj = node::ObjectWrap::Unwrap<SeriesStore>(args.Holder());
+
+  // args: device id, field, from, to
+  u32 field = args[1]->Uint32Value();
+  if (field >= SERIES_FIELD_LAST)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Unknown series field")));
+    return;
+  }
+  series_s *series = SERIES_STORE_get(obj->store_, args[0]->Uint32Value(), (series_field_e)field, FALSE);
+  u32 max = (series == NULL) ? 0 : series->sample_count;
+
+  v8::Local<v8::ArrayBuffer> times_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(u32));
+  v8::Local<v8::ArrayBuffer> values_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(s32));
+  u32 *times = (u32 *)times_buffer->GetContents().Data();
+  s32 *values = (s32 *)values_buffer->GetContents().Data();
+
+  u32 count = 0;
+  if (series != NULL)
+  {
+    count = SERIES_read(series, args[2]->Uint32Value(), args[3]->Uint32Value(), times, values, max);
+  }
+  for (u32 i = 0; i < count; i++)
+  {
+    values[i] = SERIES_STORE_to_value((series_field_e)field, values[i]);
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "times"), v8::Uint32Array::New(times_buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "values"), v8::Int32Array::New(values_buffer, 0, count));
+  args.GetReturnValue().Set(res);
+}
+
+void SeriesStore::Downsample(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  SeriesStore *obj = node::ObjectWrap::Unwrap<SeriesStore>(args.Holder());
+
+  // args: device id, field, from, to, width, method
+  u32 field = args[1]->Uint32Value();
+  if (field >= SERIES_FIELD_LAST)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Unknown series field")));
+    return;
+  }
+  u32 width = args[4]->Uint32Value();
+  if (width == 0 || width > SERIES_DOWNSAMPLE_MAX_WIDTH)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Invalid downsampling width")));
+    return;
+  }
+  u32 method = args[5]->Uint32Value();
+  series_s *series = SERIES_STORE_get(obj->store_, args[0]->Uint32Value(), (series_field_e)field, FALSE);
+  // Min/max gives up to 2 points per pixel
+  u32 max = (series == NULL) ? 0 : (method == SERIES_DOWNSAMPLE_MIN_MAX) ? width * 2 : width;
+
+  v8::Local<v8::ArrayBuffer> times_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(u32));
+  v8::Local<v8::ArrayBuffer> values_buffer = v8::ArrayBuffer::New(isolate, max * sizeof(s32));
+  u32 *times = (u32 *)times_buffer->GetContents().Data();
+  s32 *values = (s32 *)values_buffer->GetContents().Data();
+
+  u32 count = 0;
+  if (series != NULL && method == SERIES_DOWNSAMPLE_MIN_MAX)
+  {
+    count = DOWNSAMPLE_min_max(series, args[2]->Uint32Value(), args[3]->Uint32Value(), width, times, values);
+  }
+  else if (series != NULL &&
+           DOWNSAMPLE_series_lttb(series, args[2]->Uint32Value(), args[3]->Uint32Value(), width, times, values, &count) != DOWNSAMPLE_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Out of memory")));
+    return;
+  }
+  for (u32 i = 0; i < count; i++)
+  {
+    values[i] = SERIES_STORE_to_value((series_field_e)field, values[i]);
+  }
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "times"), v8::Uint32Array::New(times_buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "values"), v8::Int32Array::New(values_buffer, 0, count));
+  args.GetReturnValue().Set(res);
+}
+
+void SeriesStore::Flush(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  SeriesStore *obj = node::ObjectWrap::Unwrap<SeriesStore>(args.Holder());
+
+  if (SERIES_STORE_flush(obj->store_) != SERIES_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the series store")));
+  }
+}
+
+void SeriesStore::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  SeriesStore *obj = node::ObjectWrap::Unwrap<SeriesStore>(args.Holder());
+  u64 samples;
+  u64 encoded_size;
+  u64 encoded_samples;
+
+  SERIES_STORE_size(obj->store_, &samples, &encoded_size, &encoded_samples);
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Number::New(isolate, obj->store_->device_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "samples"), v8::Number::New(isolate, (double)samples));
+  res->Set(v8::String::NewFromUtf8(isolate, "encodedSamples"), v8::Number::New(isolate, (double)encoded_samples));
+  res->Set(v8::String::NewFromUtf8(isolate, "encodedBytes"), v8::Number::New(isolate, (double)encoded_size));
+  args.GetReturnValue().Set(res);
+}
+
+void SERIES_node_init(v8::Local<v8::Object> exports)
+{
+  SeriesStore::Init(exports);
+}
@@ -0,0 +1,575 @@
+/*!******************************************************************
+ * \file sensit_sketch.c
+ * \brief Functions to summarize a window of uplinks in mergeable sketches
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_sketch.h"
+
+/******* DEFINE ****************************************************/
+#define SKETCH_MAGIC_0 0x53 /* "SK" */
+#define SKETCH_MAGIC_1 0x4B
+#define SKETCH_VERSION 1
+#define SKETCH_HEADER_SIZE 4
+#define SKETCH_FLAG_DENSE 0x01
+
+#define SKETCH_HLL_MAX_RANK (64 - SKETCH_HLL_PRECISION + 1)
+#define SKETCH_HLL_DENSE_SIZE (SKETCH_HLL_REGISTERS * 6 / 8)
+
+#define SKETCH_BRIGHTNESS_EXACT 64
+#define SKETCH_BRIGHTNESS_SUB_BITS 5
+
+#define BATTERY_OFFSET 2700
+#define BATTERY_STEP 50
+
+/*******************************************************************/
+
+static u64 *SKETCH_histogram(sketch_s *sketch, sketch_field_e field, u32 *bucket_count)
+{
+    switch (field)
+    {
+    case SKETCH_FIELD_TEMPERATURE:
+        *bucket_count = SKETCH_TEMPERATURE_BUCKETS;
+        return sketch->temperature;
+    case SKETCH_FIELD_HUMIDITY:
+        *bucket_count = SKETCH_HUMIDITY_BUCKETS;
+        return sketch->humidity;
+    case SKETCH_FIELD_BRIGHTNESS:
+        *bucket_count = SKETCH_BRIGHTNESS_BUCKETS;
+        return sketch->brightness;
+    default:
+        *bucket_count = SKETCH_BATTERY_LEVEL_BUCKETS;
+        return sketch->battery_level;
+    }
+}
+
+/*******************************************************************/
+
+static u32 SKETCH_brightness_bucket(u16 brightness)
+{
+    u32 msb;
+
+    if (brightness < SKETCH_BRIGHTNESS_EXACT)
+    {
+        return brightness;
+    }
+    msb = 31 - __builtin_clz(brightness);
+    return SKETCH_BRIGHTNESS_EXACT + ((msb - 6) << SKETCH_BRIGHTNESS_SUB_BITS) +
+           ((brightness >> (msb - SKETCH_BRIGHTNESS_SUB_BITS)) & ((1 << SKETCH_BRIGHTNESS_SUB_BITS) - 1));
+}
+
+/*******************************************************************/
+
+static s32 SKETCH_bucket_value(sketch_field_e field, u32 bucket)
+{
+    u32 shift;
+    u32 low;
+
+    switch (field)
+    {
+    case SKETCH_FIELD_TEMPERATURE:
+        return (s32)bucket + SKETCH_TEMPERATURE_MIN;
+    case SKETCH_FIELD_HUMIDITY:
+        return (s32)bucket;
+    case SKETCH_FIELD_BRIGHTNESS:
+        if (bucket < SKETCH_BRIGHTNESS_EXACT)
+        {
+            return (s32)bucket;
+        }
+        /* Bucket of [low, low + 2^shift - 1] */
+        shift = ((bucket - SKETCH_BRIGHTNESS_EXACT) >> SKETCH_BRIGHTNESS_SUB_BITS) + 1;
+        low = ((1U << SKETCH_BRIGHTNESS_SUB_BITS) + ((bucket - SKETCH_BRIGHTNESS_EXACT) & ((1 << SKETCH_BRIGHTNESS_SUB_BITS) - 1))) << shift;
+        return (s32)(low + (((1U << shift) - 1) >> 1));
+    default:
+        return (s32)(BATTERY_OFFSET + bucket * BATTERY_STEP);
+    }
+}
+
+/*******************************************************************/
+
+static void SKETCH_add(sketch_s *sketch, sketch_field_e field, u32 bucket)
+{
+    u32 bucket_count;
+    u64 *histogram = SKETCH_histogram(sketch, field, &bucket_count);
+
+    if (bucket < bucket_count)
+    {
+        histogram[bucket]++;
+        sketch->counts[field]++;
+    }
+}
+
+/*******************************************************************/
+
+sketch_s *SKETCH_create(void)
+{
+    return (sketch_s *)calloc(1, sizeof(sketch_s));
+}
+
+/*******************************************************************/
+
+void SKETCH_destroy(sketch_s *sketch)
+{
+    free(sketch);
+}
+
+/*******************************************************************/
+
+void SKETCH_reset(sketch_s *sketch)
+{
+    memset(sketch, 0, sizeof(sketch_s));
+}
+
+/*******************************************************************/
+
+bool SKETCH_add_data(sketch_s *sketch, const data_s *data)
+{
+    bool v2_button = (data->type == PAYLOAD_V2) && data->button;
+
+    if (data->error != PARSE_ERR_NONE)
+    {
+        return FALSE;
+    }
+
+    SKETCH_add(sketch, SKETCH_FIELD_BATTERY_LEVEL, (u32)(data->battery_level - BATTERY_OFFSET) / BATTERY_STEP);
+    if (data->mode == MODE_TEMPERATURE)
+    {
+        SKETCH_add(sketch, SKETCH_FIELD_TEMPERATURE, (u32)(data->temperature - SKETCH_TEMPERATURE_MIN));
+        if (!v2_button)
+        {
+            SKETCH_add(sketch, SKETCH_FIELD_HUMIDITY, data->humidity);
+        }
+    }
+    else if (data->mode == MODE_LIGHT && !v2_button)
+    {
+        SKETCH_add(sketch, SKETCH_FIELD_BRIGHTNESS, SKETCH_brightness_bucket(data->brightness));
+    }
+    return TRUE;
+}
+
+/*******************************************************************/
+
+void SKETCH_add_device(sketch_s *sketch, u32 device_id)
+{
+    u64 hash = (u64)device_id + 0x9E3779B97F4A7C15ULL;
+    u32 index;
+    u8 rank;
+
+    /* splitmix64 finalizer, a bijection spreading the ids over 64 bits */
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+
+    /* First bits select the register, rank of the first 1 of the others */
+    index = (u32)(hash >> (64 - SKETCH_HLL_PRECISION));
+    rank = (u8)(__builtin_clzll((hash << SKETCH_HLL_PRECISION) | (1ULL << (SKETCH_HLL_PRECISION - 1))) + 1);
+    if (rank > sketch->registers[index])
+    {
+        sketch->registers[index] = rank;
+    }
+}
+
+/*******************************************************************/
+
+bool SKETCH_quantile(const sketch_s *sketch, sketch_field_e field, double q, s32 *value_out)
+{
+    u32 bucket_count;
+    const u64 *histogram = SKETCH_histogram((sketch_s *)sketch, field, &bucket_count);
+    u64 total = sketch->counts[field];
+    u64 rank;
+    u64 cumulated = 0;
+    u32 i;
+
+    if (total == 0)
+    {
+        return FALSE;
+    }
+    if (!(q > 0.0))
+    {
+        q = 0.0;
+    }
+    if (q > 1.0)
+    {
+        q = 1.0;
+    }
+    rank = (u64)ceil(q * (double)total);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    if (rank > total)
+    {
+        rank = total;
+    }
+
+    for (i = 0; i < bucket_count; i++)
+    {
+        cumulated += histogram[i];
+        if (cumulated >= rank)
+        {
+            break;
+        }
+    }
+    *value_out = SKETCH_bucket_value(field, i);
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static double SKETCH_sigma(double x)
+{
+    double y = 1.0;
+    double z = x;
+    double previous;
+
+    if (x == 1.0)
+    {
+        return INFINITY;
+    }
+    do
+    {
+        x *= x;
+        previous = z;
+        z += x * y;
+        y += y;
+    } while (z != previous);
+    return z;
+}
+
+/*******************************************************************/
+
+static double SKETCH_tau(double x)
+{
+    double y = 1.0;
+    double z = 1.0 - x;
+    double previous;
+
+    if (x == 0.0 || x == 1.0)
+    {
+        return 0.0;
+    }
+    do
+    {
+        x = sqrt(x);
+        previous = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != previous);
+    return z / 3.0;
+}
+
+/*******************************************************************/
+
+double SKETCH_distinct(const sketch_s *sketch)
+{
+    u32 histogram[SKETCH_HLL_MAX_RANK + 1];
+    double m = (double)SKETCH_HLL_REGISTERS;
+    double z;
+    s32 rank;
+    u32 i;
+
+    /* Improved raw estimator of O. Ertl, "New cardinality estimation
+       algorithms for HyperLogLog sketches": no bias correction table nor
+       switch to linear counting is needed over the whole range */
+    memset(histogram, 0, sizeof(histogram));
+    for (i = 0; i < SKETCH_HLL_REGISTERS; i++)
+    {
+        histogram[sketch->registers[i]]++;
+    }
+    if (histogram[0] == SKETCH_HLL_REGISTERS)
+    {
+        return 0.0;
+    }
+    z = m * SKETCH_tau(1.0 - histogram[SKETCH_HLL_MAX_RANK] / m);
+    for (rank = SKETCH_HLL_MAX_RANK - 1; rank >= 1; rank--)
+    {
+        z = 0.5 * (z + histogram[rank]);
+    }
+    z += m * SKETCH_sigma(histogram[0] / m);
+    return (0.5 / log(2.0)) * m * m / z;
+}
+
+/*******************************************************************/
+
+void SKETCH_merge(sketch_s *sketch, const sketch_s *other)
+{
+    u64 *histogram;
+    const u64 *other_histogram;
+    u32 bucket_count;
+    u32 field;
+    u32 i;
+
+    for (field = 0; field < SKETCH_FIELD_LAST; field++)
+    {
+        histogram = SKETCH_histogram(sketch, (sketch_field_e)field, &bucket_count);
+        other_histogram = SKETCH_histogram((sketch_s *)other, (sketch_field_e)field, &bucket_count);
+        for (i = 0; i < bucket_count; i++)
+        {
+            histogram[i] += other_histogram[i];
+        }
+        sketch->counts[field] += other->counts[field];
+    }
+    for (i = 0; i < SKETCH_HLL_REGISTERS; i++)
+    {
+        if (other->registers[i] > sketch->registers[i])
+        {
+            sketch->registers[i] = other->registers[i];
+        }
+    }
+}
+
+/*******************************************************************/
+
+static u32 SKETCH_varint_size(u64 value)
+{
+    u32 size = 1;
+
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/*******************************************************************/
+
+static u8 *SKETCH_write_varint(u8 *out, u64 value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (u8)value;
+    return out;
+}
+
+/*******************************************************************/
+
+static bool SKETCH_read_varint(const u8 **in, const u8 *end, u64 *value)
+{
+    u32 shift = 0;
+    u8 byte;
+
+    *value = 0;
+    do
+    {
+        if (*in == end || shift > 63)
+        {
+            return FALSE;
+        }
+        byte = *(*in)++;
+        *value |= (u64)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return TRUE;
+}
+
+/*******************************************************************/
+
+u8 SKETCH_serialize(const sketch_s *sketch, u8 **buffer_out, u32 *size_out)
+{
+    const u64 *histogram;
+    u32 bucket_count;
+    u32 non_empty[SKETCH_FIELD_LAST];
+    u32 registers = 0;
+    u32 sparse_size = 0;
+    u32 size = SKETCH_HEADER_SIZE;
+    bool dense;
+    s32 previous;
+    u32 field;
+    u32 i;
+    u8 *buffer;
+    u8 *out;
+
+    /* Sizing pass, indexes are written as the gap from the previous one minus 1 */
+    for (field = 0; field < SKETCH_FIELD_LAST; field++)
+    {
+        histogram = SKETCH_histogram((sketch_s *)sketch, (sketch_field_e)field, &bucket_count);
+        non_empty[field] = 0;
+        previous = -1;
+        for (i = 0; i < bucket_count; i++)
+        {
+            if (histogram[i] != 0)
+            {
+                size += SKETCH_varint_size(i - previous - 1) + SKETCH_varint_size(histogram[i]);
+                non_empty[field]++;
+                previous = (s32)i;
+            }
+        }
+        size += SKETCH_varint_size(non_empty[field]);
+    }
+    previous = -1;
+    for (i = 0; i < SKETCH_HLL_REGISTERS; i++)
+    {
+        if (sketch->registers[i] != 0)
+        {
+            sparse_size += SKETCH_varint_size(i - previous - 1) + 1;
+            registers++;
+            previous = (s32)i;
+        }
+    }
+    sparse_size += SKETCH_varint_size(registers);
+    dense = sparse_size > SKETCH_HLL_DENSE_SIZE;
+    size += dense ? SKETCH_HLL_DENSE_SIZE : sparse_size;
+
+    buffer = (u8 *)malloc(size);
+    if (buffer == NULL)
+    {
+        return SKETCH_ERR_ALLOC;
+    }
+    buffer[0] = SKETCH_MAGIC_0;
+    buffer[1] = SKETCH_MAGIC_1;
+    buffer[2] = SKETCH_VERSION;
+    buffer[3] = dense ? SKETCH_FLAG_DENSE : 0;
+    out = buffer + SKETCH_HEADER_SIZE;
+
+    for (field = 0; field < SKETCH_FIELD_LAST; field++)
+    {
+        histogram = SKETCH_histogram((sketch_s *)sketch, (sketch_field_e)field, &bucket_count);
+        out = SKETCH_write_varint(out, non_empty[field]);
+        previous = -1;
+        for (i = 0; i < bucket_count; i++)
+        {
+            if (histogram[i] != 0)
+            {
+                out = SKETCH_write_varint(out, i - previous - 1);
+                out = SKETCH_write_varint(out, histogram[i]);
+                previous = (s32)i;
+            }
+        }
+    }
+    if (dense)
+    {
+        /* 4 registers of 6 bits in 3 bytes */
+        for (i = 0; i < SKETCH_HLL_REGISTERS; i += 4)
+        {
+            *out++ = (u8)(sketch->registers[i] | (sketch->registers[i + 1] << 6));
+            *out++ = (u8)((sketch->registers[i + 1] >> 2) | (sketch->registers[i + 2] << 4));
+            *out++ = (u8)((sketch->registers[i + 2] >> 4) | (sketch->registers[i + 3] << 2));
+        }
+    }
+    else
+    {
+        out = SKETCH_write_varint(out, registers);
+        previous = -1;
+        for (i = 0; i < SKETCH_HLL_REGISTERS; i++)
+        {
+            if (sketch->registers[i] != 0)
+            {
+                out = SKETCH_write_varint(out, i - previous - 1);
+                *out++ = sketch->registers[i];
+                previous = (s32)i;
+            }
+        }
+    }
+
+    *buffer_out = buffer;
+    *size_out = size;
+    return SKETCH_ERR_NONE;
+}
+
+/*******************************************************************/
+
+static bool SKETCH_read(const u8 *buffer_in, u32 size, sketch_s *sketch)
+{
+    const u8 *in = buffer_in + SKETCH_HEADER_SIZE;
+    const u8 *end = buffer_in + size;
+    u64 *histogram;
+    u32 bucket_count;
+    u64 entries;
+    u64 gap;
+    u64 count;
+    u64 index;
+    u32 field;
+    u32 i;
+
+    if (size < SKETCH_HEADER_SIZE || buffer_in[0] != SKETCH_MAGIC_0 || buffer_in[1] != SKETCH_MAGIC_1 ||
+        buffer_in[2] != SKETCH_VERSION || (buffer_in[3] & ~SKETCH_FLAG_DENSE) != 0)
+    {
+        return FALSE;
+    }
+
+    for (field = 0; field < SKETCH_FIELD_LAST; field++)
+    {
+        histogram = SKETCH_histogram(sketch, (sketch_field_e)field, &bucket_count);
+        if (!SKETCH_read_varint(&in, end, &entries) || entries > bucket_count)
+        {
+            return FALSE;
+        }
+        index = (u64)-1;
+        for (i = 0; i < entries; i++)
+        {
+            if (!SKETCH_read_varint(&in, end, &gap) || !SKETCH_read_varint(&in, end, &count) ||
+                gap >= bucket_count || (index += gap + 1) >= bucket_count)
+            {
+                return FALSE;
+            }
+            histogram[index] = count;
+            sketch->counts[field] += count;
+        }
+    }
+
+    if (buffer_in[3] & SKETCH_FLAG_DENSE)
+    {
+        if (end - in != SKETCH_HLL_DENSE_SIZE)
+        {
+            return FALSE;
+        }
+        for (i = 0; i < SKETCH_HLL_REGISTERS; i += 4, in += 3)
+        {
+            sketch->registers[i] = in[0] & 0x3F;
+            sketch->registers[i + 1] = (u8)((in[0] >> 6) | ((in[1] & 0x0F) << 2));
+            sketch->registers[i + 2] = (u8)((in[1] >> 4) | ((in[2] & 0x03) << 4));
+            sketch->registers[i + 3] = in[2] >> 2;
+        }
+    }
+    else
+    {
+        if (!SKETCH_read_varint(&in, end, &entries) || entries > SKETCH_HLL_REGISTERS)
+        {
+            return FALSE;
+        }
+        index = (u64)-1;
+        for (i = 0; i < entries; i++)
+        {
+            if (!SKETCH_read_varint(&in, end, &gap) || gap >= SKETCH_HLL_REGISTERS ||
+                (index += gap + 1) >= SKETCH_HLL_REGISTERS || in == end)
+            {
+                return FALSE;
+            }
+            sketch->registers[index] = *in++;
+        }
+        if (in != end)
+        {
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < SKETCH_HLL_REGISTERS; i++)
+    {
+        if (sketch->registers[i] > SKETCH_HLL_MAX_RANK)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************************/
+
+u8 SKETCH_deserialize(const u8 *buffer_in, u32 size, sketch_s *sketch_out)
+{
+    SKETCH_reset(sketch_out);
+    if (!SKETCH_read(buffer_in, size, sketch_out))
+    {
+        SKETCH_reset(sketch_out);
+        return SKETCH_ERR_FORMAT;
+    }
+    return SKETCH_ERR_NONE;
+}
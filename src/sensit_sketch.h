@@ -0,0 +1,137 @@
+/*!******************************************************************
+ * \file sensit_sketch.h
+ * \brief Functions & Types to summarize a window of uplinks in mergeable sketches
+ * \author Sens'it Team
+ *
+ * A sketch holds, for a window of uplinks of any number of devices:
+ *  - a histogram per sketch_field_e, to answer quantiles. The raw
+ *    values of the decoder are small integers, temperature, humidity
+ *    and battery level have a bucket per value and their quantiles are
+ *    exact. Brightness is log-linear, exact below 64 then 32 buckets
+ *    per power of 2, within 1.6% of the exact quantile
+ *  - a HyperLogLog of 2^SKETCH_HLL_PRECISION registers of the device
+ *    ids, to estimate the number of distinct devices within ~0.8%
+ * Its size does not depend on the number of uplinks. Two sketches merge
+ * into the sketch of the union of their uplinks, whatever the order,
+ * and serialize to a compact buffer (only the non-empty buckets and
+ * registers) so that the sketches of several processes or hosts can be
+ * merged into fleet wide statistics.
+ *******************************************************************/
+
+#define SKETCH_ERR_NONE 0x00
+#define SKETCH_ERR_ALLOC 0x01
+#define SKETCH_ERR_FORMAT 0x02
+
+#define SKETCH_HLL_PRECISION 14
+#define SKETCH_HLL_REGISTERS (1 << SKETCH_HLL_PRECISION)
+
+#define SKETCH_TEMPERATURE_MIN -200 /* Raw value 0 of both versions */
+#define SKETCH_TEMPERATURE_BUCKETS 1024
+#define SKETCH_HUMIDITY_BUCKETS 256
+#define SKETCH_BRIGHTNESS_BUCKETS 384 /* 64 exact + 32 per power of 2 from 2^6 to 2^15 */
+#define SKETCH_BATTERY_LEVEL_BUCKETS 32
+
+/*!******************************************************************
+ * \enum sketch_field_e
+ * \brief Fields of data_s summarized by a histogram
+ *******************************************************************/
+typedef enum {
+    SKETCH_FIELD_TEMPERATURE,   /*!< Must be divided by 8 to get in °C */
+    SKETCH_FIELD_HUMIDITY,      /*!< Must be divided by 2 to get in % */
+    SKETCH_FIELD_BRIGHTNESS,    /*!< Must be divided by 96 to get in lux */
+    SKETCH_FIELD_BATTERY_LEVEL, /*!< Value in mV */
+    SKETCH_FIELD_LAST
+} sketch_field_e;
+
+/*!******************************************************************
+ * \struct sketch_s
+ * \brief Histograms & distinct devices of a window
+ *******************************************************************/
+typedef struct
+{
+    u64 temperature[SKETCH_TEMPERATURE_BUCKETS];     /*!< Raw value - SKETCH_TEMPERATURE_MIN */
+    u64 humidity[SKETCH_HUMIDITY_BUCKETS];
+    u64 brightness[SKETCH_BRIGHTNESS_BUCKETS];
+    u64 battery_level[SKETCH_BATTERY_LEVEL_BUCKETS]; /*!< 50 mV steps from 2700 mV */
+    u64 counts[SKETCH_FIELD_LAST];                   /*!< Values of each histogram */
+    u8 registers[SKETCH_HLL_REGISTERS];              /*!< HyperLogLog, rank of each register */
+} sketch_s;
+
+/*!************************************************************************
+ * \fn sketch_s *SKETCH_create(void)
+ * \brief Allocate an empty sketch, NULL if the allocation failed.
+ **************************************************************************/
+sketch_s *SKETCH_create(void);
+
+/*!************************************************************************
+ * \fn void SKETCH_destroy(sketch_s *sketch)
+ **************************************************************************/
+void SKETCH_destroy(sketch_s *sketch);
+
+/*!************************************************************************
+ * \fn void SKETCH_reset(sketch_s *sketch)
+ * \brief Empty a sketch, to reuse it for the next window.
+ **************************************************************************/
+void SKETCH_reset(sketch_s *sketch);
+
+/*!************************************************************************
+ * \fn bool SKETCH_add_data(sketch_s *sketch, const data_s *data)
+ * \brief Add the values of a decoded payload valid for its mode, like
+ *        formatData(): temperature & humidity in mode TEMPERATURE,
+ *        brightness in mode LIGHT, battery level for all. Only the
+ *        temperature of a v2 double click is valid.
+ *
+ * \retval                          FALSE if the payload has a parsing error
+ **************************************************************************/
+bool SKETCH_add_data(sketch_s *sketch, const data_s *data);
+
+/*!************************************************************************
+ * \fn void SKETCH_add_device(sketch_s *sketch, u32 device_id)
+ * \brief Count a device in the distinct devices.
+ **************************************************************************/
+void SKETCH_add_device(sketch_s *sketch, u32 device_id);
+
+/*!************************************************************************
+ * \fn bool SKETCH_quantile(const sketch_s *sketch, sketch_field_e field, double q, s32 *value_out)
+ * \brief Nearest rank quantile: the smallest value such that at least
+ *        q of the values are lower or equal. A brightness is the middle
+ *        of its bucket.
+ *
+ * \param[in] q                     0 for the minimum to 1 for the maximum
+ * \param[out] value_out            In the unit of data_s
+ * \retval                          FALSE if the histogram is empty
+ **************************************************************************/
+bool SKETCH_quantile(const sketch_s *sketch, sketch_field_e field, double q, s32 *value_out);
+
+/*!************************************************************************
+ * \fn double SKETCH_distinct(const sketch_s *sketch)
+ * \brief Estimate the number of distinct devices added.
+ **************************************************************************/
+double SKETCH_distinct(const sketch_s *sketch);
+
+/*!************************************************************************
+ * \fn void SKETCH_merge(sketch_s *sketch, const sketch_s *other)
+ * \brief Add the uplinks of other to sketch.
+ **************************************************************************/
+void SKETCH_merge(sketch_s *sketch, const sketch_s *other);
+
+/*!************************************************************************
+ * \fn u8 SKETCH_serialize(const sketch_s *sketch, u8 **buffer_out, u32 *size_out)
+ * \brief Encode a sketch: a 4 bytes header, then the non-empty buckets of
+ *        each histogram as varint (index gap, count) pairs, then the
+ *        registers, either non-empty ones as (varint index gap, rank) or
+ *        all of them 6 bits packed, whichever is the smallest.
+ *
+ * \param[out] buffer_out           Buffer allocated with malloc
+ * \retval                          SKETCH_ERR_NONE or SKETCH_ERR_ALLOC
+ **************************************************************************/
+u8 SKETCH_serialize(const sketch_s *sketch, u8 **buffer_out, u32 *size_out);
+
+/*!************************************************************************
+ * \fn u8 SKETCH_deserialize(const u8 *buffer_in, u32 size, sketch_s *sketch_out)
+ * \brief Decode a buffer of SKETCH_serialize, the sketch is left empty
+ *        if the buffer is not valid.
+ *
+ * \retval                          SKETCH_ERR_NONE or SKETCH_ERR_FORMAT
+ **************************************************************************/
+u8 SKETCH_deserialize(const u8 *buffer_in, u32 size, sketch_s *sketch_out);
@@ -0,0 +1,206 @@
+#include <math.h>
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_sketch.h"
+#include "sensit_payload_node.h"
+
+class Sketch : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Sketch(sketch_s *sketch) : sketch_(sketch) {}
+  ~Sketch() { SKETCH_destroy(sketch_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Update(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void AddDevices(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Quantiles(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Count(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Distinct(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Serialize(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Merge(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Reset(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  sketch_s *sketch_;
+};
+
+void Sketch::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Sketch"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "update", Update);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "addDevices", AddDevices);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "quantiles", Quantiles);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "count", Count);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "distinct", Distinct);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "serialize", Serialize);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "merge", Merge);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "reset", Reset);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Sketch"), tpl->GetFunction());
+}
+
+void Sketch::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  sketch_s *sketch = SKETCH_create();
+  if (sketch == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the sketch")));
+    return;
+  }
+
+  Sketch *obj = new Sketch(sketch);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void Sketch::Update(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  // args: Buffer payloads
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+
+  u32 added = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    data_s decoded_payload = {};
+    PAYLOAD_parse_data(payloads + (i * PAYLOAD_DATA_SIZE), &decoded_payload);
+    if (SKETCH_add_data(obj->sketch_, &decoded_payload))
+    {
+      added++;
+    }
+  }
+  // Number of payloads without parsing error
+  args.GetReturnValue().Set(added);
+}
+
+void Sketch::AddDevices(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  // args: Uint32Array device ids
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[0]);
+  size_t count = node::Buffer::Length(args[0]) / sizeof(u32);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    SKETCH_add_device(obj->sketch_, device_ids[i]);
+  }
+}
+
+void Sketch::Quantiles(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  // args: field, Float64Array quantiles
+  u32 field = args[0]->Uint32Value();
+  if (field >= SKETCH_FIELD_LAST)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Unknown sketch field")));
+    return;
+  }
+  const double *qs = (const double *)node::Buffer::Data(args[1]);
+  size_t count = node::Buffer::Length(args[1]) / sizeof(double);
+
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, count * sizeof(double));
+  double *values = (double *)buffer->GetContents().Data();
+  for (size_t i = 0; i < count; i++)
+  {
+    s32 value;
+    values[i] = SKETCH_quantile(obj->sketch_, (sketch_field_e)field, qs[i], &value) ? value : NAN;
+  }
+  args.GetReturnValue().Set(v8::Float64Array::New(buffer, 0, count));
+}
+
+void Sketch::Count(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  // args: field
+  u32 field = args[0]->Uint32Value();
+  if (field >= SKETCH_FIELD_LAST)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Unknown sketch field")));
+    return;
+  }
+  args.GetReturnValue().Set(v8::Number::New(isolate, (double)obj->sketch_->counts[field]));
+}
+
+void Sketch::Distinct(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  args.GetReturnValue().Set(v8::Number::New(isolate, SKETCH_distinct(obj->sketch_)));
+}
+
+void Sketch::Serialize(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  u8 *serialized = NULL;
+  u32 size = 0;
+  if (SKETCH_serialize(obj->sketch_, &serialized, &size) != SKETCH_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to serialize the sketch")));
+    return;
+  }
+
+  // The Buffer takes ownership of the malloc'ed sketch, no copy
+  v8::MaybeLocal<v8::Object> buffer = node::Buffer::New(isolate, (char *)serialized, size);
+  v8::Local<v8::Object> out;
+  if (buffer.ToLocal(&out))
+  {
+    args.GetReturnValue().Set(out);
+  }
+}
+
+void Sketch::Merge(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  // args: Buffer of a serialized sketch
+  sketch_s *other = SKETCH_create();
+  if (other == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the sketch")));
+    return;
+  }
+  if (SKETCH_deserialize((const u8 *)node::Buffer::Data(args[0]), node::Buffer::Length(args[0]), other) != SKETCH_ERR_NONE)
+  {
+    SKETCH_destroy(other);
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Invalid serialized sketch")));
+    return;
+  }
+  SKETCH_merge(obj->sketch_, other);
+  SKETCH_destroy(other);
+}
+
+void Sketch::Reset(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Sketch *obj = node::ObjectWrap::Unwrap<Sketch>(args.Holder());
+
+  SKETCH_reset(obj->sketch_);
+}
+
+void SKETCH_node_init(v8::Local<v8::Object> exports)
+{
+  Sketch::Init(exports);
+}
@@ -0,0 +1,544 @@
+/*!******************************************************************
+ * \file sensit_sqlite.c
+ * \brief SQLite loadable extension of the decoder
+ * \author Sens'it Team
+ *
+ * Decode raw uplinks stored in SQLite inside the database. A payload is
+ * a BLOB of 4 ("data") or 12 ("data" followed by "config") bytes, or
+ * the same as a TEXT of 8 or 24 hexadecimal characters. Registers:
+ *  - scalar functions sensit_<column>(payload) for each column below,
+ *    NULL when the payload is not valid, has a parsing error, or the
+ *    field is not sent in its mode (like parseData()). They are
+ *    deterministic, so expressions on them can be indexed
+ *  - sensit_config_json(payload, type): JSON of parseConfig() for a 8
+ *    bytes config and its type, or a 12 bytes uplink (type optional)
+ *  - the eponymous virtual table sensit_decode(payload), one row of all
+ *    the columns: SELECT * FROM uplinks, sensit_decode(uplinks.payload)
+ *
+ * Build: npm run build-sqlite (build/Release/sensit.so), needs sqlite3ext.h
+ * Load:  .load build/Release/sensit (entry point sqlite3_sensit_init)
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sqlite3ext.h>
+SQLITE_EXTENSION_INIT1
+#include "sensit_payload.h"
+#include "sensit_text.h"
+
+/******* DEFINE ****************************************************/
+#define SQLEXT_MAX_SIZE (PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+#define SQLEXT_DOOR_NOT_CALIBRATED 0x04
+
+#ifdef SQLITE_INNOCUOUS
+#define SQLEXT_FLAGS (SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS)
+#else
+#define SQLEXT_FLAGS (SQLITE_UTF8 | SQLITE_DETERMINISTIC)
+#endif
+
+/*!******************************************************************
+ * \enum sqlext_column_e
+ * \brief Columns of sensit_decode, each also a sensit_<name> function
+ *******************************************************************/
+typedef enum {
+    SQLEXT_COLUMN_TYPE,
+    SQLEXT_COLUMN_ERROR,
+    SQLEXT_COLUMN_MODE,
+    SQLEXT_COLUMN_MODE_NAME,
+    SQLEXT_COLUMN_BUTTON,
+    SQLEXT_COLUMN_BATTERY_LEVEL, /*!< mV */
+    SQLEXT_COLUMN_TEMPERATURE,   /*!< °C, exact */
+    SQLEXT_COLUMN_HUMIDITY,      /*!< %, exact */
+    SQLEXT_COLUMN_LIGHT,         /*!< lux, exact */
+    SQLEXT_COLUMN_DOOR,
+    SQLEXT_COLUMN_MAGNET,
+    SQLEXT_COLUMN_VIBRATION,
+    SQLEXT_COLUMN_EVENT_COUNTER,
+    SQLEXT_COLUMN_VERSION,       /*!< "major.minor.patch" */
+    SQLEXT_COLUMN_JSON,          /*!< JSON of parseData() */
+    SQLEXT_COLUMN_CONFIG,        /*!< JSON of parseConfig(), 12 bytes uplinks only */
+    SQLEXT_COLUMN_PAYLOAD,       /*!< Hidden argument of sensit_decode */
+    SQLEXT_COLUMN_LAST
+} sqlext_column_e;
+
+static const char *const SQLEXT_COLUMNS[SQLEXT_COLUMN_LAST] = {
+    "type", "error", "mode", "mode_name", "button", "battery_level", "temperature", "humidity", "light",
+    "door", "magnet", "vibration", "event_counter", "version", "json", "config", "payload"
+};
+
+static const char *const SQLEXT_MODES[MODE_LAST] = { "standby", "temperature", "light", "door", "vibration", "magnet" };
+
+/*!******************************************************************
+ * \struct sqlext_payload_s
+ * \brief Decoded payload
+ *******************************************************************/
+typedef struct
+{
+    u8 bytes[SQLEXT_MAX_SIZE];
+    u32 size;       /*!< PAYLOAD_DATA_SIZE or SQLEXT_MAX_SIZE */
+    data_s data;
+    config_s config; /*!< Valid if size is SQLEXT_MAX_SIZE */
+} sqlext_payload_s;
+
+/*!******************************************************************
+ * \struct sqlext_cursor_s
+ * \brief Cursor of sensit_decode, a single row
+ *******************************************************************/
+typedef struct
+{
+    sqlite3_vtab_cursor base;
+    sqlext_payload_s payload;
+    bool eof;
+} sqlext_cursor_s;
+
+/*******************************************************************/
+
+static s32 SQLEXT_hex_digit(u8 character)
+{
+    if (character >= '0' && character <= '9')
+    {
+        return character - '0';
+    }
+    character |= 0x20;
+    if (character >= 'a' && character <= 'f')
+    {
+        return character - 'a' + 10;
+    }
+    return -1;
+}
+
+/*******************************************************************/
+
+/* Bytes of a BLOB, or of a TEXT of hexadecimals, 0 if not sizes[0] or sizes[1] bytes */
+static u32 SQLEXT_bytes(sqlite3_value *value, u8 *bytes_out, u32 size_a, u32 size_b)
+{
+    const u8 *in;
+    u32 length = sqlite3_value_bytes(value);
+    s32 high;
+    s32 low;
+    u32 i;
+
+    if (sqlite3_value_type(value) == SQLITE_BLOB)
+    {
+        if (length != size_a && length != size_b)
+        {
+            return 0;
+        }
+        memcpy(bytes_out, sqlite3_value_blob(value), length);
+        return length;
+    }
+    if (sqlite3_value_type(value) != SQLITE_TEXT || (length != 2 * size_a && length != 2 * size_b))
+    {
+        return 0;
+    }
+    in = sqlite3_value_text(value);
+    for (i = 0; i < length / 2; i++)
+    {
+        high = SQLEXT_hex_digit(in[2 * i]);
+        low = SQLEXT_hex_digit(in[2 * i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return 0;
+        }
+        bytes_out[i] = (u8)((high << 4) | low);
+    }
+    return length / 2;
+}
+
+/*******************************************************************/
+
+static bool SQLEXT_decode(sqlite3_value *value, sqlext_payload_s *payload)
+{
+    memset(payload, 0, sizeof(sqlext_payload_s));
+    payload->size = SQLEXT_bytes(value, payload->bytes, PAYLOAD_DATA_SIZE, SQLEXT_MAX_SIZE);
+    if (payload->size == 0)
+    {
+        return FALSE;
+    }
+    PAYLOAD_parse_data(payload->bytes, &(payload->data));
+    if (payload->size == SQLEXT_MAX_SIZE)
+    {
+        /* The config is decoded with the type of its data */
+        if (payload->data.type == PAYLOAD_V2 || payload->data.type == PAYLOAD_V3)
+        {
+            PAYLOAD_parse_config(payload->bytes + PAYLOAD_DATA_SIZE, (payload_type_e)payload->data.type, &(payload->config));
+        }
+        else
+        {
+            payload->config.error = PARSE_ERR_TYPE;
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static void SQLEXT_result_config(sqlite3_context *context, const config_s *config, payload_type_e type)
+{
+    u8 json[TEXT_JSON_MAX_SIZE];
+
+    if (config->error != PARSE_ERR_NONE)
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+    sqlite3_result_text(context, (const char *)json, TEXT_write_json_config(config, type, json) - json, SQLITE_TRANSIENT);
+}
+
+/*******************************************************************/
+
+static void SQLEXT_result(sqlite3_context *context, sqlext_payload_s *payload, sqlext_column_e column)
+{
+    const data_s *data = &(payload->data);
+    bool v2_button = (data->type == PAYLOAD_V2) && data->button;
+    bool event_mode = (data->mode == MODE_DOOR || data->mode == MODE_VIBRATION || data->mode == MODE_MAGNET);
+    char version[16];
+    u8 *text;
+    u32 text_size;
+
+    if (column == SQLEXT_COLUMN_PAYLOAD)
+    {
+        sqlite3_result_blob(context, payload->bytes, payload->size, SQLITE_TRANSIENT);
+        return;
+    }
+    if (column == SQLEXT_COLUMN_ERROR)
+    {
+        sqlite3_result_int(context, data->error);
+        return;
+    }
+    if (column == SQLEXT_COLUMN_TYPE)
+    {
+        sqlite3_result_int(context, data->type);
+        return;
+    }
+    if (data->error != PARSE_ERR_NONE)
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+
+    switch (column)
+    {
+    case SQLEXT_COLUMN_MODE:
+        sqlite3_result_int(context, data->mode);
+        break;
+    case SQLEXT_COLUMN_MODE_NAME:
+        if (data->mode < MODE_LAST)
+        {
+            sqlite3_result_text(context, SQLEXT_MODES[data->mode], -1, SQLITE_STATIC);
+        }
+        break;
+    case SQLEXT_COLUMN_BUTTON:
+        sqlite3_result_int(context, data->button);
+        break;
+    case SQLEXT_COLUMN_BATTERY_LEVEL:
+        sqlite3_result_int(context, data->battery_level);
+        break;
+    case SQLEXT_COLUMN_TEMPERATURE:
+        if (data->mode == MODE_TEMPERATURE)
+        {
+            sqlite3_result_double(context, data->temperature / 8.0);
+        }
+        break;
+    case SQLEXT_COLUMN_HUMIDITY:
+        if (data->mode == MODE_TEMPERATURE && !v2_button)
+        {
+            sqlite3_result_double(context, data->humidity / 2.0);
+        }
+        break;
+    case SQLEXT_COLUMN_LIGHT:
+        if (data->mode == MODE_LIGHT && !v2_button)
+        {
+            sqlite3_result_double(context, data->brightness / 96.0);
+        }
+        break;
+    case SQLEXT_COLUMN_DOOR:
+        if (data->mode == MODE_DOOR && !v2_button)
+        {
+            sqlite3_result_int(context, (data->door == DOOR_NONE && data->type == PAYLOAD_V3) ? SQLEXT_DOOR_NOT_CALIBRATED : data->door);
+        }
+        break;
+    case SQLEXT_COLUMN_MAGNET:
+        if (data->mode == MODE_MAGNET && !v2_button)
+        {
+            sqlite3_result_int(context, data->magnet);
+        }
+        break;
+    case SQLEXT_COLUMN_VIBRATION:
+        if (data->mode == MODE_VIBRATION && !v2_button)
+        {
+            sqlite3_result_int(context, data->vibration);
+        }
+        break;
+    case SQLEXT_COLUMN_EVENT_COUNTER:
+        if (event_mode && !v2_button)
+        {
+            sqlite3_result_int(context, data->event_counter);
+        }
+        break;
+    case SQLEXT_COLUMN_VERSION:
+        if (data->mode == MODE_STANDBY)
+        {
+            snprintf(version, sizeof(version), "%u.%u.%u", data->version_major, data->version_minor, data->version_patch);
+            sqlite3_result_text(context, version, -1, SQLITE_TRANSIENT);
+        }
+        break;
+    case SQLEXT_COLUMN_JSON:
+        if (TEXT_write_data(payload->bytes, 1, NULL, NULL, TEXT_FORMAT_NDJSON, TEXT_COLUMNS_ALL, FALSE, &text, &text_size) != TEXT_ERR_NONE)
+        {
+            sqlite3_result_error_nomem(context);
+            break;
+        }
+        /* Without the line feed, the text is freed by SQLite */
+        sqlite3_result_text(context, (const char *)text, text_size - 1, free);
+        break;
+    case SQLEXT_COLUMN_CONFIG:
+        if (payload->size == SQLEXT_MAX_SIZE)
+        {
+            SQLEXT_result_config(context, &(payload->config), (payload_type_e)data->type);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*******************************************************************/
+
+static void SQLEXT_function(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    sqlext_payload_s payload;
+
+    (void)argc;
+    if (SQLEXT_decode(argv[0], &payload))
+    {
+        SQLEXT_result(context, &payload, (sqlext_column_e)(size_t)sqlite3_user_data(context));
+    }
+}
+
+/*******************************************************************/
+
+static void SQLEXT_config_json(sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+    u8 bytes[SQLEXT_MAX_SIZE];
+    data_s data;
+    config_s config;
+    s32 type = (argc > 1 && sqlite3_value_type(argv[1]) != SQLITE_NULL) ? sqlite3_value_int(argv[1]) : 0;
+    u32 size = SQLEXT_bytes(argv[0], bytes, PAYLOAD_CONFIG_SIZE, SQLEXT_MAX_SIZE);
+    u8 *config_in = bytes;
+
+    if (size == SQLEXT_MAX_SIZE)
+    {
+        memset(&data, 0, sizeof(data_s));
+        PAYLOAD_parse_data(bytes, &data);
+        type = (type == 0) ? data.type : type;
+        config_in = bytes + PAYLOAD_DATA_SIZE;
+    }
+    if (size == 0 || (type != PAYLOAD_V2 && type != PAYLOAD_V3))
+    {
+        return;
+    }
+    memset(&config, 0, sizeof(config_s));
+    PAYLOAD_parse_config(config_in, (payload_type_e)type, &config);
+    SQLEXT_result_config(context, &config, (payload_type_e)type);
+}
+
+/*******************************************************************/
+
+static int SQLEXT_connect(sqlite3 *db, void *aux, int argc, const char *const *argv, sqlite3_vtab **vtab_out, char **error)
+{
+    sqlite3_vtab *vtab;
+    int rc;
+
+    (void)aux;
+    (void)argc;
+    (void)argv;
+    (void)error;
+    rc = sqlite3_declare_vtab(db, "CREATE TABLE x(type, error, mode, mode_name, button, battery_level, temperature, humidity,"
+                                  " light, door, magnet, vibration, event_counter, version, json, config, payload HIDDEN)");
+    if (rc != SQLITE_OK)
+    {
+        return rc;
+    }
+    vtab = (sqlite3_vtab *)sqlite3_malloc(sizeof(sqlite3_vtab));
+    if (vtab == NULL)
+    {
+        return SQLITE_NOMEM;
+    }
+    memset(vtab, 0, sizeof(sqlite3_vtab));
+    *vtab_out = vtab;
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_disconnect(sqlite3_vtab *vtab)
+{
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info)
+{
+    int i;
+
+    (void)vtab;
+    for (i = 0; i < info->nConstraint; i++)
+    {
+        if (info->aConstraint[i].iColumn != SQLEXT_COLUMN_PAYLOAD || info->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ)
+        {
+            continue;
+        }
+        if (!info->aConstraint[i].usable)
+        {
+            /* Another plan gives the argument first */
+            return SQLITE_CONSTRAINT;
+        }
+        info->aConstraintUsage[i].argvIndex = 1;
+        info->aConstraintUsage[i].omit = 1;
+        info->idxNum = 1;
+        info->estimatedCost = 1.0;
+        if (sqlite3_libversion_number() >= 3008002)
+        {
+            info->estimatedRows = 1;
+        }
+        return SQLITE_OK;
+    }
+    /* Without argument, no row */
+    info->idxNum = 0;
+    info->estimatedCost = 1e12;
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **cursor_out)
+{
+    sqlext_cursor_s *cursor = (sqlext_cursor_s *)sqlite3_malloc(sizeof(sqlext_cursor_s));
+
+    (void)vtab;
+    if (cursor == NULL)
+    {
+        return SQLITE_NOMEM;
+    }
+    memset(cursor, 0, sizeof(sqlext_cursor_s));
+    cursor->eof = TRUE;
+    *cursor_out = &(cursor->base);
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_close(sqlite3_vtab_cursor *cursor)
+{
+    sqlite3_free(cursor);
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_filter(sqlite3_vtab_cursor *base, int idx_num, const char *idx_str, int argc, sqlite3_value **argv)
+{
+    sqlext_cursor_s *cursor = (sqlext_cursor_s *)base;
+
+    (void)idx_str;
+    /* A payload that is not a valid 4 or 12 bytes payload gives no row */
+    cursor->eof = (idx_num == 0 || argc < 1 || !SQLEXT_decode(argv[0], &(cursor->payload)));
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_next(sqlite3_vtab_cursor *base)
+{
+    ((sqlext_cursor_s *)base)->eof = TRUE;
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_eof(sqlite3_vtab_cursor *base)
+{
+    return ((sqlext_cursor_s *)base)->eof;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_column(sqlite3_vtab_cursor *base, sqlite3_context *context, int column)
+{
+    SQLEXT_result(context, &(((sqlext_cursor_s *)base)->payload), (sqlext_column_e)column);
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+static int SQLEXT_rowid(sqlite3_vtab_cursor *base, sqlite3_int64 *rowid)
+{
+    (void)base;
+    *rowid = 1;
+    return SQLITE_OK;
+}
+
+/*******************************************************************/
+
+/* Eponymous only: no xCreate, the table exists in every database */
+static sqlite3_module SQLEXT_module = {
+    0,                 /* iVersion */
+    0,                 /* xCreate */
+    SQLEXT_connect,    /* xConnect */
+    SQLEXT_best_index, /* xBestIndex */
+    SQLEXT_disconnect, /* xDisconnect */
+    0,                 /* xDestroy */
+    SQLEXT_open,       /* xOpen */
+    SQLEXT_close,      /* xClose */
+    SQLEXT_filter,     /* xFilter */
+    SQLEXT_next,       /* xNext */
+    SQLEXT_eof,        /* xEof */
+    SQLEXT_column,     /* xColumn */
+    SQLEXT_rowid,      /* xRowid */
+    0,                 /* xUpdate */
+    0,                 /* xBegin */
+    0,                 /* xSync */
+    0,                 /* xCommit */
+    0,                 /* xRollback */
+    0,                 /* xFindFunction */
+    0,                 /* xRename */
+    0,                 /* xSavepoint */
+    0,                 /* xRelease */
+    0,                 /* xRollbackTo */
+    0                  /* xShadowName */
+};
+
+/*******************************************************************/
+
+extern "C" int sqlite3_sensit_init(sqlite3 *db, char **error, const sqlite3_api_routines *api)
+{
+    char name[32];
+    int rc = SQLITE_OK;
+    u32 column;
+
+    (void)error;
+    SQLITE_EXTENSION_INIT2(api);
+
+    for (column = 0; column < SQLEXT_COLUMN_PAYLOAD && rc == SQLITE_OK; column++)
+    {
+        snprintf(name, sizeof(name), "sensit_%s", SQLEXT_COLUMNS[column]);
+        rc = sqlite3_create_function(db, name, 1, SQLEXT_FLAGS, (void *)(size_t)column, SQLEXT_function, NULL, NULL);
+    }
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_create_function(db, "sensit_config_json", 1, SQLEXT_FLAGS, NULL, SQLEXT_config_json, NULL, NULL);
+    }
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_create_function(db, "sensit_config_json", 2, SQLEXT_FLAGS, NULL, SQLEXT_config_json, NULL, NULL);
+    }
+    if (rc == SQLITE_OK)
+    {
+        rc = sqlite3_create_module(db, "sensit_decode", &SQLEXT_module, NULL);
+    }
+    return rc;
+}
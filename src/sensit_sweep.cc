@@ -0,0 +1,622 @@
+/*!******************************************************************
+ * \file sensit_sweep.c
+ * \brief Exhaustive equivalence sweep of the decode paths
+ * \author Sens'it Team
+ *
+ * A "data" payload is 32 bits: every one of them is decoded by the
+ * reference PAYLOAD_parse_data and by each candidate of
+ * sweep_data_candidates, and the data_s are compared field by field.
+ * A candidate forcing a version must match the reference on the
+ * payloads of its version and flag the others PARSE_ERR_TYPE.
+ * A "config" is 64 bits, too many to sweep: every value of each pair
+ * of bytes over a few base patterns, then random configs, go through
+ * PAYLOAD_parse_config & PAYLOAD_serialize_config of both versions.
+ * Parsing the serialized config must give back the parsed config
+ * (sensitivities of unknown thresholds are not representable and are
+ * left out), and serializing it again the same bytes.
+ * With fewer data bits, every value of the first bits is swept, the
+ * last ones are random.
+ * Threads take chunks of the spaces from a shared counter. For each
+ * (candidate, field) mismatch the payload with the fewest bits set is
+ * kept as the minimal reproduction. The exit status is 1 on mismatch,
+ * to gate a change of a decode path.
+ *
+ * Usage: sensit_sweep [-t threads] [-b data bits] [-r random configs] [-s seed]
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sensit_payload.h"
+
+/******* DEFINE ****************************************************/
+#define SWEEP_CHUNK_BITS 16
+#define SWEEP_CHUNK_SIZE (1U << SWEEP_CHUNK_BITS)
+#define SWEEP_CONFIG_BASES 3
+#define SWEEP_CONFIG_PAIRS 28 /* Pairs of bytes of a config */
+#define SWEEP_CONFIG_TYPES 2
+#define SWEEP_DEFAULT_RANDOM (1U << 24)
+#define SWEEP_FIELD_BYTES 0xFF /* Config mismatch on the serialized bytes, not on a field */
+
+#define SWEEP_FIELD(type, field) { #field, offsetof(type, field), sizeof(((type *)0)->field) }
+
+/*!******************************************************************
+ * \struct sweep_field_s
+ * \brief Field of data_s or config_s compared
+ *******************************************************************/
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    size_t size;
+} sweep_field_s;
+
+/*!******************************************************************
+ * \struct sweep_candidate_s
+ * \brief Decode path compared to PAYLOAD_parse_data
+ *******************************************************************/
+typedef struct
+{
+    const char *name;
+    payload_type_e type; /*!< Version forced, 0 for none */
+    void (*decode)(u8 *data_in, u32 count, data_s *data_out);
+} sweep_candidate_s;
+
+/*!******************************************************************
+ * \struct sweep_mismatch_s
+ * \brief Mismatches of a (candidate, field), with the minimal input
+ *******************************************************************/
+typedef struct
+{
+    u64 count;
+    u64 input;  /*!< Fewest bits set, then lowest */
+    u32 bits;
+} sweep_mismatch_s;
+
+/*******************************************************************/
+
+static const sweep_field_s sweep_data_fields[] = {
+    SWEEP_FIELD(data_s, error),
+    SWEEP_FIELD(data_s, type),
+    SWEEP_FIELD(data_s, battery_level),
+    SWEEP_FIELD(data_s, mode),
+    SWEEP_FIELD(data_s, button),
+    SWEEP_FIELD(data_s, temperature),
+    SWEEP_FIELD(data_s, humidity),
+    SWEEP_FIELD(data_s, brightness),
+    SWEEP_FIELD(data_s, door),
+    SWEEP_FIELD(data_s, vibration),
+    SWEEP_FIELD(data_s, magnet),
+    SWEEP_FIELD(data_s, event_counter),
+    SWEEP_FIELD(data_s, version_major),
+    SWEEP_FIELD(data_s, version_minor),
+    SWEEP_FIELD(data_s, version_patch),
+};
+#define SWEEP_DATA_FIELDS (sizeof(sweep_data_fields) / sizeof(sweep_field_s))
+
+static const sweep_field_s sweep_config_fields[] = {
+    SWEEP_FIELD(config_s, error),
+    SWEEP_FIELD(config_s, limited),
+    SWEEP_FIELD(config_s, is_standby_periodic),
+    SWEEP_FIELD(config_s, is_temperature_periodic),
+    SWEEP_FIELD(config_s, is_light_periodic),
+    SWEEP_FIELD(config_s, is_door_periodic),
+    SWEEP_FIELD(config_s, is_vibration_periodic),
+    SWEEP_FIELD(config_s, is_magnet_periodic),
+    SWEEP_FIELD(config_s, temperature_low_threshold),
+    SWEEP_FIELD(config_s, temperature_high_threshold),
+    SWEEP_FIELD(config_s, humidity_low_threshold),
+    SWEEP_FIELD(config_s, humidity_high_threshold),
+    SWEEP_FIELD(config_s, brightness_threshold),
+    SWEEP_FIELD(config_s, brightness_low_threshold),
+    SWEEP_FIELD(config_s, brightness_high_threshold),
+    SWEEP_FIELD(config_s, delay),
+    SWEEP_FIELD(config_s, vibration_config),
+    SWEEP_FIELD(config_s, door_config),
+    SWEEP_FIELD(config_s, period),
+};
+#define SWEEP_CONFIG_FIELDS (sizeof(sweep_config_fields) / sizeof(sweep_field_s))
+
+static const u8 sweep_config_bases[SWEEP_CONFIG_BASES] = { 0x00, 0xFF, 0xA5 };
+static const payload_type_e sweep_config_types[SWEEP_CONFIG_TYPES] = { PAYLOAD_V2, PAYLOAD_V3 };
+
+/*******************************************************************/
+
+template <payload_type_e TYPE>
+static void SWEEP_parse_data_as(u8 *data_in, u32 count, data_s *data_out)
+{
+    u32 i;
+
+    memset(data_out, 0, count * sizeof(data_s));
+    for (i = 0; i < count; i++)
+    {
+        PAYLOAD_parse_data_as<TYPE>(data_in + (i * PAYLOAD_DATA_SIZE), data_out + i);
+    }
+}
+
+/* New decode paths are added here */
+static const sweep_candidate_s sweep_data_candidates[] = {
+    { "PAYLOAD_parse_data_batch", (payload_type_e)0, PAYLOAD_parse_data_batch },
+    { "PAYLOAD_parse_data_batch_as<PAYLOAD_V2>", PAYLOAD_V2, PAYLOAD_parse_data_batch_as<PAYLOAD_V2> },
+    { "PAYLOAD_parse_data_batch_as<PAYLOAD_V3>", PAYLOAD_V3, PAYLOAD_parse_data_batch_as<PAYLOAD_V3> },
+    { "PAYLOAD_parse_data_as<PAYLOAD_V2>", PAYLOAD_V2, SWEEP_parse_data_as<PAYLOAD_V2> },
+    { "PAYLOAD_parse_data_as<PAYLOAD_V3>", PAYLOAD_V3, SWEEP_parse_data_as<PAYLOAD_V3> },
+};
+#define SWEEP_DATA_CANDIDATES (sizeof(sweep_data_candidates) / sizeof(sweep_candidate_s))
+
+/*!******************************************************************
+ * \struct sweep_s
+ * \brief Spaces to sweep, shared by the threads
+ *******************************************************************/
+typedef struct
+{
+    u64 data_count;      /*!< Payloads 0 to data_count - 1 */
+    u64 config_count;    /*!< Structured then random configs, per version */
+    u64 structured_count;
+    u64 seed;
+    u64 next;            /*!< Next chunk, taken with __sync_fetch_and_add */
+    u64 chunk_size;
+    bool config;         /*!< Sweeping configs, data payloads before */
+} sweep_s;
+
+/*!******************************************************************
+ * \struct sweep_worker_s
+ * \brief Buffers & mismatches of a thread
+ *******************************************************************/
+typedef struct
+{
+    pthread_t thread;
+    sweep_s *sweep;
+    u8 payloads[SWEEP_CHUNK_SIZE * PAYLOAD_DATA_SIZE];
+    data_s reference[SWEEP_CHUNK_SIZE];
+    data_s candidate[SWEEP_CHUNK_SIZE];
+    sweep_mismatch_s data[SWEEP_DATA_CANDIDATES][SWEEP_DATA_FIELDS];
+    sweep_mismatch_s config[SWEEP_CONFIG_TYPES][SWEEP_CONFIG_FIELDS + 1]; /*!< Last one for the bytes */
+} sweep_worker_s;
+
+/*******************************************************************/
+
+static double SWEEP_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+/*******************************************************************/
+
+static bool SWEEP_equal(const void *a, const void *b, const sweep_field_s *field)
+{
+    return memcmp((const u8 *)a + field->offset, (const u8 *)b + field->offset, field->size) == 0;
+}
+
+/*******************************************************************/
+
+static s64 SWEEP_value(const void *record, const sweep_field_s *field)
+{
+    const u8 *value = (const u8 *)record + field->offset;
+
+    switch (field->size)
+    {
+    case 1:
+        return *value;
+    case 2:
+        return *(const s16 *)value;
+    default:
+        return *(const s32 *)value;
+    }
+}
+
+/*******************************************************************/
+
+static void SWEEP_record(sweep_mismatch_s *mismatch, u64 input)
+{
+    u32 bits = __builtin_popcountll(input);
+
+    if (mismatch->count == 0 || bits < mismatch->bits || (bits == mismatch->bits && input < mismatch->input))
+    {
+        mismatch->input = input;
+        mismatch->bits = bits;
+    }
+    mismatch->count++;
+}
+
+/*******************************************************************/
+
+static void SWEEP_merge(sweep_mismatch_s *mismatch, const sweep_mismatch_s *other)
+{
+    if (other->count == 0)
+    {
+        return;
+    }
+    if (mismatch->count == 0 || other->bits < mismatch->bits || (other->bits == mismatch->bits && other->input < mismatch->input))
+    {
+        mismatch->input = other->input;
+        mismatch->bits = other->bits;
+    }
+    mismatch->count += other->count;
+}
+
+/*******************************************************************/
+
+static void SWEEP_write_payload(u32 payload, u8 *out)
+{
+    out[0] = (u8)(payload >> 24);
+    out[1] = (u8)(payload >> 16);
+    out[2] = (u8)(payload >> 8);
+    out[3] = (u8)payload;
+}
+
+/*******************************************************************/
+
+static u64 SWEEP_splitmix64(u64 x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/*******************************************************************/
+
+static u32 SWEEP_data_input(const sweep_s *sweep, u32 index)
+{
+    u32 bits = __builtin_ctzll(sweep->data_count);
+
+    if (bits == 32)
+    {
+        return index;
+    }
+    /* Every value of the first bits, that select version & mode, the others mixed */
+    return (index << (32 - bits)) | ((u32)SWEEP_splitmix64(sweep->seed + index) >> bits);
+}
+
+/*******************************************************************/
+
+static void SWEEP_data_chunk(sweep_worker_s *worker, u32 first, u32 count)
+{
+    const sweep_candidate_s *candidate;
+    const data_s *expected;
+    const data_s *got;
+    u32 input;
+    u32 c;
+    u32 f;
+    u32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        SWEEP_write_payload(SWEEP_data_input(worker->sweep, first + i), worker->payloads + (i * PAYLOAD_DATA_SIZE));
+    }
+    memset(worker->reference, 0, count * sizeof(data_s));
+    for (i = 0; i < count; i++)
+    {
+        PAYLOAD_parse_data(worker->payloads + (i * PAYLOAD_DATA_SIZE), worker->reference + i);
+    }
+
+    for (c = 0; c < SWEEP_DATA_CANDIDATES; c++)
+    {
+        candidate = sweep_data_candidates + c;
+        memset(worker->candidate, 0xA5, count * sizeof(data_s));
+        candidate->decode(worker->payloads, count, worker->candidate);
+        for (i = 0; i < count; i++)
+        {
+            expected = worker->reference + i;
+            got = worker->candidate + i;
+            input = SWEEP_data_input(worker->sweep, first + i);
+            if (candidate->type != 0 && expected->type != candidate->type)
+            {
+                /* A payload of another version is only flagged */
+                if (got->error != PARSE_ERR_TYPE)
+                {
+                    SWEEP_record(&(worker->data[c][0]), input);
+                }
+                continue;
+            }
+            for (f = 0; f < SWEEP_DATA_FIELDS; f++)
+            {
+                if (!SWEEP_equal(expected, got, sweep_data_fields + f))
+                {
+                    SWEEP_record(&(worker->data[c][f]), input);
+                }
+            }
+        }
+    }
+}
+
+/*******************************************************************/
+
+static u64 SWEEP_config_input(const sweep_s *sweep, u64 index)
+{
+    u64 input;
+    u64 pair;
+    u32 high = 0;
+    u32 low;
+    u32 base;
+
+    if (index >= sweep->structured_count)
+    {
+        return SWEEP_splitmix64(sweep->seed + index);
+    }
+    /* Every value of bytes (high, low) of a base pattern, byte 0 first */
+    base = (u32)(index / (SWEEP_CONFIG_PAIRS << 16));
+    pair = (index >> 16) % SWEEP_CONFIG_PAIRS;
+    for (low = 1; pair >= PAYLOAD_CONFIG_SIZE - low; low++)
+    {
+        pair -= PAYLOAD_CONFIG_SIZE - low;
+        high++;
+    }
+    low = high + 1 + (u32)pair;
+    input = sweep_config_bases[base] * 0x0101010101010101ULL;
+    input &= ~((0xFFULL << ((7 - high) * 8)) | (0xFFULL << ((7 - low) * 8)));
+    input |= ((index >> 8) & 0xFF) << ((7 - high) * 8);
+    input |= (index & 0xFF) << ((7 - low) * 8);
+    return input;
+}
+
+/*******************************************************************/
+
+static void SWEEP_config_chunk(sweep_worker_s *worker, u64 first, u64 count)
+{
+    const sweep_field_s *field;
+    config_s parsed;
+    config_s reparsed;
+    u8 config[PAYLOAD_CONFIG_SIZE];
+    u8 serialized[PAYLOAD_CONFIG_SIZE];
+    u8 reserialized[PAYLOAD_CONFIG_SIZE];
+    u64 input;
+    u64 i;
+    u32 t;
+    u32 f;
+    u32 k;
+
+    for (i = first; i < first + count; i++)
+    {
+        input = SWEEP_config_input(worker->sweep, i);
+        for (k = 0; k < PAYLOAD_CONFIG_SIZE; k++)
+        {
+            config[k] = (u8)(input >> ((7 - k) * 8));
+        }
+        for (t = 0; t < SWEEP_CONFIG_TYPES; t++)
+        {
+            memset(&parsed, 0, sizeof(config_s));
+            memset(&reparsed, 0, sizeof(config_s));
+            memset(serialized, 0, PAYLOAD_CONFIG_SIZE);
+            memset(reserialized, 0, PAYLOAD_CONFIG_SIZE);
+            PAYLOAD_parse_config(config, sweep_config_types[t], &parsed);
+            PAYLOAD_serialize_config(parsed, sweep_config_types[t], serialized);
+            PAYLOAD_parse_config(serialized, sweep_config_types[t], &reparsed);
+            PAYLOAD_serialize_config(reparsed, sweep_config_types[t], reserialized);
+
+            for (f = 0; f < SWEEP_CONFIG_FIELDS; f++)
+            {
+                field = sweep_config_fields + f;
+                if ((field->offset == offsetof(config_s, vibration_config) && parsed.vibration_config == VIBRATION_CONFIG_UNKNOW) ||
+                    (field->offset == offsetof(config_s, door_config) && parsed.door_config == DOOR_CONFIG_UNKNOW))
+                {
+                    continue;
+                }
+                if (!SWEEP_equal(&parsed, &reparsed, field))
+                {
+                    SWEEP_record(&(worker->config[t][f]), input);
+                }
+            }
+            if (memcmp(serialized, reserialized, PAYLOAD_CONFIG_SIZE) != 0)
+            {
+                SWEEP_record(&(worker->config[t][SWEEP_CONFIG_FIELDS]), input);
+            }
+        }
+    }
+}
+
+/*******************************************************************/
+
+static void *SWEEP_run(void *arg)
+{
+    sweep_worker_s *worker = (sweep_worker_s *)arg;
+    sweep_s *sweep = worker->sweep;
+    u64 total = sweep->config ? sweep->config_count : sweep->data_count;
+    u64 first;
+    u64 count;
+
+    while ((first = __sync_fetch_and_add(&(sweep->next), sweep->chunk_size)) < total)
+    {
+        count = (total - first < sweep->chunk_size) ? total - first : sweep->chunk_size;
+        if (sweep->config)
+        {
+            SWEEP_config_chunk(worker, first, count);
+        }
+        else
+        {
+            SWEEP_data_chunk(worker, (u32)first, (u32)count);
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************/
+
+static bool SWEEP_phase(sweep_s *sweep, sweep_worker_s *workers, u32 thread_count, bool config)
+{
+    u32 i;
+
+    sweep->config = config;
+    sweep->next = 0;
+    sweep->chunk_size = config ? SWEEP_CHUNK_SIZE / 16 : SWEEP_CHUNK_SIZE;
+    for (i = 0; i < thread_count; i++)
+    {
+        if (pthread_create(&(workers[i].thread), NULL, SWEEP_run, workers + i) != 0)
+        {
+            fprintf(stderr, "sensit_sweep: unable to start thread %u\n", i);
+            thread_count = i;
+            break;
+        }
+    }
+    for (i = 0; i < thread_count; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+    }
+    return thread_count != 0;
+}
+
+/*******************************************************************/
+
+static u64 SWEEP_report_data(sweep_worker_s *workers, u32 thread_count)
+{
+    const sweep_candidate_s *candidate;
+    sweep_mismatch_s mismatch;
+    data_s expected;
+    data_s got;
+    u8 payload[PAYLOAD_DATA_SIZE];
+    u64 total = 0;
+    u32 c;
+    u32 f;
+    u32 i;
+
+    for (c = 0; c < SWEEP_DATA_CANDIDATES; c++)
+    {
+        candidate = sweep_data_candidates + c;
+        for (f = 0; f < SWEEP_DATA_FIELDS; f++)
+        {
+            memset(&mismatch, 0, sizeof(mismatch));
+            for (i = 0; i < thread_count; i++)
+            {
+                SWEEP_merge(&mismatch, &(workers[i].data[c][f]));
+            }
+            if (mismatch.count == 0)
+            {
+                continue;
+            }
+            total += mismatch.count;
+
+            /* Decode the minimal reproduction again to show both values */
+            SWEEP_write_payload((u32)mismatch.input, payload);
+            memset(&expected, 0, sizeof(data_s));
+            PAYLOAD_parse_data(payload, &expected);
+            candidate->decode(payload, 1, &got);
+            printf("MISMATCH %s %s: %llu payloads, minimal %08x: expected %lld, got %lld\n",
+                   candidate->name, sweep_data_fields[f].name, mismatch.count, (u32)mismatch.input,
+                   SWEEP_value(&expected, sweep_data_fields + f), SWEEP_value(&got, sweep_data_fields + f));
+        }
+    }
+    return total;
+}
+
+/*******************************************************************/
+
+static u64 SWEEP_report_config(sweep_worker_s *workers, u32 thread_count)
+{
+    sweep_mismatch_s mismatch;
+    u64 total = 0;
+    u32 t;
+    u32 f;
+    u32 i;
+
+    for (t = 0; t < SWEEP_CONFIG_TYPES; t++)
+    {
+        for (f = 0; f <= SWEEP_CONFIG_FIELDS; f++)
+        {
+            memset(&mismatch, 0, sizeof(mismatch));
+            for (i = 0; i < thread_count; i++)
+            {
+                SWEEP_merge(&mismatch, &(workers[i].config[t][f]));
+            }
+            if (mismatch.count == 0)
+            {
+                continue;
+            }
+            total += mismatch.count;
+            printf("MISMATCH config v%u round trip %s: %llu configs, minimal %016llx\n", sweep_config_types[t],
+                   f == SWEEP_CONFIG_FIELDS ? "bytes" : sweep_config_fields[f].name, mismatch.count, mismatch.input);
+        }
+    }
+    return total;
+}
+
+/*******************************************************************/
+
+int main(int argc, char *argv[])
+{
+    sweep_s sweep;
+    sweep_worker_s *workers;
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    long bits = 32;
+    unsigned long long random_count = SWEEP_DEFAULT_RANDOM;
+    u64 mismatches;
+    double start;
+    double elapsed;
+    int option;
+
+    memset(&sweep, 0, sizeof(sweep));
+    sweep.seed = 1;
+    while ((option = getopt(argc, argv, "t:b:r:s:h")) != -1)
+    {
+        switch (option)
+        {
+        case 't':
+            thread_count = strtol(optarg, NULL, 10);
+            break;
+        case 'b':
+            bits = strtol(optarg, NULL, 10);
+            break;
+        case 'r':
+            random_count = strtoull(optarg, NULL, 10);
+            break;
+        case 's':
+            sweep.seed = strtoull(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t threads] [-b data bits, 1 to 32] [-r random configs] [-s seed]\n", argv[0]);
+            return (option == 'h') ? 0 : 2;
+        }
+    }
+    if (thread_count < 1 || thread_count > 1024 || bits < 1 || bits > 32)
+    {
+        fprintf(stderr, "sensit_sweep: invalid threads or data bits\n");
+        return 2;
+    }
+
+    workers = (sweep_worker_s *)calloc(thread_count, sizeof(sweep_worker_s));
+    if (workers == NULL)
+    {
+        fprintf(stderr, "sensit_sweep: out of memory\n");
+        return 2;
+    }
+    for (option = 0; option < thread_count; option++)
+    {
+        workers[option].sweep = &sweep;
+    }
+    sweep.data_count = 1ULL << bits;
+    sweep.structured_count = (u64)SWEEP_CONFIG_BASES * SWEEP_CONFIG_PAIRS << 16;
+    sweep.config_count = sweep.structured_count + random_count;
+
+    start = SWEEP_now();
+    if (!SWEEP_phase(&sweep, workers, (u32)thread_count, FALSE))
+    {
+        return 2;
+    }
+    elapsed = SWEEP_now() - start;
+    printf("data: %llu payloads x %u candidates in %.1f s, %.1f M payloads/s on %ld threads\n", sweep.data_count,
+           (u32)SWEEP_DATA_CANDIDATES, elapsed, (double)sweep.data_count / elapsed / 1e6, thread_count);
+    fflush(stdout);
+
+    start = SWEEP_now();
+    if (!SWEEP_phase(&sweep, workers, (u32)thread_count, TRUE))
+    {
+        return 2;
+    }
+    elapsed = SWEEP_now() - start;
+    printf("config: %llu configs (%llu structured, seed %llu) x %u versions in %.1f s, %.1f M configs/s\n",
+           sweep.config_count, sweep.structured_count, sweep.seed, SWEEP_CONFIG_TYPES, elapsed,
+           (double)sweep.config_count / elapsed / 1e6);
+
+    mismatches = SWEEP_report_data(workers, (u32)thread_count);
+    mismatches += SWEEP_report_config(workers, (u32)thread_count);
+    printf("%s: %llu mismatches\n", mismatches ? "FAIL" : "OK", mismatches);
+    free(workers);
+    return mismatches ? 1 : 0;
+}
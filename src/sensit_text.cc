@@ -0,0 +1,608 @@
+/*!******************************************************************
+ * \file sensit_text.c
+ * \brief Functions to write decoded payloads as NDJSON or CSV
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_text.h"
+
+/******* DEFINE ****************************************************/
+#define TEXT_MIN_CAPACITY 4096
+#define TEXT_LINE_ESTIMATE 160
+#define TEXT_MAX_LINE 512            /* Longest line, every column with a device & time */
+#define TEXT_DOOR_NOT_CALIBRATED 4   /* Door of a v3 not calibrated, as in the JavaScript */
+
+#define TEXT_BATTERY_OFFSET 2700
+#define TEXT_BATTERY_STEP 50
+#define TEXT_BATTERY_LEVELS 64       /* Levels of the 5 bits of a v3 & of a v2 */
+
+/*!******************************************************************
+ * \struct text_name_s
+ * \brief Name of a column, as a CSV header & as a JSON key with its separators
+ *******************************************************************/
+typedef struct
+{
+    const char *name;
+    const char *key; /*!< ,"name": */
+    u32 key_length;
+} text_name_s;
+
+#define TEXT_NAME(name) { name, ",\"" name "\":", sizeof(",\"" name "\":") - 1 }
+
+static const text_name_s TEXT_NAMES[TEXT_COLUMN_LAST] = {
+    TEXT_NAME("error"), TEXT_NAME("type"), TEXT_NAME("temperature"), TEXT_NAME("humidity"),
+    TEXT_NAME("light"), TEXT_NAME("version"), TEXT_NAME("door"), TEXT_NAME("magnet"),
+    TEXT_NAME("vibration"), TEXT_NAME("eventCounter"), TEXT_NAME("button"), TEXT_NAME("battery"),
+    TEXT_NAME("batteryIndicator"), TEXT_NAME("batteryLevel"), TEXT_NAME("modeCode"), TEXT_NAME("mode")
+};
+
+/*!******************************************************************
+ * \struct text_battery_s
+ * \brief Battery percentage & indicator of each battery level
+ *******************************************************************/
+typedef struct
+{
+    u8 percentage[TEXT_BATTERY_LEVELS];
+    u8 indicator[TEXT_BATTERY_LEVELS];
+} text_battery_s;
+
+static const char *TEXT_MODES[MODE_LAST] = { "standby", "temperature", "light", "door", "vibration", "magnet" };
+
+static const char TEXT_HEX[] = "0123456789ABCDEF";
+
+static const char TEXT_DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/*******************************************************************/
+
+static u8 *TEXT_write_string(u8 *out, const char *text)
+{
+    u32 length = strlen(text);
+
+    memcpy(out, text, length);
+    return out + length;
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_uint(u8 *out, u32 value)
+{
+    char digits[10];
+    u32 count = 0;
+
+    /* Most values are a single or two digits */
+    if (value < 10)
+    {
+        *out = '0' + value;
+        return out + 1;
+    }
+    if (value < 100)
+    {
+        memcpy(out, &(TEXT_DIGIT_PAIRS[value * 2]), 2);
+        return out + 2;
+    }
+    while (value >= 100)
+    {
+        count += 2;
+        memcpy(&(digits[sizeof(digits) - count]), &(TEXT_DIGIT_PAIRS[(value % 100) * 2]), 2);
+        value /= 100;
+    }
+    if (value >= 10)
+    {
+        count += 2;
+        memcpy(&(digits[sizeof(digits) - count]), &(TEXT_DIGIT_PAIRS[value * 2]), 2);
+    }
+    else
+    {
+        digits[sizeof(digits) - ++count] = '0' + value;
+    }
+    memcpy(out, &(digits[sizeof(digits) - count]), count);
+    return out + count;
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_hex(u8 *out, u32 value)
+{
+    char digits[8];
+    u32 count = 0;
+
+    do
+    {
+        digits[count++] = TEXT_HEX[value & 0x0F];
+        value >>= 4;
+    } while (value != 0);
+    while (count != 0)
+    {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_fixed(u8 *out, s32 value, u32 decimals)
+{
+    u32 magnitude = (value < 0) ? (u32)(-(s64)value) : (u32)value;
+    u32 factor = (decimals == 1) ? 10 : 100;
+    u32 fraction = magnitude % factor;
+
+    /* Shortest form, as JavaScript prints a number: no trailing zeros */
+    if (value < 0)
+    {
+        *out++ = '-';
+    }
+    out = TEXT_write_uint(out, magnitude / factor);
+    if (fraction != 0)
+    {
+        *out++ = '.';
+        if (decimals == 2)
+        {
+            *out++ = '0' + (fraction / 10);
+            fraction %= 10;
+        }
+        if (fraction != 0)
+        {
+            *out++ = '0' + fraction;
+        }
+    }
+    return out;
+}
+
+/*******************************************************************/
+
+static s32 TEXT_floor_div(s32 numerator, s32 denominator)
+{
+    s32 quotient = numerator / denominator;
+
+    return ((numerator % denominator != 0) && (numerator < 0)) ? quotient - 1 : quotient;
+}
+
+/*******************************************************************/
+
+static double TEXT_round(double value)
+{
+    /* Math.round(): nearest integer, halves rounded up */
+    double floored = floor(value);
+
+    return (value - floored >= 0.5) ? floored + 1 : floored;
+}
+
+/*******************************************************************/
+
+static u32 TEXT_battery_percentage(u16 battery_level)
+{
+    /* getBatteryPercentage() of the JavaScript, the same double operations */
+    double voltage = battery_level / 1000.0;
+    double percentage = 0;
+
+    if (voltage >= 4.15)
+    {
+        percentage = 100;
+    }
+    else if (voltage >= 3.8)
+    {
+        percentage = TEXT_round((voltage - 3.275) * 114);
+    }
+    else if (voltage >= 3.6)
+    {
+        percentage = TEXT_round((voltage - 3.56) * 250);
+    }
+    else if (voltage > 3)
+    {
+        percentage = TEXT_round((voltage - 3) * 16);
+    }
+    return (percentage < 0) ? 0 : (u32)percentage;
+}
+
+/*******************************************************************/
+
+static u32 TEXT_battery_indicator(u16 battery_level)
+{
+    /* getBatteryIndicator() of the JavaScript */
+    double voltage = battery_level / 1000.0;
+
+    if (voltage > 3.9)
+    {
+        return 4;
+    }
+    if (voltage >= 3.6)
+    {
+        return (voltage > 3.7) ? 3 : 2;
+    }
+    if (voltage >= 2.7)
+    {
+        return (voltage > 3.1) ? 1 : 0;
+    }
+    return 0;
+}
+
+/*******************************************************************/
+
+static u32 TEXT_present_columns(const data_s *data)
+{
+    /* Fields of formatData(): a v2 with its button pressed only sends the temperature */
+    bool is_v2_button = (data->type == PAYLOAD_V2) && data->button;
+    u32 columns = TEXT_COLUMNS_ALL & ~((1U << TEXT_COLUMN_TEMPERATURE) | (1U << TEXT_COLUMN_HUMIDITY) |
+                                       (1U << TEXT_COLUMN_LIGHT) | (1U << TEXT_COLUMN_VERSION) |
+                                       (1U << TEXT_COLUMN_DOOR) | (1U << TEXT_COLUMN_MAGNET) |
+                                       (1U << TEXT_COLUMN_VIBRATION) | (1U << TEXT_COLUMN_EVENT_COUNTER) |
+                                       (1U << TEXT_COLUMN_MODE));
+
+    if (data->mode < MODE_LAST)
+    {
+        columns |= 1U << TEXT_COLUMN_MODE;
+    }
+    if (data->mode == MODE_TEMPERATURE)
+    {
+        columns |= 1U << TEXT_COLUMN_TEMPERATURE;
+    }
+    if (data->mode == MODE_STANDBY)
+    {
+        columns |= 1U << TEXT_COLUMN_VERSION;
+    }
+    else if (!is_v2_button)
+    {
+        switch (data->mode)
+        {
+        case MODE_TEMPERATURE:
+            columns |= 1U << TEXT_COLUMN_HUMIDITY;
+            break;
+        case MODE_LIGHT:
+            columns |= 1U << TEXT_COLUMN_LIGHT;
+            break;
+        case MODE_DOOR:
+            columns |= (1U << TEXT_COLUMN_DOOR) | (1U << TEXT_COLUMN_EVENT_COUNTER);
+            break;
+        case MODE_VIBRATION:
+            columns |= (1U << TEXT_COLUMN_VIBRATION) | (1U << TEXT_COLUMN_EVENT_COUNTER);
+            break;
+        case MODE_MAGNET:
+            columns |= (1U << TEXT_COLUMN_MAGNET) | (1U << TEXT_COLUMN_EVENT_COUNTER);
+            break;
+        default:
+            break;
+        }
+    }
+    return columns;
+}
+
+/*******************************************************************/
+
+static bool TEXT_battery_index(u16 battery_level, u32 *index)
+{
+    *index = (u32)(battery_level - TEXT_BATTERY_OFFSET) / TEXT_BATTERY_STEP;
+    return (battery_level >= TEXT_BATTERY_OFFSET) && (*index < TEXT_BATTERY_LEVELS) &&
+           ((battery_level - TEXT_BATTERY_OFFSET) % TEXT_BATTERY_STEP == 0);
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_value(u8 *out, const data_s *data, u32 column, bool quote, const text_battery_s *battery)
+{
+    u32 index;
+
+    switch (column)
+    {
+    case TEXT_COLUMN_ERROR:
+        return TEXT_write_uint(out, data->error);
+    case TEXT_COLUMN_TYPE:
+        return TEXT_write_uint(out, data->type);
+    case TEXT_COLUMN_TEMPERATURE:
+        /* round(temperature / 8, 2) = floor((temperature * 12.5) + 0.5) hundredths */
+        return TEXT_write_fixed(out, TEXT_floor_div((25 * data->temperature) + 1, 2), 2);
+    case TEXT_COLUMN_HUMIDITY:
+        /* round(humidity / 2, 1) */
+        return TEXT_write_fixed(out, 5 * data->humidity, 1);
+    case TEXT_COLUMN_LIGHT:
+        /* round(brightness / 96, 2) = floor((brightness * 100 / 96) + 0.5) hundredths */
+        return TEXT_write_fixed(out, TEXT_floor_div((50 * data->brightness) + 24, 48), 2);
+    case TEXT_COLUMN_VERSION:
+        if (quote)
+        {
+            *out++ = '"';
+        }
+        out = TEXT_write_uint(out, data->version_major);
+        *out++ = '.';
+        out = TEXT_write_uint(out, data->version_minor);
+        *out++ = '.';
+        out = TEXT_write_uint(out, data->version_patch);
+        if (quote)
+        {
+            *out++ = '"';
+        }
+        return out;
+    case TEXT_COLUMN_DOOR:
+        return TEXT_write_uint(out, ((data->door == DOOR_NONE) && (data->type == PAYLOAD_V3)) ? TEXT_DOOR_NOT_CALIBRATED : data->door);
+    case TEXT_COLUMN_MAGNET:
+        return TEXT_write_string(out, data->magnet ? "true" : "false");
+    case TEXT_COLUMN_VIBRATION:
+        return TEXT_write_string(out, data->vibration ? "true" : "false");
+    case TEXT_COLUMN_EVENT_COUNTER:
+        return TEXT_write_uint(out, data->event_counter);
+    case TEXT_COLUMN_BUTTON:
+        return TEXT_write_string(out, data->button ? "true" : "false");
+    case TEXT_COLUMN_BATTERY:
+        return TEXT_write_uint(out, (battery != NULL && TEXT_battery_index(data->battery_level, &index)) ? battery->percentage[index]
+                                                                                                         : TEXT_battery_percentage(data->battery_level));
+    case TEXT_COLUMN_BATTERY_INDICATOR:
+        return TEXT_write_uint(out, (battery != NULL && TEXT_battery_index(data->battery_level, &index)) ? battery->indicator[index]
+                                                                                                         : TEXT_battery_indicator(data->battery_level));
+    case TEXT_COLUMN_BATTERY_LEVEL:
+        return TEXT_write_uint(out, data->battery_level);
+    case TEXT_COLUMN_MODE_CODE:
+        return TEXT_write_uint(out, data->mode);
+    case TEXT_COLUMN_MODE:
+        if (quote)
+        {
+            *out++ = '"';
+        }
+        out = TEXT_write_string(out, TEXT_MODES[data->mode]);
+        if (quote)
+        {
+            *out++ = '"';
+        }
+        return out;
+    default:
+        return out;
+    }
+}
+
+/*******************************************************************/
+
+/* Shortest decimal that reads back as the same double, like JSON.stringify.
+   Values are thresholds / 96, without exponent once integers are apart */
+static u8 *TEXT_write_double(u8 *out, double value)
+{
+    char text[32];
+    s32 precision;
+
+    if (value == (double)(s32)value)
+    {
+        snprintf(text, sizeof(text), "%d", (s32)value);
+        return TEXT_write_string(out, text);
+    }
+    for (precision = 1; precision < 17; precision++)
+    {
+        snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (strtod(text, NULL) == value)
+        {
+            return TEXT_write_string(out, text);
+        }
+    }
+    snprintf(text, sizeof(text), "%.17g", value);
+    return TEXT_write_string(out, text);
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_int(u8 *out, s32 value)
+{
+    if (value < 0)
+    {
+        *out++ = '-';
+        return TEXT_write_uint(out, (u32)(-(s64)value));
+    }
+    return TEXT_write_uint(out, (u32)value);
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_json(u8 *out, const data_s *data, const u32 *device_id, const u32 *time, u32 columns,
+                           const text_battery_s *battery)
+{
+    u8 *line = out;
+    u32 column;
+
+    /* Every field starts with a comma, the first one becomes the opening brace */
+    if (device_id != NULL)
+    {
+        out = TEXT_write_string(out, ",\"device\":\"");
+        out = TEXT_write_hex(out, *device_id);
+        *out++ = '"';
+    }
+    if (time != NULL)
+    {
+        out = TEXT_write_uint(TEXT_write_string(out, ",\"time\":"), *time);
+    }
+    columns &= TEXT_present_columns(data);
+    while (columns != 0)
+    {
+        column = __builtin_ctz(columns);
+        columns &= columns - 1;
+        memcpy(out, TEXT_NAMES[column].key, TEXT_NAMES[column].key_length);
+        out = TEXT_write_value(out + TEXT_NAMES[column].key_length, data, column, TRUE, battery);
+    }
+    if (out == line)
+    {
+        *out++ = '{';
+    }
+    else
+    {
+        *line = '{';
+    }
+    *out++ = '}';
+    *out++ = '\n';
+    return out;
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_csv(u8 *out, const data_s *data, const u32 *device_id, const u32 *time, u32 columns,
+                          const text_battery_s *battery)
+{
+    u8 *line = out;
+    u32 present = TEXT_present_columns(data);
+    u32 column;
+
+    /* Every field ends with a comma, the last one becomes the end of line */
+    if (device_id != NULL)
+    {
+        out = TEXT_write_hex(out, *device_id);
+        *out++ = ',';
+    }
+    if (time != NULL)
+    {
+        out = TEXT_write_uint(out, *time);
+        *out++ = ',';
+    }
+    while (columns != 0)
+    {
+        column = __builtin_ctz(columns);
+        columns &= columns - 1;
+        if (present & (1U << column))
+        {
+            out = TEXT_write_value(out, data, column, FALSE, battery);
+        }
+        *out++ = ',';
+    }
+    if (out == line)
+    {
+        out++;
+    }
+    out[-1] = '\n';
+    return out;
+}
+
+/*******************************************************************/
+
+static u8 *TEXT_write_header(u8 *out, bool device, bool time, u32 columns)
+{
+    u8 *line = out;
+    u32 column;
+
+    if (device)
+    {
+        out = TEXT_write_string(out, "device,");
+    }
+    if (time)
+    {
+        out = TEXT_write_string(out, "time,");
+    }
+    for (column = 0; column < TEXT_COLUMN_LAST; column++)
+    {
+        if (columns & (1U << column))
+        {
+            out = TEXT_write_string(out, TEXT_NAMES[column].name);
+            *out++ = ',';
+        }
+    }
+    if (out == line)
+    {
+        out++;
+    }
+    out[-1] = '\n';
+    return out;
+}
+
+/*******************************************************************/
+
+u8 TEXT_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times,
+                   text_format_e format, u32 columns, bool header, u8 **text_out, u32 *text_size)
+{
+    u64 capacity = ((u64)count * TEXT_LINE_ESTIMATE) + TEXT_MAX_LINE;
+    u8 *text;
+    u8 *out;
+    u32 size = 0;
+    void *grown;
+    data_s data;
+    text_battery_s battery;
+    u32 i;
+
+    capacity = (capacity < TEXT_MIN_CAPACITY) ? TEXT_MIN_CAPACITY : capacity;
+    text = (u8 *)malloc(capacity);
+    if (text == NULL)
+    {
+        return TEXT_ERR_ALLOC;
+    }
+    columns &= TEXT_COLUMNS_ALL;
+    for (i = 0; i < TEXT_BATTERY_LEVELS; i++)
+    {
+        battery.percentage[i] = TEXT_battery_percentage(TEXT_BATTERY_OFFSET + (i * TEXT_BATTERY_STEP));
+        battery.indicator[i] = TEXT_battery_indicator(TEXT_BATTERY_OFFSET + (i * TEXT_BATTERY_STEP));
+    }
+
+    if (format == TEXT_FORMAT_CSV && header)
+    {
+        size = TEXT_write_header(text, device_ids != NULL, times != NULL, columns) - text;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (capacity - size < TEXT_MAX_LINE)
+        {
+            grown = realloc(text, capacity * 2);
+            if (grown == NULL)
+            {
+                free(text);
+                return TEXT_ERR_ALLOC;
+            }
+            text = (u8 *)grown;
+            capacity *= 2;
+        }
+
+        memset(&data, 0, sizeof(data));
+        PAYLOAD_parse_data(data_in + (i * PAYLOAD_DATA_SIZE), &data);
+        out = text + size;
+        if (format == TEXT_FORMAT_CSV)
+        {
+            out = TEXT_write_csv(out, &data, (device_ids != NULL) ? &(device_ids[i]) : NULL,
+                                 (times != NULL) ? &(times[i]) : NULL, columns, &battery);
+        }
+        else
+        {
+            out = TEXT_write_json(out, &data, (device_ids != NULL) ? &(device_ids[i]) : NULL,
+                                  (times != NULL) ? &(times[i]) : NULL, columns, &battery);
+        }
+        size = out - text;
+    }
+
+    *text_out = text;
+    *text_size = size;
+    return TEXT_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 *TEXT_write_json_data(const data_s *data, u8 *out)
+{
+    /* Without the line feed of an NDJSON line */
+    return TEXT_write_json(out, data, NULL, NULL, TEXT_COLUMNS_ALL, NULL) - 1;
+}
+
+/*******************************************************************/
+
+u8 *TEXT_write_json_config(const config_s *config, payload_type_e type, u8 *out)
+{
+    /* Keys in the order of parseConfig() */
+    if (type == PAYLOAD_V3)
+    {
+        out = TEXT_write_string(out, config->is_standby_periodic ? "{\"isStandByPeriodic\":true" : "{\"isStandByPeriodic\":false");
+        out = TEXT_write_string(out, config->is_temperature_periodic ? ",\"isTemperaturePeriodic\":true" : ",\"isTemperaturePeriodic\":false");
+        out = TEXT_write_string(out, config->is_light_periodic ? ",\"isLightPeriodic\":true" : ",\"isLightPeriodic\":false");
+        out = TEXT_write_string(out, config->is_door_periodic ? ",\"isDoorPeriodic\":true" : ",\"isDoorPeriodic\":false");
+        out = TEXT_write_string(out, config->is_vibration_periodic ? ",\"isVibrationPeriodic\":true" : ",\"isVibrationPeriodic\":false");
+        out = TEXT_write_string(out, config->is_magnet_periodic ? ",\"isMagnetPeriodic\":true" : ",\"isMagnetPeriodic\":false");
+        out = TEXT_write_uint(TEXT_write_string(out, ",\"vibrationClearTime\":"), config->delay);
+        out = TEXT_write_uint(TEXT_write_string(out, ",\"lightThreshold\":"), config->brightness_threshold);
+    }
+    else
+    {
+        out = TEXT_write_double(TEXT_write_string(out, "{\"lightUpper\":"), config->brightness_high_threshold / 96.0);
+        out = TEXT_write_double(TEXT_write_string(out, ",\"lightLower\":"), config->brightness_low_threshold / 96.0);
+    }
+    out = TEXT_write_int(TEXT_write_string(out, ",\"temperatureLower\":"), config->temperature_low_threshold);
+    out = TEXT_write_int(TEXT_write_string(out, ",\"temperatureUpper\":"), config->temperature_high_threshold);
+    out = TEXT_write_uint(TEXT_write_string(out, ",\"humidityLower\":"), config->humidity_low_threshold);
+    out = TEXT_write_uint(TEXT_write_string(out, ",\"humidityUpper\":"), config->humidity_high_threshold);
+    out = TEXT_write_uint(TEXT_write_string(out, ",\"vibrationSensitivity\":"), config->vibration_config);
+    out = TEXT_write_uint(TEXT_write_string(out, ",\"door\":"), config->door_config);
+    out = TEXT_write_uint(TEXT_write_string(out, ",\"period\":"), config->period);
+    return TEXT_write_string(out, config->limited ? ",\"limited\":true}" : ",\"limited\":false}");
+}
@@ -0,0 +1,92 @@
+/*!******************************************************************
+ * \file sensit_text.h
+ * \brief Functions to write decoded payloads as NDJSON or CSV
+ * \author Sens'it Team
+ *
+ * A batch of raw "data" payloads is decoded and written straight as
+ * text, one line per payload, with the fields and units of the
+ * JavaScript formatData(): an NDJSON line is byte for byte the
+ * JSON.stringify() of the parsed object. Values divided by 8, 2 or 96
+ * are written from integers as exact fixed point decimals rounded like
+ * the JavaScript round(), without any floating point formatting. The
+ * output buffer is allocated with malloc and owned by the caller.
+ *******************************************************************/
+
+#define TEXT_ERR_NONE 0x00
+#define TEXT_ERR_ALLOC 0x01
+
+#define TEXT_JSON_MAX_SIZE 512 /* Longest object of TEXT_write_json_data & TEXT_write_json_config */
+
+/*!******************************************************************
+ * \enum text_format_e
+ * \brief Text flavours
+ *******************************************************************/
+typedef enum {
+    TEXT_FORMAT_NDJSON = 0, /*!< One JSON object per line, fields of another mode are omitted */
+    TEXT_FORMAT_CSV = 1,    /*!< Optional header line, fields of another mode are empty */
+    TEXT_FORMAT_LAST
+} text_format_e;
+
+/*!******************************************************************
+ * \enum text_column_e
+ * \brief Columns, in the order of the formatData() keys
+ *******************************************************************/
+typedef enum {
+    TEXT_COLUMN_ERROR = 0,
+    TEXT_COLUMN_TYPE,
+    TEXT_COLUMN_TEMPERATURE,       /*!< °C, 2 decimals */
+    TEXT_COLUMN_HUMIDITY,          /*!< %, 1 decimal */
+    TEXT_COLUMN_LIGHT,             /*!< lux, 2 decimals */
+    TEXT_COLUMN_VERSION,           /*!< "major.minor.patch" */
+    TEXT_COLUMN_DOOR,
+    TEXT_COLUMN_MAGNET,
+    TEXT_COLUMN_VIBRATION,
+    TEXT_COLUMN_EVENT_COUNTER,
+    TEXT_COLUMN_BUTTON,
+    TEXT_COLUMN_BATTERY,           /*!< % */
+    TEXT_COLUMN_BATTERY_INDICATOR, /*!< 0 to 4 */
+    TEXT_COLUMN_BATTERY_LEVEL,     /*!< mV */
+    TEXT_COLUMN_MODE_CODE,
+    TEXT_COLUMN_MODE,              /*!< Name of the mode */
+    TEXT_COLUMN_LAST
+} text_column_e;
+
+#define TEXT_COLUMNS_ALL ((1U << TEXT_COLUMN_LAST) - 1)
+
+/*!************************************************************************
+ * \fn u8 TEXT_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times, text_format_e format, u32 columns, bool header, u8 **text_out, u32 *text_size)
+ * \brief Decode a batch of payloads into NDJSON or CSV lines.
+ *
+ * \param[in] data_in               count payloads of PAYLOAD_DATA_SIZE length
+ * \param[in] count                 Number of payloads
+ * \param[in] device_ids            Optional "device" first column, as hexadecimal, may be NULL
+ * \param[in] times                 Optional "time" column in seconds since epoch, may be NULL
+ * \param[in] format                NDJSON or CSV
+ * \param[in] columns               Bit per text_column_e written, TEXT_COLUMNS_ALL for all
+ * \param[in] header                CSV only, write the line of the column names first
+ * \param[out] text_out             Buffer allocated with malloc
+ * \param[out] text_size            Length of text_out
+ * \retval                          TEXT_ERR_NONE or TEXT_ERR_ALLOC
+ **************************************************************************/
+u8 TEXT_write_data(u8 *data_in, u32 count, const u32 *device_ids, const u32 *times,
+                   text_format_e format, u32 columns, bool header, u8 **text_out, u32 *text_size);
+
+/*!************************************************************************
+ * \fn u8 *TEXT_write_json_data(const data_s *data, u8 *out)
+ * \brief Write the JSON object of parseData() for a decoded payload,
+ *        without line feed.
+ *
+ * \param[out] out                  At least TEXT_JSON_MAX_SIZE bytes
+ * \retval                          End of the object
+ **************************************************************************/
+u8 *TEXT_write_json_data(const data_s *data, u8 *out);
+
+/*!************************************************************************
+ * \fn u8 *TEXT_write_json_config(const config_s *config, payload_type_e type, u8 *out)
+ * \brief Write the JSON object of parseConfig() for a decoded config of
+ *        a v2 or v3 payload type.
+ *
+ * \param[out] out                  At least TEXT_JSON_MAX_SIZE bytes
+ * \retval                          End of the object
+ **************************************************************************/
+u8 *TEXT_write_json_config(const config_s *config, payload_type_e type, u8 *out);
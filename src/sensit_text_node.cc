@@ -0,0 +1,44 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_text.h"
+#include "sensit_payload_node.h"
+
+void ToText(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: Buffer payloads, Uint32Array|undefined devices, Uint32Array|undefined times, format, columns, header
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  u32 count = (u32)(node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE);
+  text_format_e format = (args[3]->Uint32Value() == TEXT_FORMAT_CSV) ? TEXT_FORMAT_CSV : TEXT_FORMAT_NDJSON;
+  const u32 *device_ids;
+  const u32 *times;
+  u8 *text = NULL;
+  u32 text_size = 0;
+
+  if (!OptionalColumn(isolate, args[1], count, &device_ids) || !OptionalColumn(isolate, args[2], count, &times))
+  {
+    return;
+  }
+  if (TEXT_write_data(payloads, count, device_ids, times, format,
+                      args[4]->Uint32Value(), args[5]->BooleanValue(), &text, &text_size) != TEXT_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to write the text")));
+    return;
+  }
+
+  // The Buffer takes ownership of the malloc'ed text, no copy
+  v8::MaybeLocal<v8::Object> buffer = node::Buffer::New(isolate, (char *)text, text_size);
+  v8::Local<v8::Object> out;
+  if (buffer.ToLocal(&out))
+  {
+    args.GetReturnValue().Set(out);
+  }
+}
+
+void TEXT_node_init(v8::Local<v8::Object> exports)
+{
+  NODE_SET_METHOD(exports, "toText", ToText);
+}
@@ -0,0 +1,352 @@
+/*!******************************************************************
+ * \file sensit_timeline.c
+ * \brief Functions to rebuild door & vibration timelines
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_timeline.h"
+
+/******* DEFINE ****************************************************/
+#define TIMELINE_MIN_DEVICES 64
+#define TIMELINE_MIN_RECORDS 64
+
+#define TIMELINE_V3_COUNTER_MASK 0xFFFF
+#define TIMELINE_V2_COUNTER_MASK 0xFF
+
+/*******************************************************************/
+
+static timeline_device_s *TIMELINE_add(timeline_s *timeline, u32 device_id)
+{
+    void *devices;
+
+    if (timeline->device_count == timeline->device_capacity)
+    {
+        devices = realloc(timeline->devices, (size_t)timeline->device_capacity * 2 * sizeof(timeline_device_s));
+        if (devices == NULL)
+        {
+            return NULL;
+        }
+        timeline->devices = (timeline_device_s *)devices;
+        timeline->device_capacity *= 2;
+    }
+    if (!DEVICES_add(&(timeline->ids), device_id, timeline->device_count))
+    {
+        return NULL;
+    }
+
+    timeline->device_count++;
+    memset(&(timeline->devices[timeline->device_count - 1]), 0, sizeof(timeline_device_s));
+    timeline->devices[timeline->device_count - 1].device_id = device_id;
+    return &(timeline->devices[timeline->device_count - 1]);
+}
+
+/*******************************************************************/
+
+static void TIMELINE_remove(timeline_s *timeline, u32 index)
+{
+    u32 last = timeline->device_count - 1;
+
+    DEVICES_remove(&(timeline->ids), timeline->devices[index].device_id);
+
+    /* Keep the devices dense */
+    if (index != last)
+    {
+        timeline->devices[index] = timeline->devices[last];
+        DEVICES_move(&(timeline->ids), timeline->devices[index].device_id, index);
+    }
+    timeline->device_count--;
+}
+
+/*******************************************************************/
+
+static bool TIMELINE_emit(timeline_s *timeline, timeline_device_s *device, u32 end, timeline_end_e reason)
+{
+    timeline_record_s *record;
+    void *records;
+
+    if (timeline->record_count == timeline->record_capacity)
+    {
+        records = realloc(timeline->records, (size_t)timeline->record_capacity * 2 * sizeof(timeline_record_s));
+        if (records == NULL)
+        {
+            return FALSE;
+        }
+        timeline->records = (timeline_record_s *)records;
+        timeline->record_capacity *= 2;
+    }
+    record = &(timeline->records[timeline->record_count++]);
+    record->device_id = device->device_id;
+    record->start = device->start;
+    record->end = end;
+    record->events = device->events;
+    record->missed = device->missed;
+    record->kind = device->kind;
+    record->reason = reason;
+    record->spare = 0;
+
+    device->kind = TIMELINE_KIND_NONE;
+    device->events = 0;
+    device->missed = 0;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static void TIMELINE_start(timeline_device_s *device, timeline_kind_e kind, u32 time, u16 events)
+{
+    device->kind = kind;
+    device->start = time;
+    device->last_event = time;
+    device->events = events;
+    device->missed = 0;
+}
+
+/*******************************************************************/
+
+static bool TIMELINE_is_tracked(const data_s *data)
+{
+    return (data->mode == MODE_DOOR || data->mode == MODE_VIBRATION) && !(data->type == PAYLOAD_V2 && data->button);
+}
+
+/*******************************************************************/
+
+static bool TIMELINE_step(timeline_s *timeline, timeline_device_s *device, const data_s *data, u32 time, bool first)
+{
+    u16 mask = (data->type == PAYLOAD_V3) ? TIMELINE_V3_COUNTER_MASK : TIMELINE_V2_COUNTER_MASK;
+    u16 delta = (data->event_counter - device->counter) & mask;
+    u16 received;
+    u16 missed;
+    timeline_kind_e kind;
+    bool alert;
+
+    /* A counter going back is a reboot of the device, not missed events */
+    if (first || delta > (mask >> 1))
+    {
+        delta = 0;
+    }
+    device->counter = data->event_counter;
+    device->last_time = time;
+
+    if (data->type == PAYLOAD_V3)
+    {
+        /* Periodic messages repeat the counter, an event message increments it */
+        received = (delta > 0) ? 1 : 0;
+        missed = (delta > 0) ? (delta - 1) : 0;
+
+        if (data->mode == MODE_DOOR)
+        {
+            kind = (data->door == DOOR_OPEN) ? TIMELINE_KIND_OPEN : ((data->door == DOOR_CLOSE) ? TIMELINE_KIND_CLOSED : TIMELINE_KIND_NONE);
+            /* Missed events happened during the ongoing interval */
+            device->missed += missed;
+            if (kind == device->kind)
+            {
+                device->events += received;
+                return TRUE;
+            }
+            if (device->kind != TIMELINE_KIND_NONE && !TIMELINE_emit(timeline, device, time, TIMELINE_END_EVENT))
+            {
+                return FALSE;
+            }
+            if (kind != TIMELINE_KIND_NONE)
+            {
+                TIMELINE_start(device, kind, time, received);
+            }
+            return TRUE;
+        }
+
+        /* MODE_VIBRATION: a message when the vibration starts & one after the clear delay */
+        if (device->kind == TIMELINE_KIND_NONE)
+        {
+            if (data->vibration)
+            {
+                TIMELINE_start(device, TIMELINE_KIND_VIBRATION, time, received);
+            }
+            return TRUE;
+        }
+        device->events += received;
+        device->missed += missed;
+        if (!data->vibration)
+        {
+            return TIMELINE_emit(timeline, device, time, TIMELINE_END_EVENT);
+        }
+        return TRUE;
+    }
+
+    /* Sens'it v2: alert frames only, a session ends after session_gap without alert */
+    alert = (data->mode == MODE_DOOR) ? (data->door == DOOR_MOVEMENT) : data->vibration;
+    kind = (data->mode == MODE_DOOR) ? TIMELINE_KIND_MOVEMENT : TIMELINE_KIND_VIBRATION;
+    missed = (delta > 0) ? (delta - (alert ? 1 : 0)) : 0;
+
+    if (device->kind != TIMELINE_KIND_NONE && (time - device->last_event) > timeline->session_gap)
+    {
+        if (!TIMELINE_emit(timeline, device, device->last_event, TIMELINE_END_GAP))
+        {
+            return FALSE;
+        }
+    }
+    if (!alert)
+    {
+        device->missed += (device->kind != TIMELINE_KIND_NONE) ? missed : 0;
+        return TRUE;
+    }
+    if (device->kind == TIMELINE_KIND_NONE)
+    {
+        TIMELINE_start(device, kind, time, 1);
+        return TRUE;
+    }
+    device->events++;
+    device->missed += missed;
+    device->last_event = time;
+    return TRUE;
+}
+
+/*******************************************************************/
+
+timeline_s *TIMELINE_create(u32 session_gap)
+{
+    timeline_s *timeline = (timeline_s *)calloc(1, sizeof(timeline_s));
+
+    if (timeline == NULL)
+    {
+        return NULL;
+    }
+    timeline->devices = (timeline_device_s *)malloc(TIMELINE_MIN_DEVICES * sizeof(timeline_device_s));
+    timeline->device_capacity = TIMELINE_MIN_DEVICES;
+    timeline->records = (timeline_record_s *)malloc(TIMELINE_MIN_RECORDS * sizeof(timeline_record_s));
+    timeline->record_capacity = TIMELINE_MIN_RECORDS;
+    timeline->session_gap = session_gap;
+    if (!DEVICES_init(&(timeline->ids)) || timeline->devices == NULL || timeline->records == NULL)
+    {
+        TIMELINE_destroy(timeline);
+        return NULL;
+    }
+    return timeline;
+}
+
+/*******************************************************************/
+
+void TIMELINE_destroy(timeline_s *timeline)
+{
+    if (timeline != NULL)
+    {
+        DEVICES_free(&(timeline->ids));
+        free(timeline->devices);
+        free(timeline->records);
+        free(timeline);
+    }
+}
+
+/*******************************************************************/
+
+u8 TIMELINE_process(timeline_s *timeline, u8 *data_in, u32 count, const u32 *device_ids, const u32 *times)
+{
+    data_s data;
+    timeline_device_s *device;
+    u32 index;
+    u32 i;
+    bool first;
+
+    timeline->record_count = 0;
+    for (i = 0; i < count; i++)
+    {
+        memset(&data, 0, sizeof(data_s));
+        PAYLOAD_parse_data(data_in + (i * PAYLOAD_DATA_SIZE), &data);
+        if (data.error != PARSE_ERR_NONE)
+        {
+            continue;
+        }
+
+        index = DEVICES_find(&(timeline->ids), device_ids[i]);
+        device = (index != DEVICES_NONE) ? &(timeline->devices[index]) : NULL;
+        first = FALSE;
+
+        if (device != NULL)
+        {
+            if (times[i] < device->last_time)
+            {
+                timeline->rejected++;
+                continue;
+            }
+            if (data.type == PAYLOAD_V2 && data.button)
+            {
+                /* A v2 button frame does not carry the values of the mode */
+                device->last_time = times[i];
+                continue;
+            }
+            if (data.mode != device->mode || data.type != device->type)
+            {
+                if (device->kind != TIMELINE_KIND_NONE && !TIMELINE_emit(timeline, device, times[i], TIMELINE_END_MODE))
+                {
+                    return TIMELINE_ERR_ALLOC;
+                }
+                if (!TIMELINE_is_tracked(&data))
+                {
+                    TIMELINE_remove(timeline, index);
+                    continue;
+                }
+                first = TRUE;
+            }
+        }
+        else
+        {
+            if (!TIMELINE_is_tracked(&data))
+            {
+                continue;
+            }
+            device = TIMELINE_add(timeline, device_ids[i]);
+            if (device == NULL)
+            {
+                return TIMELINE_ERR_ALLOC;
+            }
+            first = TRUE;
+        }
+
+        device->mode = data.mode;
+        device->type = data.type;
+        if (!TIMELINE_step(timeline, device, &data, times[i], first))
+        {
+            return TIMELINE_ERR_ALLOC;
+        }
+    }
+    return TIMELINE_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 TIMELINE_expire(timeline_s *timeline, u32 time, u32 idle)
+{
+    timeline_device_s *device;
+    u32 i = 0;
+
+    timeline->record_count = 0;
+    while (i < timeline->device_count)
+    {
+        device = &(timeline->devices[i]);
+        if (device->kind != TIMELINE_KIND_NONE && device->type == PAYLOAD_V2 && time > device->last_event &&
+            (time - device->last_event) > timeline->session_gap)
+        {
+            if (!TIMELINE_emit(timeline, device, device->last_event, TIMELINE_END_GAP))
+            {
+                return TIMELINE_ERR_ALLOC;
+            }
+        }
+        if (time > device->last_time && (time - device->last_time) > idle)
+        {
+            if (device->kind != TIMELINE_KIND_NONE && !TIMELINE_emit(timeline, device, device->last_time, TIMELINE_END_EXPIRED))
+            {
+                return TIMELINE_ERR_ALLOC;
+            }
+            /* The last device takes its place */
+            TIMELINE_remove(timeline, i);
+            continue;
+        }
+        i++;
+    }
+    return TIMELINE_ERR_NONE;
+}
+
+/*******************************************************************/
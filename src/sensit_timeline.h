@@ -0,0 +1,131 @@
+/*!******************************************************************
+ * \file sensit_timeline.h
+ * \brief Functions & Types to rebuild door & vibration timelines
+ * \author Sens'it Team
+ *
+ * A state machine per device turns the uplinks of the DOOR and
+ * VIBRATION modes into intervals:
+ *  - Sens'it v3 DOOR: open & closed intervals from the door state
+ *  - Sens'it v3 VIBRATION: sessions from the start to the end message
+ *  - Sens'it v2 DOOR & VIBRATION: sessions of alert frames, split when
+ *    no alert is received for session_gap seconds
+ * The event counter (16 bits for a v3, 8 bits for a v2) tells how many
+ * events were not received. Only devices with an ongoing interval or in
+ * one of these modes are kept, silent devices are expired.
+ *******************************************************************/
+
+#define TIMELINE_ERR_NONE 0x00
+#define TIMELINE_ERR_ALLOC 0x01
+
+#define TIMELINE_DEFAULT_SESSION_GAP 60 /* seconds */
+
+/*!******************************************************************
+ * \enum timeline_kind_e
+ * \brief Kind of interval
+ *******************************************************************/
+typedef enum {
+    TIMELINE_KIND_NONE,
+    TIMELINE_KIND_OPEN,      /*!< v3 door open */
+    TIMELINE_KIND_CLOSED,    /*!< v3 door closed */
+    TIMELINE_KIND_VIBRATION, /*!< Vibration session */
+    TIMELINE_KIND_MOVEMENT,  /*!< v2 door movement session */
+    TIMELINE_KIND_LAST
+} timeline_kind_e;
+
+/*!******************************************************************
+ * \enum timeline_end_e
+ * \brief What closed an interval
+ *******************************************************************/
+typedef enum {
+    TIMELINE_END_EVENT,   /*!< Next state or end message received */
+    TIMELINE_END_GAP,     /*!< v2 session without alert for session_gap */
+    TIMELINE_END_MODE,    /*!< Device switched to another mode */
+    TIMELINE_END_EXPIRED, /*!< Device silent, end is its last uplink */
+    TIMELINE_END_LAST
+} timeline_end_e;
+
+/*!******************************************************************
+ * \struct timeline_record_s
+ * \brief Closed interval
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 start;   /*!< Seconds */
+    u32 end;     /*!< Seconds */
+    u16 events;  /*!< Events received during the interval */
+    u16 missed;  /*!< Events inferred from event counter jumps */
+    u8 kind;     /*!< timeline_kind_e */
+    u8 reason;   /*!< timeline_end_e */
+    u16 spare;
+} timeline_record_s;
+
+/*!******************************************************************
+ * \struct timeline_device_s
+ * \brief State of an active device
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 start;      /*!< Start of the ongoing interval */
+    u32 last_time;  /*!< Last uplink */
+    u32 last_event; /*!< Last alert of a v2 session */
+    u16 counter;    /*!< Last event counter */
+    u16 events;
+    u16 missed;
+    u8 kind;        /*!< timeline_kind_e of the ongoing interval */
+    u8 mode;
+    u8 type;
+    u8 spare[3];
+} timeline_device_s;
+
+/*!******************************************************************
+ * \struct timeline_s
+ * \brief Active devices and records of the last call
+ *******************************************************************/
+typedef struct
+{
+    devices_s ids;              /*!< Index in devices of each device id */
+    timeline_device_s *devices; /*!< Dense, removal moves the last device */
+    u32 device_count;
+    u32 device_capacity;
+    u32 session_gap;
+    timeline_record_s *records; /*!< Intervals closed by the last call */
+    u32 record_count;
+    u32 record_capacity;
+    u32 rejected;               /*!< Uplinks older than the last one of their device */
+} timeline_s;
+
+/*!************************************************************************
+ * \fn timeline_s *TIMELINE_create(u32 session_gap)
+ * \brief Allocate an empty timeline, NULL if the allocation failed.
+ *
+ * \param[in] session_gap           Seconds without alert closing a v2 session
+ **************************************************************************/
+timeline_s *TIMELINE_create(u32 session_gap);
+
+/*!************************************************************************
+ * \fn void TIMELINE_destroy(timeline_s *timeline)
+ **************************************************************************/
+void TIMELINE_destroy(timeline_s *timeline);
+
+/*!************************************************************************
+ * \fn u8 TIMELINE_process(timeline_s *timeline, u8 *data_in, u32 count, const u32 *device_ids, const u32 *times)
+ * \brief Decode a batch of payloads, the closed intervals are left in
+ *        timeline->records.
+ *
+ * \param[in] data_in               count payloads of PAYLOAD_DATA_SIZE length
+ * \param[in] times                 Seconds, not lower than the previous one of the device
+ * \retval                          TIMELINE_ERR_NONE or TIMELINE_ERR_ALLOC
+ **************************************************************************/
+u8 TIMELINE_process(timeline_s *timeline, u8 *data_in, u32 count, const u32 *device_ids, const u32 *times);
+
+/*!************************************************************************
+ * \fn u8 TIMELINE_expire(timeline_s *timeline, u32 time, u32 idle)
+ * \brief Close the intervals of the devices silent for more than idle
+ *        seconds and forget them, the closed intervals are left in
+ *        timeline->records.
+ *
+ * \retval                          TIMELINE_ERR_NONE or TIMELINE_ERR_ALLOC
+ **************************************************************************/
+u8 TIMELINE_expire(timeline_s *timeline, u32 time, u32 idle);
@@ -0,0 +1,132 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_timeline.h"
+#include "sensit_payload_node.h"
+
+class Timeline : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Timeline(timeline_s *timeline) : timeline_(timeline) {}
+  ~Timeline() { TIMELINE_destroy(timeline_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Process(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Expire(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Size(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static v8::Local<v8::Object> Records(v8::Isolate *isolate, const timeline_s *timeline);
+
+  timeline_s *timeline_;
+};
+
+void Timeline::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Timeline"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "process", Process);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "expire", Expire);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "size", Size);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Timeline"), tpl->GetFunction());
+}
+
+void Timeline::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: v2 session gap in seconds
+  u32 session_gap = args[0]->IsNumber() ? args[0]->Uint32Value() : TIMELINE_DEFAULT_SESSION_GAP;
+  timeline_s *timeline = TIMELINE_create(session_gap);
+  if (timeline == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the timeline")));
+    return;
+  }
+
+  Timeline *obj = new Timeline(timeline);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+// Closed intervals as a copy of the records, one Uint32Array of 6 words per record
+v8::Local<v8::Object> Timeline::Records(v8::Isolate *isolate, const timeline_s *timeline)
+{
+  u32 count = timeline->record_count;
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, count * 6 * sizeof(u32));
+  u32 *words = (u32 *)buffer->GetContents().Data();
+
+  for (u32 i = 0; i < count; i++)
+  {
+    const timeline_record_s *record = &(timeline->records[i]);
+    words[(i * 6) + 0] = record->device_id;
+    words[(i * 6) + 1] = record->start;
+    words[(i * 6) + 2] = record->end;
+    words[(i * 6) + 3] = record->events;
+    words[(i * 6) + 4] = record->missed;
+    words[(i * 6) + 5] = (record->reason << 8) | record->kind;
+  }
+  return v8::Uint32Array::New(buffer, 0, count * 6);
+}
+
+void Timeline::Process(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Timeline *obj = node::ObjectWrap::Unwrap<Timeline>(args.Holder());
+
+  // args: Buffer payloads, Uint32Array device ids, Uint32Array times
+  u8 *payloads = (u8 *)node::Buffer::Data(args[0]);
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[1]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / PAYLOAD_DATA_SIZE;
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+
+  if (TIMELINE_process(obj->timeline_, payloads, count, device_ids, times) != TIMELINE_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the timeline")));
+    return;
+  }
+  args.GetReturnValue().Set(Records(isolate, obj->timeline_));
+}
+
+void Timeline::Expire(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Timeline *obj = node::ObjectWrap::Unwrap<Timeline>(args.Holder());
+
+  // args: time, idle in seconds
+  if (TIMELINE_expire(obj->timeline_, args[0]->Uint32Value(), args[1]->Uint32Value()) != TIMELINE_ERR_NONE)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the timeline")));
+    return;
+  }
+  args.GetReturnValue().Set(Records(isolate, obj->timeline_));
+}
+
+void Timeline::Size(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Timeline *obj = node::ObjectWrap::Unwrap<Timeline>(args.Holder());
+  args.GetReturnValue().Set(obj->timeline_->device_count);
+}
+
+void TIMELINE_node_init(v8::Local<v8::Object> exports)
+{
+  Timeline::Init(exports);
+}
@@ -0,0 +1,85 @@
+/*!******************************************************************
+ * \file sensit_trace.h
+ * \brief USDT probes of the "sensit" provider
+ * \author Sens'it Team
+ *
+ * Linux static tracepoints: each probe is a single nop behind the test
+ * of its semaphore, which a tracer attached to it (bpftrace -p) sets, so
+ * the arguments (the byte swapped words) are computed only while traced.
+ * They are compiled in when <sys/sdt.h> (systemtap-sdt-dev) is found,
+ * and to nothing otherwise or with SENSIT_NO_TRACE defined.
+ *
+ *   parse_data_entry(u32 word)
+ *   parse_data_return(u32 word, u8 type, u8 mode, u8 error)
+ *   parse_config_entry(u64 word, u8 type)
+ *   parse_config_return(u64 word, u8 type, u8 error)
+ *   serialize_config_entry(u8 type)
+ *   serialize_config_return(u64 word, u8 type)
+ *   node_entry(char *function, u32 count)
+ *   node_return(char *function, u32 count)
+ *
+ * Payload words are read big endian, as written in hexadecimal.
+ * Example bpftrace scripts are in the tools directory.
+ *******************************************************************/
+
+#if !defined(SENSIT_NO_TRACE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#define SENSIT_TRACE_ENABLED
+#endif
+#endif
+
+#ifdef SENSIT_TRACE_ENABLED
+/* Semaphore sensit_<probe>_semaphore of each probe, referenced by its note.
+   Weak: every translation unit of a binary shares the same counter */
+#define SENSIT_TRACE_SEMAPHORE(name) \
+    __attribute__((weak, section(".probes"))) volatile unsigned short sensit_##name##_semaphore
+SENSIT_TRACE_SEMAPHORE(parse_data_entry);
+SENSIT_TRACE_SEMAPHORE(parse_data_return);
+SENSIT_TRACE_SEMAPHORE(parse_config_entry);
+SENSIT_TRACE_SEMAPHORE(parse_config_return);
+SENSIT_TRACE_SEMAPHORE(serialize_config_entry);
+SENSIT_TRACE_SEMAPHORE(serialize_config_return);
+SENSIT_TRACE_SEMAPHORE(node_entry);
+SENSIT_TRACE_SEMAPHORE(node_return);
+
+#define SENSIT_TRACE_IS_ENABLED(name) __builtin_expect(sensit_##name##_semaphore != 0, 0)
+#define SENSIT_TRACE1(name, a) \
+    do { if (SENSIT_TRACE_IS_ENABLED(name)) DTRACE_PROBE1(sensit, name, a); } while (0)
+#define SENSIT_TRACE2(name, a, b) \
+    do { if (SENSIT_TRACE_IS_ENABLED(name)) DTRACE_PROBE2(sensit, name, a, b); } while (0)
+#define SENSIT_TRACE3(name, a, b, c) \
+    do { if (SENSIT_TRACE_IS_ENABLED(name)) DTRACE_PROBE3(sensit, name, a, b, c); } while (0)
+#define SENSIT_TRACE4(name, a, b, c, d) \
+    do { if (SENSIT_TRACE_IS_ENABLED(name)) DTRACE_PROBE4(sensit, name, a, b, c, d); } while (0)
+#else
+#define SENSIT_TRACE1(name, a) do {} while (0)
+#define SENSIT_TRACE2(name, a, b) do {} while (0)
+#define SENSIT_TRACE3(name, a, b, c) do {} while (0)
+#define SENSIT_TRACE4(name, a, b, c, d) do {} while (0)
+#endif
+
+/*!************************************************************************
+ * \fn u32 TRACE_data_word(const u8 *data_in)
+ * \brief Payload of PAYLOAD_DATA_SIZE bytes as a big endian word
+ **************************************************************************/
+static inline u32 TRACE_data_word(const u8 *data_in)
+{
+    u32 word;
+
+    memcpy(&word, data_in, sizeof(word));
+    return __builtin_bswap32(word);
+}
+
+/*!************************************************************************
+ * \fn u64 TRACE_config_word(const u8 *config_in)
+ * \brief Config of PAYLOAD_CONFIG_SIZE bytes as a big endian word
+ **************************************************************************/
+static inline u64 TRACE_config_word(const u8 *config_in)
+{
+    u64 word;
+
+    memcpy(&word, config_in, sizeof(word));
+    return __builtin_bswap64(word);
+}
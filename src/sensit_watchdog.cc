@@ -0,0 +1,366 @@
+/*!******************************************************************
+ * \file sensit_watchdog.c
+ * \brief Functions to detect devices missing their uplinks
+ * \author Sens'it Team
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_watchdog.h"
+
+/******* DEFINE ****************************************************/
+#define WATCHDOG_MIN_DEVICES 32
+#define WATCHDOG_SLOT_MASK (WATCHDOG_SLOTS - 1)
+
+/* Seconds of each uplink_period_e */
+static const u32 WATCHDOG_PERIODS[UPLINK_PERIOD_LAST] = { 600, 3600, 21600, 86400 };
+
+/*******************************************************************/
+
+static watchdog_device_s *WATCHDOG_add(watchdog_s *watchdog, u32 device_id)
+{
+    u32 index = DEVICES_find(&(watchdog->ids), device_id);
+    watchdog_device_s *device;
+    void *devices;
+
+    if (index != DEVICES_NONE)
+    {
+        return &(watchdog->devices[index]);
+    }
+    if (watchdog->device_count == watchdog->device_capacity)
+    {
+        devices = realloc(watchdog->devices, (size_t)watchdog->device_capacity * 2 * sizeof(watchdog_device_s));
+        if (devices == NULL)
+        {
+            return NULL;
+        }
+        watchdog->devices = (watchdog_device_s *)devices;
+        watchdog->device_capacity *= 2;
+    }
+
+    if (!DEVICES_add(&(watchdog->ids), device_id, watchdog->device_count))
+    {
+        return NULL;
+    }
+
+    watchdog->device_count++;
+    device = &(watchdog->devices[watchdog->device_count - 1]);
+    memset(device, 0, sizeof(watchdog_device_s));
+    device->device_id = device_id;
+    device->prev = WATCHDOG_NIL;
+    device->next = WATCHDOG_NIL;
+    device->slot = WATCHDOG_SLOT_NONE;
+    device->periodic = WATCHDOG_PERIODIC_UNKNOWN;
+    return device;
+}
+
+/*******************************************************************/
+
+static void WATCHDOG_unlink(watchdog_s *watchdog, u32 index)
+{
+    watchdog_device_s *device = &(watchdog->devices[index]);
+
+    if (device->slot == WATCHDOG_SLOT_NONE)
+    {
+        return;
+    }
+    if (device->prev != WATCHDOG_NIL)
+    {
+        watchdog->devices[device->prev].next = device->next;
+    }
+    else
+    {
+        watchdog->heads[device->slot] = device->next;
+    }
+    if (device->next != WATCHDOG_NIL)
+    {
+        watchdog->devices[device->next].prev = device->prev;
+    }
+    device->slot = WATCHDOG_SLOT_NONE;
+    watchdog->armed--;
+}
+
+/*******************************************************************/
+
+static void WATCHDOG_link(watchdog_s *watchdog, u32 index)
+{
+    watchdog_device_s *device = &(watchdog->devices[index]);
+    u32 delta = device->deadline - watchdog->now;
+    u32 level = 0;
+
+    if (device->deadline < watchdog->now)
+    {
+        /* Already passed, expires at the next poll */
+        device->slot = WATCHDOG_SLOT_LATE;
+    }
+    else
+    {
+        /* Level of the smallest range holding the deadline */
+        while (level < WATCHDOG_LEVELS - 1 && delta >= (1U << (WATCHDOG_SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+        device->slot = (level * WATCHDOG_SLOTS) + ((device->deadline >> (WATCHDOG_SLOT_BITS * level)) & WATCHDOG_SLOT_MASK);
+    }
+    device->prev = WATCHDOG_NIL;
+    device->next = watchdog->heads[device->slot];
+    if (device->next != WATCHDOG_NIL)
+    {
+        watchdog->devices[device->next].prev = index;
+    }
+    watchdog->heads[device->slot] = index;
+    watchdog->armed++;
+}
+
+/*******************************************************************/
+
+static u32 WATCHDOG_cascade(watchdog_s *watchdog, u32 level)
+{
+    u32 index = (watchdog->now >> (WATCHDOG_SLOT_BITS * level)) & WATCHDOG_SLOT_MASK;
+    u32 slot = (level * WATCHDOG_SLOTS) + index;
+    u32 device = watchdog->heads[slot];
+    u32 next;
+
+    /* Move the slot to the lower levels, now that its range starts */
+    watchdog->heads[slot] = WATCHDOG_NIL;
+    while (device != WATCHDOG_NIL)
+    {
+        next = watchdog->devices[device].next;
+        watchdog->armed--;
+        WATCHDOG_link(watchdog, device);
+        device = next;
+    }
+    return index;
+}
+
+/*******************************************************************/
+
+static void WATCHDOG_start(watchdog_s *watchdog, u32 time)
+{
+    if (!watchdog->started)
+    {
+        watchdog->now = time;
+        watchdog->started = TRUE;
+    }
+}
+
+/*******************************************************************/
+
+watchdog_s *WATCHDOG_create(u32 missed, u32 grace, u32 default_period)
+{
+    watchdog_s *watchdog = (watchdog_s *)calloc(1, sizeof(watchdog_s));
+    u32 i;
+
+    if (watchdog == NULL)
+    {
+        return NULL;
+    }
+    watchdog->devices = (watchdog_device_s *)malloc(WATCHDOG_MIN_DEVICES * sizeof(watchdog_device_s));
+    watchdog->device_capacity = WATCHDOG_MIN_DEVICES;
+    if (!DEVICES_init(&(watchdog->ids)) || watchdog->devices == NULL)
+    {
+        WATCHDOG_destroy(watchdog);
+        return NULL;
+    }
+    for (i = 0; i <= WATCHDOG_SLOT_LATE; i++)
+    {
+        watchdog->heads[i] = WATCHDOG_NIL;
+    }
+    watchdog->missed = (missed == 0) ? 1 : missed;
+    watchdog->grace = grace;
+    watchdog->default_period = default_period;
+    return watchdog;
+}
+
+/*******************************************************************/
+
+void WATCHDOG_destroy(watchdog_s *watchdog)
+{
+    if (watchdog != NULL)
+    {
+        DEVICES_free(&(watchdog->ids));
+        free(watchdog->devices);
+        free(watchdog);
+    }
+}
+
+/*******************************************************************/
+
+u8 WATCHDOG_arm(watchdog_s *watchdog, u32 device_id, u32 last_time, u32 deadline)
+{
+    watchdog_device_s *device = WATCHDOG_add(watchdog, device_id);
+    u32 index;
+
+    if (device == NULL)
+    {
+        return WATCHDOG_ERR_ALLOC;
+    }
+    index = device - watchdog->devices;
+    device->last_time = last_time;
+    WATCHDOG_unlink(watchdog, index);
+    if (deadline != 0)
+    {
+        WATCHDOG_start(watchdog, last_time);
+        device->deadline = deadline;
+        WATCHDOG_link(watchdog, index);
+    }
+    return WATCHDOG_ERR_NONE;
+}
+
+/*******************************************************************/
+
+u8 WATCHDOG_uplink(watchdog_s *watchdog, u32 device_id, u32 time, u8 *uplink_in, u8 size)
+{
+    watchdog_device_s *device;
+    data_s data;
+    config_s config;
+    u32 index;
+
+    if (size != PAYLOAD_DATA_SIZE && size != PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+    {
+        return WATCHDOG_ERR_DATA;
+    }
+    memset(&data, 0, sizeof(data));
+    PAYLOAD_parse_data(uplink_in, &data);
+    if (data.error != PARSE_ERR_NONE)
+    {
+        return WATCHDOG_ERR_DATA;
+    }
+    device = WATCHDOG_add(watchdog, device_id);
+    if (device == NULL)
+    {
+        return WATCHDOG_ERR_ALLOC;
+    }
+    /* A late uplink does not move the deadline back */
+    if (time < device->last_time)
+    {
+        return WATCHDOG_ERR_NONE;
+    }
+    index = device - watchdog->devices;
+    device->last_time = time;
+    device->mode = data.mode;
+
+    if (data.type == PAYLOAD_V2)
+    {
+        /* Period in the raw bits of every payload, every mode is periodic */
+        device->period = WATCHDOG_PERIODS[(uplink_in[0] >> 3) & 0x03];
+    }
+    else if (size != PAYLOAD_DATA_SIZE)
+    {
+        memset(&config, 0, sizeof(config));
+        PAYLOAD_parse_config(uplink_in + PAYLOAD_DATA_SIZE, PAYLOAD_V3, &config);
+        device->period = WATCHDOG_PERIODS[config.period & 0x03];
+        device->periodic = (config.is_standby_periodic << MODE_STANDBY) | (config.is_temperature_periodic << MODE_TEMPERATURE) |
+                           (config.is_light_periodic << MODE_LIGHT) | (config.is_door_periodic << MODE_DOOR) |
+                           (config.is_vibration_periodic << MODE_VIBRATION) | (config.is_magnet_periodic << MODE_MAGNET);
+    }
+    else if (device->period == 0)
+    {
+        device->period = watchdog->default_period;
+    }
+
+    WATCHDOG_unlink(watchdog, index);
+    if ((device->periodic >> device->mode) & 1)
+    {
+        WATCHDOG_start(watchdog, time);
+        device->deadline = time + (device->period * watchdog->missed) + watchdog->grace;
+        WATCHDOG_link(watchdog, index);
+    }
+    return WATCHDOG_ERR_NONE;
+}
+
+/*******************************************************************/
+
+void WATCHDOG_remove(watchdog_s *watchdog, u32 device_id)
+{
+    u32 index = DEVICES_find(&(watchdog->ids), device_id);
+    u32 last = watchdog->device_count - 1;
+    watchdog_device_s *moved;
+
+    if (index == DEVICES_NONE)
+    {
+        return;
+    }
+    WATCHDOG_unlink(watchdog, index);
+    DEVICES_remove(&(watchdog->ids), device_id);
+
+    /* Keep the devices dense, the links to the last device follow it */
+    if (index != last)
+    {
+        watchdog->devices[index] = watchdog->devices[last];
+        moved = &(watchdog->devices[index]);
+        DEVICES_move(&(watchdog->ids), moved->device_id, index);
+        if (moved->slot != WATCHDOG_SLOT_NONE)
+        {
+            if (moved->prev != WATCHDOG_NIL)
+            {
+                watchdog->devices[moved->prev].next = index;
+            }
+            else
+            {
+                watchdog->heads[moved->slot] = index;
+            }
+            if (moved->next != WATCHDOG_NIL)
+            {
+                watchdog->devices[moved->next].prev = index;
+            }
+        }
+    }
+    watchdog->device_count--;
+}
+
+/*******************************************************************/
+
+u32 WATCHDOG_poll(watchdog_s *watchdog, u32 time, u32 *device_ids, u32 *last_times, u32 max)
+{
+    u32 count = 0;
+    u32 slot = WATCHDOG_SLOT_LATE;
+
+    if (!watchdog->started)
+    {
+        return 0;
+    }
+    for (;;)
+    {
+        while (watchdog->heads[slot] != WATCHDOG_NIL)
+        {
+            if (count == max)
+            {
+                return count;
+            }
+            device_ids[count] = watchdog->devices[watchdog->heads[slot]].device_id;
+            last_times[count] = watchdog->devices[watchdog->heads[slot]].last_time;
+            WATCHDOG_unlink(watchdog, watchdog->heads[slot]);
+            count++;
+        }
+        if (slot != WATCHDOG_SLOT_LATE)
+        {
+            if (watchdog->now == 0xFFFFFFFF)
+            {
+                break;
+            }
+            watchdog->now++;
+        }
+        if (watchdog->now > time)
+        {
+            break;
+        }
+        if (watchdog->armed == 0)
+        {
+            /* Nothing to expire, jump to the end */
+            watchdog->now = (time == 0xFFFFFFFF) ? time : time + 1;
+            break;
+        }
+
+        /* Entering a new range of a level moves its slot down. Done again
+           when a poll resumes this tick, the timers are placed from now */
+        slot = watchdog->now & WATCHDOG_SLOT_MASK;
+        if (slot == 0 && WATCHDOG_cascade(watchdog, 1) == 0 && WATCHDOG_cascade(watchdog, 2) == 0)
+        {
+            WATCHDOG_cascade(watchdog, 3);
+        }
+    }
+    return count;
+}
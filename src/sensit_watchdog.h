@@ -0,0 +1,117 @@
+/*!******************************************************************
+ * \file sensit_watchdog.h
+ * \brief Functions & Types to detect devices missing their uplinks
+ * \author Sens'it Team
+ *
+ * Every uplink re-arms the deadline of its device from its uplink
+ * period: from the payload for a v2, from the last config reported in
+ * a 12 bytes uplink for a v3. A v3 whose mode is not periodic
+ * (is_*_periodic of its config) only sends on events and is not
+ * watched. Deadlines live in a hierarchical timer wheel of 4 levels
+ * of 256 slots with a 1 second tick, so that arming, re-arming and
+ * expiring a device is O(1) whatever the size of the fleet. Expired
+ * devices are delivered in batches by WATCHDOG_poll, once per silence.
+ *******************************************************************/
+
+#define WATCHDOG_ERR_NONE 0x00
+#define WATCHDOG_ERR_ALLOC 0x01
+#define WATCHDOG_ERR_DATA 0x02
+
+#define WATCHDOG_LEVELS 4
+#define WATCHDOG_SLOT_BITS 8
+#define WATCHDOG_SLOTS (1 << WATCHDOG_SLOT_BITS)
+#define WATCHDOG_NIL 0xFFFFFFFF
+#define WATCHDOG_SLOT_LATE (WATCHDOG_LEVELS * WATCHDOG_SLOTS) /* Deadlines already passed when armed */
+#define WATCHDOG_SLOT_NONE 0xFFFF
+#define WATCHDOG_PERIODIC_UNKNOWN 0xFF
+
+#define WATCHDOG_DEFAULT_MISSED 1
+#define WATCHDOG_DEFAULT_GRACE 300          /* seconds */
+#define WATCHDOG_DEFAULT_PERIOD 3600        /* seconds, v3 until a config is reported */
+
+/*!******************************************************************
+ * \struct watchdog_device_s
+ * \brief Watched device, linked in the list of its wheel slot
+ *******************************************************************/
+typedef struct
+{
+    u32 device_id;
+    u32 deadline;  /*!< Seconds */
+    u32 last_time; /*!< Last uplink, seconds */
+    u32 period;    /*!< Seconds */
+    u32 prev;      /*!< Index in devices, WATCHDOG_NIL at the head of the slot */
+    u32 next;      /*!< Index in devices, WATCHDOG_NIL at the tail of the slot */
+    u16 slot;      /*!< level * WATCHDOG_SLOTS + slot, WATCHDOG_SLOT_NONE when not armed */
+    u8 mode;
+    u8 periodic;   /*!< Bit per mode_e, from the last config. WATCHDOG_PERIODIC_UNKNOWN until reported */
+} watchdog_device_s;
+
+/*!******************************************************************
+ * \struct watchdog_s
+ * \brief Devices and timer wheel
+ *******************************************************************/
+typedef struct
+{
+    devices_s ids;              /*!< Index in devices of each device id */
+    watchdog_device_s *devices; /*!< Dense, removal moves the last device */
+    u32 device_count;
+    u32 device_capacity;
+    u32 heads[WATCHDOG_SLOT_LATE + 1]; /*!< First device of each wheel slot */
+    u32 now;                    /*!< Next tick to expire, seconds */
+    bool started;               /*!< now is set by the first uplink */
+    u32 armed;                  /*!< Devices with a deadline */
+    u32 missed;                 /*!< Periods without uplink before expiring */
+    u32 grace;                  /*!< Seconds added to the deadline */
+    u32 default_period;         /*!< Seconds, for a v3 without config */
+} watchdog_s;
+
+/*!************************************************************************
+ * \fn watchdog_s *WATCHDOG_create(u32 missed, u32 grace, u32 default_period)
+ * \brief Allocate an empty watchdog, NULL if the allocation failed. A
+ *        device expires missed * period + grace seconds after its last uplink.
+ **************************************************************************/
+watchdog_s *WATCHDOG_create(u32 missed, u32 grace, u32 default_period);
+
+/*!************************************************************************
+ * \fn void WATCHDOG_destroy(watchdog_s *watchdog)
+ **************************************************************************/
+void WATCHDOG_destroy(watchdog_s *watchdog);
+
+/*!************************************************************************
+ * \fn u8 WATCHDOG_arm(watchdog_s *watchdog, u32 device_id, u32 last_time, u32 deadline)
+ * \brief Set the deadline of a device, 0 to stop watching it. Restores
+ *        the state of a device without its uplink.
+ *
+ * \param[in] last_time             Last uplink of the device, seconds
+ * \param[in] deadline              Seconds, a deadline already passed expires at the next poll
+ *
+ * \retval                          WATCHDOG_ERR_NONE or WATCHDOG_ERR_ALLOC
+ **************************************************************************/
+u8 WATCHDOG_arm(watchdog_s *watchdog, u32 device_id, u32 last_time, u32 deadline);
+
+/*!************************************************************************
+ * \fn u8 WATCHDOG_uplink(watchdog_s *watchdog, u32 device_id, u32 time, u8 *uplink_in, u8 size)
+ * \brief Decode an uplink and re-arm the deadline of its device.
+ *
+ * \param[in] uplink_in             "data" payload, followed by the "config" if size is 12
+ * \param[in] size                  PAYLOAD_DATA_SIZE or PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE
+ * \retval                          WATCHDOG_ERR_NONE, WATCHDOG_ERR_ALLOC or WATCHDOG_ERR_DATA
+ **************************************************************************/
+u8 WATCHDOG_uplink(watchdog_s *watchdog, u32 device_id, u32 time, u8 *uplink_in, u8 size);
+
+/*!************************************************************************
+ * \fn void WATCHDOG_remove(watchdog_s *watchdog, u32 device_id)
+ * \brief Forget a device.
+ **************************************************************************/
+void WATCHDOG_remove(watchdog_s *watchdog, u32 device_id);
+
+/*!************************************************************************
+ * \fn u32 WATCHDOG_poll(watchdog_s *watchdog, u32 time, u32 *device_ids, u32 *last_times, u32 max)
+ * \brief Expire the deadlines up to time included. The devices expired
+ *        are disarmed until their next uplink. At most max are returned,
+ *        the next call continues with the others.
+ *
+ * \param[out] last_times           Last uplink of each device, seconds
+ * \retval                          Number of devices expired
+ **************************************************************************/
+u32 WATCHDOG_poll(watchdog_s *watchdog, u32 time, u32 *device_ids, u32 *last_times, u32 max);
@@ -0,0 +1,187 @@
+#include <node.h>
+#include <node_buffer.h>
+#include <node_object_wrap.h>
+#include <v8.h>
+#include "sensit_payload.h"
+#include "sensit_devices.h"
+#include "sensit_watchdog.h"
+#include "sensit_payload_node.h"
+
+class Watchdog : public node::ObjectWrap
+{
+public:
+  static void Init(v8::Local<v8::Object> exports);
+
+private:
+  explicit Watchdog(watchdog_s *watchdog) : watchdog_(watchdog) {}
+  ~Watchdog() { WATCHDOG_destroy(watchdog_); }
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Uplink(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Arm(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Remove(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Poll(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Stats(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  watchdog_s *watchdog_;
+};
+
+void Watchdog::Init(v8::Local<v8::Object> exports)
+{
+  v8::Isolate *isolate = exports->GetIsolate();
+
+  v8::Local<v8::FunctionTemplate> tpl = v8::FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(v8::String::NewFromUtf8(isolate, "Watchdog"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  NODE_SET_PROTOTYPE_METHOD(tpl, "uplink", Uplink);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "arm", Arm);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "remove", Remove);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "poll", Poll);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stats", Stats);
+
+  exports->Set(v8::String::NewFromUtf8(isolate, "Watchdog"), tpl->GetFunction());
+}
+
+void Watchdog::New(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+
+  // args: missed periods, grace seconds, default period seconds
+  watchdog_s *watchdog = WATCHDOG_create(args[0]->Uint32Value(), args[1]->Uint32Value(), args[2]->Uint32Value());
+  if (watchdog == NULL)
+  {
+    isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to allocate the watchdog")));
+    return;
+  }
+
+  Watchdog *obj = new Watchdog(watchdog);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void Watchdog::Uplink(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Watchdog *obj = node::ObjectWrap::Unwrap<Watchdog>(args.Holder());
+
+  // args: Buffer uplinks, size of an uplink, Uint32Array device ids, Uint32Array times
+  u8 *uplinks = (u8 *)node::Buffer::Data(args[0]);
+  u8 size = (u8)args[1]->Uint32Value();
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[2]);
+  const u32 *times = (const u32 *)node::Buffer::Data(args[3]);
+
+  if (size != PAYLOAD_DATA_SIZE && size != PAYLOAD_DATA_SIZE + PAYLOAD_CONFIG_SIZE)
+  {
+    isolate->ThrowException(v8::Exception::RangeError(v8::String::NewFromUtf8(isolate, "Uplinks are 4 or 12 bytes")));
+    return;
+  }
+
+  size_t count = node::Buffer::Length(args[0]) / size;
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[3]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[3]) / sizeof(u32);
+  }
+
+  // Number of uplinks that could not be decoded
+  u32 rejected = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    u8 err = WATCHDOG_uplink(obj->watchdog_, device_ids[i], times[i], uplinks + (i * size), size);
+    if (err == WATCHDOG_ERR_ALLOC)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the watchdog")));
+      return;
+    }
+    rejected += (err == WATCHDOG_ERR_DATA);
+  }
+  args.GetReturnValue().Set(rejected);
+}
+
+void Watchdog::Arm(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Watchdog *obj = node::ObjectWrap::Unwrap<Watchdog>(args.Holder());
+
+  // args: Uint32Array device ids, Uint32Array last times, Uint32Array deadlines
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[0]);
+  const u32 *last_times = (const u32 *)node::Buffer::Data(args[1]);
+  const u32 *deadlines = (const u32 *)node::Buffer::Data(args[2]);
+
+  size_t count = node::Buffer::Length(args[0]) / sizeof(u32);
+  if (count > node::Buffer::Length(args[1]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[1]) / sizeof(u32);
+  }
+  if (count > node::Buffer::Length(args[2]) / sizeof(u32))
+  {
+    count = node::Buffer::Length(args[2]) / sizeof(u32);
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    if (WATCHDOG_arm(obj->watchdog_, device_ids[i], last_times[i], deadlines[i]) != WATCHDOG_ERR_NONE)
+    {
+      isolate->ThrowException(v8::Exception::Error(v8::String::NewFromUtf8(isolate, "Unable to grow the watchdog")));
+      return;
+    }
+  }
+}
+
+void Watchdog::Remove(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  Watchdog *obj = node::ObjectWrap::Unwrap<Watchdog>(args.Holder());
+
+  // args: Uint32Array device ids
+  const u32 *device_ids = (const u32 *)node::Buffer::Data(args[0]);
+  size_t count = node::Buffer::Length(args[0]) / sizeof(u32);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    WATCHDOG_remove(obj->watchdog_, device_ids[i]);
+  }
+}
+
+void Watchdog::Poll(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Watchdog *obj = node::ObjectWrap::Unwrap<Watchdog>(args.Holder());
+
+  // args: time, max devices
+  u32 time = args[0]->Uint32Value();
+  u32 max = args[1]->Uint32Value();
+  if (max > obj->watchdog_->armed)
+  {
+    max = obj->watchdog_->armed;
+  }
+
+  // Both columns in a single ArrayBuffer
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, (size_t)max * 2 * sizeof(u32));
+  u32 *columns = (u32 *)buffer->GetContents().Data();
+  u32 count = WATCHDOG_poll(obj->watchdog_, time, columns, columns + max, max);
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Uint32Array::New(buffer, 0, count));
+  res->Set(v8::String::NewFromUtf8(isolate, "lastTimes"), v8::Uint32Array::New(buffer, max * sizeof(u32), count));
+  args.GetReturnValue().Set(res);
+}
+
+void Watchdog::Stats(const v8::FunctionCallbackInfo<v8::Value> &args)
+{
+  v8::Isolate *isolate = args.GetIsolate();
+  Watchdog *obj = node::ObjectWrap::Unwrap<Watchdog>(args.Holder());
+
+  v8::Local<v8::Object> res = v8::Object::New(isolate);
+  res->Set(v8::String::NewFromUtf8(isolate, "devices"), v8::Number::New(isolate, obj->watchdog_->device_count));
+  res->Set(v8::String::NewFromUtf8(isolate, "armed"), v8::Number::New(isolate, obj->watchdog_->armed));
+  args.GetReturnValue().Set(res);
+}
+
+void WATCHDOG_node_init(v8::Local<v8::Object> exports)
+{
+  Watchdog::Init(exports);
+}
@@ -0,0 +1,385 @@
+/*!******************************************************************
+ * \file sensitd.c
+ * \brief Local batch decoding daemon
+ * \author Sens'it Team
+ *
+ * Serve the protocol of sensit_protocol.h on a Unix domain socket and
+ * optionally on a localhost TCP port, so that any local process decodes
+ * Sens'it payloads without its own implementation of the bit layouts.
+ * A single thread multiplexes the connections with epoll. Requests of a
+ * connection are pipelined: every complete request read is decoded and
+ * the replies are written in order as the socket accepts them.
+ *
+ * Usage: sensitd [-s socket path] [-p tcp port]
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "sensit_payload.h"
+#include "sensit_protocol.h"
+
+/******* DEFINE ****************************************************/
+#define SENSITD_DEFAULT_SOCKET "/tmp/sensitd.sock"
+#define SENSITD_MAX_EVENTS 64
+#define SENSITD_READ_SIZE 65536
+#define SENSITD_MAX_PENDING (64 * 1024 * 1024) /* Stop reading a connection that does not read its replies */
+#define SENSITD_COMPACT_SIZE (1024 * 1024)       /* Written bytes of the replies moved out once a send is partial */
+
+/*!******************************************************************
+ * \struct sensitd_connection_s
+ * \brief Listening socket or client connection
+ *******************************************************************/
+typedef struct
+{
+    int fd;
+    bool listener;
+    u32 events;             /*!< Registered epoll events */
+    u8 *in;                 /*!< Bytes read, not handled yet */
+    u32 in_size;
+    u32 in_capacity;
+    protocol_buffer_s out;  /*!< Replies */
+    u32 out_offset;         /*!< Bytes of out already written */
+    bool eof;               /*!< Peer shut down its side, close once the replies are written */
+} sensitd_connection_s;
+
+static volatile sig_atomic_t sensitd_stop = 0;
+
+/*******************************************************************/
+
+static void SENSITD_on_signal(int signal)
+{
+    (void)signal;
+    sensitd_stop = 1;
+}
+
+/*******************************************************************/
+
+static sensitd_connection_s *SENSITD_add(int epoll_fd, int fd, bool listener)
+{
+    sensitd_connection_s *connection = (sensitd_connection_s *)calloc(1, sizeof(sensitd_connection_s));
+    struct epoll_event event;
+
+    if (connection == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+    connection->fd = fd;
+    connection->listener = listener;
+    connection->events = EPOLLIN;
+
+    event.events = connection->events;
+    event.data.ptr = connection;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+        close(fd);
+        free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+/*******************************************************************/
+
+static void SENSITD_close(sensitd_connection_s *connection)
+{
+    /* Closing the fd removes it from the epoll set */
+    close(connection->fd);
+    free(connection->in);
+    PROTOCOL_free(&(connection->out));
+    free(connection);
+}
+
+/*******************************************************************/
+
+static bool SENSITD_update_events(int epoll_fd, sensitd_connection_s *connection)
+{
+    u32 pending = connection->out.size - connection->out_offset;
+    u32 events = ((pending != 0) ? (u32)EPOLLOUT : 0) | ((pending < SENSITD_MAX_PENDING && !connection->eof) ? (u32)EPOLLIN : 0);
+    struct epoll_event event;
+
+    if (events == connection->events)
+    {
+        return TRUE;
+    }
+    connection->events = events;
+    event.events = events;
+    event.data.ptr = connection;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event) == 0;
+}
+
+/*******************************************************************/
+
+static bool SENSITD_write(sensitd_connection_s *connection)
+{
+    ssize_t written;
+    u32 pending;
+
+    while (connection->out_offset < connection->out.size)
+    {
+        written = send(connection->fd, connection->out.data + connection->out_offset,
+                       connection->out.size - connection->out_offset, MSG_NOSIGNAL);
+        if (written < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                return FALSE;
+            }
+            break;
+        }
+        connection->out_offset += (u32)written;
+    }
+
+    /* A peer reading while new replies are appended may never drain them
+       all, move the unsent part to the front instead of growing behind it */
+    pending = connection->out.size - connection->out_offset;
+    if (pending == 0 || connection->out_offset >= SENSITD_COMPACT_SIZE)
+    {
+        if (pending != 0)
+        {
+            memmove(connection->out.data, connection->out.data + connection->out_offset, pending);
+        }
+        connection->out.size = pending;
+        connection->out_offset = 0;
+    }
+    return TRUE;
+}
+
+/*******************************************************************/
+
+static u32 SENSITD_length(const u8 *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((u32)in[3] << 24);
+}
+
+/*******************************************************************/
+
+static bool SENSITD_read(sensitd_connection_s *connection)
+{
+    ssize_t received;
+    u32 offset = 0;
+    u32 capacity = connection->in_size + SENSITD_READ_SIZE;
+    u32 length;
+    void *in;
+
+    /* The bytes left are the start of a request, whose length was checked:
+       reserve all of it at once rather than a read size per wake up */
+    if (connection->in_size >= PROTOCOL_LENGTH_SIZE)
+    {
+        capacity = PROTOCOL_LENGTH_SIZE + SENSITD_length(connection->in);
+    }
+    if (connection->in_capacity < capacity)
+    {
+        in = realloc(connection->in, capacity);
+        if (in == NULL)
+        {
+            return FALSE;
+        }
+        connection->in = (u8 *)in;
+        connection->in_capacity = capacity;
+    }
+
+    /* A single read per wake up keeps the other connections served */
+    received = recv(connection->fd, connection->in + connection->in_size, connection->in_capacity - connection->in_size, 0);
+    if (received == 0)
+    {
+        connection->eof = TRUE;
+        return TRUE;
+    }
+    if (received < 0)
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    connection->in_size += (u32)received;
+
+    /* Handle every complete request */
+    while (connection->in_size - offset >= PROTOCOL_LENGTH_SIZE)
+    {
+        length = SENSITD_length(connection->in + offset);
+        if (length < PROTOCOL_HEADER_SIZE || length > PROTOCOL_MAX_REQUEST)
+        {
+            return FALSE;
+        }
+        if (connection->in_size - offset - PROTOCOL_LENGTH_SIZE < length)
+        {
+            break;
+        }
+        if (PROTOCOL_handle(connection->in + offset + PROTOCOL_LENGTH_SIZE, length, &(connection->out)) != PROTOCOL_ERR_NONE)
+        {
+            return FALSE;
+        }
+        offset += PROTOCOL_LENGTH_SIZE + length;
+    }
+    memmove(connection->in, connection->in + offset, connection->in_size - offset);
+    connection->in_size -= offset;
+
+    return SENSITD_write(connection);
+}
+
+/*******************************************************************/
+
+static void SENSITD_accept(int epoll_fd, sensitd_connection_s *listener)
+{
+    int one = 1;
+    int fd;
+
+    for (;;)
+    {
+        fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            return;
+        }
+        /* Fails on Unix domain sockets, harmless */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        SENSITD_add(epoll_fd, fd, FALSE);
+    }
+}
+
+/*******************************************************************/
+
+static int SENSITD_listen_unix(const char *path)
+{
+    struct sockaddr_un address;
+    int fd;
+
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*******************************************************************/
+
+static int SENSITD_listen_tcp(u16 port)
+{
+    struct sockaddr_in address;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*******************************************************************/
+
+int main(int argc, char **argv)
+{
+    const char *path = SENSITD_DEFAULT_SOCKET;
+    long port = 0;
+    struct epoll_event events[SENSITD_MAX_EVENTS];
+    struct sigaction action;
+    sensitd_connection_s *connection;
+    int epoll_fd;
+    int listen_fd;
+    int count;
+    int option;
+    int i;
+
+    while ((option = getopt(argc, argv, "s:p:h")) != -1)
+    {
+        switch (option)
+        {
+        case 's':
+            path = optarg;
+            break;
+        case 'p':
+            port = strtol(optarg, NULL, 10);
+            if (port <= 0 || port > 0xFFFF)
+            {
+                fprintf(stderr, "sensitd: invalid port %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-s socket path] [-p tcp port]\n", argv[0]);
+            return (option == 'h') ? 0 : 1;
+        }
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = SENSITD_on_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    listen_fd = SENSITD_listen_unix(path);
+    if (epoll_fd < 0 || listen_fd < 0 || SENSITD_add(epoll_fd, listen_fd, TRUE) == NULL)
+    {
+        fprintf(stderr, "sensitd: unable to listen on %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (port != 0)
+    {
+        listen_fd = SENSITD_listen_tcp((u16)port);
+        if (listen_fd < 0 || SENSITD_add(epoll_fd, listen_fd, TRUE) == NULL)
+        {
+            fprintf(stderr, "sensitd: unable to listen on 127.0.0.1:%ld: %s\n", port, strerror(errno));
+            unlink(path);
+            return 1;
+        }
+    }
+
+    while (!sensitd_stop)
+    {
+        count = epoll_wait(epoll_fd, events, SENSITD_MAX_EVENTS, -1);
+        for (i = 0; i < count; i++)
+        {
+            connection = (sensitd_connection_s *)events[i].data.ptr;
+            if (connection->listener)
+            {
+                SENSITD_accept(epoll_fd, connection);
+                continue;
+            }
+            if (((events[i].events & EPOLLOUT) && !SENSITD_write(connection)) ||
+                ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && (connection->events & EPOLLIN) && !SENSITD_read(connection)) ||
+                (connection->eof && connection->out.size == 0) || !SENSITD_update_events(epoll_fd, connection))
+            {
+                SENSITD_close(connection);
+            }
+        }
+    }
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { readArrowStream } = require('./fixtures/arrow');
+
+const payloads = ['f6100065', 'f609744f', 'b6180000', '895d205d'];
+
+tap.test('sensitPayload.toArrow() stream', (t) => {
+  const arrow = sensitPayload.toArrow(payloads, { devices: [1, 2, 3, 4] });
+  t.strictSame(arrow.readUInt32LE(0), 0xFFFFFFFF);
+  t.strictSame(arrow.length % 8, 0);
+  // End-of-stream marker
+  t.strictSame(arrow.readUInt32LE(arrow.length - 8), 0xFFFFFFFF);
+  t.strictSame(arrow.readUInt32LE(arrow.length - 4), 0);
+
+  t.throws(() => sensitPayload.toArrow(payloads, { devices: [1, 2, 3] }), RangeError);
+  t.throws(() => sensitPayload.configToArrow(['46003f0f8004223c'], sensitPayload.PAYLOAD_TYPE_V3, { times: [1, 2] }), RangeError);
+  t.end();
+});
+
+tap.test('sensitPayload.toArrow() columns', (t) => {
+  const known = payloads.concat(['ae003040', 'ffffffff']);
+  const devices = known.map((payload, i) => i + 1);
+  const times = known.map((payload, i) => 1500000000 + (i * 600));
+  const { fields, batches } = readArrowStream(sensitPayload.toArrow(known, { devices, times }));
+  t.strictSame(fields.map(field => field.name).slice(0, 4), ['device', 'time', 'error', 'type']);
+  t.strictSame(batches.length, 1);
+  const { length, columns } = batches[0];
+  t.strictSame(length, known.length);
+  t.strictSame(columns.device, devices);
+  t.strictSame(columns.time, times);
+
+  // Raw units of the columns, null when parse() leaves the field out
+  const scaled = (value, scale) => (value === undefined ? null : Math.round(value * scale));
+  known.forEach((payload, row) => {
+    const data = sensitPayload.parse(payload);
+    const value = name => columns[name][row];
+    t.strictSame(value('error'), data.error);
+    if (data.error !== sensitPayload.PARSE_ERR_NONE) {
+      return;
+    }
+    t.strictSame([value('type'), value('mode'), value('battery_level'), value('button')],
+      [data.type, data.modeCode, data.batteryLevel, data.button], payload);
+    t.strictSame([value('temperature'), value('humidity'), value('brightness'), value('event_counter')],
+      [scaled(data.temperature, 8), scaled(data.humidity, 2), scaled(data.light, 96), scaled(data.eventCounter, 1)], payload);
+    t.strictSame(value('version_major') === null ? undefined : `${value('version_major')}.${value('version_minor')}.${value('version_patch')}`,
+      data.version, payload);
+  });
+  t.end();
+});
+
+tap.test('sensitPayload.configToArrow() file', (t) => {
+  const arrow = sensitPayload.configToArrow(['46003f0f8004223c'], sensitPayload.PAYLOAD_TYPE_V3, { format: 'file' });
+  t.strictSame(arrow.slice(0, 6).toString(), 'ARROW1');
+  t.strictSame(arrow.slice(arrow.length - 6).toString(), 'ARROW1');
+
+  // The stream follows the padded magic
+  const { columns } = readArrowStream(arrow, 8).batches[0];
+  const { config } = sensitPayload.parse('ae00304046003f0f8004223c');
+  t.strictSame([columns.limited[0], columns.period[0], columns.door_config[0], columns.delay[0]],
+    [config.limited, config.period, config.door, config.vibrationClearTime]);
+  t.strictSame([columns.temperature_low_threshold[0], columns.temperature_high_threshold[0], columns.humidity_low_threshold[0],
+    columns.humidity_high_threshold[0], columns.brightness_threshold[0], columns.vibration_config[0]],
+  [config.temperatureLower, config.temperatureUpper, config.humidityLower, config.humidityUpper, config.lightThreshold,
+    config.vibrationSensitivity]);
+  t.strictSame([columns.is_standby_periodic[0], columns.is_temperature_periodic[0], columns.is_light_periodic[0]],
+    [config.isStandByPeriodic, config.isTemperaturePeriodic, config.isLightPeriodic]);
+  t.end();
+});
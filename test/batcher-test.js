@@ -0,0 +1,107 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { randomPayloads } = require('./fixtures/payloads');
+
+// Hexadecimal payloads, a third with a "config" part
+function randomUplinks(count, seed) {
+  const buffer = randomPayloads(count, seed);
+  return Array.from({ length: count }, (value, i) => {
+    const data = buffer.toString('hex', i * 4, (i + 1) * 4);
+    return i % 3 === 0 ? `${data}00ff008f04027390` : data;
+  });
+}
+
+tap.test('batcher.parse()', (t) => {
+  const payloads = randomUplinks(1000, 13);
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 5000, maxBatch: 64 });
+
+  return Promise.all(payloads.map(payload => batcher.parse(payload).catch(err => err))).then((results) => {
+    results.forEach((data, i) => {
+      try {
+        t.strictSame(data, sensitPayload.parse(payloads[i]));
+      } catch (err) {
+        // e.g. the "config" part of a payload of unknown type
+        t.strictSame(data.message, err.message);
+      }
+    });
+    const stats = batcher.stats();
+    t.strictSame(stats.requests, 1000);
+    t.strictSame(stats.pending, 0);
+    t.ok(stats.batches >= 1000 / 64 && stats.batches < 1000 / 8, `${stats.batches} batches`);
+    t.ok(stats.efficiency > 0.85);
+    t.ok(stats.batchSize > 16 && stats.batchSize <= 64, `batch size ${stats.batchSize}`);
+  });
+});
+
+tap.test('batcher.parse(payload, callback)', (t) => {
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 2000 });
+  const started = process.hrtime();
+  batcher.parse('895d205d', (err, data) => {
+    const [seconds, nanoseconds] = process.hrtime(started);
+    t.error(err);
+    t.strictSame(data, sensitPayload.parse('895d205d'));
+    t.ok((seconds * 1e6) + (nanoseconds / 1e3) >= 1000);
+    t.strictSame(batcher.stats().flushedByDelay, 1);
+
+    batcher.parse('b609', (lengthErr) => {
+      t.match(lengthErr, /8 or 24 hexadecimal characters/);
+      t.strictSame(batcher.stats().requests, 1);
+      t.end();
+    });
+  });
+  t.strictSame(batcher.stats().pending, 1);
+});
+
+tap.test('batcher.flush()', (t) => {
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 60000000 });
+  const pending = batcher.parse('895d205d');
+  batcher.flush();
+  t.strictSame(batcher.stats().pending, 0);
+  return pending.then((data) => {
+    t.strictSame(data.mode, 'temperature');
+    return t.rejects(batcher.parse(42), /8 or 24 hexadecimal characters/);
+  });
+});
+
+tap.test('batcher rejects non hexadecimal payloads', (t) => {
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 1000 });
+  const valid = batcher.parse('895d205d');
+  const invalid = batcher.parse('zzzzzzzz');
+  const partly = batcher.parse('895d20zz00ff008f04027390');
+  t.strictSame(batcher.stats().pending, 1);
+  return Promise.all([valid, invalid.catch(err => err), partly.catch(err => err)]).then(([data, err, partlyErr]) => {
+    t.strictSame(data, sensitPayload.parse('895d205d'));
+    t.match(err, /8 or 24 hexadecimal characters/);
+    t.match(partlyErr, /8 or 24 hexadecimal characters/);
+  });
+});
+
+tap.test('batcher callbacks are asynchronous', (t) => {
+  // The second request fills the batch, which is decoded within parse()
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 60000000, maxBatch: 2 });
+  const order = [];
+  batcher.parse('895d205d', () => order.push('first'));
+  batcher.parse('895d205d', (err, data) => {
+    order.push('second');
+    t.error(err);
+    t.strictSame(data.mode, 'temperature');
+    t.strictSame(order, ['returned', 'first', 'second']);
+    t.end();
+  });
+  order.push('returned');
+  t.strictSame(batcher.stats().batches, 1);
+});
+
+tap.test('batcher adapts its batch size', (t) => {
+  // A latency target no batch can meet shrinks the batches down to single requests
+  const batcher = sensitPayload.createBatcher({ maxDelayUs: 100, maxBatch: 128, targetLatencyUs: 0.001 });
+  const payloads = randomUplinks(2000, 17);
+  return Promise.all(payloads.map(payload => batcher.parse(payload).catch(err => err))).then(() => {
+    t.strictSame(batcher.stats().batchSize, 1);
+    t.throws(() => sensitPayload.createBatcher({ maxBatch: 0 }), /must be positive/);
+  });
+});
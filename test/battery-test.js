@@ -0,0 +1,42 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+// v3 temperature payload with the given 5 bits battery level
+function payloadV3(battery) {
+  return Buffer.from([(battery << 3) | 0b110, sensitPayload.MODE_TEMPERATURE << 3, 0x74, 0x4f]).toString('hex');
+}
+
+tap.test('batteryForecaster.query()', (t) => {
+  const forecaster = sensitPayload.createBatteryForecaster();
+  const start = 1500000000;
+  const payloads = [];
+  const devices = [];
+  const times = [];
+  // Device 1 looses 50 mV every 2 days, device 2 stays at 4200 mV
+  for (let day = 0; day <= 20; day++) {
+    payloads.push(payloadV3(30 - Math.floor(day / 2)), payloadV3(30));
+    devices.push(1, 2);
+    times.push(start + (day * 86400), start + (day * 86400));
+  }
+  t.strictSame(forecaster.update(payloads, devices, times), 0);
+  t.strictSame(forecaster.size(), 2);
+
+  const estimate = forecaster.get(1);
+  t.ok(Math.abs(estimate.slope + 25) < 2);
+  t.ok(Math.abs(forecaster.get(2).slope) < 0.01);
+  t.strictSame(forecaster.get(3), undefined);
+
+  const now = start + (20 * 86400);
+  t.strictSame(Array.from(forecaster.query({ below: 3300, withinDays: 30, now }).devices), [1]);
+  t.strictSame(Array.from(forecaster.query({ below: 3300, withinDays: 5, now }).devices), []);
+
+  // A recharged battery restarts the regression
+  forecaster.update([payloadV3(30)], [1], [now + 86400]);
+  t.strictSame(forecaster.get(1).samples, 1);
+  t.strictSame(forecaster.get(1).slope, 0);
+  t.end();
+});
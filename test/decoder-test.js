@@ -0,0 +1,50 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { spawnSync } = require('child_process');
+const sensitPayload = require('../');
+
+const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'sensit-decoder-plugin-'));
+const plugin = path.join(directory, 'decoder-plugin.so');
+const build = spawnSync('g++', ['-O2', '-fPIC', '-shared', `-I${path.join(__dirname, '..', 'src')}`,
+  path.join(__dirname, 'fixtures', 'decoder-plugin.cc'), '-o', plugin]);
+
+// A loaded plugin stays mapped once unlinked
+tap.teardown(() => {
+  fs.readdirSync(directory).forEach(file => fs.unlinkSync(path.join(directory, file)));
+  fs.rmdirSync(directory);
+});
+
+tap.test('registerDecoders()', { skip: process.platform === 'win32' || build.error || build.status !== 0 }, (t) => {
+  // 3 low bits 0b111 are not a Sens'it payload until the plugin is loaded
+  t.strictSame(sensitPayload.parseData('3700985d').error, 1);
+  t.strictSame(sensitPayload.decoders(), []);
+
+  t.strictSame(sensitPayload.registerDecoders(plugin), 1);
+  t.strictSame(sensitPayload.decoders(), [{ name: 'compact', type: 4, keyMask: 7, keyValue: 7 }]);
+
+  const data = sensitPayload.parseData('3700985d');
+  t.strictSame(data.type, 4);
+  t.strictSame(data.error, 0);
+  t.strictSame(data.mode, 'temperature');
+  t.strictSame(data.temperature, 19);
+  t.strictSame(data.humidity, 46.5);
+  t.strictSame(data.batteryLevel, 3000);
+
+  // Rejected by the match of the plugin, v2 & v3 are unchanged
+  t.strictSame(sensitPayload.parseData('3f00985d').error, 1);
+  t.strictSame(sensitPayload.parseData('f6100065'), sensitPayload.parseDataV3('f6100065'));
+
+  // Batch & columnar decoding go through the same jump table
+  const batch = sensitPayload.parseDataBatch(Buffer.from('3700985df6100065', 'hex'));
+  t.strictSame(batch.map(payload => payload.type), [4, 3]);
+  t.match(sensitPayload.toNdjson(Buffer.from('3700985d', 'hex')).toString(), /"temperature":19/);
+
+  t.throws(() => sensitPayload.registerDecoders(path.join(directory, 'missing-decoder-plugin.so')));
+  t.end();
+});
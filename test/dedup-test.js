@@ -0,0 +1,30 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+
+tap.test('deduplicator.isDuplicate()', (t) => {
+  const dedup = sensitPayload.createDeduplicator({ capacity: 16 });
+  t.strictSame(dedup.isDuplicate('1A2B3C', 4094), false);
+  t.strictSame(dedup.isDuplicate('1A2B3C', 4094), true);
+  // seqNumber wraps around after 4095
+  t.strictSame(dedup.isDuplicate('1A2B3C', 2), false);
+  t.strictSame(dedup.isDuplicate('1A2B3C', 4095), false);
+  t.strictSame(dedup.isDuplicate('1A2B3C', 4095), true);
+  t.strictSame(dedup.isDuplicate('1A2B3D', 4095), false);
+  t.end();
+});
+
+tap.test('deduplicator.filter()', (t) => {
+  const dedup = sensitPayload.createDeduplicator();
+  const mask = dedup.filter(['1A2B3C', '1A2B3C', '1A2B3D', '1A2B3C'], [10, 10, 10, 9]);
+  t.strictSame(Array.from(mask), [1, 0, 1, 1]);
+  const stats = dedup.stats();
+  t.strictSame(stats.lookups, 4);
+  t.strictSame(stats.duplicates, 1);
+  t.strictSame(stats.duplicateRate, 0.25);
+  t.end();
+});
@@ -0,0 +1,34 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+tap.test('downlinkStore.answer()', (t) => {
+  const store = sensitPayload.createDownlinkStore();
+  const config = '00ff008f04027390';
+  const other = '00ff008f04027391';
+
+  t.strictSame(store.answer('1A2B3C'), null);
+  t.strictSame(store.set(['1A2B3C', 2], [config, config], [2, 2]), 0);
+  t.strictSame(store.answer('1A2B3C'), { config, version: 2 });
+  t.strictSame(store.stats(), { devices: 2, pending: 2 });
+
+  // Device reports the desired config
+  t.strictSame(store.answer('1A2B3C', `f6096180${config}`), null);
+  t.strictSame(store.stats().pending, 1);
+
+  // Older version ignored, newer one answered
+  t.strictSame(store.set(['1A2B3C'], [other], 1), 1);
+  t.strictSame(store.answer('1A2B3C'), null);
+  t.strictSame(store.set(['1A2B3C'], [other], 3), 0);
+  t.strictSame(store.answer('1A2B3C'), { config: other, version: 3 });
+  t.strictSame(store.get('1A2B3C'), { desired: other, version: 3, reported: config });
+
+  store.report([2], [`f6096180${config}`]);
+  store.clear(['1A2B3C']);
+  t.strictSame(store.answer('1A2B3C'), null);
+  t.strictSame(store.stats(), { devices: 2, pending: 0 });
+  t.end();
+});
@@ -0,0 +1,78 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { randomPayloads } = require('./fixtures/payloads');
+
+function createStore(count) {
+  const store = sensitPayload.createSeriesStore();
+  const times = Uint32Array.from({ length: count }, (value, i) => 1500000000 + (i * 600));
+  store.append(randomPayloads(count, 3), new Uint32Array(count), times);
+  return store;
+}
+
+// Lowest & highest sample of each bucket, in time order
+function minMax({ times, values }, from, to, width) {
+  const points = [];
+  for (let bucket = 0; bucket < width; bucket++) {
+    let min = -1;
+    let max = -1;
+    times.forEach((time, i) => {
+      if (Math.floor(((time - from) * width) / (to - from + 1)) !== bucket) {
+        return;
+      }
+      min = min < 0 || values[i] < values[min] ? i : min;
+      max = max < 0 || values[i] > values[max] ? i : max;
+    });
+    if (min >= 0) {
+      new Set([min, max].sort((a, b) => times[a] - times[b])).forEach(i => points.push([times[i], values[i]]));
+    }
+  }
+  return points;
+}
+
+const toPoints = ({ times, values }) => Array.from(times, (time, i) => [time, values[i]]);
+
+tap.test('store.downsample() minMax', (t) => {
+  const store = createStore(20000);
+  const from = 1500000000 + 123457;
+  const to = 1500000000 + 9000000;
+  const samples = store.read(0, 'batteryLevel', from, to);
+
+  const downsampled = store.downsample(0, 'batteryLevel', { width: 300, method: 'minMax', from, to });
+  t.strictSame(toPoints(downsampled), minMax(samples, from, to, 300));
+  t.strictSame(Math.max(...downsampled.values), Math.max(...samples.values));
+  t.strictSame(Math.min(...downsampled.values), Math.min(...samples.values));
+
+  // The range is clamped to the samples, the ones waiting for a full block included
+  const all = store.read(0, 'batteryLevel');
+  t.strictSame(toPoints(store.downsample(0, 'batteryLevel', { width: 7, method: 'minMax' })),
+    minMax(all, all.times[0], all.times[all.times.length - 1], 7));
+  t.end();
+});
+
+tap.test('store.downsample() lttb', (t) => {
+  const store = createStore(20000);
+  const all = store.read(0, 'temperature');
+
+  const short = store.downsample(0, 'temperature', { width: 200, from: all.times[0], to: all.times[400] });
+  t.strictSame(short.times.length, 200);
+  t.strictSame(short.times[0], all.times[0]);
+  t.strictSame(short.times[199], all.times[400]);
+
+  const long = store.downsample(0, 'temperature', { width: 500 });
+  t.strictSame(long.times.length, 500);
+  t.ok(long.times.every((time, i) => i === 0 || time > long.times[i - 1]));
+  const samples = new Map(toPoints(all));
+  t.ok(long.times.every((time, i) => samples.get(time) === long.values[i]));
+
+  // Fewer samples than pixels are returned as is
+  t.strictSame(toPoints(store.downsample(0, 'temperature', { width: 50, to: all.times[9] })), toPoints(all).slice(0, 10));
+  t.strictSame(store.downsample(1, 'temperature', { width: 50 }).times.length, 0);
+
+  t.throws(() => store.downsample(0, 'temperature', { width: 0 }), RangeError);
+  t.throws(() => store.downsample(0, 'temperature', { width: 10, method: 'average' }));
+  t.end();
+});
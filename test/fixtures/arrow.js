@@ -0,0 +1,101 @@
+/**
+ * Minimal reader of the Arrow IPC streams written by toArrow() & configToArrow():
+ * int, bool and timestamp columns, little endian, no dictionaries
+ */
+
+// Little endian 64 bits integer, exact below 2^53
+const readInt64 = (buffer, position) => buffer.readUInt32LE(position) + (buffer.readInt32LE(position + 4) * 0x100000000);
+
+// Flatbuffers table at position
+function table(buffer, position) {
+  const vtable = position - buffer.readInt32LE(position);
+  const vtableSize = buffer.readUInt16LE(vtable);
+  const field = (slot) => {
+    const offset = 4 + (2 * slot) < vtableSize ? buffer.readUInt16LE(vtable + 4 + (2 * slot)) : 0;
+    return offset ? position + offset : null;
+  };
+  const ref = (slot) => {
+    const at = field(slot);
+    return at === null ? null : at + buffer.readUInt32LE(at);
+  };
+  const vector = (slot) => {
+    const at = ref(slot);
+    return at === null ? { start: 0, length: 0 } : { start: at + 4, length: buffer.readUInt32LE(at) };
+  };
+  return {
+    field,
+    u8: (slot, value = 0) => (field(slot) === null ? value : buffer.readUInt8(field(slot))),
+    i16: (slot, value = 0) => (field(slot) === null ? value : buffer.readInt16LE(field(slot))),
+    i32: (slot, value = 0) => (field(slot) === null ? value : buffer.readInt32LE(field(slot))),
+    i64: (slot, value = 0) => (field(slot) === null ? value : readInt64(buffer, field(slot))),
+    table: slot => (ref(slot) === null ? null : table(buffer, ref(slot))),
+    vector,
+    string: (slot) => {
+      const at = ref(slot);
+      return buffer.toString('utf8', at + 4, at + 4 + buffer.readUInt32LE(at));
+    },
+  };
+}
+
+// Schema.fields: name, Type union (2 Int, 6 Bool, 10 Timestamp)
+function readSchema(buffer, schema) {
+  const { start, length } = schema.vector(1);
+  return Array.from({ length }, (value, i) => {
+    const at = start + (4 * i);
+    const field = table(buffer, at + buffer.readUInt32LE(at));
+    const type = field.table(3);
+    const typeId = field.u8(2);
+    if (typeId === 2) {
+      return { name: field.string(0), width: type.i32(0) / 8, signed: type.u8(1) === 1 };
+    }
+    return { name: field.string(0), width: typeId === 10 ? 8 : 0, signed: true };
+  });
+}
+
+// RecordBatch: length, nodes & buffers (validity, values) of each column
+function readBatch(buffer, batch, fields, body) {
+  const length = batch.i64(0);
+  const buffers = batch.vector(2);
+  const columns = {};
+  fields.forEach(({ name, width, signed }, i) => {
+    const at = buffers.start + (32 * i);
+    const validity = body + readInt64(buffer, at);
+    const validityLength = readInt64(buffer, at + 8);
+    const values = body + readInt64(buffer, at + 16);
+    columns[name] = Array.from({ length }, (value, row) => {
+      const bit = position => (buffer[position + (row >> 3)] >> (row & 7)) & 1;
+      if (validityLength && !bit(validity)) {
+        return null;
+      }
+      if (!width) {
+        return bit(values) === 1;
+      }
+      if (width === 8) {
+        return readInt64(buffer, values + (8 * row));
+      }
+      return signed ? buffer.readIntLE(values + (width * row), width) : buffer.readUIntLE(values + (width * row), width);
+    });
+  });
+  return { length, columns };
+}
+
+function readArrowStream(buffer, position = 0) {
+  const batches = [];
+  let fields = [];
+  for (;;) {
+    const metadataLength = buffer.readUInt32LE(position + 4);
+    if (metadataLength === 0) {
+      return { fields, batches };
+    }
+    const message = table(buffer, position + 8 + buffer.readUInt32LE(position + 8));
+    const body = position + 8 + metadataLength;
+    if (message.u8(1) === 1) {
+      fields = readSchema(buffer, message.table(2));
+    } else {
+      batches.push(readBatch(buffer, message.table(2), fields, body));
+    }
+    position = body + message.i64(3);
+  }
+}
+
+module.exports = { readArrowStream };
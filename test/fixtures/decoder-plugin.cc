@@ -0,0 +1,51 @@
+/*!******************************************************************
+ * \file decoder-plugin.c
+ * \brief Example decoder plugin: a compact temperature format on the
+ *        first byte values unused by v2 & v3 (3 low bits 0b111)
+ * \author Sens'it Team
+ *
+ * g++ -O2 -fPIC -shared -Isrc test/fixtures/decoder-plugin.cc -o decoder-plugin.so
+ *
+ * byte 0: bits 4-7 battery (100 mV steps from 2700 mV), bit 3 revision
+ *         (0 only), bits 0-2 0b111
+ * bytes 1-2: temperature, signed big endian, must be divided by 8 to get in °C
+ * byte 3: humidity, must be divided by 2 to get in %
+ *******************************************************************/
+/******* INCLUDES **************************************************/
+#include "sensit_payload.h"
+
+/******* DEFINE ****************************************************/
+#define COMPACT_TYPE PAYLOAD_LAST
+#define COMPACT_BATTERY_OFFSET 2700
+#define COMPACT_BATTERY_STEP 100
+
+/*******************************************************************/
+
+static bool COMPACT_match(const u8 *data_in)
+{
+    return (data_in[0] & 0x08) == 0;
+}
+
+/*******************************************************************/
+
+static void COMPACT_parse(u8 *data_in, data_s *data_out)
+{
+    data_out->mode = MODE_TEMPERATURE;
+    data_out->battery_level = COMPACT_BATTERY_OFFSET + ((data_in[0] >> 4) * COMPACT_BATTERY_STEP);
+    data_out->temperature = (s16)((data_in[1] << 8) | data_in[2]);
+    data_out->humidity = data_in[3];
+}
+
+/*******************************************************************/
+
+static const payload_decoder_s COMPACT_decoders[] = {
+    { "compact", COMPACT_TYPE, 0x07, 0x07, COMPACT_match, COMPACT_parse }
+};
+
+/*******************************************************************/
+
+extern "C" const payload_decoder_s *sensit_payload_decoders(u32 *count)
+{
+    *count = sizeof(COMPACT_decoders) / sizeof(COMPACT_decoders[0]);
+    return COMPACT_decoders;
+}
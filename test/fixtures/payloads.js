@@ -0,0 +1,21 @@
+/**
+ * Deterministic payloads of every version and mode, from a linear
+ * congruential generator
+ *
+ * @param {Number} count
+ * @param {Number} seed
+ *
+ * @return {Buffer} count concatenated 4 bytes payloads
+ */
+
+function randomPayloads(count, seed) {
+  const buffer = Buffer.alloc(count * 4);
+  let state = seed;
+  for (let i = 0; i < count; i++) {
+    state = ((state * 1103515245) + 12345) >>> 0;
+    buffer.writeUInt32BE((state ^ (state >>> 15)) >>> 0, i * 4);
+  }
+  return buffer;
+}
+
+module.exports = { randomPayloads };
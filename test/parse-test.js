@@ -178,3 +178,77 @@ samples.forEach((sample) => {
     t.end();
   });
 });
+
+samples.filter(sample => sample.payload.length === 8).forEach((sample) => {
+  tap.test(`sensitPayload.parseDataV${sample.expected.type}(${sample.payload})`, (t) => {
+    const parseAs = sample.expected.type === 3 ? sensitPayload.parseDataV3 : sensitPayload.parseDataV2;
+    const parseOther = sample.expected.type === 3 ? sensitPayload.parseDataV2 : sensitPayload.parseDataV3;
+    t.strictSame(parseAs(sample.payload), sensitPayload.parseData(sample.payload));
+    t.equal(parseOther(sample.payload).error, sensitPayload.PARSE_ERR_TYPE);
+    t.end();
+  });
+});
+
+tap.test('sensitPayload.parseDataBatch()', (t) => {
+  const payloads = samples.filter(sample => sample.payload.length === 8).map(sample => sample.payload);
+  t.strictSame(sensitPayload.parseDataBatch(payloads), payloads.map(sensitPayload.parseData));
+  t.strictSame(sensitPayload.parseDataBatchV3(['f6100065']), [sensitPayload.parseDataV3('f6100065')]);
+
+  // Every batch API goes through the same conversion, nothing of an earlier buffer is decoded
+  ['g0000000', 'zzzzzzzz', 'f610006z'].forEach((payload) => {
+    t.throws(() => sensitPayload.parseDataBatch(['f6100065', payload]), TypeError);
+  });
+  t.throws(() => sensitPayload.toArrow(['zzzzzzzz']), TypeError);
+  t.end();
+});
+
+samples.forEach((sample) => {
+  tap.test(`sensitPayload.parseInto(${sample.payload})`, (t) => {
+    const data = sensitPayload.createData();
+    const expected = sensitPayload.parse(sample.payload);
+    sensitPayload.parseInto(sample.payload.slice(0, 8), data);
+    // Properties cleared to undefined are dropped by JSON
+    t.strictSame(JSON.parse(JSON.stringify(data)), sensitPayload.parseData(sample.payload.slice(0, 8)));
+    const word = parseInt(sample.payload.slice(0, 8), 16);
+    t.strictSame(sensitPayload.parseInto(word, sensitPayload.createData()), data);
+    if (expected.config) {
+      const config = sensitPayload.createConfig();
+      sensitPayload.parseConfigInto(sample.payload.slice(8, 24), expected.type, config);
+      t.strictSame(JSON.parse(JSON.stringify(config)), expected.config);
+    }
+    t.end();
+  });
+});
+
+tap.test('sensitPayload.parseInto() rejects non hexadecimal payloads', (t) => {
+  // The scratch buffer still holds the previous payload
+  sensitPayload.parseInto('f609744f', sensitPayload.createData());
+  t.throws(() => sensitPayload.parseInto('zzzzzzzz', sensitPayload.createData()), TypeError);
+  t.throws(() => sensitPayload.parseInto('f609744z', sensitPayload.createData()), TypeError);
+  sensitPayload.parseConfigInto('46003f0f8004223c', sensitPayload.PAYLOAD_TYPE_V3, sensitPayload.createConfig());
+  t.throws(() => sensitPayload.parseConfigInto('46003f0f8004223g', sensitPayload.PAYLOAD_TYPE_V3, sensitPayload.createConfig()),
+    TypeError);
+  t.end();
+});
+
+tap.test('sensitPayload.parseDataWord()', (t) => {
+  const values = sensitPayload.parseDataWord(0xf6100065);
+  t.strictSame(values.length, sensitPayload.DATA_WORD_LENGTH);
+  t.strictSame(values[sensitPayload.DATA_WORD_FIELDS.mode], sensitPayload.MODE_LIGHT);
+  t.strictSame(values[sensitPayload.DATA_WORD_FIELDS.brightness], 101);
+  t.strictSame(sensitPayload.parseDataWord(0xf6100065, new Int32Array(sensitPayload.DATA_WORD_LENGTH)), values);
+  t.throws(() => sensitPayload.parseDataWord(0xf6100065, new Int32Array(4)), /too short/);
+  t.end();
+});
+
+tap.test('sensitPayload.PayloadView', (t) => {
+  const payloads = samples.map(sample => sample.payload.slice(0, 8));
+  const batch = Buffer.from(payloads.join(''), 'hex');
+  const view = sensitPayload.createPayloadView(batch);
+  payloads.forEach((payload, index) => {
+    view.reset(batch, index * 4);
+    t.strictSame(view.format(), sensitPayload.parseData(payload));
+    t.equal(view.mode, sensitPayload.lib.parseData(Buffer.from(payload, 'hex')).mode);
+  });
+  t.end();
+});
@@ -0,0 +1,82 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { randomPayloads } = require('./fixtures/payloads');
+
+// Row ids of the decoded payloads accepted by the filter
+function expectedRows(decoded, filter) {
+  const rows = [];
+  decoded.forEach((data, row) => {
+    if (filter(data)) {
+      rows.push(row);
+    }
+  });
+  return Uint32Array.from(rows);
+}
+
+tap.test('index.query()', (t) => {
+  // More than 65536 rows, to span several containers
+  const payloads = randomPayloads(150000, 3);
+  const decoded = sensitPayload.parseDataBatch(payloads);
+  const index = sensitPayload.createPayloadIndex();
+  t.strictSame(index.add(payloads.slice(0, 400000)), 0);
+  t.strictSame(index.add(payloads.slice(400000)), 100000);
+
+  const valid = data => data.error === sensitPayload.PARSE_ERR_NONE;
+  t.strictSame(index.query({ button: true }), expectedRows(decoded, data => valid(data) && data.button));
+  t.strictSame(index.query({ door: sensitPayload.DOOR_NOT_CALIBRATED }),
+    expectedRows(decoded, data => data.door === sensitPayload.DOOR_NOT_CALIBRATED));
+  t.strictSame(index.query({ error: [sensitPayload.PARSE_ERR_TYPE, sensitPayload.PARSE_ERR_MODE] }),
+    expectedRows(decoded, data => data.error !== sensitPayload.PARSE_ERR_NONE));
+  t.strictSame(index.query({ batteryLevel: { min: 2900, max: 3100 } }),
+    expectedRows(decoded, data => valid(data) && data.batteryLevel >= 2900 && data.batteryLevel <= 3100));
+
+  const query = {
+    andNot: [
+      { or: [{ door: sensitPayload.DOOR_OPEN, button: true }, { mode: sensitPayload.MODE_MAGNET }] },
+      { type: sensitPayload.PAYLOAD_TYPE_V2 },
+      { batteryLevel: 2700 }
+    ]
+  };
+  const rows = expectedRows(decoded, data => ((data.door === sensitPayload.DOOR_OPEN && data.button) ||
+    (valid(data) && data.modeCode === sensitPayload.MODE_MAGNET)) &&
+    data.type !== sensitPayload.PAYLOAD_TYPE_V2 && !(valid(data) && data.batteryLevel === 2700));
+  t.ok(rows.length > 0);
+  t.strictSame(index.query(query), rows);
+  t.strictSame(index.count(query), rows.length);
+  t.strictSame(index.query({ and: [{ mode: sensitPayload.MODE_DOOR }, { mode: sensitPayload.MODE_LIGHT }] }), new Uint32Array(0));
+
+  // Back to batch decode
+  const selected = sensitPayload.parseDataBatch(sensitPayload.selectRows(payloads, rows));
+  t.strictSame(selected, Array.from(rows, row => decoded[row]));
+
+  t.throws(() => index.query({ color: 1 }), /Unknown index field/);
+  t.throws(() => index.query({ or: [] }), /non-empty array/);
+  t.throws(() => index.query({ mode: 256 }), /Invalid value/);
+  t.throws(() => sensitPayload.selectRows(payloads, [150000]), /out of the payloads/);
+  t.end();
+});
+
+tap.test('index.serialize()', (t) => {
+  const payloads = randomPayloads(20000, 5);
+  const index = sensitPayload.createPayloadIndex();
+  index.add(payloads);
+  const serialized = index.serialize();
+
+  const reloaded = sensitPayload.createPayloadIndex(serialized);
+  t.strictSame(reloaded.serialize(), serialized);
+  t.strictSame(reloaded.stats().containers, index.stats().containers);
+  t.strictSame(reloaded.query({ mode: sensitPayload.MODE_VIBRATION }), index.query({ mode: sensitPayload.MODE_VIBRATION }));
+  t.strictSame(reloaded.add(payloads.slice(0, 4)), 20000);
+
+  t.throws(() => sensitPayload.createPayloadIndex(serialized.slice(0, serialized.length - 1)), /Invalid serialized index/);
+  t.throws(() => sensitPayload.createPayloadIndex(Buffer.from('5358010000000000', 'hex')), /Invalid serialized index/);
+
+  index.reset();
+  t.strictSame(index.stats().rows, 0);
+  t.strictSame(index.count({ error: 0 }), 0);
+  t.end();
+});
@@ -0,0 +1,54 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+tap.test('reorderer.push() / poll()', (t) => {
+  const reorderer = sensitPayload.createReorderer({ lateness: 60 });
+  const payloads = ['f6100001', 'f6100002', 'f6100003', 'f6100004', 'f6100005'];
+
+  // Device 1 uplinks 2 and 3 swapped, device 2 in order
+  t.strictSame(reorderer.push(payloads, [1, 1, 2, 1, 2], [1, 3, 7, 2, 8], [1000, 1020, 1005, 1010, 1030]), new Uint8Array(5));
+  t.strictSame(reorderer.poll().devices.length, 0); // watermark 1030 - 60
+
+  reorderer.push(['f6100006'], [1], [4], [1100]);
+  const batch = reorderer.poll(); // watermark 1040
+  t.strictSame(Array.from(batch.devices), [1, 2, 1, 1, 2]);
+  t.strictSame(Array.from(batch.seqNumbers), [1, 7, 2, 3, 8]);
+  t.strictSame(Array.from(batch.times), [1000, 1005, 1010, 1020, 1030]);
+  t.strictSame(batch.payloads.toString('hex'), 'f6100001f6100003f6100004f6100002f6100005');
+  t.strictSame(batch.watermark, 1040);
+  t.strictSame(sensitPayload.parseDataBatch(batch.payloads).length, 5);
+
+  // Older than the watermark of the last poll
+  t.strictSame(reorderer.push(['f6100007', 'f6100008'], [3, 1], [1, 5], [1039, 1101]), Uint8Array.from([1, 0]));
+
+  const flushed = reorderer.flush();
+  t.strictSame(Array.from(flushed.times), [1100, 1101]);
+  t.match(reorderer.stats(), { devices: 3, held: 0, pushed: 7, released: 7, late: 1, forced: 0 });
+  t.end();
+});
+
+tap.test('reorderer depth', (t) => {
+  const reorderer = sensitPayload.createReorderer({ lateness: 3600, depth: 2, size: 12 });
+  const uplinks = Buffer.alloc(4 * 12);
+  for (let i = 0; i < 4; i++) {
+    uplinks.writeUInt32BE(i, i * 12);
+  }
+
+  // The oldest uplink of a full device is released before the watermark
+  t.strictSame(reorderer.push(uplinks, [5, 5, 5, 5], [2, 1, 3, 0], [20, 10, 30, 5]), Uint8Array.from([0, 0, 0, 1]));
+  const batch = reorderer.poll();
+  t.strictSame(Array.from(batch.times), [10]);
+  t.strictSame(batch.payloads.length, 12);
+  t.strictSame(batch.payloads.readUInt32BE(0), 1);
+  t.strictSame(reorderer.stats().forced, 1);
+
+  const rest = reorderer.poll({ watermark: 25, max: 1 });
+  t.strictSame(Array.from(rest.times), [20]);
+  t.strictSame(Array.from(reorderer.flush().times), [30]);
+  t.throws(() => sensitPayload.createReorderer({ size: 8 }));
+  t.end();
+});
@@ -0,0 +1,36 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+tap.test('ring.push() and ring.drain()', { skip: process.platform !== 'linux' }, (t) => {
+  const ring = sensitPayload.createRing({ capacity: 3 });
+  t.strictSame(ring.stats(), { capacity: 4, size: 0, overflow: 0 });
+  t.strictSame(ring.wait(0), false);
+
+  t.ok(ring.push('1A2B3C', 100, 1, 'f6096180'));
+  t.ok(ring.push(2, 200, 2, 'f6096180', '00ff008f04027390'));
+  t.strictSame(ring.pushBatch(['f6096180', 'f6096180', 'f6096180'], [3, 4, 5], [300, 400, 500], [3, 4, 5]), 2);
+  t.strictSame(ring.stats(), { capacity: 4, size: 4, overflow: 1 });
+  t.strictSame(ring.wait(0), true);
+
+  const records = ring.drain(3);
+  t.strictSame(Array.from(records.devices), [0x1A2B3C, 2, 3]);
+  t.strictSame(Array.from(records.times), [100, 200, 300]);
+  t.strictSame(Array.from(records.seqNumbers), [1, 2, 3]);
+  t.strictSame(Array.from(records.sizes), [4, 12, 4]);
+  t.strictSame(records.payloads.toString('hex'), 'f6096180f6096180f6096180');
+  t.strictSame(records.configs.toString('hex').slice(16, 32), '00ff008f04027390');
+  t.strictSame(sensitPayload.parseDataBatch(records.payloads)[0], sensitPayload.parseData('f6096180'));
+
+  // Shared with another mapping
+  const consumer = sensitPayload.openRing(ring.path);
+  t.strictSame(Array.from(consumer.drain().devices), [4]);
+  t.strictSame(ring.stats().size, 0);
+  consumer.close();
+  ring.close();
+  t.throws(() => ring.drain());
+  t.end();
+});
@@ -0,0 +1,34 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+// v3 temperature payload
+function payloadV3(temperature, humidity) {
+  const raw = (temperature * 8) + 200;
+  return Buffer.from([(30 << 3) | 0b110, (sensitPayload.MODE_TEMPERATURE << 3) | (raw >> 8), raw & 0xFF, humidity * 2]).toString('hex');
+}
+
+tap.test('ruleEngine.evaluate()', (t) => {
+  const engine = sensitPayload.createRuleEngine();
+  t.strictSame(engine.addRule({ field: 'temperature', high: 30, hysteresis: 2, debounce: 2 }), 0);
+  t.strictSame(engine.addRule({ field: 'humidity', low: 30, high: 70, hysteresis: 2 }), 1);
+
+  const temperatures = [25, 31, 29, 31, 31, 29, 27, 27];
+  const humidities = [50, 75, 71, 69, 25, 25, 65, 31];
+  const payloads = temperatures.map((temperature, i) => payloadV3(temperature, humidities[i]));
+  const devices = payloads.map(() => '1A2B3C');
+
+  t.strictSame(engine.evaluate(payloads, devices), [
+    { row: 1, device: 0x1A2B3C, rule: 1, from: 'normal', to: 'high' },
+    { row: 4, device: 0x1A2B3C, rule: 0, from: 'normal', to: 'high' },
+    { row: 4, device: 0x1A2B3C, rule: 1, from: 'high', to: 'low' },
+    { row: 6, device: 0x1A2B3C, rule: 1, from: 'low', to: 'normal' },
+    { row: 7, device: 0x1A2B3C, rule: 0, from: 'high', to: 'normal' }
+  ]);
+  // The state is kept from one batch to the next
+  t.strictSame(engine.evaluate([payloadV3(27, 50)], ['1A2B3C']), []);
+  t.end();
+});
@@ -0,0 +1,77 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const fs = require('fs');
+const net = require('net');
+const os = require('os');
+const path = require('path');
+const { spawn } = require('child_process');
+const sensitPayload = require('../');
+
+const binary = path.join(__dirname, '..', 'build', 'Release', 'sensitd');
+
+function request(format, frameSize, id, frames) {
+  const header = Buffer.alloc(8);
+  header.writeUInt32LE(4 + frames.length, 0);
+  header.writeUInt8(format, 4);
+  header.writeUInt8(frameSize, 5);
+  header.writeUInt16LE(id, 6);
+  return Buffer.concat([header, frames]);
+}
+
+function replies(buffer) {
+  const res = [];
+  for (let offset = 0; offset + 4 <= buffer.length;) {
+    const length = buffer.readUInt32LE(offset);
+    res.push({
+      status: buffer[offset + 4],
+      format: buffer[offset + 5],
+      id: buffer.readUInt16LE(offset + 6),
+      body: buffer.slice(offset + 8, offset + 4 + length)
+    });
+    offset += 4 + length;
+  }
+  return res;
+}
+
+tap.test('sensitd', { skip: !fs.existsSync(binary) }, (t) => {
+  const socket = path.join(os.tmpdir(), `sensitd-${process.pid}.sock`);
+  const daemon = spawn(binary, ['-s', socket]);
+  setTimeout(() => {
+    const client = net.connect(socket);
+    const chunks = [];
+    client.on('data', chunk => chunks.push(chunk));
+    client.on('end', () => {
+      const [ndjson, binaryReply, invalid, ndjsonConfig] = replies(Buffer.concat(chunks));
+      t.strictSame(ndjson.id, 1);
+      t.strictSame(ndjson.status, 0);
+      const lines = ndjson.body.toString().trim().split('\n').map(line => JSON.parse(line));
+      t.strictSame(lines, [sensitPayload.parseData('f6096180'), sensitPayload.parseData('a1bc12f3')]);
+
+      t.strictSame(binaryReply.id, 2);
+      t.strictSame(binaryReply.body.length, 32);
+      // Binary records keep the raw units of the decoder
+      const raw = sensitPayload.parseDataWord(0xf6096180);
+      t.strictSame(binaryReply.body.readUInt16LE(4), raw[sensitPayload.DATA_WORD_FIELDS.batteryLevel]);
+      t.strictSame(binaryReply.body.readInt16LE(6), 153);
+      t.strictSame(binaryReply.body[16], 0);
+
+      t.strictSame(invalid.status, 2);
+      t.strictSame(invalid.body.length, 0);
+
+      t.strictSame(ndjsonConfig.id, 4);
+      t.strictSame(JSON.parse(ndjsonConfig.body.toString()), sensitPayload.parse('f609618000ff008f04027390'));
+      daemon.kill();
+      t.end();
+    });
+    // Pipelined, then half closed
+    client.end(Buffer.concat([
+      request(1, 4, 1, Buffer.from('f6096180a1bc12f3', 'hex')),
+      request(0, 12, 2, Buffer.from('f609618000ff008f04027390', 'hex')),
+      request(0, 12, 3, Buffer.from('f6096180', 'hex')),
+      request(1, 12, 4, Buffer.from('f609618000ff008f04027390', 'hex'))
+    ]));
+  }, 200);
+});
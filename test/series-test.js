@@ -0,0 +1,145 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { randomPayloads } = require('./fixtures/payloads');
+
+const DEVICES = 3;
+
+// Uplinks of DEVICES devices interleaved, 10 minutes apart with a few seconds of jitter
+function createUplinks(count, seed) {
+  const payloads = randomPayloads(count, seed);
+  const devices = Uint32Array.from({ length: count }, (value, i) => i % DEVICES);
+  const times = Uint32Array.from({ length: count }, (value, i) => 1500000000 + (Math.floor(i / DEVICES) * 600) + (i % 7 === 0 ? 0 : i % 5));
+  return { payloads, devices, times };
+}
+
+// Samples each field of each device should hold, in the raw units of the decoder
+function expectedSamples({ payloads, devices, times }) {
+  const samples = new Map();
+  const push = (device, field, time, value) => {
+    const key = `${device}/${field}`;
+    if (!samples.has(key)) {
+      samples.set(key, { times: [], values: [] });
+    }
+    samples.get(key).times.push(time);
+    samples.get(key).values.push(value);
+  };
+  const view = sensitPayload.createPayloadView(payloads, 0);
+  for (let i = 0; i < devices.length; i++) {
+    view.reset(payloads, i * 4);
+    if (view.error !== sensitPayload.PARSE_ERR_NONE) {
+      continue;
+    }
+    const v2Button = view.type === sensitPayload.PAYLOAD_TYPE_V2 && view.button === 1;
+    push(devices[i], 'batteryLevel', times[i], view.batteryLevel);
+    if (view.mode === sensitPayload.MODE_TEMPERATURE) {
+      push(devices[i], 'temperature', times[i], view.temperature);
+      if (!v2Button) {
+        push(devices[i], 'humidity', times[i], view.humidity);
+      }
+    } else if (view.mode === sensitPayload.MODE_LIGHT && !v2Button) {
+      push(devices[i], 'brightness', times[i], view.brightness);
+    } else if (view.mode !== sensitPayload.MODE_STANDBY && !v2Button) {
+      push(devices[i], 'eventCounter', times[i], view.eventCounter);
+    }
+  }
+  return samples;
+}
+
+const toArrays = ({ times, values }) => ({ times: Array.from(times), values: Array.from(values) });
+
+tap.test('store.append() & store.read()', (t) => {
+  const uplinks = createUplinks(30000, 21);
+  const decoded = sensitPayload.parseDataBatch(uplinks.payloads);
+  const modes = new Set(decoded.map(data => `${data.type}/${data.mode}`));
+  t.ok(['temperature', 'light', 'door', 'vibration', 'magnet', 'standby'].every(mode => modes.has(`2/${mode}`) && modes.has(`3/${mode}`)));
+
+  const store = sensitPayload.createSeriesStore();
+  t.strictSame(store.append(uplinks.payloads, uplinks.devices, uplinks.times), 0);
+  const expected = expectedSamples(uplinks);
+  let total = 0;
+  for (let device = 0; device < DEVICES; device++) {
+    Object.keys(sensitPayload.SERIES_FIELDS).forEach((field) => {
+      const samples = expected.get(`${device}/${field}`);
+      t.ok(samples.times.length > 64, `${field} of ${device} spans several blocks`);
+      t.strictSame(toArrays(store.read(device, field)), samples, `${field} of ${device}`);
+      total += samples.times.length;
+    });
+  }
+
+  const stats = store.stats();
+  t.strictSame(stats.devices, DEVICES);
+  t.strictSame(stats.samples, total);
+  t.ok(stats.encodedSamples < total && stats.bitsPerSample < 32);
+  t.strictSame(toArrays(store.read(DEVICES, 'temperature')), { times: [], values: [] });
+  t.throws(() => store.read(0, 'door'), /Unknown series field/);
+  t.end();
+});
+
+tap.test('store.read() within blocks', (t) => {
+  const uplinks = createUplinks(20000, 23);
+  const store = sensitPayload.createSeriesStore();
+  store.append(uplinks.payloads, uplinks.devices, uplinks.times);
+  const expected = expectedSamples(uplinks);
+
+  const { times, values } = expected.get('1/batteryLevel');
+  const range = (from, to) => {
+    const selected = { times: [], values: [] };
+    times.forEach((time, i) => {
+      if (time >= from && time <= to) {
+        selected.times.push(time);
+        selected.values.push(values[i]);
+      }
+    });
+    return selected;
+  };
+
+  // Bounds in the middle of blocks, on a sample and between two samples
+  [[10, 20], [63, 64], [100, 1000], [1500, times.length - 1]].forEach(([first, last]) => {
+    t.strictSame(toArrays(store.read(1, 'batteryLevel', times[first], times[last])), range(times[first], times[last]));
+    t.strictSame(toArrays(store.read(1, 'batteryLevel', times[first] + 1, times[last] - 1)),
+      range(times[first] + 1, times[last] - 1));
+  });
+  t.strictSame(toArrays(store.read(1, 'batteryLevel', times[200], times[200])), range(times[200], times[200]));
+  t.strictSame(store.read(1, 'batteryLevel', times[200], times[100]).times.length, 0);
+  t.strictSame(store.read(1, 'batteryLevel', times[times.length - 1] + 1).times.length, 0);
+  t.end();
+});
+
+tap.test('store.flush()', (t) => {
+  // 100 standby uplinks of a v3 device: a full block of 64 and 36 samples waiting
+  const payload = Buffer.from('ae003040', 'hex');
+  const count = 100;
+  const payloads = Buffer.concat(Array.from({ length: count }, () => payload));
+  const times = Uint32Array.from({ length: count }, (value, i) => 1500000000 + (i * 3600));
+  const store = sensitPayload.createSeriesStore();
+  store.append(payloads, new Uint32Array(count), times);
+  t.strictSame(store.stats().samples, count);
+  t.strictSame(store.stats().encodedSamples, 64);
+
+  const before = toArrays(store.read(0, 'batteryLevel'));
+  t.strictSame(before.times, Array.from(times));
+  store.flush();
+  t.strictSame(store.stats().encodedSamples, count);
+  t.strictSame(toArrays(store.read(0, 'batteryLevel')), before);
+  t.strictSame(toArrays(store.read(0, 'batteryLevel', times[70], times[80])),
+    { times: Array.from(times.slice(70, 81)), values: before.values.slice(70, 81) });
+
+  // Appending after a shorter block, at the same second as the last uplink
+  const last = times[count - 1];
+  t.strictSame(store.append(payloads.slice(0, 8), [0, 0], [last, last + 60]), 0);
+  t.strictSame(store.read(0, 'batteryLevel', last).times, Uint32Array.from([last, last, last + 60]));
+  t.strictSame(store.stats().encodedSamples, count);
+
+  // An older uplink is rejected, whatever the block its time falls in
+  t.strictSame(store.append(payloads.slice(0, 4), [0], [times[10]]), 1);
+  t.strictSame(store.stats().samples, count + 2);
+  store.flush();
+  store.flush();
+  t.strictSame(store.stats().encodedSamples, count + 2);
+  t.strictSame(store.read(0, 'batteryLevel').times.length, count + 2);
+  t.end();
+});
@@ -0,0 +1,82 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+const { randomPayloads } = require('./fixtures/payloads');
+
+// Nearest rank quantile of the values
+function exactQuantile(values, q) {
+  const sorted = values.slice().sort((a, b) => a - b);
+  return sorted[Math.max(Math.ceil(q * sorted.length), 1) - 1];
+}
+
+tap.test('sketch.quantiles()', (t) => {
+  const payloads = randomPayloads(20000, 7);
+  const decoded = sensitPayload.parseDataBatch(payloads).filter(data => data.error === 0);
+  const sketch = sensitPayload.createSketch();
+
+  t.strictSame(sketch.update(payloads), decoded.length);
+  t.strictSame(sketch.count('temperature'), decoded.filter(data => 'temperature' in data).length);
+  t.strictSame(sketch.count('batteryLevel'), decoded.length);
+
+  const fields = { temperature: 'temperature', humidity: 'humidity', brightness: 'light', batteryLevel: 'batteryLevel' };
+  Object.keys(fields).forEach((field) => {
+    const values = decoded.filter(data => fields[field] in data).map(data => data[fields[field]]);
+    const qs = [0, 0.5, 0.95, 0.99, 1];
+    sketch.quantiles(field, qs).forEach((value, i) => {
+      const exact = exactQuantile(values, qs[i]);
+      // formatData() rounds to 2 decimals, brightness buckets are within 1.6%
+      const tolerance = field === 'brightness' ? (exact * 0.016) + 0.01 : 0.01;
+      t.ok(Math.abs(value - exact) <= tolerance, `${field} q${qs[i]}: ${value} ~ ${exact}`);
+    });
+  });
+
+  t.ok(Number.isNaN(sensitPayload.createSketch().quantile('temperature', 0.5)));
+  t.throws(() => sketch.quantiles('door'));
+  t.end();
+});
+
+tap.test('sketch.distinct()', (t) => {
+  const sketch = sensitPayload.createSketch();
+  t.strictSame(sketch.distinct(), 0);
+
+  sketch.addDevices(['1A2B3C', '1A2B3C', 5]);
+  t.strictSame(sketch.distinct(), 2);
+
+  const devices = new Uint32Array(50000);
+  for (let i = 0; i < devices.length; i++) {
+    devices[i] = (i * 2654435761) >>> 0;
+  }
+  sketch.addDevices(devices);
+  sketch.addDevices(devices.subarray(0, 1000));
+  t.ok(Math.abs(sketch.distinct() - 50002) < 50002 * 0.03);
+  t.end();
+});
+
+tap.test('sketch.merge()', (t) => {
+  const payloads = randomPayloads(4000, 11);
+  const devices = Array.from({ length: 4000 }, (value, i) => i % 700);
+  const whole = sensitPayload.createSketch();
+  const first = sensitPayload.createSketch();
+  const second = sensitPayload.createSketch();
+  whole.update(payloads, devices);
+  first.update(payloads.slice(0, 8000), devices.slice(0, 2000));
+  second.update(payloads.slice(8000), devices.slice(2000));
+
+  // Merged in another process from the serialized partials
+  const merged = sensitPayload.createSketch(first.serialize()).merge(second.serialize());
+  t.strictSame(merged.serialize(), whole.serialize());
+  t.strictSame(first.merge(second).serialize(), whole.serialize());
+  t.strictSame(merged.quantiles('humidity'), whole.quantiles('humidity'));
+  t.ok(whole.serialize().length < 8000);
+
+  t.throws(() => merged.merge(Buffer.from('534b0100ff', 'hex')), /Invalid serialized sketch/);
+  t.strictSame(merged.serialize(), whole.serialize());
+
+  merged.reset();
+  t.strictSame(merged.count('batteryLevel'), 0);
+  t.strictSame(merged.distinct(), 0);
+  t.end();
+});
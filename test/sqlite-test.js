@@ -0,0 +1,50 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const fs = require('fs');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const root = path.join(__dirname, '..');
+const extension = path.join(root, 'build', 'Release', 'sensit');
+const sqlite = spawnSync('sqlite3', ['-version']);
+// The extension needs g++ and the SQLite headers, which the addon does not
+const headers = spawnSync('g++', ['-E', '-x', 'c++', '-'], { input: '#include <sqlite3ext.h>\n' });
+
+function query(sql) {
+  const res = spawnSync('sqlite3', ['-json', ':memory:', `.load ${extension}`, sql], { encoding: 'utf8' });
+  return JSON.parse(res.stdout || '[]');
+}
+
+tap.test('sqlite extension', { skip: sqlite.error || headers.error || headers.status !== 0 }, (t) => {
+  // Built on demand, with the command of npm run build-sqlite
+  const build = spawnSync(require('../package.json').scripts['build-sqlite'], { cwd: root, shell: true, encoding: 'utf8' });
+  t.strictSame(build.status, 0, build.stderr);
+  t.ok(fs.existsSync(`${extension}.so`), 'npm run build-sqlite');
+  t.strictSame(query("SELECT sensit_mode('f6100065') AS mode, sensit_light(x'f6100065') AS light, sensit_temperature('f6100065') AS temperature"),
+    [{ mode: 2, light: 101 / 96, temperature: null }]);
+  t.strictSame(query("SELECT sensit_version('ae00304046003f0f8004223c') AS version"), [{ version: '3.1.0' }]);
+  t.strictSame(query("SELECT sensit_type('f610006') AS type, sensit_mode('ffffffff') AS mode"), [{ type: null, mode: null }]);
+
+  // Same JSON as the JavaScript API
+  const [{ data, config }] = query("SELECT sensit_json('895d205d00ff008f04027390') AS data, sensit_config_json('00ff008f04027390', 2) AS config");
+  t.strictSame(JSON.parse(data), {
+    error: 0, type: 2, temperature: 19, humidity: 46.5, button: false, battery: 100, batteryIndicator: 4, batteryLevel: 4150, modeCode: 1, mode: 'temperature'
+  });
+  t.strictSame(JSON.parse(config), {
+    lightUpper: 10, lightLower: 0, temperatureLower: -20, temperatureUpper: 107, humidityLower: 0, humidityUpper: 0, vibrationSensitivity: 2, door: 0, period: 1, limited: true
+  });
+
+  const rows = query(`CREATE TABLE uplinks(device, payload);
+    INSERT INTO uplinks VALUES (1, 'f6100065'), (2, x'895d205d00ff008f04027390'), (3, 'ffffffff'), (4, x'00');
+    CREATE INDEX uplinks_mode ON uplinks(sensit_mode(payload));
+    SELECT u.device, d.mode_name, d.temperature, d.config IS NOT NULL AS config FROM uplinks u, sensit_decode(u.payload) d ORDER BY u.device`);
+  t.strictSame(rows, [
+    { device: 1, mode_name: 'light', temperature: null, config: 0 },
+    { device: 2, mode_name: 'temperature', temperature: 19.0, config: 1 },
+    { device: 3, mode_name: null, temperature: null, config: 0 }
+  ]);
+  t.end();
+});
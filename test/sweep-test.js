@@ -0,0 +1,24 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const fs = require('fs');
+const path = require('path');
+const { execFile } = require('child_process');
+
+const binary = path.join(__dirname, '..', 'build', 'Release', 'sensit_sweep');
+
+tap.test('sensit_sweep', { skip: !fs.existsSync(binary) }, (t) => {
+  execFile(binary, ['-t', '2', '-b', '20', '-r', '65536'], (err, stdout) => {
+    t.error(err);
+    t.match(stdout, /^data: 1048576 payloads x 5 candidates/m);
+    t.match(stdout, /^config: 5570560 configs/m);
+    t.match(stdout, /^OK: 0 mismatches$/m);
+
+    execFile(binary, ['-b', '33'], (usageErr) => {
+      t.strictSame(usageErr.code, 2);
+      t.end();
+    });
+  });
+});
@@ -0,0 +1,41 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+const payloads = ['f6100065', 'f609744f', 'b6180000', '895d205d'];
+
+tap.test('sensitPayload.toNdjson()', (t) => {
+  const lines = sensitPayload.toNdjson(payloads).toString().split('\n');
+  t.strictSame(lines.pop(), '');
+  t.strictSame(lines, payloads.map(payload => JSON.stringify(sensitPayload.parseData(payload))));
+
+  const prefixed = sensitPayload.toNdjson(payloads.slice(1, 2), { devices: ['1A2B3C'], times: [10], columns: ['temperature', 'mode'] });
+  t.strictSame(prefixed.toString(), '{"device":"1A2B3C","time":10,"temperature":21.5,"mode":"temperature"}\n');
+  t.throws(() => sensitPayload.toNdjson(payloads, { columns: ['brightness'] }));
+  t.end();
+});
+
+tap.test('sensitPayload.toCsv()', (t) => {
+  const csv = sensitPayload.toCsv(payloads, {
+    devices: ['1A2B3C', 2, 3, 4],
+    times: [10, 20, 30, 40],
+    columns: ['mode', 'temperature', 'humidity', 'battery']
+  });
+  t.strictSame(csv.toString(), [
+    'device,time,temperature,humidity,battery,mode',
+    '1A2B3C,10,,,100,light',
+    '2,20,21.5,39.5,100,temperature',
+    '3,30,,,60,door',
+    '4,40,19,46.5,100,temperature',
+    ''
+  ].join('\n'));
+  t.strictSame(sensitPayload.toCsv(payloads.slice(0, 1), { header: false, columns: ['light'] }).toString(), '1.05\n');
+
+  // A key column of another length is an error, not a column left out
+  t.throws(() => sensitPayload.toCsv(payloads, { devices: [1, 2, 3] }), RangeError);
+  t.throws(() => sensitPayload.toNdjson(payloads, { times: [10, 20, 30, 40, 50] }), RangeError);
+  t.end();
+});
@@ -0,0 +1,35 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+// v3 door payload
+function doorV3(door, eventCounter) {
+  return Buffer.from([(30 << 3) | 0b110, (sensitPayload.MODE_DOOR << 3) | door, eventCounter >> 8, eventCounter & 0xFF]).toString('hex');
+}
+
+tap.test('timeline.process()', (t) => {
+  const timeline = sensitPayload.createTimeline();
+  const payloads = [
+    doorV3(sensitPayload.DOOR_OPEN, 1),
+    doorV3(sensitPayload.DOOR_CLOSE, 2),
+    doorV3(sensitPayload.DOOR_CLOSE, 2),
+    // 2 events missed
+    doorV3(sensitPayload.DOOR_OPEN, 5)
+  ];
+  const intervals = timeline.process(payloads, [1, 1, 1, 1], [100, 200, 300, 400]);
+  t.strictSame(intervals.map(({ kind, start, end, missed }) => ({ kind, start, end, missed })), [
+    { kind: 'open', start: 100, end: 200, missed: 0 },
+    { kind: 'closed', start: 200, end: 400, missed: 2 }
+  ]);
+  t.strictSame(timeline.size(), 1);
+
+  const expired = timeline.expire(1000, 300);
+  t.strictSame(expired.length, 1);
+  t.strictSame(expired[0].kind, 'open');
+  t.strictSame(expired[0].endReason, 'expired');
+  t.strictSame(timeline.size(), 0);
+  t.end();
+});
@@ -0,0 +1,37 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const fs = require('fs');
+const path = require('path');
+const { execFile } = require('child_process');
+
+const addon = path.join(__dirname, '..', 'build', 'Release', 'sensit_payload_lib.node');
+const tools = path.join(__dirname, '..', 'tools');
+
+// The probes are compiled in only when <sys/sdt.h> is found at build time
+const traced = fs.existsSync('/usr/include/sys/sdt.h') && fs.existsSync(addon);
+
+tap.test('USDT probes of the tools scripts', { skip: !traced }, (t) => {
+  execFile('readelf', ['-n', addon], (err, stdout) => {
+    t.error(err);
+    // stapsdt notes of the sensit provider, guarded by a semaphore
+    const probes = new Set();
+    const note = /Provider: (\S+)\s+Name: (\S+)\s+Location: .*Semaphore: (0x[0-9a-f]+)/g;
+    for (let match = note.exec(stdout); match !== null; match = note.exec(stdout)) {
+      if (match[1] === 'sensit' && Number(match[3]) !== 0) {
+        probes.add(match[2]);
+      }
+    }
+    fs.readdirSync(tools).filter(file => file.endsWith('.bt')).forEach((file) => {
+      const used = fs.readFileSync(path.join(tools, file), 'utf8').match(/usdt:\*:sensit:\w+/g) || [];
+      t.ok(used.length > 0, `${file} attaches to sensit probes`);
+      used.forEach((probe) => {
+        const name = probe.split(':').pop();
+        t.ok(probes.has(name), `${file}: ${name} is in the addon`);
+      });
+    });
+    t.end();
+  });
+});
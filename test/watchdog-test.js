@@ -0,0 +1,42 @@
+/**
+ * Module dependencies
+ */
+
+const tap = require('tap');
+const sensitPayload = require('../');
+
+tap.test('watchdog.poll()', (t) => {
+  const watchdog = sensitPayload.createWatchdog({ grace: 60 });
+
+  // v2 every hour, v3 every 10 minutes in a periodic temperature mode, v3 without config
+  t.strictSame(watchdog.uplink(['895d205d'], ['A1'], [1000]), 0);
+  t.strictSame(watchdog.uplink(['f60961800209099900010114'], ['B2'], [1000]), 0);
+  t.strictSame(watchdog.uplink(['f6096180', 'ffffffff'], ['C3', 'D4'], [1000, 1000]), 1);
+  t.strictSame(watchdog.stats(), { devices: 3, armed: 3 });
+
+  t.strictSame(Array.from(watchdog.poll(1659).devices), []);
+  const expired = watchdog.poll(1660);
+  t.strictSame(Array.from(expired.devices), [0xB2]);
+  t.strictSame(Array.from(expired.lastTimes), [1000]);
+  t.strictSame(watchdog.stats().armed, 2);
+
+  // Temperature mode not periodic in the config, not watched
+  t.strictSame(watchdog.uplink(['f609618000ff008f04027390'], ['B2'], [2000]), 0);
+  t.strictSame(watchdog.stats().armed, 2);
+
+  // Late uplink ignored, next one re-arms
+  watchdog.uplink(['895d205d'], ['A1'], [900]);
+  watchdog.uplink(['895d205d'], ['A1'], [1100]);
+
+  // Restored deadline already passed
+  watchdog.arm([5], [2000], [1500]);
+  t.strictSame(Array.from(watchdog.poll(2000).devices), [5]);
+
+  t.strictSame(watchdog.poll(4660, 1).devices.length, 1);
+  t.strictSame(Array.from(watchdog.poll(4660).devices), []);
+  t.strictSame(Array.from(watchdog.poll(4760).devices), [0xA1]);
+
+  watchdog.remove(['A1', 'B2', 'C3', 5]);
+  t.strictSame(watchdog.stats(), { devices: 0, armed: 0 });
+  t.end();
+});